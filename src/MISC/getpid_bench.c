@@ -0,0 +1,111 @@
+/*
+ *  getpid_bench.c  --  syscall round-trip microbenchmark
+ *
+ *	Calls getpid() in a loop, first through "int $0x80" and then (if
+ *	the cpu has it) through sysenter, and prints the average number of
+ *	cpu cycles per call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define	NR_GETPID	20
+#define	DEFAULT_LOOPS	100000
+
+
+unsigned long long rdtsc ()
+  {
+    unsigned long long t;
+    __asm __volatile ("rdtsc" : "=A" (t));
+    return t;
+  }
+
+
+int have_sysenter ()
+  {
+    unsigned int a, b, c, d;
+    int family, model, stepping;
+
+    /*  Assume that cpuid exists (a 486 without it has no TSC either)  */
+    __asm __volatile ("cpuid" : "=a" (a), "=b" (b), "=c" (c), "=d" (d)
+	: "a" (1));
+
+    stepping = a & 15;
+    model = (a >> 4) & 15;
+    family = (a >> 8) & 15;
+
+    /*  Early Pentium Pros claim to have sysenter, but don't:  */
+    if (family == 6 && model < 3 && stepping < 3)
+	return 0;
+
+    return (d & 0x800) != 0;
+  }
+
+
+int int80_getpid ()
+  {
+    int res;
+
+    /*  The kernel expects a return address below the arguments:  */
+    __asm __volatile ("pushl %%eax\n\tint $0x80\n\taddl $4, %%esp"
+	: "=a" (res) : "a" (NR_GETPID) : "ecx", "edx", "memory", "cc");
+    return res;
+  }
+
+
+int sysenter_getpid ()
+  {
+    int res;
+
+    /*  ecx = userland esp, edx = where to return  */
+    __asm __volatile ("pushl %%eax\n\tmovl %%esp, %%ecx\n\t"
+	"movl $1f, %%edx\n\tsysenter\n1:\taddl $4, %%esp"
+	: "=a" (res) : "a" (NR_GETPID) : "ecx", "edx", "memory", "cc");
+    return res;
+  }
+
+
+void bench (char *name, int (*func)(), int loops)
+  {
+    unsigned long long t0, t1;
+    int i, pid;
+
+    pid = func ();
+    if (pid != getpid ())
+      {
+	printf ("%s: returned %i, expected %i\n", name, pid, getpid ());
+	exit (1);
+      }
+
+    t0 = rdtsc ();
+    for (i=0; i<loops; i++)
+	func ();
+    t1 = rdtsc ();
+
+    printf ("%-10s %i calls, %i cycles/call\n", name, loops,
+	(int) ((t1 - t0) / loops));
+  }
+
+
+main (int argc, char *argv[])
+  {
+    int loops = DEFAULT_LOOPS;
+
+    if (argc > 1)
+	loops = atoi (argv[1]);
+    if (loops < 1)
+      {
+	printf ("usage: %s [loops]\n", argv[0]);
+	exit (0);
+      }
+
+    bench ("int $0x80", int80_getpid, loops);
+
+    if (have_sysenter ())
+	bench ("sysenter", sysenter_getpid, loops);
+    else
+	printf ("sysenter: not supported by this cpu\n");
+
+    exit (0);
+  }
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+
+/*
+ *  dmesg  --  show recent kernel messages
+ *
+ *	Prints the kernel message buffer, /proc/dmesg.  (Uses cat() from
+ *	cat.c.)
+ */
+
+
+#include <fcntl.h>
+
+
+#define	DMESG_PROCFILE		"/proc/dmesg"
+
+
+
+int main_dmesg (int argc, char *argv[])
+  {
+    int f;
+
+    if (argc > 1)
+      {
+	printf ("usage: %s\n", argv[0]);
+	return 1;
+      }
+
+    f = open (DMESG_PROCFILE, O_RDONLY);
+    if (f < 0)
+      {
+	perror (DMESG_PROCFILE);
+	return 1;
+      }
+
+    cat (f);
+    close (f);
+    return 0;
+  }
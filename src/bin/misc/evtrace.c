@@ -0,0 +1,242 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+
+/*
+ *  evtrace  --  event trace control and decoder
+ *
+ *	"evtrace start", "evtrace stop" and "evtrace reset" are passed on
+ *	to /proc/evtrace. Without a command, the binary records in
+ *	/proc/evtrace are read (which removes them from the kernel's ring
+ *	buffer) and printed as a timeline. With -o, the raw records are
+ *	saved to a file instead, and -f decodes such a file.
+ *
+ *	The record format and event numbers must match sys/evtrace.h.
+ */
+
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+
+#define	EVTRACE_PROCFILE	"/proc/evtrace"
+#define	EVTRACE_NRECORDS	1024
+
+
+struct evtrace_record
+      {
+	u_int64_t	time;
+	u_int16_t	type;
+	u_int16_t	cpu;
+	u_int32_t	pid;
+	u_int32_t	arg [4];
+      };
+
+/*  Event names and the format of their arguments, indexed by type:  */
+struct evtrace_format
+      {
+	char	*name;
+	char	*args;		/*  'x' hex, 'd' decimal, 's' 4 chars, '-' none  */
+      } evtrace_formats [] =
+      {
+	{  "lost",		"d---"  },
+	{  "pswitch",		"dd--"  },
+	{  "sleep",		"xs--"  },
+	{  "wakeup",		"x---"  },
+	{  "wakeup_proc",	"d---"  },
+	{  "fault",		"xd--"  },
+	{  "fault_done",	"xd--"  },
+	{  "bcache_hit",	"xd--"  },
+	{  "bcache_miss",	"xd--"  },
+	{  "dev_read",		"sdd-"  },
+	{  "dev_write",		"sdd-"  },
+	{  "dev_done",		"sd--"  },
+	{  "irq",		"d---"  },
+	{  "irq_done",		"d---"  },
+      };
+
+#define	EVTRACE_NTYPES	(sizeof(evtrace_formats) / sizeof(evtrace_formats[0]))
+
+u_int64_t evtrace_first = 0, evtrace_prev = 0;
+int evtrace_any = 0;
+
+
+
+void evtrace_print (struct evtrace_record *r)
+  {
+    char name4 [5];
+    int i, j;
+
+    if (!evtrace_any)
+      {
+	printf ("%12s %10s %5s  %s\n", "cycles", "delta", "pid", "event");
+	evtrace_first = evtrace_prev = r->time;
+	evtrace_any = 1;
+      }
+
+    printf ("%12.0f %10lu %5u  ", (double) (r->time - evtrace_first),
+	(unsigned long) (r->time - evtrace_prev), (unsigned) r->pid);
+    evtrace_prev = r->time;
+
+    if (r->type >= EVTRACE_NTYPES)
+      {
+	printf ("type%u %x %x %x %x\n", r->type, r->arg[0], r->arg[1],
+	    r->arg[2], r->arg[3]);
+	return;
+      }
+
+    printf ("%-12s", evtrace_formats[r->type].name);
+    for (i=0; i<4; i++)
+	switch (evtrace_formats[r->type].args[i])
+	  {
+	    case 'x':
+		printf (" 0x%x", r->arg[i]);
+		break;
+	    case 'd':
+		printf (" %u", r->arg[i]);
+		break;
+	    case 's':
+		for (j=0; j<4; j++)
+		  {
+		    name4[j] = (r->arg[i] >> (j*8)) & 255;
+		    if (name4[j] && (name4[j] < 32 || name4[j] > 126))
+			name4[j] = '?';
+		  }
+		name4[4] = '\0';
+		printf (" %s", name4);
+		break;
+	  }
+
+    printf ("\n");
+  }
+
+
+
+int evtrace_decode (char *filename, char *outfile)
+  {
+    /*
+     *	Read records from filename until there are no more, and either
+     *	print them or (if outfile is not NULL) save them to outfile.
+     */
+
+    struct evtrace_record *buf;
+    int fd, outfd = -1, n, i, nrecords = 0;
+
+    buf = malloc (sizeof(struct evtrace_record) * EVTRACE_NRECORDS);
+    if (!buf)
+      {
+	printf ("evtrace: out of memory\n");
+	return 1;
+      }
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0)
+      {
+	perror (filename);
+	return 1;
+      }
+
+    if (outfile)
+      {
+	outfd = open (outfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (outfd < 0)
+	  {
+	    perror (outfile);
+	    close (fd);
+	    return 1;
+	  }
+      }
+
+    while ((n = read (fd, buf, sizeof(struct evtrace_record)
+	* EVTRACE_NRECORDS)) > 0)
+      {
+	n /= sizeof(struct evtrace_record);
+	nrecords += n;
+
+	if (outfd >= 0)
+	  {
+	    if (write (outfd, buf, n * sizeof(struct evtrace_record)) < 0)
+	      {
+		perror (outfile);
+		break;
+	      }
+	  }
+	else
+	    for (i=0; i<n; i++)
+		evtrace_print (&buf[i]);
+      }
+
+    if (outfd >= 0)
+      {
+	close (outfd);
+	printf ("%i records saved to %s\n", nrecords, outfile);
+      }
+    else
+    if (!nrecords)
+	printf ("no events\n");
+
+    close (fd);
+    free (buf);
+    return 0;
+  }
+
+
+
+int main_evtrace (int argc, char *argv[])
+  {
+    char *filename = EVTRACE_PROCFILE, *outfile = NULL;
+    int i, fd;
+
+    if (argc > 1 && (!strcmp (argv[1], "start") || !strcmp (argv[1], "stop")
+	|| !strcmp (argv[1], "reset")))
+      {
+	fd = open (EVTRACE_PROCFILE, O_WRONLY);
+	if (fd < 0 || write (fd, argv[1], strlen(argv[1])) < 0)
+	  {
+	    perror (EVTRACE_PROCFILE);
+	    return 1;
+	  }
+	close (fd);
+	return 0;
+      }
+
+    for (i=1; i<argc; i++)
+      {
+	if (!strcmp (argv[i], "-f") && i+1 < argc)
+	    filename = argv[++i];
+	else
+	if (!strcmp (argv[i], "-o") && i+1 < argc)
+	    outfile = argv[++i];
+	else
+	  {
+	    printf ("usage: %s [start|stop|reset]\n"
+		"       %s [-f file] [-o file]\n", argv[0], argv[0]);
+	    return 1;
+	  }
+      }
+
+    return evtrace_decode (filename, outfile);
+  }
@@ -0,0 +1,249 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+
+/*
+ *  kprof  --  kernel profiler control and report
+ *
+ *	"kprof start", "kprof stop", "kprof reset" and "kprof pid N" are
+ *	passed on to /proc/kprof. Without a command, the kernel samples in
+ *	/proc/kprof are added up per function, using the kernel's link map
+ *	(the output of "nm -n yoctix"), and the busiest functions are
+ *	printed.
+ */
+
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+
+#define	KPROF_PROCFILE		"/proc/kprof"
+#define	KPROF_DEFAULTMAP	"/yoctix.map"
+#define	KPROF_DEFAULTLINES	25
+
+
+struct kprof_sym
+      {
+	unsigned long	addr;
+	char		*name;
+	unsigned long	count;
+      };
+
+struct kprof_sym *kprof_syms = NULL;
+int kprof_nsyms = 0;
+
+
+
+int kprof_loadmap (char *mapfile)
+  {
+    /*  Read text symbols from nm -n output. Returns 0 on success.  */
+
+    FILE *f;
+    char line [256], name [200], type;
+    unsigned long addr;
+    int allocated = 0;
+
+    f = fopen (mapfile, "r");
+    if (!f)
+	return -1;
+
+    while (fgets (line, sizeof(line), f))
+      {
+	if (sscanf (line, "%lx %c %199s", &addr, &type, name) != 3)
+	    continue;
+	if (type != 'T' && type != 't')
+	    continue;
+
+	if (kprof_nsyms >= allocated)
+	  {
+	    allocated = allocated? allocated*2 : 1024;
+	    kprof_syms = realloc (kprof_syms,
+		allocated * sizeof(struct kprof_sym));
+	    if (!kprof_syms)
+	      {
+		fclose (f);
+		return -1;
+	      }
+	  }
+
+	kprof_syms[kprof_nsyms].addr = addr;
+	kprof_syms[kprof_nsyms].name = strdup (name);
+	kprof_syms[kprof_nsyms].count = 0;
+	kprof_nsyms ++;
+      }
+
+    fclose (f);
+    return 0;
+  }
+
+
+
+struct kprof_sym *kprof_findsym (unsigned long addr)
+  {
+    /*  Binary search for the last symbol at or below addr:  */
+
+    int lo = 0, hi = kprof_nsyms - 1, mid;
+
+    if (kprof_nsyms == 0 || addr < kprof_syms[0].addr)
+	return NULL;
+
+    while (lo < hi)
+      {
+	mid = (lo + hi + 1) / 2;
+	if (kprof_syms[mid].addr <= addr)
+	    lo = mid;
+	else
+	    hi = mid - 1;
+      }
+
+    return &kprof_syms[lo];
+  }
+
+
+
+int kprof_cmpcount (const void *a, const void *b)
+  {
+    const struct kprof_sym *sa = a, *sb = b;
+
+    if (sa->count == sb->count)
+	return 0;
+    return sa->count < sb->count? 1 : -1;
+  }
+
+
+
+int kprof_report (char *mapfile, int lines)
+  {
+    FILE *f;
+    char line [256];
+    unsigned long addr, count, total = 0, unknown = 0;
+    struct kprof_sym *s;
+    int i;
+
+    if (kprof_loadmap (mapfile))
+      {
+	printf ("kprof: could not read %s\n", mapfile);
+	return 1;
+      }
+
+    f = fopen (KPROF_PROCFILE, "r");
+    if (!f)
+      {
+	perror (KPROF_PROCFILE);
+	return 1;
+      }
+
+    while (fgets (line, sizeof(line), f))
+      {
+	if (!strncmp (line, "kprof:", 6))
+	  {
+	    printf ("%s", line);
+	    continue;
+	  }
+
+	if (sscanf (line, "k %lx %lu", &addr, &count) != 2)
+	    continue;
+
+	total += count;
+	s = kprof_findsym (addr);
+	if (s)
+	    s->count += count;
+	else
+	    unknown += count;
+      }
+
+    fclose (f);
+
+    if (!total)
+      {
+	printf ("no kernel samples\n");
+	return 0;
+      }
+
+    qsort (kprof_syms, kprof_nsyms, sizeof(struct kprof_sym), kprof_cmpcount);
+
+    printf ("%8s %6s  %s\n", "samples", "%", "function");
+    for (i=0; i<kprof_nsyms && i<lines && kprof_syms[i].count; i++)
+	printf ("%8lu %6.2f  %s\n", kprof_syms[i].count,
+	    100.0 * kprof_syms[i].count / total, kprof_syms[i].name);
+
+    if (unknown)
+	printf ("%8lu %6.2f  (unknown)\n", unknown, 100.0 * unknown / total);
+
+    return 0;
+  }
+
+
+
+int main_kprof (int argc, char *argv[])
+  {
+    char *mapfile = KPROF_DEFAULTMAP;
+    int lines = KPROF_DEFAULTLINES;
+    char cmd [64];
+    int i, fd;
+
+    if (argc > 1 && (!strcmp (argv[1], "start") || !strcmp (argv[1], "stop")
+	|| !strcmp (argv[1], "reset") || !strcmp (argv[1], "pid")))
+      {
+	if (!strcmp (argv[1], "pid"))
+	  {
+	    if (argc < 3)
+	      {
+		printf ("usage: %s pid N\n", argv[0]);
+		return 1;
+	      }
+	    snprintf (cmd, sizeof(cmd), "pid %s", argv[2]);
+	  }
+	else
+	    snprintf (cmd, sizeof(cmd), "%s", argv[1]);
+
+	fd = open (KPROF_PROCFILE, O_WRONLY);
+	if (fd < 0 || write (fd, cmd, strlen(cmd)) < 0)
+	  {
+	    perror (KPROF_PROCFILE);
+	    return 1;
+	  }
+	close (fd);
+	return 0;
+      }
+
+    for (i=1; i<argc; i++)
+      {
+	if (!strcmp (argv[i], "-m") && i+1 < argc)
+	    mapfile = argv[++i];
+	else
+	if (!strcmp (argv[i], "-n") && i+1 < argc)
+	    lines = atoi (argv[++i]);
+	else
+	  {
+	    printf ("usage: %s [start|stop|reset|pid N]\n"
+		"       %s [-m mapfile] [-n lines]\n", argv[0], argv[0]);
+	    return 1;
+	  }
+      }
+
+    return kprof_report (mapfile, lines);
+  }
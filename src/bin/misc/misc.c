@@ -34,16 +34,26 @@
  *
  *  usage: date
  *      2 Dec 2000	First version.
+ *	19 Oct 2026	reads the time from the shared time page
+ *
+ *  usage: dmesg
+ *	19 Oct 2026	first version
  *
  *  usage: echo [-n] [string] [..]
  *      15 Oct 1999     First version.
  *
+ *  usage: evtrace [start|stop|reset]  or  evtrace [-f file] [-o file]
+ *	19 Oct 2026	first version
+ *
  *  usage: hdump filename [..]
  *      10 Feb 2001	--
  *
  *  usage: hostname [-s] [hostname_to_set]
  *      15 Oct 1999     First version.                      
  *
+ *  usage: kprof [start|stop|reset|pid N]  or  kprof [-m mapfile] [-n lines]
+ *	19 Oct 2026	first version
+ *
  *  usage: mkdir [-p] [-m mode] dirname [...]
  *	15 Oct 1999	first version
  *	11 Feb 2001	added into misc
@@ -85,9 +95,13 @@ struct command
 
 
 #include "cat.c"
+#include "dmesg.c"
+#include "evtrace.c"
 #include "hdump.c"
+#include "kprof.c"
 #include "mkdir.c"
 #include "ps.c"
+#include "timepage.c"
 
 
 
@@ -113,9 +127,16 @@ int main_date (int argc, char *argv[])
   {
     char buf[50];
     struct tm *tm;
+    struct timeval tv;
     time_t t;
 
-    t = time (NULL);
+    if (timepage_gettimeofday (&tv))
+      {
+	perror ("gettimeofday()");
+	return 1;
+      }
+
+    t = tv.tv_sec;
     tm = localtime (&t);
     strftime (buf, sizeof(buf), "%a %b %e %H:%M:%S %Z %Y", tm);
     printf ("%s\n", buf);
@@ -340,9 +361,12 @@ struct command commands[] =
 	{ "arch",	"",				main_arch  },
 	{ "cat",	"",				main_cat  },
 	{ "date",	"",				main_date  },
+	{ "dmesg",	"",				main_dmesg  },
 	{ "echo",	"[-n] [string] [..]",		main_echo  },
+	{ "evtrace",	"[start|stop|reset] | [-f file] [-o file]", main_evtrace  },
 	{ "hdump",	"filename [..]",		main_hdump  },
 	{ "hostname",	"[-s] [new_hosname]",		main_hostname  },
+	{ "kprof",	"[start|stop|reset|pid N] | [-m map] [-n lines]", main_kprof  },
 	{ "mkdir",	"[-p] [-m mode] dirname [...]",	main_mkdir  },
 	{ "ps",		"",				main_ps  },
 	{ "pwd",	"",				main_pwd  },
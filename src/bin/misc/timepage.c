@@ -0,0 +1,148 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+
+/*
+ *  timepage  --  gettimeofday() without a system call
+ *
+ *	The kernel maps a read-only page with the time at the last tick
+ *	into every process at TIMEPAGE_ADDR, and on i386 also the TSC
+ *	value at that tick and how to convert TSC cycles to nanoseconds.
+ *	timepage_gettimeofday() reads the page, and falls back to the
+ *	gettimeofday() system call if the page isn't there (an older
+ *	kernel, or a kernel which couldn't map it).
+ *
+ *	Whether the page is mapped is found out the first time, using
+ *	access(): it returns EFAULT for an unreadable address.
+ *
+ *	The page layout must match sys/timepage.h.
+ */
+
+
+#include <errno.h>
+#include <sys/time.h>
+
+
+#define	TIMEPAGE_ADDR		0xe0000000
+#define	TIMEPAGE_MAGIC		0x54696d65
+#define	TIMEPAGE_VERSION	1
+#define	TIMEPAGE_USERCLOCK	1
+
+
+struct timepage
+      {
+	u_int32_t	magic;
+	u_int32_t	version;
+	volatile u_int32_t seq;
+	u_int32_t	flags;
+	int32_t		sec;
+	int32_t		nsec;
+	u_int64_t	uptime;
+	u_int64_t	tickstamp;
+	u_int32_t	cycles_per_tick;
+	u_int32_t	mult;
+	u_int32_t	shift;
+	u_int32_t	tick_nsec;
+      };
+
+/*  NULL if not yet checked, -1 if there is no time page:  */
+struct timepage *timepage = NULL;
+
+
+
+struct timepage *timepage_find ()
+  {
+    struct timepage *tp = (struct timepage *) TIMEPAGE_ADDR;
+
+    if (access ((char *) tp, F_OK) < 0 && errno == EFAULT)
+	return (struct timepage *) -1;
+
+    if (tp->magic != TIMEPAGE_MAGIC || tp->version != TIMEPAGE_VERSION)
+	return (struct timepage *) -1;
+
+    return tp;
+  }
+
+
+
+u_int32_t timepage_phase (struct timepage *tp)
+  {
+    /*
+     *	Nanoseconds since the last tick, like timer_phase() in the
+     *	kernel. (0 if the TSC can't be used.)
+     */
+
+#ifdef __i386__
+    u_int64_t delta, tsc;
+
+    if (!(tp->flags & TIMEPAGE_USERCLOCK) || !tp->cycles_per_tick)
+	return 0;
+
+    __asm__ __volatile__ ("rdtsc" : "=A" (tsc));
+    delta = tsc - tp->tickstamp;
+    if (delta >= tp->cycles_per_tick)
+	return tp->tick_nsec - 1;
+
+    return (u_int32_t) ((delta * tp->mult) >> tp->shift);
+#else
+    return 0;
+#endif
+  }
+
+
+
+int timepage_gettimeofday (struct timeval *tv)
+  {
+    struct timepage *tp;
+    u_int32_t seq;
+    int32_t sec, nsec;
+
+    if (!timepage)
+	timepage = timepage_find ();
+    tp = timepage;
+
+    if (tp == (struct timepage *) -1)
+	return gettimeofday (tv, NULL);
+
+    /*  Retry if the kernel updated the page while we were reading it:  */
+    do
+      {
+	while ((seq = tp->seq) & 1)
+	    ;
+	sec = tp->sec;
+	nsec = tp->nsec + timepage_phase (tp);
+      } while (tp->seq != seq);
+
+    while (nsec >= 1000000000)
+      {
+	sec ++;
+	nsec -= 1000000000;
+      }
+
+    tv->tv_sec = sec;
+    tv->tv_usec = nsec / 1000;
+    return 0;
+  }
+
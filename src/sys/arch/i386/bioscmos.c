@@ -43,6 +43,8 @@
  *	17 Dec 1999	adding com/lpt stuff
  *	5 Jan 2000	cmos_read() and cmos_write() functions
  *	7 Jan 2000	actually registering bios? at mainbus0
+ *	19 Oct 2026	showing pending kernel messages before halting
+ *			or rebooting
  */
 
 
@@ -55,6 +57,7 @@
 #include <sys/module.h>
 #include <sys/arch/i386/pio.h>
 #include <sys/interrupts.h>
+#include <sys/msgbuf.h>
 
 
 
@@ -85,6 +88,7 @@ int bcd_to_int (int bcd)
 
 void machdep_halt ()
   {
+    msgbuf_flush ();
     asm ("cli\nhlt");
   }
 
@@ -96,6 +100,7 @@ void machdep_reboot ()
     int t2;
     int p=0x64,d=0xfe;
 
+    msgbuf_flush ();
     interrupts (DISABLE);
     for (t2=10; t2<1000000000; t2 *= 10)
       {
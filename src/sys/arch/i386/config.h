@@ -4,9 +4,21 @@
  */
 
 
-#define	MAX_PROCESSES		8186	/*  i386: max is 8192-6 = 8186  */
+/* #define	DUMPREGS_ON_PANIC */
 
 
-/* #define	DUMPREGS_ON_PANIC */
+/*
+ *  Use the i386 versions of memcpy(), memset(), strlen(), and strcmp()
+ *  in arch/i386/string*, instead of the portable ones in std/string.c:
+ */
 
+#define	MD_STRING_FUNCTIONS
+
+
+/*
+ *  Serial console:  Kernel messages are also written to this serial port
+ *  (0 = pccom0 = COM1), if the pccom module is configured.
+ */
 
+#define	PCCOM_CONSOLE		0
+#define	PCCOM_CONSOLE_SPEED	115200
@@ -94,6 +94,8 @@ int	console_current_offset = 0;		/*  for quicker updates  */
 int	console_nrofcolumns = 0;
 int	console_nroflines = 0;
 int	console_crtcbase = 0x3d0;		/*  0x3d0 for color, 0x3b0 for monochrome  */
+byte	*console_videomem = (byte *) 0;	/*  start of video memory  */
+int	console_startoffset = 0;		/*  CRTC start address (in chars)  */
 
 
 
@@ -110,7 +112,21 @@ void console_reset ()
      *	Called from console_init() and kdb_initconsole().
      */
 
-    int p = console_gethardwarecursorpos();
+    int p;
+
+    /*
+     *	pccon scrolls the screen by changing the CRTC start address, so
+     *	the visible screen doesn't necessarily begin at the start of
+     *	video memory:
+     */
+
+    outb (console_crtcbase+4, 0xc);
+    console_startoffset = inb (console_crtcbase+5);
+    outb (console_crtcbase+4, 0xd);
+    console_startoffset = console_startoffset*256 + inb (console_crtcbase+5);
+    console_screenbuffer = console_videomem + 2*console_startoffset;
+
+    p = console_gethardwarecursorpos();
     console_cursor_xpos = p % console_nrofcolumns;
     console_cursor_ypos = p / console_nrofcolumns;
 
@@ -154,12 +170,12 @@ void console_init ()
     if ((p[0] & 0x30) == 0x30)
       {
 	console_crtcbase = 0x3b0;
-	console_screenbuffer = (byte *) 0xb0000;
+	console_videomem = (byte *) 0xb0000;
       }
     else
       {   
 	console_crtcbase = 0x3d0;
-	console_screenbuffer = (byte *) 0xb8000;
+	console_videomem = (byte *) 0xb8000;
       }
 
     console_nrofcolumns = 80;
@@ -177,7 +193,7 @@ void console_sethardwarecursorpos ()
      *	-------------------------------
      */
 
-    int p = console_current_offset / 2;
+    int p = console_current_offset / 2 + console_startoffset;
 
     outb (console_crtcbase+4, 0xe);
     outb (console_crtcbase+5, p / 256);
@@ -202,7 +218,7 @@ int console_gethardwarecursorpos ()
     p = inb (console_crtcbase+5);
     outb (console_crtcbase+4, 0xf);
     p = p*256 + inb (console_crtcbase+5);
-    return p;
+    return p - console_startoffset;
   }
 
 
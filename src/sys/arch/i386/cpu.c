@@ -0,0 +1,242 @@
+/*
+ *  Copyright (C) 2001 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  arch/i386/cpu.c  --  i386 CPU identification
+ *
+ *	i386_cpu_identify() is called from machdep_res_init(). It uses the
+ *	cpuid instruction (if there is one) to find out who made the CPU
+ *	and which optional features it has. Other parts of the i386 code
+ *	should look at i386_cpu_features before using things like the TSC
+ *	or MMX.
+ *
+ *	i386_sysenter_init() enables the sysenter syscall entry point on
+ *	cpus which have it. It is called once the cpu's TSS exists.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ *	19 Oct 2026	i386_sysenter_init()
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/std.h>
+#include <sys/md/machdep.h>
+#include <sys/arch/i386/cpu.h>
+#include <sys/arch/i386/gdt.h>
+#include <sys/proc.h>
+#include <sys/arch/i386/syscall.h>
+
+
+u_int32_t	i386_cpu_features = 0;
+int		i386_cpu_family = 3;
+int		i386_cpu_model = 0;
+int		i386_cpu_stepping = 0;
+char		i386_cpu_vendor [13] = "unknown";
+int		i386_sysenter = 0;
+
+extern struct i386tss *i386_cputss;
+
+
+struct i386_cpu_featurename
+      {
+	u_int32_t	flag;
+	char		*name;
+      };
+
+struct i386_cpu_featurename i386_cpu_featurenames [] =
+      {
+	{  CPUID_FPU,	"fpu"  },
+	{  CPUID_TSC,	"tsc"  },
+	{  CPUID_MSR,	"msr"  },
+	{  CPUID_CX8,	"cx8"  },
+	{  CPUID_APIC,	"apic"  },
+	{  CPUID_SEP,	"sep"  },
+	{  CPUID_PGE,	"pge"  },
+	{  CPUID_CMOV,	"cmov"  },
+	{  CPUID_MMX,	"mmx"  },
+	{  CPUID_FXSR,	"fxsr"  },
+	{  CPUID_SSE,	"sse"  },
+	{  CPUID_SSE2,	"sse2"  },
+	{  0,		NULL  }
+      };
+
+
+void i386_string_init ();
+
+
+
+int i386_cpuid_supported ()
+  {
+    /*
+     *	The cpuid instruction exists if the ID flag (bit 21) in eflags
+     *	can be changed.
+     */
+
+    u_int32_t f1, f2;
+
+    __asm __volatile ("pushfl\n"
+	"popl	%0\n"
+	"movl	%0, %1\n"
+	"xorl	$0x200000, %0\n"
+	"pushl	%0\n"
+	"popfl\n"
+	"pushfl\n"
+	"popl	%0\n"
+	"pushl	%1\n"
+	"popfl" : "=&r" (f1), "=&r" (f2));
+
+    return ((f1 ^ f2) & 0x200000)? 1 : 0;
+  }
+
+
+
+void i386_cpuid (u_int32_t function, u_int32_t *regs)
+  {
+    /*
+     *	Execute cpuid.  regs[0..3] is set to eax, ebx, ecx, and edx.
+     */
+
+    __asm __volatile ("cpuid" : "=a" (regs[0]), "=b" (regs[1]),
+	"=c" (regs[2]), "=d" (regs[3]) : "a" (function));
+  }
+
+
+
+int i386_cpu_featurestobuf (char *buf, int buflen)
+  {
+    /*
+     *	Write a list of CPU features, such as "fpu tsc mmx", to buf.
+     *	Returns the number of features.
+     */
+
+    int i, n = 0;
+
+    buf[0] = '\0';
+    for (i=0; i386_cpu_featurenames[i].name; i++)
+	if (i386_cpu_features & i386_cpu_featurenames[i].flag)
+	  {
+	    snprintf (buf+strlen(buf), buflen-strlen(buf), "%s%s",
+		n? " " : "", i386_cpu_featurenames[i].name);
+	    n++;
+	  }
+
+    return n;
+  }
+
+
+
+void i386_cpu_identify ()
+  {
+    /*
+     *	i386_cpu_identify ()
+     *	--------------------
+     *
+     *	Fill in i386_cpu_* using cpuid. CPUs without cpuid are left as
+     *	"unknown" family 3 (386) or 4 (486) without any features.
+     *	Once we know what the CPU can do, the string functions can pick
+     *	the fastest implementation.
+     */
+
+    u_int32_t regs[4], cr0;
+
+    if (!i386_cpuid_supported ())
+      {
+	i386_cpu_family = 4;
+	return;
+      }
+
+    i386_cpuid (0, regs);
+    memcpy (i386_cpu_vendor + 0, &regs[1], 4);
+    memcpy (i386_cpu_vendor + 4, &regs[3], 4);
+    memcpy (i386_cpu_vendor + 8, &regs[2], 4);
+    i386_cpu_vendor[12] = '\0';
+
+    if (regs[0] < 1)
+	return;
+
+    i386_cpuid (1, regs);
+    i386_cpu_stepping = regs[0] & 15;
+    i386_cpu_model    = (regs[0] >> 4) & 15;
+    i386_cpu_family   = (regs[0] >> 8) & 15;
+    i386_cpu_features = regs[3];
+
+    /*  If the FPU is emulated, then MMX/SSE can not be used either:  */
+    __asm __volatile ("movl %%cr0, %0" : "=r" (cr0));
+    if (cr0 & 4)
+	i386_cpu_features &= ~(CPUID_FPU | CPUID_MMX | CPUID_FXSR
+		| CPUID_SSE | CPUID_SSE2);
+
+    /*  Early Pentium Pros claim to have sysenter, but don't:  */
+    if (i386_cpu_family == 6 && i386_cpu_model < 3 && i386_cpu_stepping < 3)
+	i386_cpu_features &= ~CPUID_SEP;
+
+    i386_string_init ();
+  }
+
+
+
+void i386_sysenter_init ()
+  {
+    /*
+     *	i386_sysenter_init ()
+     *	---------------------
+     *
+     *	sysenter is a lot cheaper than "int $0x80", since the cpu doesn't
+     *	have to look at the IDT or at any segment descriptors. It loads
+     *	cs from an MSR (and ss = cs+8), which matches SEL_CODE/SEL_DATA.
+     *
+     *	The esp MSR points to the esp0 field of the cpu's TSS. The entry
+     *	code loads the real kernel stack pointer from there, so that it
+     *	doesn't have to be updated on every process switch.
+     */
+
+    if (!(i386_cpu_features & CPUID_SEP) || !i386_cputss)
+	return;
+
+    i386_wrmsr (MSR_SYSENTER_CS, SEL_CODE);
+    i386_wrmsr (MSR_SYSENTER_ESP, (u_int32_t) &i386_cputss->esp0);
+    i386_wrmsr (MSR_SYSENTER_EIP, (u_int32_t) &arch_sysenterasm);
+
+    i386_sysenter = 1;
+  }
+
+
+
+
+u_int64_t machdep_cyclecounter ()
+  {
+    /*
+     *	Return the value of the time stamp counter, or 0 on CPUs
+     *	which don't have one.
+     */
+
+    if (!(i386_cpu_features & CPUID_TSC))
+	return 0;
+
+    return i386_rdtsc ();
+  }
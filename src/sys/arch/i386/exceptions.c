@@ -29,17 +29,23 @@
  *	When an exception occurs, we need to handle it. Usually, this means
  *	killing the process causing the exception.
  *
- *	Page fault exceptions are handled by vm_fault().
+ *	Page fault exceptions are handled by vm_fault(). Device-not-available
+ *	exceptions give the FPU to the process which wants it (see fpu.c).
  *
  *  History:
  *	24 Oct 1999	first version
  *	?? 2000		page fault stuff
+ *	19 Oct 2026	write faults in page tables write protected by fork()
+ *	19 Oct 2026	no per-process TSS any more
+ *	19 Oct 2026	device-not-available (#NM) handler for lazy FPU
+ *			switching
  */
 
 
 #include "../config.h"
 #include <string.h>
 #include <sys/std.h>
+#include <sys/malloc.h>
 #include <sys/proc.h>
 #include <sys/vm.h>
 #include <sys/interrupts.h>
@@ -53,6 +59,12 @@
 extern byte *idt;
 extern volatile struct proc *curproc;
 extern size_t userland_startaddr;
+extern u_int32_t i386_cr3;
+
+extern struct proc *i386_fpu_owner;
+extern int i386_fpu_ts, i386_fpu_present;
+extern u_int32_t i386_fpu_traps;
+extern byte *i386_fpu_initstate;
 
 
 void exception0_asm();
@@ -133,6 +145,9 @@ u_int32_t machdep_pagefaulthandler (size_t linearaddr, int errorcode)
      *	linearaddr is the linear address. (Yeah, really! :-)
      *	To convert it to a userland address, we subtract the userland
      *	starting address.
+     *
+     *	The return value is loaded into cr3 (flushing the TLB) by the
+     *	asm code.
      */
 
     struct proc *p;
@@ -144,11 +159,73 @@ u_int32_t machdep_pagefaulthandler (size_t linearaddr, int errorcode)
     printk ("pagefault pid %i linearaddr %x errorcode %x", p->pid, linearaddr, errorcode);
 #endif
 
+    /*  A write to a page table which was write protected by fork()?  */
+    if ((errorcode & 3) == 3 &&
+	pmap_cowfault (p, linearaddr - userland_startaddr))
+	return i386_cr3;
+
     vm_fault (p, linearaddr - userland_startaddr,
 	((errorcode&2)? VM_PAGEFAULT_WRITE : VM_PAGEFAULT_READ)
 	+ ((errorcode&1)? 0 : VM_PAGEFAULT_NOTPRESENT) );
 
-    return p->md.tss->cr3;
+    return i386_cr3;
+  }
+
+
+
+void machdep_fpuhandler ()
+  {
+    /*
+     *	machdep_fpuhandler ()
+     *	---------------------
+     *
+     *	Called (with interrupts disabled) when curproc uses the FPU while
+     *	CR0.TS is set. Save the current owner's state, and give the FPU
+     *	to curproc.
+     */
+
+    struct proc *p;
+    ret_t tmp_result;
+
+    p = (struct proc *) curproc;
+    if (!p)
+	panic ("machdep_fpuhandler: FPU used by the kernel");
+
+    i386_fpu_traps ++;
+
+    if (!i386_fpu_present)
+      {
+	printk ("pid %i: no FPU", p->pid);
+	interrupts (ENABLE);
+	sys_exit (&tmp_result, p, 0);
+	panic ("machdep_fpuhandler: not reached");
+      }
+
+    /*  The first time p uses the FPU, it gets a fresh state:  */
+    if (!p->md.fpustate)
+      {
+	p->md.fpustate = malloc (I386_FPUSTATE_SIZE);
+	if (!p->md.fpustate)
+	  {
+	    printk ("pid %i: out of memory for FPU state", p->pid);
+	    interrupts (ENABLE);
+	    sys_exit (&tmp_result, p, 0);
+	    panic ("machdep_fpuhandler: not reached");
+	  }
+	memcpy (p->md.fpustate, i386_fpu_initstate, I386_FPUSTATE_SIZE);
+      }
+
+    __asm __volatile ("clts");
+    i386_fpu_ts = 0;
+
+    if (i386_fpu_owner == p)
+	return;
+
+    if (i386_fpu_owner)
+	i386_fpu_save (i386_fpu_owner);
+
+    i386_fpu_restore (p);
+    i386_fpu_owner = p;
   }
 
 
@@ -171,7 +248,7 @@ void machdep_exceptionhandler (int nr, int a,int b,int c,int d,int e, int f,int
     interrupts (ENABLE);
 
     printk ("exception #%i pid %i cs:eip=%Y:%x stack %x %x %x %x %x %x %x %x %x %x %x %x %x", nr, curproc->pid,
-	curproc->md.tss->cs, curproc->md.tss->eip, a,b,c,d,e,f,g,h,i,j,k,l,m);
+	I386_FRAME(p)->cs, I386_FRAME(p)->eip, a,b,c,d,e,f,g,h,i,j,k,l,m);
 
     sys_exit (&tmp_result, p, 0);
 
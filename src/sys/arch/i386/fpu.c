@@ -0,0 +1,227 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  arch/i386/fpu.c  --  lazy FPU/SSE context switching
+ *
+ *	The FPU (and SSE) registers are not saved and restored on every
+ *	context switch. Instead, i386_fpu_owner is the process whose state
+ *	is in the FPU right now, and machdep_pswitch() sets CR0.TS when
+ *	switching to any other process. The first FPU instruction of that
+ *	process then causes a device-not-available exception (#NM), and
+ *	machdep_fpuhandler() saves the owner's state, loads the process'
+ *	own state, and makes it the new owner. Processes which never touch
+ *	the FPU never trap, and have no saved state at all. (The #NM handler
+ *	is machdep_fpuhandler() in exceptions.c.)
+ *
+ *	The state is saved with fxsave/fxrstor if the cpu has them (which
+ *	includes the SSE registers), otherwise with fnsave/frstor.
+ *
+ *	i386_fpu_init ()
+ *		Detect the FPU, and enable fxsave and SSE.
+ *
+ *	i386_fpu_save (), i386_fpu_restore ()
+ *		Save or load the FPU state of a process.
+ *
+ *	i386_fpu_fork ()
+ *		Give a child process a copy of the parent's FPU state.
+ *
+ *	i386_fpu_release ()
+ *		Forget a process' FPU state. (On exec and exit.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/proc.h>
+#include <sys/arch/i386/machdep.h>
+#include <sys/arch/i386/cpu.h>
+
+
+extern volatile struct proc *curproc;
+
+
+/*  The process whose state is in the FPU:  (one per cpu)  */
+struct proc *i386_fpu_owner = NULL;
+
+/*  Non-zero if CR0.TS is known to be set:  */
+int i386_fpu_ts = 0;
+
+int i386_fpu_present = 0;
+u_int32_t i386_fpu_traps = 0;
+
+/*  The state of a freshly initialized FPU, given to new users:  */
+byte *i386_fpu_initstate = NULL;
+
+
+
+void i386_fpu_save (struct proc *p)
+  {
+    /*  Save the FPU state into p's save area. TS must be clear.  */
+
+    if (i386_cpu_features & CPUID_FXSR)
+	__asm __volatile ("fxsave (%0)" : : "r" (p->md.fpustate) : "memory");
+    else
+	__asm __volatile ("fnsave (%0)" : : "r" (p->md.fpustate) : "memory");
+  }
+
+
+
+void i386_fpu_restore (struct proc *p)
+  {
+    /*  Load p's saved state into the FPU. TS must be clear.  */
+
+    if (i386_cpu_features & CPUID_FXSR)
+	__asm __volatile ("fxrstor (%0)" : : "r" (p->md.fpustate));
+    else
+	__asm __volatile ("frstor (%0)" : : "r" (p->md.fpustate));
+  }
+
+
+
+void i386_fpu_settrap ()
+  {
+    /*  Set CR0.TS, so that the next FPU instruction traps:  */
+
+    __asm __volatile ("movl %%cr0, %%eax; orl $8, %%eax; movl %%eax, %%cr0"
+	: : : "eax");
+    i386_fpu_ts = 1;
+  }
+
+
+
+void i386_fpu_init ()
+  {
+    /*
+     *	i386_fpu_init ()
+     *	----------------
+     *
+     *	Check that there is an FPU (fninit should give a zero status
+     *	word), turn on fxsave/fxrstor and SSE support in CR4 if the cpu
+     *	has them, and remember what a freshly initialized FPU looks like.
+     *	Called from machdep_res_init(), after i386_cpu_identify().
+     */
+
+    u_int32_t cr0, cr4;
+    u_int16_t status = 0xffff;
+
+    __asm __volatile ("movl %%cr0, %0" : "=r" (cr0));
+    if (cr0 & 4)
+	return;
+
+    __asm __volatile ("clts");
+    __asm __volatile ("fninit; fnstsw %0" : "=m" (status));
+    if (status != 0)
+      {
+	i386_fpu_settrap ();
+	return;
+      }
+
+    if (i386_cpu_features & CPUID_FXSR)
+      {
+	__asm __volatile ("movl %%cr4, %0" : "=r" (cr4));
+	cr4 |= 0x200;				/*  OSFXSR  */
+	if (i386_cpu_features & CPUID_SSE)
+	    cr4 |= 0x400;			/*  OSXMMEXCPT  */
+	__asm __volatile ("movl %0, %%cr4" : : "r" (cr4));
+      }
+
+    /*  malloc() returns blocks aligned to their size, as fxsave wants:  */
+    i386_fpu_initstate = (byte *) malloc (I386_FPUSTATE_SIZE);
+    if (!i386_fpu_initstate)
+      {
+	i386_fpu_settrap ();
+	return;
+      }
+
+    memset (i386_fpu_initstate, 0, I386_FPUSTATE_SIZE);
+    if (i386_cpu_features & CPUID_FXSR)
+	__asm __volatile ("fxsave (%0)" : : "r" (i386_fpu_initstate)
+	    : "memory");
+    else
+	__asm __volatile ("fnsave (%0)" : : "r" (i386_fpu_initstate)
+	    : "memory");
+
+    i386_fpu_present = 1;
+    i386_fpu_settrap ();
+  }
+
+
+
+void i386_fpu_fork (struct proc *parent, struct proc *child)
+  {
+    /*
+     *	Give child a copy of parent's FPU state. (If there is not enough
+     *	memory, the child gets a fresh state when it first uses the FPU.)
+     *	Interrupts should be disabled.
+     */
+
+    if (!parent->md.fpustate)
+	return;
+
+    /*  The parent's state may only be in the FPU. (fnsave also resets
+	the FPU, so let the parent trap and load it again.)  */
+    if (i386_fpu_owner == parent)
+      {
+	__asm __volatile ("clts");
+	i386_fpu_save (parent);
+	i386_fpu_owner = NULL;
+	i386_fpu_settrap ();
+      }
+
+    child->md.fpustate = malloc (I386_FPUSTATE_SIZE);
+    if (child->md.fpustate)
+	memcpy (child->md.fpustate, parent->md.fpustate,
+	    I386_FPUSTATE_SIZE);
+  }
+
+
+
+void i386_fpu_release (struct proc *p)
+  {
+    /*
+     *	Forget p's FPU state. If p is running, its next FPU instruction
+     *	will trap and get a fresh state. Interrupts should be disabled.
+     */
+
+    if (i386_fpu_owner == p)
+      {
+	i386_fpu_owner = NULL;
+	if (p == curproc && !i386_fpu_ts)
+	    i386_fpu_settrap ();
+      }
+
+    if (p->md.fpustate)
+      {
+	free (p->md.fpustate);
+	p->md.fpustate = NULL;
+      }
+  }
+
@@ -30,6 +30,7 @@
  *	22 Oct 1999	first version
  *	24 Oct 1999	minor changes
  *	28 Dec 1999	fixed minor bugs
+ *	19 Oct 2026	no TSS descriptors for processes, only one for the cpu
  */
 
 
@@ -95,15 +96,12 @@ void gdt_init ()
      *		2: Kernel DATA descriptor
      *		3: User CODE descriptor
      *		4: User DATA descriptor
-     *		5: Dummy TSS descriptor
-     *		6: ...		(one TSS descriptor for each process)
+     *		5: The cpu's TSS descriptor
      */
 
     size_t sz;
 
-    sz = 8 * (6 + MAX_PROCESSES);
-    if (sz > 65536)
-	panic ("gdt_init(): MAX_PROCESSES set too high");
+    sz = 8 * GDT_NENTRIES;
     gdt = i386_lowalloc (sz);
 
 
@@ -32,14 +32,18 @@
  *
  *  History:
  *	8 Dec 2000	working (print and getch). One cmd so far: dumpcmos
+ *	19 Oct 2026	strbench
  */
 
 
 #include "../config.h"
 #include <sys/arch/i386/machdep.h>
 #include <sys/arch/i386/pio.h>
+#include <sys/arch/i386/cpu.h>
 #include <sys/std.h>
+#include <sys/malloc.h>
 #include <string.h>
+#include <stdio.h>
 #include <sys/console.h>
 
 
@@ -47,11 +51,19 @@
 extern int console_cursor_color;
 extern int console_cursor_xpos;
 
+#ifdef MD_STRING_FUNCTIONS
+/*  The portable versions, from std/string.c:  */
+void *std_memset (void *, int, size_t);
+void *std_memcpy (void *, void *, size_t);
+size_t std_strlen (char *);
+#endif
+
 
 
 struct kdb_command kdb_machdep_cmds [] =
       {
 	{  "dumpcmos",	"Dump cmos data",	kdb_machdep_dumpcmos  },
+	{  "strbench",	"Benchmark memcpy/memset/strlen",	kdb_machdep_strbench  },
 	{  NULL,	NULL,			NULL  }
       };
 
@@ -80,6 +92,80 @@ void kdb_machdep_dumpcmos (char *cmdline)
 
 
 
+void kdb_machdep_strbench (char *cmdline)
+  {
+    /*
+     *	Compare the i386 string functions with the portable ones in
+     *	std/string.c, for sizes from 16 bytes to 64 KB. The numbers
+     *	printed are the average number of cycles per call (TSC).
+     */
+
+#ifdef MD_STRING_FUNCTIONS
+    char buf [KDB_MAXCMDLINE];
+    byte *a, *b;
+    u_int64_t t0, t1, t2, t3, t4, t5, t6;
+    size_t size;
+    int i, n;
+
+    if (!(i386_cpu_features & CPUID_TSC))
+      {
+	kdb_print ("strbench: the cpu has no TSC\n");
+	return;
+      }
+
+    a = (byte *) malloc (65536 + 4);
+    b = (byte *) malloc (65536 + 4);
+    if (!a || !b)
+      {
+	kdb_print ("strbench: out of memory\n");
+	if (a)  free (a);
+	if (b)  free (b);
+	return;
+      }
+
+    memset (b, 'x', 65536);
+
+    for (size=16; size<=65536; size*=4)
+      {
+	n = 262144 / size;
+	if (n < 16)
+	    n = 16;
+
+	b[size] = '\0';
+
+	t0 = i386_rdtsc ();
+	for (i=0; i<n; i++)  memcpy (a+1, b, size);
+	t1 = i386_rdtsc ();
+	for (i=0; i<n; i++)  std_memcpy (a+1, b, size);
+	t2 = i386_rdtsc ();
+	for (i=0; i<n; i++)  memset (a+1, i, size);
+	t3 = i386_rdtsc ();
+	for (i=0; i<n; i++)  std_memset (a+1, i, size);
+	t4 = i386_rdtsc ();
+	for (i=0; i<n; i++)  strlen ((char *)b);
+	t5 = i386_rdtsc ();
+	for (i=0; i<n; i++)  std_strlen ((char *)b);
+	t6 = i386_rdtsc ();
+
+	b[size] = 'x';
+
+	snprintf (buf, sizeof(buf), "%i bytes: memcpy %i (std %i)  memset %i (std %i)  strlen %i (std %i)\n",
+		(int)size,
+		(int)((t1-t0)/n), (int)((t2-t1)/n),
+		(int)((t3-t2)/n), (int)((t4-t3)/n),
+		(int)((t5-t4)/n), (int)((t6-t5)/n));
+	kdb_print (buf);
+      }
+
+    free (a);
+    free (b);
+#else
+    kdb_print ("strbench: MD_STRING_FUNCTIONS is not defined\n");
+#endif
+  }
+
+
+
 void kdb_print (char *s)
   {
     if (!s)
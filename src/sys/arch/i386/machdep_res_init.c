@@ -41,6 +41,10 @@
  *	21 Oct 1999	removed call to cmos_init()
  *	5 Jan 2000	actually registering cpu0 at mainbus0, but no
  *			detection of cpu type yet...
+ *	19 Oct 2026	cpu identification using cpuid (arch/i386/cpu.c)
+ *	19 Oct 2026	the dummy TSS is now the cpu's only TSS
+ *	19 Oct 2026	FPU initialization
+ *	19 Oct 2026	TSC calibration (i386_tsc_init)
  */
 
 
@@ -48,6 +52,7 @@
 #include <sys/arch/i386/machdep.h>
 #include <sys/arch/i386/pio.h>
 #include <sys/arch/i386/gdt.h>
+#include <sys/arch/i386/cpu.h>
 #include <sys/std.h>
 #include <sys/timer.h>
 #include <sys/interrupts.h>
@@ -59,6 +64,7 @@
 
 
 extern struct timespec system_time;
+extern struct i386tss *i386_cputss;
 
 
 void i386_settask (int nr, struct i386tss *tss);
@@ -85,27 +91,35 @@ int machdep_res_init ()
      *
      *		o)  Identify the CPU
      *		o)  Identify the BIOS
-     *		o)  Setup a dummy TSS
+     *		o)  Setup the cpu's TSS
      *		o)  Setup system_time
      */
 
     struct module *m;
     char buf [80];
-    struct i386tss *dummytss;
 
 
     /*
      *	Identify the CPU:
-     *
-     *	TODO:  actually perform a true cpu identification...
      */
 
+    i386_cpu_identify ();
+
     m = module_register ("mainbus0", MODULETYPE_SYSTEM | MODULETYPE_BUILTIN |
 		MODULETYPE_NUMBERED, "cpu", "Processor");
     module_nametobuf (m, buf, 80);
-    snprintf (buf+strlen(buf), 80-strlen(buf), ": i386");
+    snprintf (buf+strlen(buf), 80-strlen(buf), ": %s family %i model %i step %i",
+	i386_cpu_vendor, i386_cpu_family, i386_cpu_model, i386_cpu_stepping);
     printk ("%s", buf);
 
+    if (i386_cpu_featurestobuf (buf, 80))
+	printk ("%s: %s", m->shortname, buf);
+
+    i386_fpu_init ();
+
+    /*  Use the TSC as clocksource, if there is one:  */
+    i386_tsc_init ();
+
 
     /*
      *	Identify the BIOS:
@@ -115,15 +129,20 @@ int machdep_res_init ()
 
 
     /*
-     *	Set up a dummy TSS:  (The i386 needs to have an "old" TSS when
-     *	we switch tasks, so that the current processor state can be
-     *	saved away somewhere.)
+     *	Set up the cpu's TSS:  (The cpu loads ss0:esp0 from it when
+     *	entering the kernel from userland. esp0 is set by machdep_pswitch().
+     *	The I/O permission bitmap is outside the TSS, so userland has no
+     *	access to any ports.)
      */
 
-    dummytss = (struct i386tss *) malloc (sizeof(struct i386tss));
-    memset (dummytss, 0, sizeof(struct i386tss));
-    i386_settask (5, (struct i386tss *) dummytss);
-    i386_ltr (5);
+    i386_cputss = (struct i386tss *) malloc (sizeof(struct i386tss));
+    memset (i386_cputss, 0, sizeof(struct i386tss));
+    i386_cputss->ss0 = SEL_DATA;
+    i386_cputss->iobase = sizeof(struct i386tss);
+    i386_settask (SEL_CPUTSS/8, i386_cputss);
+    i386_ltr (SEL_CPUTSS/8);
+
+    i386_sysenter_init ();
 
 
     /*
@@ -25,6 +25,16 @@
 
 /*
  *  arch/i386/pmap.c  --  i386 specific physical memory mapping stuff
+ *
+ *	Copy-on-write after fork() is set up lazily: pmap_markpages_cow()
+ *	only clears the write bit of the page directory entries, and the
+ *	page table entries are write protected by pmap_cowfault() on the
+ *	first write fault within each 4 MB page table.
+ *
+ *	The TLB has to be flushed when mappings are removed or write
+ *	protected in the loaded page directory. (That is not necessarily
+ *	curproc's: kernel threads, and vfork() children, run in another
+ *	process' address space.)
  */
 
 
@@ -39,9 +49,12 @@
 #include <sys/arch/i386/machdep.h>
 #include <sys/arch/i386/proc.h>
 #include <sys/arch/i386/gdt.h>
+#include <sys/arch/i386/cpu.h>
 
 
 extern size_t userland_startaddr;
+extern volatile struct proc *curproc;
+extern u_int32_t i386_cr3;
 
 
 int pmap_mappage (struct proc *p, size_t virtualaddr, byte *a_page, u_int32_t region_type)
@@ -148,11 +161,110 @@ int pmap_markpages_cow (struct proc *p, size_t startaddr, size_t endaddr)
      *	endaddr of process p as non-writable. startaddr and endaddr are
      *	userland addresses.
      *
+     *	Only the write bit of the page directory entries is removed, so
+     *	the cost depends on the number of page tables, not on the number
+     *	of pages. A page table may also map writable MAP_SHARED regions,
+     *	which are not copy-on-write; the first write to one of them just
+     *	takes an extra fault, where pmap_cowfault() write protects only
+     *	the copy-on-write regions' pages and makes the page table
+     *	writable again.
+     *
      *	Return 1 on success, 0 on failure.
      */
 
-    /*  Remove "write" bit from all pages:  */
-    return pmap_markpages (p, startaddr, endaddr, 2);
+    size_t *pagedir;
+    int pdentrynr, lastpdentrynr;
+
+    if (!p || startaddr>=endaddr)
+	return 0;
+
+    if (endaddr >= 0xffffffff-userland_startaddr)
+      endaddr = 0xffffffff-userland_startaddr;
+
+    pagedir = p->md.pagedir;
+    pdentrynr = ((startaddr + userland_startaddr) >> 22) & 1023;
+    lastpdentrynr = ((endaddr + userland_startaddr) >> 22) & 1023;
+
+    for (; pdentrynr <= lastpdentrynr; pdentrynr++)
+	if (pagedir[pdentrynr] & 1)
+	    pagedir[pdentrynr] &= ~2;
+
+    /*  Old TLB entries may still allow writes:  */
+    if ((u_int32_t) p->md.pagedir == i386_cr3)
+	asm ("movl %%cr3, %%eax; movl %%eax, %%cr3": : : "eax");
+
+    return 1;
+  }
+
+
+
+int pmap_cowfault (struct proc *p, size_t virtualaddr)
+  {
+    /*
+     *	pmap_cowfault ()
+     *	----------------
+     *
+     *	Called on write faults, before vm_fault(). If the page table
+     *	covering virtualaddr was write protected by pmap_markpages_cow(),
+     *	then remove the write bit from the page table entries of all
+     *	copy-on-write regions within the page table instead, and make the
+     *	page directory entry writable again. The faulting instruction
+     *	will then fault again (on the page table entry) if the page
+     *	itself is copy-on-write.
+     *
+     *	Returns 1 if the page table was fixed up, 0 otherwise.
+     */
+
+    size_t *pagedir;
+    size_t start, end, first, last;
+    int pdentrynr;
+    struct vm_region *region;
+
+    pagedir = p->md.pagedir;
+    pdentrynr = ((virtualaddr + userland_startaddr) >> 22) & 1023;
+
+    if ((pagedir[pdentrynr] & 3) != 1)
+	return 0;
+
+    /*  Userland address range covered by the page table:  */
+    start = ((size_t) pdentrynr << 22) - userland_startaddr;
+    end = start + 4*1024*1024 - 1;
+
+    for (region=p->vmregions; region; region=region->next)
+      {
+	if (!(region->type & VMREGION_COW) || region->end_addr < start
+	    || region->start_addr > end)
+		continue;
+
+	first = region->start_addr > start? region->start_addr : start;
+	last = region->end_addr < end? region->end_addr : end;
+	pmap_markpages (p, first, last, 2);
+      }
+
+    pagedir[pdentrynr] |= 2;
+    return 1;
+  }
+
+
+
+int pmap_writeprotect (struct proc *p, size_t startaddr, size_t endaddr)
+  {
+    /*
+     *	Remove write access from all pages from address startaddr upto
+     *	(and including) endaddr of process p. (Used to catch the next
+     *	write to a page of a shared file mapping which has been written
+     *	back.)
+     *
+     *	Return 1 on success, 0 on failure.
+     */
+
+    if (!pmap_markpages (p, startaddr, endaddr, 2))
+	return 0;
+
+    if ((u_int32_t) p->md.pagedir == i386_cr3)
+	asm ("movl %%cr3, %%eax; movl %%eax, %%cr3": : : "eax");
+
+    return 1;
   }
 
 
@@ -167,7 +279,14 @@ int pmap_unmappages (struct proc *p, size_t startaddr, size_t endaddr)
      */
 
     /*  Remove all access bits from the pages:  */
-    return pmap_markpages (p, startaddr, endaddr, 7);
+    if (!pmap_markpages (p, startaddr, endaddr, 7))
+	return 0;
+
+    /*  The pages may be freed and reused, so no TLB entries may remain:  */
+    if ((u_int32_t) p->md.pagedir == i386_cr3)
+	asm ("movl %%cr3, %%eax; movl %%eax, %%cr3": : : "eax");
+
+    return 1;
   }
 
 
@@ -199,3 +318,46 @@ int pmap_mapped (struct proc *p, size_t virtualaddr)
     return 1;
   }
 
+
+
+
+int pmap_referenced (struct proc *p, size_t virtualaddr)
+  {
+    /*
+     *	Return 1 if the page at virtualaddr in process p is mapped and
+     *	has been accessed since the last call, 0 otherwise. The accessed
+     *	bit is cleared, and if p's page directory is loaded, then the
+     *	page's TLB entry is flushed so that the next access sets the bit
+     *	again.
+     */
+
+    size_t *pagedir;
+    size_t *pagetable;
+    int pdentrynr, ptentrynr;
+
+    virtualaddr += userland_startaddr;
+    pagedir = p->md.pagedir;
+    pdentrynr = (virtualaddr >> 22) & 1023;
+    ptentrynr = (virtualaddr >> 12) & 1023;
+
+    if (!(pagedir[pdentrynr] & 7))
+	return 0;
+
+    pagetable = (size_t *) ((u_int32_t)pagedir[pdentrynr] & 0xfffff000);
+
+    if (!(pagetable[ptentrynr] & 7) || !(pagetable[ptentrynr] & 0x20))
+	return 0;
+
+    pagetable[ptentrynr] &= ~0x20;
+
+    if ((u_int32_t) p->md.pagedir == i386_cr3)
+      {
+	/*  (invlpg is not available on the 386)  */
+	if (i386_cpu_family >= 4)
+	    asm ("invlpg (%0)": : "r" (virtualaddr) : "memory");
+	else
+	    asm ("movl %%cr3, %%eax; movl %%eax, %%cr3": : : "eax");
+      }
+
+    return 1;
+  }
@@ -26,17 +26,31 @@
 /*
  *  arch/i386/proc.c  --  i386 specific process handling functions
  *
- *	The i386 processor family has a multitasking concept based around
- *	something called "tasks". Each task is described by a "tss" -- task
- *	state segment. If you are not familiar with the tss concept, you
- *	should read one of Intel's books on the subject, for example
- *	"80386 System Software Writers Guide".
+ *	Processes are switched in software. There is only one TSS (task
+ *	state segment) per cpu, and the only thing the cpu uses it for is
+ *	finding the kernel stack (ss0:esp0) when entering the kernel from
+ *	userland. machdep_pswitch() updates esp0, and then calls
+ *	i386_swtch() (swtch_asm.S) which saves the callee-saved registers
+ *	and the stack pointer of the old process, and restores those of
+ *	the new process. The user mode registers of a process are always
+ *	in a struct i386frame at the top of its kernel stack.
  *
- *	Unix processes can be mapped into the i386 "task" representation --
- *	this is the way I do it right now -- but this is not neccessary. A
- *	different approach would be to use "software processes" where the CPU's
- *	register copying functions etc have to be emulated in software. There
- *	are good and bad aspects on both approaches.
+ *	cr3 is only reloaded when the new process uses a different page
+ *	directory than the one currently loaded. Kernel threads don't have
+ *	a page directory of their own, and run in whatever address space
+ *	was loaded before them.
+ *
+ *	The FPU is switched lazily, see fpu.c.
+ *
+ *	A process which has never run is given a kernel stack which looks
+ *	like it was switched away from, with a return address pointing to
+ *	i386_proc_trampoline (which irets to userland using the register
+ *	frame) or i386_kthread_trampoline.
+ *
+ *  History:
+ *	19 Oct 2026	software context switch, instead of one hardware
+ *			task (TSS and GDT descriptor) per process
+ *	19 Oct 2026	lazy FPU switching
  */
 
 
@@ -56,18 +70,43 @@
 extern volatile struct proc *procqueue [];
 extern volatile struct proc *curproc;
 extern u_int32_t *i386_kernel_pagedir;
+extern u_int32_t i386_cr3;
 extern size_t userland_startaddr;
-extern byte *gdt;
+extern struct proc *i386_fpu_owner;
+extern int i386_fpu_ts;
+
+
+/*  See swtch_asm.S  */
+void i386_swtch (u_int32_t *oldkesp, u_int32_t newkesp, u_int32_t newcr3);
+void i386_pstart (u_int32_t newkesp);
+void i386_proc_trampoline ();
+void i386_kthread_trampoline ();
+
+
+/*  The cpu's TSS (set up by machdep_res_init()):  */
+struct i386tss *i386_cputss = NULL;
 
+/*  Where the boot context's stack pointer is saved on the first switch:  */
+u_int32_t i386_boot_kesp;
 
-/*  See task.c  */
-void i386_settask (int nr, struct i386tss *tss);
-void i386_ltr (int nr);
-void i386_jmptss (int nr);
 
 
-/*  A hint for finding the next free TSS slot in the GDT:  */
-int next_free_tss = I386_FIRSTTSS;
+u_int32_t i386_switchframe (u_int32_t *stack, void (*start)())
+  {
+    /*
+     *	Push what i386_swtch() expects to find on a kernel stack below
+     *	'stack' (callee-saved registers, and start() as the return
+     *	address). Returns the new stack pointer.
+     */
+
+    *(--stack) = (u_int32_t) start;
+    *(--stack) = 0;		/*  ebp  */
+    *(--stack) = 0;		/*  ebx  */
+    *(--stack) = 0;		/*  esi  */
+    *(--stack) = 0;		/*  edi  */
+
+    return (u_int32_t) stack;
+  }
 
 
 
@@ -114,102 +153,72 @@ int machdep_proc_init (struct proc *p)
      *	Returns 1 on success, 0 on failure.
      */
 
-    struct i386tss *tss;
     u_int32_t *pagedir;
     void *kstack;
-    int i, found;
-
-
-    /*	Is there actually any speed increase to use a
-	whole page for the TSS??? Probably not... */
-    tss = (struct i386tss *) malloc (sizeof(struct i386tss));
-    if (!tss)
-	return 0;
 
     pagedir = (u_int32_t *) malloc (PAGESIZE);
     if (!pagedir)
-      {
-	free (tss);
 	return 0;
-      }
 
     kstack = (void *) malloc (KSTACK_SIZE);
     if (!kstack)
       {
 	free (pagedir);
-	free (tss);
 	return 0;
       }
 
-    p->md.tss = tss;
     p->md.pagedir = pagedir;
     p->md.kstack = kstack;
 
-
     /*
-     *  Initialize the tss
-     *	==================
-     *
-     *	Flags need to have IF (Interrupts Enable) turned on when switching
-     *	between multiple tasks.
-     *
-     *	cs,ds,es,ss actually use the same address range, but different
-     *	segments because data is not executable and so on. The "+3" in cs
-     *	and ss are there to allow the process to run at all. (This is one
-     *	of the worst "bugs" I have encountered when dealing with this stuff.)
-     *
-     *	The process' cr3 register should point to its pagedir.
-     *
-     *	ss0:esp0 should point to the process' kernel stack, which is used
-     *	whenever the process needs to jump into kernel mode (syscalls,
-     *	timer interrupts etc).
+     *	esp0 is where the cpu puts the user mode registers when the
+     *	process enters the kernel (syscalls, interrupts etc). The process
+     *	can't be switched to until something (machdep_fork(),
+     *	machdep_kthread_init() or an emulation's startproc) has set up
+     *	its kernel stack.
      */
 
-    memset (tss, 0, sizeof (struct i386tss));
-    tss->eflags = 0x00000202;
-    tss->ds = SEL_USERDATA;
-    tss->es = SEL_USERDATA;
-    tss->ss = SEL_USERDATA + 3;
-    tss->cs = SEL_USERCODE + 3;
-    tss->cr3 = (u_int32_t) pagedir;
-    tss->ss0 = SEL_DATA;
-    tss->esp0 = (u_int32_t) kstack + KSTACK_SIZE - KSTACK_MARGIN;
+    p->md.esp0 = (u_int32_t) kstack + KSTACK_SIZE - KSTACK_MARGIN;
+    p->md.kesp = 0;
+    p->md.cr3 = (u_int32_t) pagedir;
+    p->md.fpustate = NULL;
+
+    machdep_pagedir_init (p);
+
+    return 1;
+  }
+
 
 
+int machdep_kthread_init (struct proc *p, void (*func)())
+  {
     /*
-     *  Initialize the page directory.
+     *	machdep_kthread_init ()
+     *	-----------------------
+     *
+     *	Set up the kernel stack of a process (allocated by
+     *	machdep_proc_init()) so that it runs func() in kernel mode, with
+     *	interrupts enabled. A kernel thread only touches kernel memory,
+     *	so its page directory is freed, and it runs in whatever address
+     *	space is loaded.
+     *
+     *	Returns 1 on success, 0 on failure.
      */
 
-    machdep_pagedir_init (p);
-
+    u_int32_t *stack;
 
-    /*  Find a free TSS slot (present bit == 0):  */
-    i = next_free_tss;
-    found = 0;
-    while (!found)
-      {
-	if ((gdt[8*i+5] & 128) == 0)
-	  found = i;
-	else
-	  {
-	    i++;
-	    if (i >= MAX_PROCESSES+I386_FIRSTTSS)
-		i = I386_FIRSTTSS;
-	    if (i == next_free_tss)
-		panic ("machdep_proc_init(): no free TSS slots in GDT");
-	  }
-      }
+    if (!p || !p->md.kstack)
+	return 0;
 
-/*
-    printk ("using tss %i", found);
-*/
+    machdep_proc_freemaps (p);
+    p->md.cr3 = 0;
 
-    p->md.tss_nr = found;
-    i386_settask (found, tss);
+    /*  A zero return address, in case func() returns:  */
+    stack = (u_int32_t *) p->md.esp0;
+    *(--stack) = 0;
+    *(--stack) = (u_int32_t) func;
 
-    next_free_tss = found + 1;
-    if (next_free_tss >= MAX_PROCESSES+I386_FIRSTTSS)
-	next_free_tss = I386_FIRSTTSS;
+    p->md.kesp = i386_switchframe (stack, i386_kthread_trampoline);
 
     return 1;
   }
@@ -220,7 +229,8 @@ int machdep_proc_freemaps (struct proc *p)
   {
     /*
      *	Free memory occupied by process p's pagetables
-     *	and page directory.
+     *	and page directory. p is left with the kernel's pagedir. (If the
+     *	pagedir is loaded, the kernel's pagedir is loaded instead.)
      *	Returns 1 on success, 0 on failure.
      */
 
@@ -230,6 +240,14 @@ int machdep_proc_freemaps (struct proc *p)
     pagedir = p->md.pagedir;
     if (pagedir)
       {
+	if ((u_int32_t) pagedir == i386_cr3)
+	  {
+	    i386_cr3 = (u_int32_t) i386_kernel_pagedir;
+	    asm ("movl %%eax, %%cr3": : "a" (i386_cr3));
+	  }
+
+	p->md.cr3 = (u_int32_t) i386_kernel_pagedir;
+
 	for (i=(userland_startaddr/(4*1024*1024)); i<1024; i++)
 	  {
 	    pagetable = (size_t *) ((u_int32_t)pagedir[i] & 0xfffff000);
@@ -245,6 +263,58 @@ int machdep_proc_freemaps (struct proc *p)
 
 
 
+void machdep_proc_borrowmaps (struct proc *p, struct proc *from)
+  {
+    /*
+     *	machdep_proc_borrowmaps ()
+     *	--------------------------
+     *
+     *	Free p's own pagedir and pagetables, and let p run in from's
+     *	address space instead. Used by vfork(): the child runs in the
+     *	parent's address space until it calls execve() or exits, and
+     *	then calls machdep_proc_returnmaps().
+     */
+
+    machdep_proc_freemaps (p);
+
+    p->md.pagedir = from->md.pagedir;
+    p->md.cr3 = (u_int32_t) p->md.pagedir;
+  }
+
+
+
+int machdep_proc_returnmaps (struct proc *p)
+  {
+    /*
+     *	machdep_proc_returnmaps ()
+     *	--------------------------
+     *
+     *	Stop using a borrowed address space, and give p an empty pagedir
+     *	of its own. (If that fails, p is left with the kernel's pagedir,
+     *	which is enough for exiting.)
+     *
+     *	Returns 1 on success, 0 on failure.
+     */
+
+    size_t *pagedir;
+
+    pagedir = (size_t *) malloc (PAGESIZE);
+    p->md.pagedir = pagedir;
+
+    if (!pagedir)
+      {
+	p->md.cr3 = (u_int32_t) i386_kernel_pagedir;
+	return 0;
+      }
+
+    machdep_pagedir_init (p);
+    p->md.cr3 = (u_int32_t) pagedir;
+
+    return 1;
+  }
+
+
+
 int machdep_proc_remove (struct proc *p)
   {
     /*
@@ -258,8 +328,7 @@ int machdep_proc_remove (struct proc *p)
     if (!p)
 	return 0;
 
-    /*  Free the Task State Segment:  */
-    free (p->md.tss);
+    i386_fpu_release (p);
 
     /*  Free pagedir and all pagetables:  */
     machdep_proc_freemaps (p);
@@ -267,66 +336,82 @@ int machdep_proc_remove (struct proc *p)
     /*  Free the kernel stack associated with this process:  */
     free (p->md.kstack);
 
-    /*  Mark the TSS entry in the GDT as not-present:  */
-    gdt [8*p->md.tss_nr+5] &= 127;
-
     return 1;
   }
 
 
 
-void machdep_setkerneltaskaddr (void *kernelcode)
+void machdep_pswitch (struct proc *p)
   {
     /*
-     *	Ugly hack: this function sets up a dummy tss with
-     *	kernel privileges (using eip == kernelcode) and jumps
-     *	to it.
+     *	machdep_pswitch ()
+     *	------------------
      *
-     *	TODO:  This function is probably not used anymore...
+     *	Set curproc to the new process 'p' and switch to it.
+     *	(Only switch to the new process if it is not already running.)
+     *	Interrupts should be disabled.
      */
 
-    static struct i386tss *dummy_tss = NULL;
-    static byte *dummy_stack = NULL;
-
-    if (!dummy_tss)
-	dummy_tss = (struct i386tss *) malloc (sizeof(struct i386tss));
-
-    if (!dummy_stack)
-	dummy_stack = (byte *) malloc (KSTACK_SIZE);
-
-    memset (dummy_tss, 0, sizeof(struct i386tss));
-    dummy_tss->eflags = 0x00000002;
-    dummy_tss->cs   = SEL_CODE;
-    dummy_tss->ds   = SEL_DATA;
-    dummy_tss->es   = SEL_DATA;
-    dummy_tss->ss   = SEL_DATA;
-    dummy_tss->esp  = (u_int32_t) dummy_stack + KSTACK_SIZE - KSTACK_MARGIN;
-    dummy_tss->ss0  = SEL_DATA;
-    dummy_tss->esp0 = (u_int32_t) dummy_stack + KSTACK_SIZE - KSTACK_MARGIN;
-    dummy_tss->cr3  = (u_int32_t) i386_kernel_pagedir;
-    dummy_tss->eip  = (u_int32_t) kernelcode;
-
-    i386_settask (SEL_DUMMYTSS/8, dummy_tss);
-    i386_jmptss (SEL_DUMMYTSS/8);
+    struct proc *old;
+    u_int32_t cr3;
+
+    if (curproc == p)
+	return;
+
+    old = (struct proc *) curproc;
+    curproc = p;
+
+    i386_cputss->esp0 = p->md.esp0;
+
+    /*  Let the FPU trap, unless p's state is already in it:  */
+    if (p == i386_fpu_owner)
+      {
+	if (i386_fpu_ts)
+	  {
+	    asm ("clts");
+	    i386_fpu_ts = 0;
+	  }
+      }
+    else
+	if (!i386_fpu_ts)
+	    i386_fpu_settrap ();
+
+    /*  Don't reload cr3 (and flush the TLB) unless we have to:  */
+    cr3 = p->md.cr3;
+    if (cr3 == i386_cr3)
+	cr3 = 0;
+    if (cr3)
+	i386_cr3 = cr3;
+
+    i386_swtch (old? &old->md.kesp : &i386_boot_kesp, p->md.kesp, cr3);
   }
 
 
 
-void machdep_pswitch (struct proc *p)
+void i386_proc_start (struct proc *p)
   {
     /*
-     *	machdep_pswitch ()
+     *	i386_proc_start ()
      *	------------------
      *
-     *	Set curproc to the new process 'p' and jump to it.
-     *	(Only switch to the new process if it is not already running.)
+     *	Start running p in userland, using the register frame at the top
+     *	of its kernel stack. Used by execve() when the new program has been
+     *	loaded: whatever is running now (p itself, or the boot context when
+     *	process 1 is started) is thrown away. The new program starts
+     *	with a fresh FPU state. Doesn't return.
      */
 
-    if (curproc != p)
-      {
-	curproc = p;
-	i386_jmptss (p->md.tss_nr);
-      }
+    interrupts (DISABLE);
+
+    i386_fpu_release (p);
+
+    curproc = p;
+    i386_cputss->esp0 = p->md.esp0;
+    i386_cr3 = p->md.cr3;
+    asm ("movl %%eax, %%cr3": : "a" (i386_cr3));
+
+    i386_pstart (i386_switchframe ((u_int32_t *) I386_FRAME(p),
+	i386_proc_trampoline));
   }
 
 
@@ -337,45 +422,32 @@ int machdep_fork (struct proc *parent, struct proc *child)
      *	machdep_fork ()
      *	---------------
      *
-     *	Super-ugly hack, because I don't know how to do this any other
-     *	way. Anyway, the point of this function is to do the actual
-     *	low-level split-up of the parent process and return the child PID
-     *	to the parent and zero to the child.
+     *	Do the actual low-level split-up of the parent process: set up
+     *	the child's kernel stack so that the child returns zero from the
+     *	fork() syscall when it is first switched to, and return the child
+     *	PID to the parent.
      *
      *	Should be called with interrupts disabled.
      */
 
-    u_int32_t *parentstack;
+    struct i386frame *frame;
 
     /*
-     *	Re-setup child's tss to point to child's userland; restore
-     *	registers to what they were when the parent fork() syscall was
-     *	issued, but set eax to zero.
+     *	The child returns to userland with the same registers as the
+     *	parent had when the fork() syscall was issued, but with eax
+     *	(the return value) and the carry flag (error) cleared.
      */
 
-    memset (child->md.tss, 0, sizeof(struct i386tss));
-    parentstack = (u_int32_t *) parent->md.tss->esp0;
-
-    child->md.tss->esp0 = (u_int32_t) child->md.kstack + KSTACK_SIZE - KSTACK_MARGIN;
-    child->md.tss->ss0 = SEL_DATA;
-    child->md.tss->cr3 = (u_int32_t) child->md.pagedir;
-    child->md.tss->eip = parentstack[-5];
-    child->md.tss->eflags = parentstack[-3] & 0xfffffffe;
-    child->md.tss->eax = 0;	/*  parent's eax is at parentstack[-6], but   */
-				/*  we want to return 0 to the child process  */
-    child->md.tss->ecx = parentstack[-8];
-    child->md.tss->edx = parentstack[-9];
-    child->md.tss->ebx = parentstack[-7];
-    child->md.tss->esp = parentstack[-2];
-    child->md.tss->ebp = parentstack[-10];
-    child->md.tss->esi = parentstack[-11];
-    child->md.tss->edi = parentstack[-12];
-    child->md.tss->ds = (u_int16_t) parentstack[-13];
-    child->md.tss->es = (u_int16_t) parentstack[-14];
-    child->md.tss->fs = (u_int16_t) parentstack[-15];
-    child->md.tss->gs = (u_int16_t) parentstack[-16];
-    child->md.tss->cs = (u_int16_t) parentstack[-4];
-    child->md.tss->ss = (u_int16_t) parentstack[-1];
+    frame = I386_FRAME(child);
+    memcpy (frame, I386_FRAME(parent), sizeof(struct i386frame));
+    frame->eax = 0;
+    frame->eflags &= 0xfffffffe;
+
+    i386_fpu_fork (parent, child);
+
+    child->md.cr3 = (u_int32_t) child->md.pagedir;
+    child->md.kesp = i386_switchframe ((u_int32_t *) frame,
+	i386_proc_trampoline);
 
 
     /*  Add child to runqueue:  */
@@ -28,6 +28,8 @@
  *
  *  History:
  *	15 Sep 2000	first version
+ *	19 Oct 2026	registers are found at p->md.esp0, there is no
+ *			per-process TSS any more
  */
 
 
@@ -62,7 +64,7 @@ int machdep_sigreturn (struct proc *p, struct sigcontext *scp)
 printk ("in machdep_sigreturn (p->pid=%i, scp=0x%x)", p->pid, scp);
 
     scp = (struct sigcontext *) ((byte *)scp + userland_startaddr);
-    pstack = (u_int32_t *) p->md.tss->esp0;
+    pstack = (u_int32_t *) p->md.esp0;
 
     pstack[ -1] = scp->ss;
     pstack[ -2] = scp->esp;
@@ -112,8 +114,9 @@ int machdep_sigtramp (struct proc *p, void *codeptr, int signr)
      *	called.
      *
      *	There are two cases we have to handle -- if p is curproc, then we
-     *	need to get cpu register values from p's kernel stack, otherwise
-     *	we'll find them in p->md.tss.
+     *	need to get cpu register values from p's kernel stack. Otherwise
+     *	they are on p's kernel stack too, but p may have been interrupted
+     *	in userland, and then the layout is different.
      *
      *	Read signal_asm.S for more info on arch_sigtramp_asmcode.
      *
@@ -148,7 +151,7 @@ printk ("machdep_sigtramp (p->pid=%i codeptr=0x%x)", p->pid, codeptr);
 	printk ("  machdep_sigtramp(): p==curproc");
 */
 
-	pstack = (u_int32_t *) p->md.tss->esp0;
+	pstack = (u_int32_t *) p->md.esp0;
 
 	ss  = pstack[-1];
 	esp = pstack[-2];
@@ -170,23 +173,8 @@ printk ("machdep_sigtramp (p->pid=%i codeptr=0x%x)", p->pid, codeptr);
     else
       {
 	printk ("  machdep_sigtramp(): p!=curproc (not yet implemented, TODO)");
-return EINVAL;
-	eax = p->md.tss->eax;
-	ebx = p->md.tss->ebx;
-	ecx = p->md.tss->ecx;
-	edx = p->md.tss->edx;
-	esi = p->md.tss->esi;
-	edi = p->md.tss->edi;
-	ebp = p->md.tss->ebp;
-	esp = p->md.tss->esp;
-	eip = p->md.tss->eip;
-	eflags = p->md.tss->eflags;
-	cs = p->md.tss->cs;
-	ds = p->md.tss->ds;
-	es = p->md.tss->es;
-	fs = p->md.tss->fs;
-	gs = p->md.tss->gs;
-	ss = p->md.tss->ss;
+	interrupts (oldints);
+	return EINVAL;
       }
 
 /*
@@ -237,7 +225,7 @@ printk ("about to trampoline pid=%i, cs:eip=0x%Y:0x%x esp=0x%x ebp=0x%x eflags=0
 	printk ("  machdep_sigtramp(): (2) p==curproc");
 */
 
-	pstack = (u_int32_t *) p->md.tss->esp0;
+	pstack = (u_int32_t *) p->md.esp0;
 
 	pstack[-2] = esp;				/*  esp  */
 	pstack[-5] = esp;				/*  eip  */
@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2001 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  arch/i386/string.c  --  i386 string functions
+ *
+ *	strlen() and strcmp() look at a dword at a time. An aligned dword
+ *	load never crosses a page boundary, so it is safe to read a few
+ *	bytes past the terminating nul.
+ *
+ *	i386_memcpy_simd() is called by memcpy() (arch/i386/string_asm.S)
+ *	for large copies, if i386_string_init() found MMX. The FPU state is
+ *	saved with fnsave around each chunk, with interrupts disabled so
+ *	that nobody else can touch the FPU (or set CR0.TS by switching
+ *	tasks) in the middle of it. Copies to or from userland never come
+ *	here, since a page fault could sleep in the middle of the copy.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/interrupts.h>
+#include <sys/arch/i386/cpu.h>
+
+#ifdef	MD_STRING_FUNCTIONS
+
+
+/*  Copy at most this much with interrupts disabled:  */
+#define	SIMD_CHUNK		16384
+
+/*  Use non-temporal stores (which bypass the cache) at this size:  */
+#define	SIMD_NONTEMPORAL_MIN	32768
+
+/*  Size of the fnsave area:  */
+#define	FNSAVE_SIZE		108
+
+#define	SIMDMODE_NONE		0
+#define	SIMDMODE_MMX		1
+#define	SIMDMODE_SSE		2
+
+int i386_memcpy_simdmode = SIMDMODE_NONE;
+
+/*  True if a dword contains a zero byte:  */
+#define	HASZERO(w)	(((w) - 0x01010101) & ~(w) & 0x80808080)
+
+
+
+void i386_string_init ()
+  {
+    /*
+     *	Called by i386_cpu_identify() once i386_cpu_features is known.
+     */
+
+    if (i386_cpu_features & CPUID_SSE)
+	i386_memcpy_simdmode = SIMDMODE_SSE;
+    else
+    if (i386_cpu_features & CPUID_MMX)
+	i386_memcpy_simdmode = SIMDMODE_MMX;
+  }
+
+
+
+void *i386_memcpy_simd (void *dst, void *src, size_t len)
+  {
+    /*
+     *	Copy len bytes from src to dst using MMX registers, 64 bytes per
+     *	loop iteration. The blocks may not overlap, and must both be in
+     *	kernel memory. (memcpy() checks that.)
+     */
+
+    byte *d = (byte *) dst;
+    byte *s = (byte *) src;
+    byte fpustate [FNSAVE_SIZE];
+    u_int32_t cr0;
+    size_t n, chunk;
+    int oldints, nontemporal;
+
+    nontemporal = (i386_memcpy_simdmode == SIMDMODE_SSE
+	&& len >= SIMD_NONTEMPORAL_MIN);
+
+    /*  Align the destination to 8 bytes:  */
+    n = (-(size_t)d) & 7;
+    memcpy (d, s, n);
+    d += n;  s += n;  len -= n;
+
+    while (len >= 64)
+      {
+	chunk = len & ~63;
+	if (chunk > SIMD_CHUNK)
+	    chunk = SIMD_CHUNK;
+	n = chunk / 64;
+
+	oldints = interrupts (DISABLE);
+	__asm __volatile ("movl %%cr0, %0" : "=r" (cr0));
+	__asm __volatile ("clts");
+	__asm __volatile ("fnsave %0" : "=m" (fpustate));
+
+	if (nontemporal)
+	    __asm __volatile ("1:\n"
+		"prefetchnta 256(%0)\n"
+		"movq	(%0), %%mm0\n"
+		"movq	8(%0), %%mm1\n"
+		"movq	16(%0), %%mm2\n"
+		"movq	24(%0), %%mm3\n"
+		"movq	32(%0), %%mm4\n"
+		"movq	40(%0), %%mm5\n"
+		"movq	48(%0), %%mm6\n"
+		"movq	56(%0), %%mm7\n"
+		"movntq	%%mm0, (%1)\n"
+		"movntq	%%mm1, 8(%1)\n"
+		"movntq	%%mm2, 16(%1)\n"
+		"movntq	%%mm3, 24(%1)\n"
+		"movntq	%%mm4, 32(%1)\n"
+		"movntq	%%mm5, 40(%1)\n"
+		"movntq	%%mm6, 48(%1)\n"
+		"movntq	%%mm7, 56(%1)\n"
+		"addl	$64, %0\n"
+		"addl	$64, %1\n"
+		"decl	%2\n"
+		"jnz	1b\n"
+		"sfence" : "+r" (s), "+r" (d), "+r" (n) : : "memory");
+	else
+	    __asm __volatile ("1:\n"
+		"movq	(%0), %%mm0\n"
+		"movq	8(%0), %%mm1\n"
+		"movq	16(%0), %%mm2\n"
+		"movq	24(%0), %%mm3\n"
+		"movq	32(%0), %%mm4\n"
+		"movq	40(%0), %%mm5\n"
+		"movq	48(%0), %%mm6\n"
+		"movq	56(%0), %%mm7\n"
+		"movq	%%mm0, (%1)\n"
+		"movq	%%mm1, 8(%1)\n"
+		"movq	%%mm2, 16(%1)\n"
+		"movq	%%mm3, 24(%1)\n"
+		"movq	%%mm4, 32(%1)\n"
+		"movq	%%mm5, 40(%1)\n"
+		"movq	%%mm6, 48(%1)\n"
+		"movq	%%mm7, 56(%1)\n"
+		"addl	$64, %0\n"
+		"addl	$64, %1\n"
+		"decl	%2\n"
+		"jnz	1b" : "+r" (s), "+r" (d), "+r" (n) : : "memory");
+
+	__asm __volatile ("frstor %0" : : "m" (fpustate));
+	__asm __volatile ("movl %0, %%cr0" : : "r" (cr0));
+	interrupts (oldints);
+
+	len -= chunk;
+      }
+
+    /*  The remaining 0..63 bytes:  */
+    memcpy (d, s, len);
+
+    return dst;
+  }
+
+
+
+size_t strlen (char *s)
+  {
+    char *p = s;
+    u_int32_t w;
+
+    while ((size_t)p & 3)
+      {
+	if (!*p)
+	    return p - s;
+	p++;
+      }
+
+    while (1)
+      {
+	w = *(u_int32_t *)p;
+	if (HASZERO(w))
+	    break;
+	p += 4;
+      }
+
+    while (*p)
+	p++;
+
+    return p - s;
+  }
+
+
+
+int strcmp (unsigned char *s1, unsigned char *s2)
+  {
+    u_int32_t w1, w2;
+
+    if (!s1 || !s2)
+      {
+	printk ("strcmp: NULL ptr");
+	return 1;
+      }
+
+    /*  Compare dwords if both strings have the same alignment:  */
+    if ((((size_t)s1 ^ (size_t)s2) & 3) == 0)
+      {
+	while ((size_t)s1 & 3)
+	  {
+	    if (*s1 != *s2)
+		return (*s1 < *s2)? -1 : 1;
+	    if (!*s1)
+		return 0;
+	    s1++, s2++;
+	  }
+
+	while (1)
+	  {
+	    w1 = *(u_int32_t *)s1;
+	    w2 = *(u_int32_t *)s2;
+	    if (w1 != w2 || HASZERO(w1))
+		break;
+	    s1 += 4, s2 += 4;
+	  }
+      }
+
+    /*  Find the exact difference (or end) one byte at a time:  */
+    while (*s1 == *s2)
+      {
+	if (!*s1)
+	    return 0;
+	s1++, s2++;
+      }
+
+    return (*s1 < *s2)? -1 : 1;
+  }
+
+
+#else	/*  !MD_STRING_FUNCTIONS  */
+
+
+void i386_string_init ()
+  {
+  }
+
+
+#endif	/*  !MD_STRING_FUNCTIONS  */
@@ -25,6 +25,13 @@
 
 /*
  *  arch/i386/task.c  --  i386 task related functions
+ *
+ *	Processes are switched in software (see proc.c), so the only task
+ *	is the cpu's TSS, which is needed to find the kernel stack.
+ *
+ *  History:
+ *	19 Oct 2026	removed i386_jmptss(), hardware task switching is
+ *			no longer used
  */
 
 
@@ -64,38 +71,10 @@ void i386_ltr (int nr)
      *	-----------
      *
      *	The ltr instruction loads the task register with a specific value.
-     *	It can be used before any process is started to tell the CPU where
-     *	to save away the current cpu registers on the first task switch.
+     *	It is used once, to tell the CPU where its TSS is.
      */
 
     nr *= 8;
     asm ("ltr %%ax": : "a" (nr));
   }
 
-
-
-void i386_jmptss (int nr)
-  {
-    /*
-     *	i386_jmptss ()
-     *	--------------
-     *
-     *	Switch to task nr 'nr'. Whenever "this" task (the one that is
-     *	executing the ljmp instruction) is restarted, cs:eip points to
-     *	the instruction immediately following the ljmp. (In other words,
-     *	we return from i386_jmptss()...)
-     */
-
-    unsigned char buf[6];
-
-    nr *= 8;
-    buf[0]=0;
-    buf[1]=0;
-    buf[2]=0;
-    buf[3]=0;
-    buf[4]=nr & 255;
-    buf[5]=nr >> 8;
-
-    asm ("ljmp (%%eax)": : "a" (&buf));
-  }
-
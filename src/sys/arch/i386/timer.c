@@ -28,6 +28,9 @@
  *
  *  History:
  *	28 Dec 1999	first version
+ *	19 Oct 2026	kernel profiler clock (timer or RTC)
+ *	19 Oct 2026	TSC clocksource, and one-shot interrupts from the
+ *			PIT in the middle of a tick
  */
 
 
@@ -40,6 +43,9 @@
 #include <sys/arch/i386/gdt.h>
 #include <sys/arch/i386/pio.h>
 #include <sys/arch/i386/pic.h>
+#include <sys/kprof.h>
+#include <sys/md/machdep.h>
+#include <sys/arch/i386/cpu.h>
 
 
 extern byte *idt;
@@ -49,9 +55,31 @@ extern volatile ticks_t system_ticks;
 
 int switchratio = 1;
 
+/*  The PIT's input clock, and the count it uses for one tick:  */
+#define	I386_PIT_HZ		1193182
+u_int32_t i386_pit_divisor;
+
+/*  One-shots closer than this (in PIT clocks) are not worth it:  */
+#define	I386_PIT_MINCOUNT	20
+
+u_int64_t i386_tsc_read ();
+
+struct clocksource i386_tsc_clocksource =
+      {  "tsc",  i386_tsc_read,  0,  0,  CLOCKSOURCE_USERREAD  };
+
 void timer_asm ();
 void timer ();
 
+#ifdef KPROF
+/*  Set when timer_asm should pass samples to the profiler:  */
+volatile int i386_kprof_tick = 0;
+
+void irq8_asm ();
+void i386_kprof_rtc_asm ();
+int cmos_read (int pos);
+void cmos_write (int pos, int value);
+#endif
+
 
 void machdep_timer_init ()
   {
@@ -64,7 +92,9 @@ void machdep_timer_init ()
      *		(o)  Prepare an entry for our timer routine in the IDT.
      *
      *		(o)  Program the 8253 PIT (Programmable Interval
-     *			Timer) to trigger HZ times per second.
+     *			Timer) to trigger HZ times per second. (Mode 2,
+     *			so that the count can be read back, and changed
+     *			by machdep_timer_oneshot().)
      *
      *		(o)  Enable interrupts (turn on the system timer).
      */
@@ -88,12 +118,12 @@ void machdep_timer_init ()
 		IDT_TYPE_INTERRUPTGATE, 0);
 
     /*  Set frequency of the 8253 PIT to HZ:  */
-    v = 1193180;  /*  or is it 1192500 ???  */
-    v /= HZ;
+    v = I386_PIT_HZ / HZ;
+    i386_pit_divisor = v;
 
-    outb (0x43, 0x36);
-    outb (0x40, v % 255);
-    outb (0x40, v / 256);
+    outb (0x43, 0x34);
+    outb (0x40, v & 255);
+    outb (0x40, v >> 8);
 
     pic_setmask (0);
 
@@ -104,3 +134,199 @@ void machdep_timer_init ()
   }
 
 
+
+u_int64_t i386_tsc_read ()
+  {
+    return i386_rdtsc ();
+  }
+
+
+
+void i386_tsc_init ()
+  {
+    /*
+     *	i386_tsc_init ()
+     *	----------------
+     *
+     *	Count the number of TSC cycles during one tick, and use the TSC
+     *	as the clocksource. The tick is measured with PIT channel 2 (the
+     *	speaker channel, with the speaker turned off), which doesn't
+     *	interrupt. Called after cpu identification.
+     */
+
+    u_int64_t t1, t2, best = 0;
+    int i, oldints, port61;
+
+    if (!(i386_cpu_features & CPUID_TSC))
+	return;
+
+    oldints = interrupts (DISABLE);
+    port61 = inb (0x61);
+
+    /*  Measure a few times, and keep the shortest:  */
+    for (i=0; i<3; i++)
+      {
+	/*  Gate on, speaker off; channel 2 in mode 0 (one-shot):  */
+	outb (0x61, (port61 & ~0x02) | 0x01);
+	outb (0x43, 0xb0);
+	outb (0x42, i386_pit_divisor & 255);
+	outb (0x42, i386_pit_divisor >> 8);
+
+	t1 = i386_rdtsc ();
+	while ((inb (0x61) & 0x20) == 0)
+	    ;
+	t2 = i386_rdtsc ();
+
+	if (!best || t2 - t1 < best)
+	    best = t2 - t1;
+      }
+
+    outb (0x61, port61);
+    interrupts (oldints);
+
+    if (!best || best >= 0x80000000)
+	return;
+
+    i386_tsc_clocksource.cycles_per_tick = (u_int32_t) best;
+    timer_setclocksource (&i386_tsc_clocksource);
+  }
+
+
+
+int machdep_timer_oneshot (u_int32_t nsec)
+  {
+    /*
+     *	machdep_timer_oneshot ()
+     *	------------------------
+     *
+     *	Make the PIT interrupt once more, nsec nanoseconds after the last
+     *	tick (which is less than one tick). The counter is restarted with
+     *	the remaining count until then, and the rest of the tick is
+     *	written as the next count, so the ticks that follow stay in
+     *	phase. machdep_timer_oneshot_done() puts back the normal count.
+     *
+     *	Returns 1 if the interrupt was arranged, 0 if it is too close (or
+     *	a tick is already pending). Interrupts should be disabled.
+     */
+
+    u_int32_t d, e, c;
+
+    /*  nsec to PIT clocks:  (1193182 / 10^9 = 5124677 / 2^32)  */
+    d = (u_int32_t) (((u_int64_t) nsec * 5124677) >> 32);
+
+    /*  Latch and read counter 0:  */
+    outb (0x43, 0x00);
+    c = inb (0x40);
+    c |= inb (0x40) << 8;
+    e = i386_pit_divisor - c;
+
+    /*  Has the counter already wrapped? (IRQ 0 in the PIC's IRR)  */
+    outb (0x20, 0x0a);		/*  master PIC: read IRR  */
+    if (inb (0x20) & 1)
+	return 0;
+
+    if (d + I386_PIT_MINCOUNT >= i386_pit_divisor
+	|| d < e + I386_PIT_MINCOUNT)
+	return 0;
+
+    outb (0x43, 0x34);
+    outb (0x40, (d-e) & 255);
+    outb (0x40, (d-e) >> 8);
+    outb (0x40, (i386_pit_divisor-d) & 255);
+    outb (0x40, (i386_pit_divisor-d) >> 8);
+
+    return 1;
+  }
+
+
+
+void machdep_timer_oneshot_done ()
+  {
+    /*  Whole ticks again, after the rest of this one:  */
+
+    outb (0x40, i386_pit_divisor & 255);
+    outb (0x40, i386_pit_divisor >> 8);
+  }
+
+
+
+#ifdef KPROF
+void i386_kprof_sample (u_int32_t eip, u_int32_t cs)
+  {
+    /*  Called by timer_asm or i386_kprof_rtc_asm with the interrupted
+	eip and cs. (User eips are relative to the userland segment.)  */
+
+    kprof_sample ((size_t) eip, (cs & 3) == 3);
+  }
+
+
+
+void machdep_kprof_range (size_t *lowpc, size_t *highpc)
+  {
+    /*
+     *	The kernel's text starts at 0x100000 (including the a.out header)
+     *	and its length is in the header's a_text field.
+     */
+
+    byte *p = (byte *) 0x100000;
+
+    *lowpc = 0x100000;
+    *highpc = 0x100000 + (p[4] + p[5]*256 + p[6]*65536 + p[7]*16777216);
+  }
+
+
+
+int machdep_kprof_start ()
+  {
+    /*
+     *	machdep_kprof_start ()
+     *	----------------------
+     *
+     *	Start delivering samples to kprof_sample(). With KPROF_RTC_HZ,
+     *	the RTC's periodic interrupt (IRQ 8) is programmed to that rate
+     *	and its IDT entry is pointed at i386_kprof_rtc_asm. Otherwise,
+     *	the system timer takes one sample per tick.
+     *
+     *	Returns the number of samples per second.
+     */
+
+#ifdef KPROF_RTC_HZ
+    int rate = 3, oldints;
+
+    /*  The RTC's periodic rate is 32768 >> (rate-1) Hz:  */
+    while (rate < 15 && (32768 >> (rate-1)) > KPROF_RTC_HZ)
+	rate ++;
+
+    oldints = interrupts (DISABLE);
+    i386setidtentry (idt + 8*0x28, (byte *) &i386_kprof_rtc_asm, SEL_CODE,
+		IDT_TYPE_INTERRUPTGATE, 0);
+    cmos_write (0x0a, (cmos_read (0x0a) & 0xf0) | rate);
+    cmos_write (0x0b, cmos_read (0x0b) | 0x40);
+    cmos_read (0x0c);
+    interrupts (oldints);
+
+    return 32768 >> (rate-1);
+#else
+    i386_kprof_tick = 1;
+    return HZ;
+#endif
+  }
+
+
+
+void machdep_kprof_stop ()
+  {
+#ifdef KPROF_RTC_HZ
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    cmos_write (0x0b, cmos_read (0x0b) & ~0x40);
+    cmos_read (0x0c);
+    i386setidtentry (idt + 8*0x28, (byte *) &irq8_asm, SEL_CODE,
+		IDT_TYPE_INTERRUPTGATE, 0);
+    interrupts (oldints);
+#else
+    i386_kprof_tick = 0;
+#endif
+  }
+#endif	/*  KPROF  */
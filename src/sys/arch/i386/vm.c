@@ -49,6 +49,9 @@ extern	byte	*gdt;
 /*  The kernel page directory (at a fixed address):  */
 u_int32_t *i386_kernel_pagedir = NULL;
 
+/*  The page directory currently loaded in cr3:  */
+u_int32_t i386_cr3;
+
 /*  Size of kernel in physical RAM rounded up to nearest 4MB:  */
 size_t	userland_startaddr;
 
@@ -134,6 +137,7 @@ void machdep_vm_init ()
      *	Let's turn the paging on:
      */
 
+    i386_cr3 = (u_int32_t) i386_kernel_pagedir;
     asm ("movl %%eax, %%cr3": : "a" (i386_kernel_pagedir));
     asm ("movl %cr0, %eax");
     asm ("orl $0x80010033, %eax");
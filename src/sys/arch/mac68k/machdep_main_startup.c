@@ -31,6 +31,7 @@
  *
  *  History:
  *	9 Dec 2000	test
+ *	19 Oct 2026	showing pending kernel messages before halting
  */
 
 
@@ -38,6 +39,7 @@
 #include <sys/arch/mac68k/machdep.h>
 #include <sys/defs.h>
 #include <sys/std.h>
+#include <sys/msgbuf.h>
 
 
 extern size_t malloc_firstaddr;
@@ -60,6 +62,7 @@ void machdep_reboot ()
 void machdep_halt ()
   {
     printk ("machdep_halt()");
+    msgbuf_flush ();
     for (;;) ;
   }
 
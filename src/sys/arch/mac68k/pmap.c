@@ -81,6 +81,32 @@ return 0;
 
 
 
+int pmap_cowfault (struct proc *p, size_t virtualaddr)
+  {
+    /*
+     *	Fix up a page table which was write protected by
+     *	pmap_markpages_cow(). Returns 1 if it was, 0 otherwise.
+     */
+
+    return 0;
+  }
+
+
+
+int pmap_writeprotect (struct proc *p, size_t startaddr, size_t endaddr)
+  {
+    /*
+     *	Remove write access from all pages from address startaddr upto
+     *	(and including) endaddr of process p.
+     *
+     *	Return 1 on success, 0 on failure.
+     */
+
+    return 0;
+  }
+
+
+
 int pmap_unmappages (struct proc *p, size_t startaddr, size_t endaddr)
   {
     /*
@@ -107,3 +133,15 @@ int pmap_mapped (struct proc *p, size_t virtualaddr)
     return 0;
   }
 
+
+
+
+int pmap_referenced (struct proc *p, size_t virtualaddr)
+  {
+    /*
+     *	Return 1 if the page at virtualaddr in process p has been
+     *	accessed since the last call, 0 otherwise.
+     */
+
+    return 0;
+  }
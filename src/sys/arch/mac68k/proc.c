@@ -70,6 +70,22 @@ int machdep_proc_init (struct proc *p)
 
 
 
+int machdep_kthread_init (struct proc *p, void (*func)())
+  {
+    /*
+     *	machdep_kthread_init ()
+     *	-----------------------
+     *
+     *	Make process p run func() in kernel mode.
+     *
+     *	Returns 1 on success, 0 on failure.
+     */
+
+    return 0;
+  }
+
+
+
 int machdep_proc_freemaps (struct proc *p)
   {
     /*
@@ -83,6 +99,27 @@ int machdep_proc_freemaps (struct proc *p)
 
 
 
+void machdep_proc_borrowmaps (struct proc *p, struct proc *from)
+  {
+    /*
+     *	Let p use from's page tables.  (vfork())
+     */
+  }
+
+
+
+int machdep_proc_returnmaps (struct proc *p)
+  {
+    /*
+     *	Give p page tables of its own again.
+     *	Returns 1 on success, 0 on failure.
+     */
+
+    return 1;
+  }
+
+
+
 int machdep_proc_remove (struct proc *p)
   {
     /*
@@ -28,6 +28,8 @@
  *
  *  History:
  *	9 Dec 2000	first version
+ *	19 Oct 2026	kernel profiler stubs
+ *	19 Oct 2026	one-shot timer stubs
  */
 
 
@@ -36,6 +38,7 @@
 #include <sys/std.h>
 #include <sys/timer.h>
 #include <sys/interrupts.h>
+#include <sys/kprof.h>
 
 
 extern volatile struct proc *curproc;
@@ -86,3 +89,49 @@ void machdep_timer_init ()
   }
 
 
+
+
+
+int machdep_timer_oneshot (u_int32_t nsec)
+  {
+    /*  TODO:  no one-shot interrupts yet  */
+    return 0;
+  }
+
+
+
+void machdep_timer_oneshot_done ()
+  {
+  }
+
+
+
+u_int64_t machdep_cyclecounter ()
+  {
+    /*  TODO  */
+    return 0;
+  }
+
+
+
+#ifdef KPROF
+void machdep_kprof_range (size_t *lowpc, size_t *highpc)
+  {
+    /*  TODO  */
+    *lowpc = *highpc = 0;
+  }
+
+
+
+int machdep_kprof_start ()
+  {
+    /*  TODO:  no profiling clock yet  */
+    return 0;
+  }
+
+
+
+void machdep_kprof_stop ()
+  {
+  }
+#endif
@@ -50,3 +50,178 @@
 #define	KDB
 #define	KDB_ON_PANIC
 
+
+/*
+ *  Kernel message buffer
+ *  ---------------------
+ *
+ *  printk() messages are kept in a ring of MSGBUF_SIZE chars (a power of
+ *  two), shown on the console by a kernel thread, and readable through
+ *  /proc/dmesg.
+ */
+
+#define	MSGBUF_SIZE		16384
+
+
+/*
+ *  Pre-zeroed pages
+ *  ----------------
+ *
+ *  The idle loop keeps up to VM_ZEROPOOL_PAGES zero-filled pages ready
+ *  for anonymous memory page faults, as long as there are at least
+ *  VM_ZEROPOOL_MINFREE bytes of free memory.
+ */
+
+#define	VM_ZEROPOOL_PAGES	32
+#define	VM_ZEROPOOL_MINFREE	(512*1024)
+
+
+
+/*
+ *  Pageout daemon and swap
+ *  -----------------------
+ *
+ *  When free memory drops below VM_PAGEOUT_LOWWATER bytes, the pageout
+ *  daemon is woken up, and frees pages until there are at least
+ *  VM_PAGEOUT_HIGHWATER bytes free. Anonymous pages are written to the
+ *  VM_SWAPDEVICE partition (at most VM_SWAPPAGES pages), if it exists.
+ */
+
+#define	VM_PAGEOUT_LOWWATER	(256*1024)
+#define	VM_PAGEOUT_HIGHWATER	(1024*1024)
+#define	VM_SWAPDEVICE		"wd0b"
+#define	VM_SWAPPAGES		8192
+
+
+/*
+ *  Shared file mappings and madvise()
+ *  ----------------------------------
+ *
+ *  A fault in a MADV_SEQUENTIAL file mapping reads VM_READAHEAD_PAGES pages
+ *  ahead. MADV_WILLNEED reads at most VM_WILLNEED_MAXPAGES pages at a time.
+ *  Dirty pages of shared file mappings are written back VM_WRITEBACK_BATCH
+ *  pages at a time.
+ */
+
+#define	VM_READAHEAD_PAGES	8
+#define	VM_WILLNEED_MAXPAGES	256
+#define	VM_WRITEBACK_BATCH	16
+
+
+/*
+ *  Exec image cache
+ *  ----------------
+ *
+ *  The EXEC_CACHE_SIZE most recently executed programs keep their pages in
+ *  memory (until the pageout daemon needs them), and the first
+ *  EXEC_CACHE_HEADERLEN bytes of each program are remembered, so that
+ *  execve() doesn't need to read the exec header again.
+ */
+
+#define	EXEC_CACHE_SIZE		16
+#define	EXEC_CACHE_HEADERLEN	64
+
+
+/*
+ *  Device registry
+ *  ---------------
+ *
+ *  Registered devices are hashed by name and by device number, in
+ *  DEVICE_HASHSIZE chains each (a power of two). Device numbers are
+ *  1 .. DEVICE_MAXNR-1, and the lowest free number is always used.
+ */
+
+#define	DEVICE_HASHSIZE		64
+#define	DEVICE_MAXNR		4096
+
+
+/*
+ *  Locks
+ *  -----
+ *
+ *  A lock() which finds the lock held by a process that is running (on
+ *  another cpu) tries LOCK_SPINCOUNT times before going to sleep. On a
+ *  uniprocessor the holder can't run while we spin, so this is 0.
+ */
+
+#define	LOCK_SPINCOUNT		0
+
+
+/*
+ *  Lock statistics
+ *  ---------------
+ *
+ *  If LOCKSTAT is defined, then lock() and unlock() count acquisitions,
+ *  contention, wait and hold times per lock name (at most LOCKSTAT_NAMES
+ *  names) and per lock (the LOCKSTAT_LOCKS first locks seen). See
+ *  kern/lockstat.c, /proc/lockstat and the kdb "lockstat" command.
+ *  Off by default, since it makes every lock() and unlock() slower.
+ */
+
+/* #define	LOCKSTAT */
+#define	LOCKSTAT_NAMES		128
+#define	LOCKSTAT_LOCKS		512
+
+
+/*
+ *  Syscall statistics
+ *  ------------------
+ *
+ *  If SYSCALLSTAT is defined, then syscall() counts calls, errors and
+ *  time per emulation and syscall number, with a latency histogram of
+ *  SYSCALLSTAT_BUCKETS log2(cycles) buckets. SYSCALLSTAT_PERPROC adds
+ *  per-process totals and call counts. See kern/syscallstat.c,
+ *  /proc/syscallstat, /proc/<pid>/syscalls and the kdb "syscallstat"
+ *  command.
+ */
+
+#define	SYSCALLSTAT
+#define	SYSCALLSTAT_BUCKETS	24
+#define	SYSCALLSTAT_PERPROC
+
+
+/*
+ *  Kernel profiler
+ *  ---------------
+ *
+ *  If KPROF is defined, then the program counter interrupted by each
+ *  clock interrupt is sampled while profiling is running. Kernel PCs
+ *  go into a histogram with one bucket per 2^KPROF_SHIFT bytes of
+ *  kernel text; one process' user PCs can be sampled into a histogram
+ *  of KPROF_USERBUCKETS buckets. If KPROF_RTC_HZ is defined (a power
+ *  of two, 2..8192), then samples are taken from the RTC periodic
+ *  interrupt at that rate instead of from the system timer (i386).
+ *  See kern/kprof.c, /proc/kprof and bin/misc/kprof.c.
+ */
+
+#define	KPROF
+#define	KPROF_SHIFT		4
+#define	KPROF_USERBUCKETS	4096
+#define	KPROF_RTC_HZ		1024
+
+
+/*
+ *  Event trace
+ *  -----------
+ *
+ *  If EVTRACE is defined, then process switches, sleep/wakeup, page
+ *  faults, buffer cache lookups, block device I/O and interrupts can be
+ *  traced into a ring buffer of EVTRACE_RECORDS (a power of two) binary
+ *  records. See kern/evtrace.c, /proc/evtrace and bin/misc/evtrace.c.
+ */
+
+#define	EVTRACE
+#define	EVTRACE_RECORDS		4096
+
+
+/*
+ *  Benchmarks
+ *  ----------
+ *
+ *  In-kernel microbenchmarks (kern/bench.c), run once at boot:
+ *
+ *  BENCH_PSWITCH	context switch ping-pong between two kernel
+ *			threads, 2^BENCH_PSWITCH rounds
+ */
+
+/* #define	BENCH_PSWITCH		12 */
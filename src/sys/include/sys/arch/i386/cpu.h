@@ -0,0 +1,91 @@
+/*
+ *  Copyright (C) 2001 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  sys/arch/i386/cpu.h  --  i386 CPU identification
+ */
+
+#ifndef	__SYS__ARCH__I386__CPU_H
+#define	__SYS__ARCH__I386__CPU_H
+
+
+#include <sys/defs.h>
+
+
+/*  Feature flags returned in edx by cpuid function 1:  */
+#define	CPUID_FPU		0x00000001	/*  x87 FPU on chip  */
+#define	CPUID_TSC		0x00000010	/*  Time Stamp Counter  */
+#define	CPUID_MSR		0x00000020	/*  rdmsr/wrmsr  */
+#define	CPUID_CX8		0x00000100	/*  cmpxchg8b  */
+#define	CPUID_APIC		0x00000200	/*  APIC on chip  */
+#define	CPUID_SEP		0x00000800	/*  sysenter/sysexit  */
+#define	CPUID_PGE		0x00002000	/*  global pages  */
+#define	CPUID_CMOV		0x00008000	/*  cmov  */
+#define	CPUID_MMX		0x00800000	/*  MMX  */
+#define	CPUID_FXSR		0x01000000	/*  fxsave/fxrstor  */
+#define	CPUID_SSE		0x02000000	/*  SSE  */
+#define	CPUID_SSE2		0x04000000	/*  SSE2  */
+
+
+/*  Model specific registers:  */
+#define	MSR_SYSENTER_CS		0x174
+#define	MSR_SYSENTER_ESP	0x175
+#define	MSR_SYSENTER_EIP	0x176
+
+
+extern u_int32_t	i386_cpu_features;	/*  CPUID_* flags  */
+extern int		i386_cpu_family;
+extern int		i386_cpu_model;
+extern int		i386_cpu_stepping;
+extern char		i386_cpu_vendor [13];
+extern int		i386_sysenter;		/*  1 if sysenter is enabled  */
+
+
+/*  Functions in arch/i386/cpu.c:  */
+
+void i386_cpuid (u_int32_t function, u_int32_t *regs);
+void i386_cpu_identify ();
+int i386_cpu_featurestobuf (char *buf, int buflen);
+void i386_sysenter_init ();
+
+
+/*  Read the Time Stamp Counter.  Only valid if CPUID_TSC is set.  */
+static __inline u_int64_t
+i386_rdtsc(void)
+{
+	u_int64_t t;
+	__asm __volatile("rdtsc" : "=A" (t));
+	return t;
+}
+
+
+/*  Write a model specific register.  Only valid if CPUID_MSR is set.  */
+static __inline void
+i386_wrmsr(u_int32_t msr, u_int64_t value)
+{
+	__asm __volatile("wrmsr" : : "c" (msr), "A" (value));
+}
+
+#endif	/*  __SYS__ARCH__I386__CPU_H  */
@@ -39,10 +39,9 @@
 #define	SEL_DATA	0x0010
 #define	SEL_USERCODE	0x0018
 #define	SEL_USERDATA	0x0020
-#define	SEL_DUMMYTSS	0x0028
-#define	SEL_FIRSTTSS	0x0030
+#define	SEL_CPUTSS	0x0028
 
-#define	I386_FIRSTTSS	6
+#define	GDT_NENTRIES	6
 
 
 #define GDT_DESCTYPE_SYSTEM		0
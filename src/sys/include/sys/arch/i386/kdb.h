@@ -36,6 +36,7 @@
 
 void kdb_initconsole ();
 void kdb_machdep_dumpcmos (char *cmdline);
+void kdb_machdep_strbench (char *cmdline);
 void kdb_print (char *s);
 int kdb_getch ();
 
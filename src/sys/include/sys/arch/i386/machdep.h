@@ -81,6 +81,9 @@ int bcd_to_int (int);
 void machdep_reboot ();
 void machdep_halt ();
 
+/*  Free running cycle counter (TSC), or 0 if there is none:  */
+u_int64_t machdep_cyclecounter ();
+
 
 #endif	/*  __SYS__ARCH__I386__MACHDEP_H  */
 
@@ -36,6 +36,10 @@
 struct proc;
 struct vm_object;
 
+
+/*  Size of a saved FPU state (fxsave needs 512 bytes, fnsave 108):  */
+#define	I386_FPUSTATE_SIZE	512
+
 struct i386tss
       {
 	u_int16_t	backlink;
@@ -84,13 +88,47 @@ struct i386tss
       };
 
 
+/*
+ *  The user mode registers of a process, at the top of its kernel stack.
+ *  (Pushed by the cpu and the syscall entry code, in this order from the
+ *  top of the stack and down.)
+ */
+
+struct i386frame
+      {
+	u_int32_t	gs;
+	u_int32_t	fs;
+	u_int32_t	es;
+	u_int32_t	ds;
+	u_int32_t	edi;
+	u_int32_t	esi;
+	u_int32_t	ebp;
+	u_int32_t	edx;
+	u_int32_t	ecx;
+	u_int32_t	ebx;
+	u_int32_t	eax;
+	u_int32_t	eip;
+	u_int32_t	cs;
+	u_int32_t	eflags;
+	u_int32_t	esp;
+	u_int32_t	ss;
+      };
+
+#define	I386_FRAME(p)	((struct i386frame *) (p)->md.esp0 - 1)
+
+
 
 struct mdproc
       {
-	/*  Task State Segment:  */
-	struct	i386tss		*tss;
+	/*  Saved kernel stack pointer, while the process is not running:  */
+	u_int32_t		kesp;
+
+	/*  Top of the kernel stack (loaded into the cpu's TSS):  */
+	u_int32_t		esp0;
 
-	u_int16_t		tss_nr;
+	/*  Page directory to load into cr3, or 0 for kernel threads
+	    which can run in any address space:  */
+	u_int32_t		cr3;
 
 	/*  Pointer to the process' page table directory:  */
 	u_int32_t		*pagedir;
@@ -98,6 +136,9 @@ struct mdproc
 	/*  Pointer to the process' kernel stack:  */
 	void			*kstack;
 
+	/*  Saved FPU/SSE state, or NULL if the FPU has never been used:  */
+	void			*fpustate;
+
 	/*  "Temporary" pointer to the process' stack vm_object.
 	    Used to create pages containing argc,argv,envp, and
 	    all the environment and argument strings and pointers...  */
@@ -112,20 +153,36 @@ struct mdproc
 
 void machdep_pagedir_init (struct proc *);
 int machdep_proc_init (struct proc *);
+int machdep_kthread_init (struct proc *, void (*func)());
 int machdep_proc_freemaps (struct proc *);
 int machdep_proc_remove (struct proc *);
 int machdep_fork (struct proc *parent, struct proc *child);
+void machdep_proc_borrowmaps (struct proc *p, struct proc *from);
+int machdep_proc_returnmaps (struct proc *p);
 
-void machdep_setkerneltaskaddr (void *);
 void machdep_pswitch (struct proc *p);
+void i386_proc_start (struct proc *p);
+
+
+/*  Functions in arch/i386/fpu.c:  */
+
+void i386_fpu_init ();
+void i386_fpu_save (struct proc *p);
+void i386_fpu_restore (struct proc *p);
+void i386_fpu_settrap ();
+void i386_fpu_fork (struct proc *parent, struct proc *child);
+void i386_fpu_release (struct proc *p);
 
 
 /*  Functions in arch/i386/pmap.c:  */
 
 int pmap_mappage (struct proc *p, size_t virtualaddr, byte *a_page, u_int32_t region_type);
 int pmap_markpages_cow (struct proc *p, size_t startaddr, size_t endaddr);
+int pmap_cowfault (struct proc *p, size_t virtualaddr);
+int pmap_writeprotect (struct proc *p, size_t startaddr, size_t endaddr);
 int pmap_unmappages (struct proc *p, size_t startaddr, size_t endaddr);
 int pmap_mapped (struct proc *p, size_t virtualaddr);
+int pmap_referenced (struct proc *p, size_t virtualaddr);
 
 
 #endif	/*  __SYS__ARCH__I386__PROC_H  */
@@ -32,6 +32,7 @@
 
 
 void arch_syscallasm ();
+void arch_sysenterasm ();
 
 
 #endif	/*  __SYS__ARCH__I386__SYSCALL_H  */
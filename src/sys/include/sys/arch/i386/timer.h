@@ -36,6 +36,9 @@
 
 
 void machdep_timer_init ();
+int machdep_timer_oneshot (u_int32_t nsec);
+void machdep_timer_oneshot_done ();
+void i386_tsc_init ();
 
 
 #endif	/*  __SYS__ARCH__I386__TIMER_H  */
@@ -69,6 +69,9 @@ int machdep_oldinterrupts ();
 void machdep_reboot ();
 void machdep_halt ();
 
+/*  Free running cycle counter, or 0 if there is none:  */
+u_int64_t machdep_cyclecounter ();
+
 
 #endif	/*  __SYS__ARCH__MAC68K__MACHDEP_H  */
 
@@ -48,9 +48,12 @@ struct mdproc
 
 void machdep_pagedir_init (struct proc *);
 int machdep_proc_init (struct proc *);
+int machdep_kthread_init (struct proc *, void (*func)());
 int machdep_proc_freemaps (struct proc *);
 int machdep_proc_remove (struct proc *);
 int machdep_fork (struct proc *parent, struct proc *child);
+void machdep_proc_borrowmaps (struct proc *p, struct proc *from);
+int machdep_proc_returnmaps (struct proc *p);
 void machdep_pswitch (struct proc *p);
 
 
@@ -58,8 +61,11 @@ void machdep_pswitch (struct proc *p);
 
 int pmap_mappage (struct proc *p, size_t virtualaddr, byte *a_page, u_int32_t region_type);
 int pmap_markpages_cow (struct proc *p, size_t startaddr, size_t endaddr);
+int pmap_cowfault (struct proc *p, size_t virtualaddr);
+int pmap_writeprotect (struct proc *p, size_t startaddr, size_t endaddr);
 int pmap_unmappages (struct proc *p, size_t startaddr, size_t endaddr);
 int pmap_mapped (struct proc *p, size_t virtualaddr);
+int pmap_referenced (struct proc *p, size_t virtualaddr);
 
 
 #endif	/*  __SYS__ARCH__MAC68K__PROC_H  */
@@ -36,6 +36,8 @@
 
 
 void machdep_timer_init ();
+int machdep_timer_oneshot (u_int32_t nsec);
+void machdep_timer_oneshot_done ();
 
 
 #endif	/*  __SYS__ARCH__MAC68K__TIMER_H  */
@@ -40,6 +40,11 @@ struct device
       {
 	struct lockstruct lock;
 
+	/*  These are managed by the device registry:  */
+	struct device	*prev;
+	struct device	*name_next;		/*  name hash chain  */
+	struct device	*nr_next;		/*  device number hash chain  */
+
 	/*  These require lock to be set:  */
 	struct device	*next;
 	ref_t		refcount;
@@ -91,9 +96,13 @@ struct device *device_alloc (char *name, const char *owner, u_int32_t type,
 
 int device_free (struct device *d);
 
-/*  Try to unregister a device. Returns 1 on success, 0 on failure.  */
+/*  Try to unregister a device. Returns 0 on success, errno on failure.  */
 int device_unregister (char *name);
 
+/*  Find a registered device by name or by device number:  */
+struct device *device_lookup (char *name);
+struct device *device_lookup_nr (dev_t nr);
+
 
 /*  Debug dump:  */
 void device_dump ();
@@ -30,6 +30,17 @@
 #ifndef	__SYS__EMUL_H
 #define	__SYS__EMUL_H
 
+#include <sys/defs.h>
+
+
+struct vnode;
+struct vm_object;
+struct syscallstat;
+
+
+/*  Max nr of (32-bit) arguments to a syscall:  */
+#define	SYSCALL_MAXARGS		10
+
 
 
 struct emul
@@ -63,6 +74,13 @@ struct emul
 	/*  syscalls  */
 	int		highest_syscall_nr;
 	void		**syscall;
+
+	/*  Nr of argument words for each syscall (if NULL, then
+	    SYSCALL_MAXARGS words are copied for every syscall):  */
+	u_int8_t	*syscall_nargs;
+
+	/*  Statistics, one entry per syscall (see kern/syscallstat.c):  */
+	struct syscallstat *syscallstat;
       };
 
 
@@ -70,6 +88,15 @@ struct emul
 struct emul *emul_register (const char *name);
 int emul_unregister (struct emul *e);
 
+struct emul *exec_cache_lookup (struct vnode *v, byte *header, size_t len);
+int exec_cache_header (struct vnode *v, void *header, size_t len);
+void exec_cache_enter (struct vnode *v, struct vm_object *vmobj,
+	struct emul *emul, byte *header, size_t len);
+int exec_cache_shrink ();
+
+extern u_int32_t exec_cache_hits;
+extern u_int32_t exec_cache_misses;
+
 
 #endif	/*  __SYS__EMUL_H  */
 
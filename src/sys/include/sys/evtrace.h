@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  sys/evtrace.h  --  binary event trace
+ */
+
+#ifndef	__SYS__EVTRACE_H
+#define	__SYS__EVTRACE_H
+
+
+#include <sys/defs.h>
+
+
+/*
+ *  One trace record. The record format and the event numbers are
+ *  also known by bin/misc/evtrace.c, so don't change them lightly.
+ */
+
+struct evtrace_record
+      {
+	u_int64_t	time;			/*  machdep_cyclecounter()  */
+	u_int16_t	type;			/*  EVT_*  */
+	u_int16_t	cpu;			/*  always 0, for now  */
+	u_int32_t	pid;			/*  curproc, or 0  */
+	u_int32_t	arg [4];
+      };
+
+					/*  arguments:  */
+#define	EVT_LOST		0	/*  nr of records lost  */
+#define	EVT_PSWITCH		1	/*  old pid, new pid  */
+#define	EVT_SLEEP		2	/*  wchan, wmesg (4 chars)  */
+#define	EVT_WAKEUP		3	/*  wchan  */
+#define	EVT_WAKEUP_PROC		4	/*  pid  */
+#define	EVT_FAULT		5	/*  addr, action  */
+#define	EVT_FAULT_DONE		6	/*  addr, kind (0=minor, 1=major)  */
+#define	EVT_BCACHE_HIT		7	/*  mountinstance, blocknr  */
+#define	EVT_BCACHE_MISS		8	/*  mountinstance, blocknr  */
+#define	EVT_DEV_READ		9	/*  device (4 chars), blocknr, nblocks  */
+#define	EVT_DEV_WRITE		10	/*  device (4 chars), blocknr, nblocks  */
+#define	EVT_DEV_DONE		11	/*  device (4 chars), result  */
+#define	EVT_IRQ			12	/*  irq nr  */
+#define	EVT_IRQ_DONE		13	/*  irq nr  */
+
+
+#ifdef EVTRACE
+
+extern volatile int evtrace_on;
+
+void evtrace_event (int type, u_int32_t a0, u_int32_t a1, u_int32_t a2);
+u_int32_t evtrace_name4 (char *name);
+int evtrace_control (char *cmd);
+size_t evtrace_read (char *buf, size_t buflen);
+
+/*  Tracepoints cost one test when tracing is off:  */
+#define	EVTRACE_EVENT(type,a0,a1,a2)	{ if (evtrace_on) evtrace_event ((type), \
+	(u_int32_t)(a0), (u_int32_t)(a1), (u_int32_t)(a2)); }
+
+#else
+
+#define	EVTRACE_EVENT(type,a0,a1,a2)	{ }
+
+#endif	/*  EVTRACE  */
+
+
+#endif	/*  __SYS__EVTRACE_H  */
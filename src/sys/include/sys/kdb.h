@@ -51,9 +51,16 @@ void kdb_dumpmem (size_t addr, size_t len, byte *buf);
 void kdb_mdump (char *);
 void kdb_modules (char *);
 void kdb_help (char *);
+#ifdef LOCKSTAT
+void kdb_lockstat (char *);
+#endif
 void kdb_reboot (char *);
 void kdb_status (char *);
+#ifdef SYSCALLSTAT
+void kdb_syscallstat (char *);
+#endif
 void kdb_version (char *);
+void kdb_vmstat (char *);
 void kdb ();
 
 
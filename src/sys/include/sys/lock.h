@@ -40,9 +40,21 @@ struct proc;
 
 struct lockstruct
       {
-	char		*writelock_value;
-	ref_t		readlock_refcount;
-	struct proc	*waiting_proc;
+	char		*writelock_value;	/*  write holder's lockvalue  */
+	ref_t		readlock_refcount;	/*  nr of read holders  */
+	struct proc	*waiting_proc;		/*  first waiter (FIFO queue)  */
+	struct proc	*owner;			/*  write holder  */
+	int		writers_waiting;	/*  nr of writers in the queue  */
+
+	/*  Contention statistics:  */
+	u_int32_t	nr_contended;		/*  lock() calls which waited  */
+	u_int64_t	wait_cycles;		/*  total time spent waiting  */
+
+#ifdef LOCKSTAT
+	/*  Start and lockvalue of the current hold (see kern/lockstat.c):  */
+	u_int64_t	lockstat_since;
+	char		*lockstat_name;
+#endif
       };
 
 
@@ -60,6 +72,9 @@ int unlock (struct lockstruct *lockaddr);
 #define	LOCK_RO			0
 #define	LOCK_RW			4
 
+/*  Set in p->lock_flags while p is in a lock's wait queue:  */
+#define	LOCK_WAITING		0x100
+
 
 #endif	/*  __SYS__LOCK_H  */
 
@@ -0,0 +1,64 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  sys/lockstat.h  --  lock contention statistics
+ */
+
+#ifndef	__SYS__LOCKSTAT_H
+#define	__SYS__LOCKSTAT_H
+
+
+#include <sys/defs.h>
+
+struct lockstruct;
+
+
+#ifdef LOCKSTAT
+
+/*  Statistics for one lock name, or one lock:  */
+struct lockstat_entry
+      {
+	char		*name;		/*  lockvalue  */
+	void		*lockaddr;	/*  per-lock entries only  */
+
+	u_int32_t	acquired;	/*  nr of successful lock() calls  */
+	u_int32_t	contended;	/*  nr of them which had to wait  */
+	u_int64_t	wait_total;	/*  cycles spent waiting  */
+	u_int64_t	wait_max;
+	u_int64_t	hold_total;	/*  cycles the lock was held  */
+	u_int64_t	hold_max;
+      };
+
+void lockstat_acquire (struct lockstruct *l, char *name, int contended,
+	u_int64_t waited);
+void lockstat_release (struct lockstruct *l, char *name, u_int64_t held);
+void lockstat_reset ();
+size_t lockstat_print (char *buf, size_t buflen);
+
+#endif	/*  LOCKSTAT  */
+
+
+#endif	/*  __SYS__LOCKSTAT_H  */
@@ -32,6 +32,8 @@
 
 #include <sys/defs.h>
 
+struct vm_object;
+
 
 /*
  *  MCB:  Memory Control Block
@@ -85,6 +87,12 @@ struct mcb
 	 *  since an MCB array index of 0 always points to a reserved page.
 	 */
 	size_t		next;
+
+	/*
+	 *  The vm_object whose page hash table the page is in. (Only
+	 *  valid for MCB_VMOBJECT_PAGE pages.) Used by the pageout daemon.
+	 */
+	struct vm_object *object;
     };
 
 
@@ -116,6 +124,10 @@ void *malloc (size_t len);
 void free (void *p);
 size_t malloc_getsize (void *p);
 
+extern size_t malloc_totalfreememory;
+extern size_t malloc_lowwater;
+extern volatile int malloc_lowwater_woken;
+
 
 #endif	/*  __SYS__MALLOC_H  */
 
@@ -67,5 +67,25 @@
 #define	MAP_FAILED	((void *)-1)
 
 
+/*
+ *  msync() flags:
+ */
+
+#define	MS_ASYNC	0x01
+#define	MS_SYNC		0x02
+#define	MS_INVALIDATE	0x04
+
+
+/*
+ *  madvise() advice:
+ */
+
+#define	MADV_NORMAL	0
+#define	MADV_RANDOM	1
+#define	MADV_SEQUENTIAL	2
+#define	MADV_WILLNEED	3
+#define	MADV_DONTNEED	4
+
+
 #endif	/*  __SYS__MMAN_H  */
 
@@ -135,11 +135,27 @@ struct proc
 	int		sc_params_ok;		/*  Memory ranges for syscall parameters
 						    has been checked? (0 or 1)  */
 
+	/*  Nr of vm operations (faults, region changes) in progress.
+	    The pageout daemon leaves the process alone while > 0.  */
+	int		vm_busy;
+
+	/*  Lock wait queue:  (see kern/lock.c)  */
+	struct proc	*lock_next;		/*  next waiter for the same lock  */
+	char		*lock_value;		/*  lockvalue we are waiting with  */
+	int		lock_flags;		/*  LOCK_RW, LOCK_WAITING  */
+
 	/*  Child/parent relationship:  */
 	struct proc	*parent;		/*  parent. (NULL if orphaned)  */
 	int		nr_of_children;		/*  nr of children  */
 	int		exitcode;		/*  exitcode for parent  */
 
+	/*  Syscall statistics:  (see kern/syscallstat.c)  */
+	u_int32_t	sc_calls;		/*  nr of syscalls  */
+	u_int32_t	sc_errors;		/*  nr of them which failed  */
+	u_int64_t	sc_cycles;		/*  cycles spent in syscalls  */
+	u_int32_t	*sc_count;		/*  calls per syscall nr, or NULL  */
+	int		sc_count_n;		/*  nr of entries in sc_count  */
+
 #define	PROC_MI_COPYFROM cred
 
 	/*  Process credentials:  */
@@ -191,6 +207,8 @@ struct proc
 
 
 #define	PFLAG_CALLEDEXEC		1
+#define	PFLAG_KTHREAD			2	/*  kernel thread, no userland  */
+#define	PFLAG_VFORK			4	/*  using the parent's address space  */
 
 
 
@@ -201,6 +219,11 @@ struct proc
 void proc_init ();
 struct proc *proc_alloc ();
 int proc_remove (struct proc *);
+struct proc *proc_kthread_create (void (*func)(), void *wchan, char *wmesg);
+#ifdef BENCH_PSWITCH
+void bench_pswitch_init ();
+#endif
+void vfork_release (struct proc *p);
 int superuser ();
 void pswitch ();
 void sleep (void *, char *);
@@ -44,7 +44,9 @@ struct timeval;
 void syscall_init ();
 
 /*  sys_fork.c:  */
+int fork1 (ret_t *res, struct proc *p, int vforkflag);
 int sys_fork (ret_t *res, struct proc *p);
+int sys_vfork (ret_t *res, struct proc *p);
 
 /*  sys_fd.c:  */
 int sys_open (ret_t *res, struct proc *p, char *filename, int flags, mode_t mode);
@@ -95,6 +97,8 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[], char *e
 int sys_mmap (ret_t *res, struct proc *p, void *addr, size_t len, int prot, int flags, int fd, off_t offset);
 int sys_munmap (ret_t *res, struct proc *p, void *addr, size_t len);
 int sys_mprotect (ret_t *res, struct proc *p, void *addr, size_t len, int prot);
+int sys_msync (ret_t *res, struct proc *p, void *addr, size_t len, int flags);
+int sys_madvise (ret_t *res, struct proc *p, void *addr, size_t len, int behav);
 int sys_break (ret_t *res, struct proc *p, char *nsize);
 
 /*  sys_sig.c:  */
@@ -106,6 +110,8 @@ int sys_kill (ret_t *res, struct proc *p, pid_t pid, int sig);
 
 /*  sys_time.c:  */
 int sys_gettimeofday (ret_t *res, struct proc *p, struct timeval *tp, void *timezoneptr);
+int sys_clock_gettime (ret_t *res, struct proc *p, int clock_id, struct timespec *tp);
+int sys_clock_getres (ret_t *res, struct proc *p, int clock_id, struct timespec *tp);
 
 /*  sys_misc.c:  */
 int sys_reboot (ret_t *res, struct proc *p, int how);
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  sys/syscallstat.h  --  syscall statistics
+ */
+
+#ifndef	__SYS__SYSCALLSTAT_H
+#define	__SYS__SYSCALLSTAT_H
+
+
+#include <sys/defs.h>
+
+struct emul;
+struct proc;
+
+
+#ifdef SYSCALLSTAT
+
+/*  Statistics for one syscall number of one emulation:  */
+struct syscallstat
+      {
+	u_int32_t	calls;			/*  nr of calls  */
+	u_int32_t	errors;			/*  nr of calls returning an errno  */
+	u_int64_t	cycles;			/*  total cycles spent  */
+	u_int32_t	hist [SYSCALLSTAT_BUCKETS];	/*  2^n cycles  */
+      };
+
+void syscallstat_account (struct emul *e, struct proc *p, int nr, int error,
+	u_int64_t starttime);
+void syscallstat_procfree (struct proc *p);
+void syscallstat_reset ();
+size_t syscallstat_print (char *buf, size_t buflen);
+size_t syscallstat_procprint (struct proc *p, char *buf, size_t buflen);
+
+#endif	/*  SYSCALLSTAT  */
+
+
+#endif	/*  __SYS__SYSCALLSTAT_H  */
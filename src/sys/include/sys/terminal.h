@@ -35,10 +35,16 @@
 #include <sys/defs.h>
 
 
-#define	MAX_INPUT		1024
+#define	MAX_INPUT		1024		/*  must be a power of 2  */
 #define	MAX_OUTPUT		512
 #define	OUTPUT_MARGIN		4
 
+#define	TERMINAL_LINEEND(ts,ch)	((ch) == (ts)->termio.c_cc[VEOF] || \
+				 (ch) == (ts)->termio.c_cc[VEOL] || (ch) == '\n')
+
+/*  Was the char at inputbuf[i] a line terminator when it was added?  */
+#define	TERMINAL_ISLINEEND(ts,i) ((ts)->lineend[(i) >> 3] & (1 << ((i) & 7)))
+
 struct termstate
       {
 	/*  A termios struct stores control flags etc.:  */
@@ -52,8 +58,21 @@ struct termstate
 	char		inputbuf [MAX_INPUT];
 	size_t		inputhead, inputtail;
 
+	/*  Number of complete lines (ending with NL, EOL, or EOF)
+	    in inputbuf, and the index of the line terminator of
+	    the first of them. These are updated as characters are
+	    added, so that readers don't have to scan inputbuf.  */
+	size_t		nlines;
+	size_t		firstlineend;
+
+	/*  One bit per inputbuf position, set if the char there was a
+	    line terminator when it was added. (VEOF and VEOL may be
+	    changed while the line is still in inputbuf.)  */
+	byte		lineend [MAX_INPUT / 8];
+
 	/*  Linemode "sleep": (a canonical read should sleep
 	    on this address... wakeup if NL, EOL, or EOF is typed)
+	    The value is the number of sleeping readers.
 	    TODO: since this is also used for non-canonical sleep,
 		it should be renamed!  */
 	int		linemode_sleep;
@@ -57,5 +57,10 @@ struct timeval
       };
 
 
+/*  Clocks for sys_clock_gettime():  (same numbers as OpenBSD)  */
+#define	CLOCK_REALTIME		0	/*  since 1970  */
+#define	CLOCK_MONOTONIC		3	/*  since boot  */
+
+
 #endif	/*  __SYS__TIME_H  */
 
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  sys/timepage.h  --  the shared time page
+ *
+ *  The kernel keeps the time at the last tick (and the calibration of the
+ *  clocksource) in a page which is mapped read-only into every process at
+ *  TIMEPAGE_ADDR. Userland can then find out the current time without a
+ *  system call:
+ *
+ *	1)  Read seq. If it is odd, the kernel is updating the page.
+ *	2)  Read the other fields, and the clocksource (rdtsc).
+ *	3)  If seq has changed, start over.
+ *
+ *  The clocksource can only be used if TIMEPAGE_USERCLOCK is set in flags.
+ *  Otherwise the page only has tick resolution. Userland must check magic
+ *  and version, and fall back to the system call if they don't match.
+ */
+
+#ifndef	__SYS__TIMEPAGE_H
+#define	__SYS__TIMEPAGE_H
+
+
+#include <sys/defs.h>
+
+
+#define	TIMEPAGE_ADDR		0xe0000000
+#define	TIMEPAGE_MAGIC		0x54696d65		/*  "Time"  */
+#define	TIMEPAGE_VERSION	1
+
+/*  Flags:  */
+#define	TIMEPAGE_USERCLOCK	1
+
+struct timepage
+      {
+	u_int32_t	magic;
+	u_int32_t	version;
+	volatile u_int32_t seq;		/*  odd while being updated  */
+	u_int32_t	flags;
+
+	/*  Time at the last tick:  */
+	s_int32_t	sec;		/*  since 1970  */
+	s_int32_t	nsec;
+	u_int64_t	uptime;		/*  ns since boot  */
+
+	/*  Clocksource value at the last tick, and its calibration:  */
+	u_int64_t	tickstamp;
+	u_int32_t	cycles_per_tick;
+	u_int32_t	mult;		/*  ns = (cycles*mult) >> shift  */
+	u_int32_t	shift;
+	u_int32_t	tick_nsec;	/*  length of a tick  */
+      };
+
+
+struct proc;
+
+void timepage_init ();
+void timepage_update ();
+int timepage_attach (struct proc *p);
+
+
+#endif	/*  __SYS__TIMEPAGE_H  */
@@ -31,6 +31,7 @@
 #define	__SYS__TIMER_H
 
 
+#include <sys/defs.h>
 #include <sys/md/timer.h>
 
 struct proc;
@@ -41,7 +42,7 @@ struct timer_wakeup_chain
       {
 	volatile struct timer_wakeup_chain *next;
 	void		*wakeup_addr;		/*  address to wakeup()  */
-	ticks_t		ticks;			/*  nr of remaining ticks before wakeup  */
+	u_int64_t	deadline;		/*  uptime (ns) of the wakeup  */
 	int		flags;			/*  user or kernel mode timer  */
       };
 
@@ -49,8 +50,39 @@ struct timer_wakeup_chain
 #define	TWC_KERNEL	1
 
 
+/*
+ *  A clocksource is a free running counter which the machine dependant
+ *  code has calibrated against the system timer. It is used to find out
+ *  how much time has passed since the last tick.
+ */
+
+struct clocksource
+      {
+	char		*name;
+	u_int64_t	(*read) ();
+	u_int32_t	cycles_per_tick;	/*  set by machdep code  */
+	u_int32_t	mult;			/*  set by timer_setclocksource  */
+	u_int32_t	flags;
+      };
+
+/*  Clocksource flags:  */
+#define	CLOCKSOURCE_USERREAD	1	/*  userland can read it too  */
+
+/*  ns = (cycles * mult) >> CLOCKSOURCE_SHIFT  */
+#define	CLOCKSOURCE_SHIFT	24
+
+/*  One-shot timer state (see timer_arm() in kern/timer.c):  */
+#define	TIMER_ONESHOT_NONE	0
+#define	TIMER_ONESHOT_ARMED	1
+#define	TIMER_ONESHOT_FIRED	2
+
+
 void timer_init ();
 void timer ();
+void timer_setclocksource (struct clocksource *cs);
+void timer_gettime (struct timespec *ts);
+u_int64_t timer_getuptime ();
+u_int32_t timer_div64 (u_int64_t n, u_int32_t d);
 time_t time_rawtounix (int year, int month, int day, int hour, int min, int sec);
 int timer_sleep (struct proc *p, struct timespec *ts, char *sleepmsg);
 int timer_ksleep (struct timespec *ts, void *k_func, int resetflag);
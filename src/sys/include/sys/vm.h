@@ -35,6 +35,8 @@
 #include <sys/md/vm.h>
 #include <sys/md/machdep.h>		/*  for PAGESIZE  */
 
+struct device;
+
 
 /*  Maybe these macros should be in sys/defs.h instead?  */
 
@@ -54,11 +56,13 @@
  *	(o)  Shadow objects (with reference to another object)
  *
  *  A virtual memory object can be shared by several processes. The refcount
- *  tells how many processes actually share the object.
+ *  tells how many vm_regions and shadow objects actually refer to the object.
  *
- *  A shadow object may have at most two referers (other vm_objects), and their
- *  addresses should be stored in shadow_ref1 and shadow_ref2. This is because
- *  we want to be able to free modified pages when processes die etc.
+ *  When an object is left with only one referer, and that referer is a
+ *  shadow object, the two are merged by vm_object_collapse(). A shadow
+ *  object which covers all resident pages of its backing object skips
+ *  the backing object altogether, so that shadow chains stay short even
+ *  when processes fork repeatedly.
  */
 
 struct vm_object
@@ -76,22 +80,64 @@ struct vm_object
 	u_int16_t		flags;		/*  additional flags  */
 	ref_t			refcount;	/*  reference count  */
 
-	/*  If this object is a shadow object, then these are the two shadow objects
-	    referencing it (ie after a fork). (There can not be more than two.)
-	    Set these to NULL if there are no shadow objects refering this object.  */
-	struct vm_object	*shadow_ref1;
-	struct vm_object	*shadow_ref2;
-
 	/*  If this is a file object, then this is the vnode we're representing:  */
 	struct vnode		*vnode;
 
 	/*  Pointer to the vm_object's pagein function:  */
 	void *			(*pagein)();		/*  *errno, vmregion, vmobject, linearaddr  */
 
-	/*  Index into the MCB array to the first page in the chain:  */
-	size_t			page_chain_start;
+	/*
+	 *  Resident pages:  page_hash[] contains indices into the MCB
+	 *  array of the first page in each hash chain. The chains are
+	 *  linked using mcb->next, and the hash table grows as pages
+	 *  are added.
+	 */
+	size_t			*page_hash;
+	size_t			page_hashsize;	/*  nr of chains (2^n)  */
+	size_t			npages;		/*  nr of resident pages  */
+	size_t			ncopied;	/*  nr of pages copied up
+						    from ->next (approx.)  */
+	size_t			nswapped;	/*  nr of pages on swap  */
+
+	/*  Pages which are currently being paged in or out:  */
+	struct vm_busypage	*busy_pages;
+      };
+
+
+/*
+ *  A busy-page marker is added to a vm_object while one of its pages is
+ *  being paged in (or out to swap) without the object being locked.
+ */
+
+struct vm_busypage
+      {
+	struct vm_busypage	*next;
+	size_t			page_nr;
+	int			waiting;	/*  nr of sleeping faults  */
       };
 
+
+/*
+ *  Pages which have been paged out to the swap device are remembered in
+ *  a global hash table (hashed on page_nr), one entry per page. See
+ *  vm/vm_swap.c.
+ */
+
+struct vm_swapent
+      {
+	struct vm_swapent	*next;
+	struct vm_object	*obj;
+	size_t			page_nr;
+	size_t			slot;		/*  swap slot (1, 2, ...)  */
+      };
+
+#define	VM_SWAP_HASHSIZE		1024
+
+/*  Page hash table sizes, and the hash function:  */
+#define	VM_OBJECT_MINHASHSIZE		32
+#define	VM_OBJECT_MAXHASHSIZE		65536
+#define	VM_OBJECT_PAGEHASH(obj,page_nr)	((page_nr) & ((obj)->page_hashsize - 1))
+
 /*  Object types:  */
 #define	VM_OBJECT_FILE			1
 #define	VM_OBJECT_ANONYMOUS		2
@@ -100,6 +146,12 @@ struct vm_object
 /*  Object flags (ORed):  */
 #define	VM_OBJECT_EXECUTABLEFILE	1
 
+/*  Page status bits, in the mcb bitmap field of vm_object pages:  */
+#define	VM_PAGE_REFERENCED		1	/*  used since last scan  */
+#define	VM_PAGE_DIRTY			2	/*  written through a shared
+						    mapping, not written back  */
+#define	VM_PAGE_WRITEBACK		4	/*  being written back  */
+
 
 /*
  *  vm_region
@@ -134,6 +186,10 @@ struct vm_region
 #define	VMREGION_EXECUTABLE		4
 #define	VMREGION_COW			8
 #define	VMREGION_STACK			16
+#define	VMREGION_SHARED			32	/*  MAP_SHARED, writes go to
+						    the object itself  */
+#define	VMREGION_SEQUENTIAL		64	/*  madvise() hints  */
+#define	VMREGION_RANDOM			128
 
 
 
@@ -149,13 +205,78 @@ int vm_region_detach (struct proc *p, size_t start_addr);
 void *vm_region_findfree (struct proc *p, size_t len);
 
 struct vm_object *vm_object_create (int type);
+size_t vm_object_findpage (struct vm_object *obj, size_t page_nr);
+void vm_object_addpage (struct vm_object *obj, byte *a_page, size_t page_nr);
+void vm_object__insert (struct vm_object *obj, size_t mcb_index);
+void vm_object__remove (struct vm_object *obj, size_t mcb_index);
+struct vm_busypage *vm_object_findbusy (struct vm_object *obj, size_t page_nr);
+int vm_object_setbusy (struct vm_object *obj, size_t page_nr);
+void vm_object_unbusy (struct vm_object *obj, size_t page_nr);
+void vm_object_waitbusy (struct vm_object *obj, struct vm_busypage *b);
 int vm_object_freepages (struct vm_object *obj, size_t firstpage, size_t lastpage);
 int vm_object_free (struct vm_object *obj);
 int vm_object_combine (struct vm_object *subobj, struct vm_object *newobj);
+int vm_object_bypass (struct vm_object *obj);
+void vm_object_collapse (struct vm_object *obj);
+
+extern u_int32_t vm_object_collapses;
+extern u_int32_t vm_object_bypasses;
 
 int vm_fork (struct proc *p, struct proc *child_proc);
 
+void vm_zero_init ();
+byte *vm_zeropage_alloc ();
+void vm_zeropool_fill ();
+
+extern byte *vm_zeropage;
+extern volatile int vm_zeropool_count;
+extern u_int32_t vm_zeropage_maps;
+extern u_int32_t vm_zeropool_hits;
+extern u_int32_t vm_zeropool_misses;
+
+void vm_swap_init ();
+int vm_swap_alloc (size_t *slot);
+void vm_swap_free (size_t slot);
+int vm_swap_io (size_t slot, byte *page, int writeflag);
+size_t vm_swap_lookup (struct vm_object *obj, size_t page_nr);
+void vm_swap_enter (struct vm_object *obj, struct vm_swapent *e,
+	size_t page_nr, size_t slot);
+void vm_swap_freepages (struct vm_object *obj, size_t firstpage, size_t lastpage);
+void vm_swap_moveobj (struct vm_object *from, struct vm_object *to);
+int vm_swap_covered (struct vm_object *obj, struct vm_object *backing);
+int vm_swapin (struct vm_object *obj, size_t page_nr);
+
+extern struct device *vm_swapdev;
+extern size_t vm_swap_nslots;
+extern size_t vm_swap_used;
+extern u_int32_t vm_swap_ins;
+extern u_int32_t vm_swap_outs;
+
+void vm_pageout_init ();
+int vm_pageout_wait ();
+
+extern u_int32_t vm_pageout_passes;
+extern u_int32_t vm_pageout_reclaimed;
+
 void vm_fault (struct proc *p, size_t virtualaddr, int action);
+int vm_fault_prefetch (struct proc *p, struct vm_region *region,
+	size_t startaddr, size_t endaddr);
+
+int vm_writeback (struct vm_object *obj, size_t firstpage, size_t lastpage);
+int vm_writeback_region (struct vm_region *region, size_t startaddr,
+	size_t endaddr);
+size_t vm_writeback_dirty (size_t maxpages);
+
+extern u_int32_t vm_writeback_pages;
+extern u_int32_t vm_readahead_pages;
+
+/*  Fault latency histogram:  (bucket n = 2^n .. 2^(n+1)-1 cycles)  */
+#define	VM_FAULT_MINOR			0
+#define	VM_FAULT_MAJOR			1
+#define	VM_FAULT_HISTBUCKETS		32
+
+extern u_int32_t vm_fault_count [2];
+extern u_int32_t vm_fault_hist [2][VM_FAULT_HISTBUCKETS];
 
 #define	VM_PAGEFAULT_READ		1
 #define	VM_PAGEFAULT_WRITE		2
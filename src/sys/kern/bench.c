@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/bench.c  --  in-kernel microbenchmarks
+ *
+ *	These are compiled in only if enabled in config.h, and run once
+ *	at boot. Results are printed with printk().
+ *
+ *	bench_pswitch_init ()  (BENCH_PSWITCH)
+ *		Context switch ping-pong: two kernel threads wake each
+ *		other up and go to sleep, 2^BENCH_PSWITCH rounds. The time
+ *		per switch is the total time divided by the number of
+ *		switches, so it includes sleep() and wakeup(), and any other
+ *		process which happened to be on the run queue.
+ *
+ *  History:
+ *	19 Oct 2026	first version (context switch ping-pong)
+ */
+
+
+#include "../config.h"
+#include <sys/std.h>
+#include <sys/interrupts.h>
+#include <sys/proc.h>
+#include <sys/md/machdep.h>
+
+
+#ifdef BENCH_PSWITCH
+
+int bench_pswitch_a, bench_pswitch_b, bench_pswitch_done;
+
+
+
+void bench_pswitch_ping ()
+  {
+    u_int64_t starttime, cycles;
+    u_int32_t i;
+
+    interrupts (DISABLE);
+
+    starttime = machdep_cyclecounter ();
+
+    for (i=0; i < (1 << BENCH_PSWITCH); i++)
+      {
+	wakeup (&bench_pswitch_b);
+	sleep (&bench_pswitch_a, "ping");
+      }
+
+    cycles = machdep_cyclecounter () - starttime;
+
+    printk ("bench: %i context switches, %i cycles per switch",
+	2 << BENCH_PSWITCH, (u_int32_t) (cycles >> (BENCH_PSWITCH + 1)));
+
+    for (;;)
+	sleep (&bench_pswitch_done, "done");
+  }
+
+
+
+void bench_pswitch_pong ()
+  {
+    interrupts (DISABLE);
+
+    for (;;)
+      {
+	wakeup (&bench_pswitch_a);
+	sleep (&bench_pswitch_b, "pong");
+      }
+  }
+
+
+
+void bench_pswitch_init ()
+  {
+    /*
+     *	Create the two threads, and let the first one start running
+     *	as soon as processes are scheduled.
+     */
+
+    if (!proc_kthread_create (bench_pswitch_ping, &bench_pswitch_a, "ping")
+	|| !proc_kthread_create (bench_pswitch_pong, &bench_pswitch_b, "pong"))
+      {
+	printk ("bench_pswitch_init(): could not create threads");
+	return;
+      }
+
+    wakeup (&bench_pswitch_a);
+  }
+
+#endif	/*  BENCH_PSWITCH  */
+
@@ -0,0 +1,231 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/evtrace.c  --  binary event trace
+ *
+ *	When EVTRACE is defined in config.h, tracepoints in the scheduler,
+ *	the page fault handler, the buffer cache, block device I/O and the
+ *	interrupt dispatcher call evtrace_event() (via the EVTRACE_EVENT
+ *	macro in sys/evtrace.h) while tracing is turned on. Each event is stored as
+ *	a fixed size struct evtrace_record, timestamped with the cycle
+ *	counter, in a ring buffer of EVTRACE_RECORDS records.
+ *
+ *	Unlike printk(), this doesn't touch the console, so it can be used
+ *	to look at timing without changing it much. Tracing is controlled
+ *	by writing "start", "stop" or "reset" to /proc/evtrace. Reading
+ *	/proc/evtrace consumes records; if the reader is too slow, then
+ *	the oldest records are overwritten and the reader gets an EVT_LOST
+ *	record instead. bin/misc/evtrace decodes the records.
+ *
+ *	There is only one cpu, so there is one ring. It is updated with
+ *	interrupts disabled.
+ *
+ *	evtrace_event ()
+ *		Add a record to the ring.
+ *
+ *	evtrace_name4 ()
+ *		Pack the first 4 chars of a name into an argument.
+ *
+ *	evtrace_control ()
+ *		Start, stop or reset tracing.
+ *
+ *	evtrace_read ()
+ *		Remove records from the ring.  (Used by procfs.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/md/machdep.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/errno.h>
+#include <sys/proc.h>
+#include <sys/evtrace.h>
+
+
+#ifdef EVTRACE
+
+
+extern volatile struct proc *curproc;
+
+volatile int evtrace_on = 0;
+
+struct evtrace_record *evtrace_ring = NULL;
+u_int32_t evtrace_head = 0;		/*  nr of records ever written  */
+u_int32_t evtrace_tail = 0;		/*  nr of records ever read (or lost)  */
+u_int32_t evtrace_lost = 0;		/*  lost, not yet reported  */
+
+
+
+void evtrace_event (int type, u_int32_t a0, u_int32_t a1, u_int32_t a2)
+  {
+    struct evtrace_record *r;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    if (!evtrace_ring)
+      {
+	interrupts (oldints);
+	return;
+      }
+
+    r = &evtrace_ring [evtrace_head & (EVTRACE_RECORDS-1)];
+    r->time = machdep_cyclecounter ();
+    r->type = type;
+    r->cpu = 0;
+    r->pid = curproc? curproc->pid : 0;
+    r->arg[0] = a0;
+    r->arg[1] = a1;
+    r->arg[2] = a2;
+    r->arg[3] = 0;
+
+    evtrace_head ++;
+
+    /*  Overwrote the oldest unread record?  */
+    if (evtrace_head - evtrace_tail > EVTRACE_RECORDS)
+      {
+	evtrace_tail ++;
+	evtrace_lost ++;
+      }
+
+    interrupts (oldints);
+  }
+
+
+
+u_int32_t evtrace_name4 (char *name)
+  {
+    u_int32_t x = 0;
+    int i;
+
+    for (i=0; i<4 && name && name[i]; i++)
+	x |= (u_int32_t) (unsigned char) name[i] << (i*8);
+
+    return x;
+  }
+
+
+
+int evtrace_control (char *cmd)
+  {
+    /*
+     *	Handle a command written to /proc/evtrace. The ring is allocated
+     *	the first time tracing is started. Returns 0 on success, errno
+     *	on error.
+     */
+
+    struct evtrace_record *ring;
+    int oldints;
+
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "start"))
+      {
+	if (!evtrace_ring)
+	  {
+	    ring = (struct evtrace_record *) malloc
+		(sizeof(struct evtrace_record) * EVTRACE_RECORDS);
+	    if (!ring)
+		return ENOMEM;
+
+	    oldints = interrupts (DISABLE);
+	    if (evtrace_ring)
+		free (ring);
+	    else
+		evtrace_ring = ring;
+	    interrupts (oldints);
+	  }
+
+	evtrace_on = 1;
+	return 0;
+      }
+
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "stop"))
+      {
+	evtrace_on = 0;
+	return 0;
+      }
+
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "reset"))
+      {
+	oldints = interrupts (DISABLE);
+	evtrace_head = evtrace_tail = evtrace_lost = 0;
+	interrupts (oldints);
+	return 0;
+      }
+
+    return EINVAL;
+  }
+
+
+
+size_t evtrace_read (char *buf, size_t buflen)
+  {
+    /*
+     *	evtrace_read ()
+     *	---------------
+     *
+     *	Move as many whole records as fit in buf out of the ring, oldest
+     *	first. If records have been lost since the last call, an EVT_LOST
+     *	record comes first.
+     *
+     *	Returns the number of bytes copied to buf.
+     */
+
+    struct evtrace_record *r = (struct evtrace_record *) buf;
+    size_t n = 0, max = buflen / sizeof(struct evtrace_record);
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    if (evtrace_lost && n < max)
+      {
+	memset (r, 0, sizeof(struct evtrace_record));
+	r->time = machdep_cyclecounter ();
+	r->type = EVT_LOST;
+	r->arg[0] = evtrace_lost;
+	evtrace_lost = 0;
+	r ++, n ++;
+      }
+
+    while (evtrace_ring && evtrace_tail != evtrace_head && n < max)
+      {
+	memcpy (r, &evtrace_ring [evtrace_tail & (EVTRACE_RECORDS-1)],
+	    sizeof(struct evtrace_record));
+	evtrace_tail ++;
+	r ++, n ++;
+      }
+
+    interrupts (oldints);
+    return n * sizeof(struct evtrace_record);
+  }
+
+
+#endif	/*  EVTRACE  */
@@ -0,0 +1,338 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/exec_cache.c  --  exec image cache
+ *
+ *	The file vm_objects of the EXEC_CACHE_SIZE most recently executed
+ *	programs are kept referenced, so that the pageout daemon doesn't
+ *	drop their pages when no process is running the program. The first
+ *	bytes of each file (the exec header) and the emulation which
+ *	recognized it are remembered too, so a repeated execve() of the
+ *	same program doesn't need to read anything from the file.
+ *
+ *	An entry is only used if the file's size and modification time are
+ *	unchanged. The cache is protected by disabling interrupts.
+ *
+ *	exec_cache_lookup ()
+ *		Find the emulation and header of a cached program.
+ *
+ *	exec_cache_header ()
+ *		Get the cached header of a program.  (Used by loadexec()
+ *		functions.)
+ *
+ *	exec_cache_enter ()
+ *		Add a program to the cache.
+ *
+ *	exec_cache_shrink ()
+ *		Drop the least recently used entry. Called by the pageout
+ *		daemon when memory is low.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/proc.h>
+#include <sys/vnode.h>
+#include <sys/vm.h>
+#include <sys/emul.h>
+
+
+struct exec_cache_entry
+      {
+	struct exec_cache_entry	*next;		/*  LRU list, most  */
+	struct exec_cache_entry	*prev;		/*  recent first    */
+
+	struct vnode		*v;
+	struct vm_object	*vmobj;		/*  referenced  */
+	struct emul		*emul;
+
+	/*  To detect changes to the file:  */
+	time_t			mtime;
+	long			mtimensec;
+	off_t			size;
+
+	size_t			header_len;
+	byte			header [EXEC_CACHE_HEADERLEN];
+      };
+
+
+struct exec_cache_entry *exec_cache_first = NULL;
+struct exec_cache_entry *exec_cache_last = NULL;
+int exec_cache_entries = 0;
+
+/*  Statistics:  */
+u_int32_t exec_cache_hits = 0;
+u_int32_t exec_cache_misses = 0;
+
+
+
+void exec_cache__unlink (struct exec_cache_entry *e)
+  {
+    /*
+     *	Remove e from the LRU list. Interrupts should be disabled.
+     */
+
+    if (e->prev)
+	e->prev->next = e->next;
+    else
+	exec_cache_first = e->next;
+
+    if (e->next)
+	e->next->prev = e->prev;
+    else
+	exec_cache_last = e->prev;
+
+    e->next = e->prev = NULL;
+    exec_cache_entries --;
+  }
+
+
+
+void exec_cache__linkfirst (struct exec_cache_entry *e)
+  {
+    /*
+     *	Put e first in the LRU list. Interrupts should be disabled.
+     */
+
+    e->prev = NULL;
+    e->next = exec_cache_first;
+    if (exec_cache_first)
+	exec_cache_first->prev = e;
+    else
+	exec_cache_last = e;
+    exec_cache_first = e;
+    exec_cache_entries ++;
+  }
+
+
+
+struct exec_cache_entry *exec_cache__find (struct vnode *v)
+  {
+    /*
+     *	Find the entry for v, or NULL if v is not in the cache. Interrupts
+     *	should be disabled.
+     */
+
+    struct exec_cache_entry *e;
+
+    for (e=exec_cache_first; e; e=e->next)
+	if (e->v == v)
+	    return e;
+
+    return NULL;
+  }
+
+
+
+void exec_cache__free (struct exec_cache_entry *e)
+  {
+    /*
+     *	Drop an entry's reference to its vm_object, and free the entry.
+     *	(The entry must already be unlinked.) The object's pages are left
+     *	for the pageout daemon.
+     */
+
+    vm_object_free (e->vmobj);
+    free (e);
+  }
+
+
+
+int exec_cache__valid (struct exec_cache_entry *e)
+  {
+    return e->mtime == e->v->ss.st_mtime &&
+	e->mtimensec == e->v->ss.st_mtimensec && e->size == e->v->ss.st_size;
+  }
+
+
+
+struct emul *exec_cache_lookup (struct vnode *v, byte *header, size_t len)
+  {
+    /*
+     *	exec_cache_lookup ()
+     *	--------------------
+     *
+     *	If the program v is in the cache (and hasn't changed), then the
+     *	first len bytes of the file are copied to header, the entry
+     *	becomes the most recently used, and the emulation which handles
+     *	the program is returned. Otherwise NULL is returned.
+     */
+
+    struct exec_cache_entry *e;
+    struct emul *emul = NULL;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    e = exec_cache__find (v);
+    if (e && !exec_cache__valid (e))
+      {
+	exec_cache__unlink (e);
+	interrupts (oldints);
+	exec_cache__free (e);
+	exec_cache_misses ++;
+	return NULL;
+      }
+
+    if (e && len <= e->header_len)
+      {
+	memcpy (header, e->header, len);
+	emul = e->emul;
+
+	exec_cache__unlink (e);
+	exec_cache__linkfirst (e);
+      }
+
+    interrupts (oldints);
+
+    if (emul)
+	exec_cache_hits ++;
+    else
+	exec_cache_misses ++;
+
+    return emul;
+  }
+
+
+
+int exec_cache_header (struct vnode *v, void *header, size_t len)
+  {
+    /*
+     *	Copy the first len bytes of the program v from the cache to
+     *	header. Returns 0 on success, 1 if the program is not cached
+     *	(and the header has to be read from the file).
+     */
+
+    struct exec_cache_entry *e;
+    int oldints, res = 1;
+
+    oldints = interrupts (DISABLE);
+
+    e = exec_cache__find (v);
+    if (e && len <= e->header_len && exec_cache__valid (e))
+      {
+	memcpy (header, e->header, len);
+	res = 0;
+      }
+
+    interrupts (oldints);
+    return res;
+  }
+
+
+
+void exec_cache_enter (struct vnode *v, struct vm_object *vmobj,
+	struct emul *emul, byte *header, size_t len)
+  {
+    /*
+     *	exec_cache_enter ()
+     *	-------------------
+     *
+     *	Add program v (which has just been executed successfully) to the
+     *	cache, and take a reference to its vm_object. If the cache is
+     *	full, then the least recently used entry is dropped.
+     */
+
+    struct exec_cache_entry *e, *old = NULL;
+    int oldints;
+
+    e = (struct exec_cache_entry *) malloc (sizeof(struct exec_cache_entry));
+    if (!e)
+	return;
+
+    if (len > EXEC_CACHE_HEADERLEN)
+	len = EXEC_CACHE_HEADERLEN;
+
+    memset (e, 0, sizeof(struct exec_cache_entry));
+    e->v = v;
+    e->vmobj = vmobj;
+    e->emul = emul;
+    e->mtime = v->ss.st_mtime;
+    e->mtimensec = v->ss.st_mtimensec;
+    e->size = v->ss.st_size;
+    e->header_len = len;
+    memcpy (e->header, header, len);
+
+    lock (&vmobj->lock, "exec_cache_enter", LOCK_BLOCKING | LOCK_RW);
+    vmobj->refcount ++;
+    unlock (&vmobj->lock);
+
+    oldints = interrupts (DISABLE);
+
+    /*  Already there? (Two processes executing the same program.)  */
+    if (exec_cache__find (v))
+      {
+	interrupts (oldints);
+	exec_cache__free (e);
+	return;
+      }
+
+    exec_cache__linkfirst (e);
+
+    if (exec_cache_entries > EXEC_CACHE_SIZE)
+      {
+	old = exec_cache_last;
+	exec_cache__unlink (old);
+      }
+
+    interrupts (oldints);
+
+    if (old)
+	exec_cache__free (old);
+  }
+
+
+
+int exec_cache_shrink ()
+  {
+    /*
+     *	Drop the least recently used entry. Returns 1 if an entry was
+     *	dropped, 0 if the cache was empty.
+     */
+
+    struct exec_cache_entry *e;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    e = exec_cache_last;
+    if (e)
+	exec_cache__unlink (e);
+
+    interrupts (oldints);
+
+    if (!e)
+	return 0;
+
+    exec_cache__free (e);
+    return 1;
+  }
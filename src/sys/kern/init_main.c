@@ -56,6 +56,10 @@
  *	14 Jan 2000	calls device_init()
  *	26 Jul 2000	creates proc1 before mounting root
  *	19 Oct 2000	opens /dev/console instead of /dev/ttyC0
+ *	19 Oct 2026	starts the pageout daemon
+ *	19 Oct 2026	starts the context switch benchmark (BENCH_PSWITCH)
+ *	19 Oct 2026	starts the message buffer thread
+ *	19 Oct 2026	calls timepage_init()
  */
 
 
@@ -76,6 +80,8 @@
 #include <sys/syscalls.h>
 #include <sys/ports.h>
 #include <sys/interrupts.h>
+#include <sys/msgbuf.h>
+#include <sys/timepage.h>
 #include <sys/dma.h>
 #include <sys/timer.h>
 #include <sys/time.h>
@@ -163,6 +169,13 @@ int init_main ()
     interrupts (ENABLE);
 
 
+    /*
+     *	The time page, which is mapped into every process:
+     */
+
+    timepage_init ();
+
+
     /*
      *	Initialize statically linked modules
      */
@@ -170,6 +183,26 @@ int init_main ()
     staticmodules_init ();
 
 
+    /*
+     *	Start the pageout daemon  (the swap device is registered
+     *	by a statically linked module, so this must be done here)
+     */
+
+    vm_pageout_init ();
+
+
+    /*
+     *	From now on, printk() messages are shown on the console by
+     *	a kernel thread:
+     */
+
+    msgbuf_init ();
+
+#ifdef BENCH_PSWITCH
+    bench_pswitch_init ();
+#endif
+
+
     /*
      *	Create process 1
      *	(Only pids ranging from PID_MIN are represented in the pidbitmap,
@@ -62,6 +62,9 @@
  *  History:
  *	8 Dec 2000	first version, entering of partial command names
  *			supported. (help, reboot, version, continue, mdump)
+ *	19 Oct 2026	lockstat
+ *	19 Oct 2026	syscallstat
+ *	19 Oct 2026	flushes the message buffer on entry
  */
 
 
@@ -75,7 +78,12 @@
 #include <stdio.h>
 #include <sys/interrupts.h>
 #include <sys/lock.h>
+#include <sys/lockstat.h>
+#include <sys/syscallstat.h>
+#include <sys/msgbuf.h>
 #include <sys/md/machdep.h>
+#include <sys/vm.h>
+#include <sys/emul.h>
 
 
 extern char *compile_info, *compile_generation;
@@ -90,11 +98,18 @@ struct kdb_command kdb_cmds[] =
       {
 	{  "continue",	"Exit the debugger",		NULL /* special */  },
 	{  "help",	"Print a help message",		kdb_help  },
+#ifdef LOCKSTAT
+	{  "lockstat",	"Lock statistics ('reset' clears)", kdb_lockstat  },
+#endif
 	{  "mdump",	"Raw memory dump",		kdb_mdump  },
 	{  "modules",	"Print list of modules",	kdb_modules  },
 	{  "reboot",	"Force reboot",			kdb_reboot  },
 	{  "status",	"Print system status",		kdb_status  },
+#ifdef SYSCALLSTAT
+	{  "syscallstat", "Syscall statistics ('reset' clears)", kdb_syscallstat  },
+#endif
 	{  "version",	"Print OS version",		kdb_version  },
+	{  "vmstat",	"Print page fault statistics",	kdb_vmstat  },
 	{  NULL,	NULL,				NULL  }
       };
 
@@ -334,6 +349,18 @@ void kdb_status (char *s)
 			pp->lock.writelock_value, pp->wmesg);
 		kdb_print (buf);
 
+		/*  Waiting for a lock? Then show who is holding it:  */
+		if (pp->lock_flags & LOCK_WAITING)
+		  {
+		    struct lockstruct *l = (struct lockstruct *) pp->wchan;
+
+		    snprintf (buf, sizeof(buf), "    waiting for lock 0x%x, "
+			"held by pid %i ('%s'), %i readers\n", l,
+			l->owner? l->owner->pid : -1, l->writelock_value,
+			l->readlock_refcount);
+		    kdb_print (buf);
+		  }
+
 		if (pp->next == procqueue[i])
 		  pp = NULL;
 		else
@@ -358,6 +385,129 @@ void kdb_version (char *s)
 
 
 
+void kdb_vmstat (char *s)
+  {
+    /*
+     *	Print the number of minor and major page faults, and the
+     *	fault latency histograms (in cycles).
+     */
+
+    char buf[KDB_TMP_BUF_LEN];
+    int kind, i;
+
+    for (kind=VM_FAULT_MINOR; kind<=VM_FAULT_MAJOR; kind++)
+      {
+	snprintf (buf, sizeof(buf), "%s faults: %i\n",
+	    kind==VM_FAULT_MINOR? "minor" : "major", vm_fault_count[kind]);
+	kdb_print (buf);
+
+	for (i=0; i<VM_FAULT_HISTBUCKETS; i++)
+	  if (vm_fault_hist[kind][i])
+	    {
+		snprintf (buf, sizeof(buf), "  2^%i cycles: %i\n",
+		    i, vm_fault_hist[kind][i]);
+		kdb_print (buf);
+	    }
+      }
+
+    snprintf (buf, sizeof(buf), "shadow chain collapses: %i  bypasses: %i\n",
+	vm_object_collapses, vm_object_bypasses);
+    kdb_print (buf);
+
+    snprintf (buf, sizeof(buf), "zero page maps: %i  pool: %i pages, "
+	"%i hits, %i misses\n", vm_zeropage_maps, vm_zeropool_count,
+	vm_zeropool_hits, vm_zeropool_misses);
+    kdb_print (buf);
+
+    snprintf (buf, sizeof(buf), "pageout: %i passes, %i pages reclaimed\n",
+	vm_pageout_passes, vm_pageout_reclaimed);
+    kdb_print (buf);
+
+    snprintf (buf, sizeof(buf), "swap: %i of %i pages used, %i ins, "
+	"%i outs\n", vm_swap_used, vm_swap_nslots, vm_swap_ins, vm_swap_outs);
+    kdb_print (buf);
+
+    snprintf (buf, sizeof(buf), "shared file mappings: %i pages written "
+	"back, %i pages read ahead\n", vm_writeback_pages, vm_readahead_pages);
+    kdb_print (buf);
+
+    snprintf (buf, sizeof(buf), "exec cache: %i hits, %i misses\n",
+	exec_cache_hits, exec_cache_misses);
+    kdb_print (buf);
+  }
+
+
+
+#ifdef LOCKSTAT
+void kdb_lockstat (char *s)
+  {
+    /*
+     *	Print lock contention statistics, or clear them if the command
+     *	is followed by "reset".
+     */
+
+    char *buf;
+    size_t buflen = 8192;
+
+    while (*s && *s != ' ')
+	s++;
+    while (*s == ' ')
+	s++;
+
+    if (!strcmp ((unsigned char *) s, (unsigned char *) "reset"))
+      {
+	lockstat_reset ();
+	kdb_print ("lock statistics cleared\n");
+	return;
+      }
+
+    buf = (char *) malloc (buflen);
+    if (!buf)
+	return;
+
+    lockstat_print (buf, buflen);
+    kdb_print (buf);
+    free (buf);
+  }
+#endif
+
+
+
+#ifdef SYSCALLSTAT
+void kdb_syscallstat (char *s)
+  {
+    /*
+     *	Print syscall statistics, or clear them if the command is
+     *	followed by "reset".
+     */
+
+    char *buf;
+    size_t buflen = 8192;
+
+    while (*s && *s != ' ')
+	s++;
+    while (*s == ' ')
+	s++;
+
+    if (!strcmp ((unsigned char *) s, (unsigned char *) "reset"))
+      {
+	syscallstat_reset ();
+	kdb_print ("syscall statistics cleared\n");
+	return;
+      }
+
+    buf = (char *) malloc (buflen);
+    if (!buf)
+	return;
+
+    syscallstat_print (buf, buflen);
+    kdb_print (buf);
+    free (buf);
+  }
+#endif
+
+
+
 /********    End of MI kdb_* commands    ********/
 
 
@@ -380,6 +530,7 @@ void kdb ()
     void (*func)();
 
     oldints = interrupts (DISABLE);
+    msgbuf_flush ();
     kdb_initconsole ();
 
     while (1)
@@ -0,0 +1,235 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/kprof.c  --  statistical kernel profiler
+ *
+ *	When KPROF is defined in config.h, the machine dependant clock
+ *	interrupt code calls kprof_sample() with the interrupted program
+ *	counter while profiling is running. (This is either the system
+ *	timer, at HZ, or a faster clock; see machdep_kprof_start().)
+ *
+ *	Kernel PCs are counted in a histogram covering the kernel's text,
+ *	with one bucket per 2^KPROF_SHIFT bytes. User PCs are only counted,
+ *	unless a pid has been selected, in which case that process' PCs
+ *	below KPROF_USERBUCKETS << KPROF_SHIFT get a histogram of their own.
+ *	Samples outside both histograms are counted as "other".
+ *
+ *	Profiling is controlled by writing "start", "stop", "reset" or
+ *	"pid N" (0 = none) to /proc/kprof, and reading /proc/kprof gives
+ *	the non-empty buckets. bin/misc/kprof maps them to symbols.
+ *
+ *	kprof_sample ()
+ *		Record one sample.  (Called with interrupts disabled.)
+ *
+ *	kprof_control ()
+ *		Start, stop or reset profiling.
+ *
+ *	kprof_print ()
+ *		Print the histograms as text.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/errno.h>
+#include <sys/proc.h>
+#include <sys/kprof.h>
+
+
+#ifdef KPROF
+
+
+extern volatile struct proc *curproc;
+
+volatile int kprof_running = 0;
+int kprof_rate = 0;			/*  samples per second  */
+
+u_int32_t *kprof_hist = NULL;		/*  kernel histogram  */
+size_t kprof_lowpc, kprof_highpc;
+size_t kprof_nbuckets;
+
+pid_t kprof_pid = 0;			/*  process to profile in userland  */
+u_int32_t kprof_userhist [KPROF_USERBUCKETS];
+
+u_int32_t kprof_samples = 0;
+u_int32_t kprof_usersamples = 0;
+u_int32_t kprof_other = 0;
+
+
+
+void kprof_sample (size_t pc, int usermode)
+  {
+    size_t i;
+
+    kprof_samples ++;
+
+    if (usermode)
+      {
+	kprof_usersamples ++;
+	if (!kprof_pid || !curproc || curproc->pid != kprof_pid)
+	    return;
+
+	i = pc >> KPROF_SHIFT;
+	if (i < KPROF_USERBUCKETS)
+	    kprof_userhist [i] ++;
+	else
+	    kprof_other ++;
+	return;
+      }
+
+    if (pc >= kprof_lowpc && pc < kprof_highpc)
+	kprof_hist [(pc - kprof_lowpc) >> KPROF_SHIFT] ++;
+    else
+	kprof_other ++;
+  }
+
+
+
+void kprof__reset ()
+  {
+    if (kprof_hist)
+	memset (kprof_hist, 0, sizeof(u_int32_t) * kprof_nbuckets);
+    memset (kprof_userhist, 0, sizeof(kprof_userhist));
+    kprof_samples = kprof_usersamples = kprof_other = 0;
+  }
+
+
+
+int kprof_control (char *cmd)
+  {
+    /*
+     *	kprof_control ()
+     *	----------------
+     *
+     *	Handle a command written to /proc/kprof. The kernel histogram is
+     *	allocated the first time profiling is started. Returns 0 on
+     *	success, errno on error.
+     */
+
+    int oldints, res = 0;
+    size_t len;
+
+    oldints = interrupts (DISABLE);
+
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "start"))
+      {
+	if (kprof_running)
+	    goto done;
+
+	if (!kprof_hist)
+	  {
+	    machdep_kprof_range (&kprof_lowpc, &kprof_highpc);
+	    kprof_nbuckets = ((kprof_highpc - kprof_lowpc) >> KPROF_SHIFT) + 1;
+	    len = sizeof(u_int32_t) * kprof_nbuckets;
+	    kprof_hist = (u_int32_t *) malloc (len);
+	    if (!kprof_hist)
+	      {
+		res = ENOMEM;
+		goto done;
+	      }
+	    memset (kprof_hist, 0, len);
+	  }
+
+	kprof_rate = machdep_kprof_start ();
+	if (!kprof_rate)
+	  {
+	    res = ENODEV;
+	    goto done;
+	  }
+
+	kprof_running = 1;
+      }
+    else
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "stop"))
+      {
+	if (kprof_running)
+	    machdep_kprof_stop ();
+	kprof_running = 0;
+      }
+    else
+    if (!strcmp ((unsigned char *) cmd, (unsigned char *) "reset"))
+	kprof__reset ();
+    else
+    if (!strncmp ((unsigned char *) cmd, (unsigned char *) "pid ", 4))
+      {
+	kprof_pid = 0;
+	for (cmd+=4; *cmd >= '0' && *cmd <= '9'; cmd++)
+	    kprof_pid = kprof_pid * 10 + (*cmd - '0');
+	memset (kprof_userhist, 0, sizeof(kprof_userhist));
+      }
+    else
+	res = EINVAL;
+
+done:
+    interrupts (oldints);
+    return res;
+  }
+
+
+
+size_t kprof_print (char *buf, size_t buflen)
+  {
+    /*
+     *	kprof_print ()
+     *	--------------
+     *
+     *	The first line describes the profile. Then follows one line per
+     *	non-empty bucket: "k addr count" for the kernel, "u addr count"
+     *	for the selected process. addr is the lowest address covered by
+     *	the bucket. Output stops when buf is nearly full.
+     *
+     *	Returns the number of chars printed.
+     */
+
+    size_t len = 0, i;
+
+    len += snprintf (buf+len, buflen-len, "kprof: running %i rate %i "
+	"shift %i samples %u user %u other %u pid %i\n", kprof_running,
+	kprof_rate, KPROF_SHIFT, kprof_samples, kprof_usersamples,
+	kprof_other, kprof_pid);
+
+    for (i=0; kprof_hist && i<kprof_nbuckets && buflen-len >= 32; i++)
+      if (kprof_hist[i])
+	len += snprintf (buf+len, buflen-len, "k %x %u\n",
+	    kprof_lowpc + (i << KPROF_SHIFT), kprof_hist[i]);
+
+    for (i=0; kprof_pid && i<KPROF_USERBUCKETS && buflen-len >= 32; i++)
+      if (kprof_userhist[i])
+	len += snprintf (buf+len, buflen-len, "u %x %u\n",
+	    i << KPROF_SHIFT, kprof_userhist[i]);
+
+    return len;
+  }
+
+
+#endif	/*  KPROF  */
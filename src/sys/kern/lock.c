@@ -26,11 +26,37 @@
 /*
  *  kern/lock.c  --  resource locking
  *
+ *	A lockstruct is a sleeping reader/writer lock. Any number of readers
+ *	(LOCK_RO), or one writer (LOCK_RW), may hold the lock at a time.
+ *
+ *	Processes which have to wait are put in the lock's FIFO wait queue
+ *	(linked through p->lock_next), and sleep with the lock address as
+ *	wchan. unlock() hands the lock over directly to the first waiter
+ *	(or to all readers at the front of the queue), and wakes up only
+ *	those processes. A woken process already holds the lock, so nobody
+ *	can get in between.
+ *
+ *	Writers are preferred: a reader which finds writers waiting queues
+ *	up behind them, even if the lock is only read locked. (This means
+ *	that a process must not take a read lock which it already holds.)
+ *
+ *	The write holder and the time spent waiting are recorded in the
+ *	lockstruct. With LOCKSTAT, every acquisition and release is also
+ *	reported to kern/lockstat.c.
+ *
+ *	lock ()
+ *		Lock a resource, possibly waiting for it.
+ *
+ *	unlock ()
+ *		Unlock a resource, and hand it over to the next waiter(s).
  *
  *  History:
  *	14 Apr 2000	test
  *	7 Jun 2000	if DEBUGLEVEL>5 then we printk lock values...
  *	13 Dec 2000	combined readonly/readwrite locks (lockstruct)
+ *	19 Oct 2026	sleeping locks with a wait queue and hand-over,
+ *			writer preference, holder and wait time
+ *	19 Oct 2026	LOCKSTAT hooks
  */
 
 
@@ -40,6 +66,80 @@
 #include <sys/interrupts.h>
 #include <sys/proc.h>
 #include <sys/lock.h>
+#include <sys/lockstat.h>
+#include <sys/md/machdep.h>
+
+
+extern volatile struct proc *curproc;
+extern volatile int need_to_pswitch;
+
+
+
+int lock__free (struct lockstruct *lockaddr, int writeflag)
+  {
+    /*
+     *	Returns 1 if the lock can be taken right away. Readers don't get
+     *	past waiting writers. Interrupts should be disabled.
+     */
+
+    if (lockaddr->writelock_value)
+	return 0;
+
+    if (writeflag)
+	return lockaddr->readlock_refcount == 0 && !lockaddr->waiting_proc;
+
+    return lockaddr->writers_waiting == 0;
+  }
+
+
+
+void lock__handover (struct lockstruct *lockaddr)
+  {
+    /*
+     *	The lock has become free. Give it to the first process in the wait
+     *	queue if that is a writer, otherwise to all readers at the front
+     *	of the queue. Interrupts should be disabled.
+     */
+
+    struct proc *p;
+
+    p = lockaddr->waiting_proc;
+    if (!p)
+	return;
+
+#ifdef LOCKSTAT
+    lockaddr->lockstat_since = machdep_cyclecounter ();
+    lockaddr->lockstat_name = p->lock_value;
+#endif
+
+    if (p->lock_flags & LOCK_RW)
+      {
+	lockaddr->waiting_proc = p->lock_next;
+	lockaddr->writers_waiting --;
+	lockaddr->writelock_value = p->lock_value;
+	lockaddr->owner = p;
+
+	p->lock_next = NULL;
+	p->lock_flags &= ~LOCK_WAITING;
+	if (p->status == P_SLEEP)
+	    wakeup_proc (p);
+      }
+    else
+	while (p && !(p->lock_flags & LOCK_RW))
+	  {
+	    lockaddr->waiting_proc = p->lock_next;
+	    lockaddr->readlock_refcount ++;
+
+	    p->lock_next = NULL;
+	    p->lock_flags &= ~LOCK_WAITING;
+	    if (p->status == P_SLEEP)
+		wakeup_proc (p);
+
+	    p = lockaddr->waiting_proc;
+	  }
+
+    need_to_pswitch = 1;
+  }
 
 
 
@@ -51,15 +151,20 @@ int lock (struct lockstruct *lockaddr, char *lockvalue, int flags)
      *
      *	Lock a kernel resource.
      *
+     *	If the lock can't be taken right away and LOCK_BLOCKING is set,
+     *	then the caller is put last in the lock's wait queue, and sleeps
+     *	until unlock() has handed over the lock to it. (Before any process
+     *	has been started, there is no one to hand over to, so then we
+     *	simply wait for an interrupt handler to release the lock.)
+     *
      *	Return values are:
      *		0    lock ok
      *		-1   could not lock, and blocking==0
-     *
-     *	TODO: Is it better tojust set need_to_pswitch than to do a pswitch()
-     *	call manually?
      */
 
-    int oldints;
+    struct proc *p, *q;
+    u_int64_t starttime = 0;
+    int oldints, spin;
     int writeflag, blocking;
 
     oldints = interrupts (DISABLE);
@@ -77,18 +182,15 @@ int lock (struct lockstruct *lockaddr, char *lockvalue, int flags)
 
 
     /*  Resource not locked? Then lock it and return successfully:  */
-    if (!(lockaddr->writelock_value))
-      {
-	if (!writeflag || lockaddr->readlock_refcount==0)
-	  goto lock_and_return;
-      }
+    if (lock__free (lockaddr, writeflag))
+	goto lock_and_return;
 
 
     /*
      *	We are here if the resource was locked by someone else...
      *
      *	If the caller didn't use the LOCK_BLOCKING flag, then return -1
-     *	immediately. Otherwise, let's loop forever until we get the lock:
+     *	immediately.
      */
 
     if (!blocking)
@@ -97,35 +199,93 @@ int lock (struct lockstruct *lockaddr, char *lockvalue, int flags)
 	return -1;
       }
 
-    while (1)
+    starttime = machdep_cyclecounter ();
+    lockaddr->nr_contended ++;
+
+    if (!curproc)
       {
-int i=0;
+	while (!lock__free (lockaddr, writeflag))
+	  {
+	    interrupts (ENABLE);
+	    interrupts (DISABLE);
+	  }
 
-	interrupts (ENABLE);
-//	sleep ((void *)lockaddr, "lock");
+	lockaddr->wait_cycles += machdep_cyclecounter () - starttime;
+	goto lock_and_return;
+      }
 
-i++;
-if (i==2000)
-  {
-    printk ("waiting for 0x%x (%s)", lockaddr, lockvalue);
-  }
 
+    /*
+     *	Spinning is only worth it if the write holder is running (on
+     *	another cpu), and may soon unlock:
+     */
+
+    for (spin=0; spin<LOCK_SPINCOUNT && lockaddr->owner &&
+	 lockaddr->owner != curproc && lockaddr->owner->status == P_RUN; spin++)
+      {
+	interrupts (ENABLE);
 	interrupts (DISABLE);
 
-	if (!(lockaddr->writelock_value))
+	if (lock__free (lockaddr, writeflag))
 	  {
-	    if (!writeflag || lockaddr->readlock_refcount==0)
-	      goto lock_and_return;
+	    lockaddr->wait_cycles += machdep_cyclecounter () - starttime;
+	    goto lock_and_return;
 	  }
       }
 
-    panic ("lock: not reached");
+
+    /*  Put ourselves last in the wait queue:  */
+    p = (struct proc *) curproc;
+    p->lock_next = NULL;
+    p->lock_value = lockvalue;
+    p->lock_flags = (flags & LOCK_RW) | LOCK_WAITING;
+
+    if (writeflag)
+	lockaddr->writers_waiting ++;
+
+    q = lockaddr->waiting_proc;
+    if (!q)
+	lockaddr->waiting_proc = p;
+    else
+      {
+	while (q->lock_next)
+	    q = q->lock_next;
+	q->lock_next = p;
+      }
+
+    /*  Sleep until unlock() has given us the lock:  (other wakeups,
+	for example by signals, are ignored)  */
+    while (p->lock_flags & LOCK_WAITING)
+	sleep ((void *) lockaddr, lockvalue);
+
+    lockaddr->wait_cycles += machdep_cyclecounter () - starttime;
+
+#ifdef LOCKSTAT
+    lockstat_acquire (lockaddr, lockvalue, 1,
+	machdep_cyclecounter () - starttime);
+#endif
+
+    interrupts (oldints);
+    return 0;
 
 
 lock_and_return:
 
+#ifdef LOCKSTAT
+    if (!lockaddr->writelock_value && !lockaddr->readlock_refcount)
+      {
+	lockaddr->lockstat_since = machdep_cyclecounter ();
+	lockaddr->lockstat_name = lockvalue;
+      }
+    lockstat_acquire (lockaddr, lockvalue, starttime != 0,
+	starttime? machdep_cyclecounter () - starttime : 0);
+#endif
+
     if (writeflag)
-      lockaddr->writelock_value = lockvalue;
+      {
+	lockaddr->writelock_value = lockvalue;
+	lockaddr->owner = (struct proc *) curproc;
+      }
     else
       lockaddr->readlock_refcount ++;
 
@@ -141,6 +301,9 @@ int unlock (struct lockstruct *lockaddr)
      *	unlock ()
      *	---------
      *
+     *	If the lock becomes free, and there are waiters, then the lock
+     *	is handed over to the first of them.
+     *
      *	Returns 0 on success, or -1 if the resource was NOT locked.
      */
 
@@ -163,28 +326,34 @@ int unlock (struct lockstruct *lockaddr)
 		lockaddr->writelock_value);
 
 	lockaddr->writelock_value = NULL;
-	interrupts (oldints);
-	return 0;
+	lockaddr->owner = NULL;
       }
-
-    /*  Read lock?  */
-    if (lockaddr->readlock_refcount == 0)
+    else
       {
+	/*  Read lock?  */
+	if (lockaddr->readlock_refcount == 0)
+	  {
 #if DEBUGLEVEL>=2
-	printk ("unlock: trying to unlock non-locked resource "
+	    printk ("unlock: trying to unlock non-locked resource "
 		"(refcount problems)");
 #endif
-	interrupts (oldints);
-	return -1;
+	    interrupts (oldints);
+	    return -1;
+	  }
+
+	/*  Yes, it was a read lock:  */
+	lockaddr->readlock_refcount --;
       }
 
-    /*  Yes, it was a read lock:  */
-    lockaddr->readlock_refcount --;
+    if (lockaddr->readlock_refcount == 0)
+      {
+#ifdef LOCKSTAT
+	lockstat_release (lockaddr, lockaddr->lockstat_name,
+	    machdep_cyclecounter () - lockaddr->lockstat_since);
+#endif
+	lock__handover (lockaddr);
+      }
 
     interrupts (oldints);
-
-    /*  TODO: This wakeup should really be a "wakeup_one" or something:  */
-    wakeup ((void *)lockaddr);
     return 0;
   }
-
@@ -0,0 +1,301 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/lockstat.c  --  lock contention statistics
+ *
+ *	When LOCKSTAT is defined in config.h, lock() and unlock() report
+ *	every acquisition and release here. Statistics are kept per lock
+ *	name (the lockvalue string passed to lock(), which identifies the
+ *	code path), and per lock (the address of the lockstruct). Both
+ *	tables are small open addressed hash tables; when a table is full,
+ *	new names or locks are counted in lockstat_overflows instead.
+ *
+ *	Times are in machdep_cyclecounter() units. The hold time is
+ *	counted from when the lock goes from free to held, until it is
+ *	free again, and is accounted to the name used when it was taken.
+ *	The tables are protected by disabling interrupts.
+ *
+ *	lockstat_acquire ()
+ *		Called by lock() when a lock has been taken.
+ *
+ *	lockstat_release ()
+ *		Called by unlock() when a lock becomes free.
+ *
+ *	lockstat_reset ()
+ *		Clear all statistics.
+ *
+ *	lockstat_print ()
+ *		Print the statistics as text.  (Used by kdb and procfs.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/std.h>
+#include <sys/interrupts.h>
+#include <sys/lock.h>
+#include <sys/lockstat.h>
+
+
+#ifdef LOCKSTAT
+
+
+struct lockstat_entry lockstat_names [LOCKSTAT_NAMES];
+struct lockstat_entry lockstat_locks [LOCKSTAT_LOCKS];
+u_int32_t lockstat_overflows = 0;
+
+
+
+size_t lockstat__hashname (char *name)
+  {
+    size_t h = 0;
+
+    while (*name)
+	h = h * 31 + (unsigned char) *name++;
+
+    return h;
+  }
+
+
+
+struct lockstat_entry *lockstat__name (char *name)
+  {
+    /*
+     *	Find (or create) the entry for a lock name. Different pointers
+     *	to equal strings share one entry. Returns NULL if the table is
+     *	full. Interrupts should be disabled.
+     */
+
+    size_t h, i;
+
+    if (!name)
+	name = "(null)";
+
+    h = lockstat__hashname (name) % LOCKSTAT_NAMES;
+    for (i=0; i<LOCKSTAT_NAMES; i++)
+      {
+	if (!lockstat_names[h].name)
+	  {
+	    lockstat_names[h].name = name;
+	    return &lockstat_names[h];
+	  }
+
+	if (lockstat_names[h].name == name || !strcmp
+	    ((unsigned char *) lockstat_names[h].name, (unsigned char *) name))
+	    return &lockstat_names[h];
+
+	h = (h + 1) % LOCKSTAT_NAMES;
+      }
+
+    return NULL;
+  }
+
+
+
+struct lockstat_entry *lockstat__lock (struct lockstruct *l)
+  {
+    /*
+     *	Find (or create) the entry for a lock. Returns NULL if the table
+     *	is full. Interrupts should be disabled.
+     */
+
+    size_t h, i;
+
+    h = ((size_t) l >> 2) % LOCKSTAT_LOCKS;
+    for (i=0; i<LOCKSTAT_LOCKS; i++)
+      {
+	if (!lockstat_locks[h].lockaddr)
+	  {
+	    lockstat_locks[h].lockaddr = (void *) l;
+	    return &lockstat_locks[h];
+	  }
+
+	if (lockstat_locks[h].lockaddr == (void *) l)
+	    return &lockstat_locks[h];
+
+	h = (h + 1) % LOCKSTAT_LOCKS;
+      }
+
+    return NULL;
+  }
+
+
+
+void lockstat__acquire (struct lockstat_entry *e, int contended,
+	u_int64_t waited)
+  {
+    e->acquired ++;
+    if (!contended)
+	return;
+
+    e->contended ++;
+    e->wait_total += waited;
+    if (waited > e->wait_max)
+	e->wait_max = waited;
+  }
+
+
+
+void lockstat__release (struct lockstat_entry *e, u_int64_t held)
+  {
+    e->hold_total += held;
+    if (held > e->hold_max)
+	e->hold_max = held;
+  }
+
+
+
+void lockstat_acquire (struct lockstruct *l, char *name, int contended,
+	u_int64_t waited)
+  {
+    struct lockstat_entry *e;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    e = lockstat__name (name);
+    if (e)
+	lockstat__acquire (e, contended, waited);
+    else
+	lockstat_overflows ++;
+
+    e = lockstat__lock (l);
+    if (e)
+      {
+	/*  Remember the most recent name used with this lock:  */
+	e->name = name;
+	lockstat__acquire (e, contended, waited);
+      }
+    else
+	lockstat_overflows ++;
+
+    interrupts (oldints);
+  }
+
+
+
+void lockstat_release (struct lockstruct *l, char *name, u_int64_t held)
+  {
+    struct lockstat_entry *e;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    e = lockstat__name (name);
+    if (e)
+	lockstat__release (e, held);
+
+    e = lockstat__lock (l);
+    if (e)
+	lockstat__release (e, held);
+
+    interrupts (oldints);
+  }
+
+
+
+void lockstat_reset ()
+  {
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    memset (lockstat_names, 0, sizeof(lockstat_names));
+    memset (lockstat_locks, 0, sizeof(lockstat_locks));
+    lockstat_overflows = 0;
+    interrupts (oldints);
+  }
+
+
+
+size_t lockstat__line (char *buf, size_t buflen, char *title,
+	struct lockstat_entry *e)
+  {
+    /*  One line of output. Times are in units of 1024 cycles.  */
+
+    return snprintf (buf, buflen, "%s %u %u %u %u %u %u\n", title,
+	e->acquired, e->contended,
+	(u_int32_t) (e->wait_total >> 10), (u_int32_t) (e->wait_max >> 10),
+	(u_int32_t) (e->hold_total >> 10), (u_int32_t) (e->hold_max >> 10));
+  }
+
+
+
+size_t lockstat_print (char *buf, size_t buflen)
+  {
+    /*
+     *	lockstat_print ()
+     *	-----------------
+     *
+     *	Print statistics for all lock names which have been used, and for
+     *	all locks which have been contended, to buf (at most buflen-1
+     *	chars). Output stops when buf is nearly full.
+     *
+     *	Returns the number of chars printed.
+     */
+
+    char title [80];
+    size_t len = 0, i;
+    int oldints;
+
+    if (buflen < 256)
+	return 0;
+
+    oldints = interrupts (DISABLE);
+
+    len += snprintf (buf+len, buflen-len, "lockstat: times in units "
+	"of 1024 cycles, %u overflows\n", lockstat_overflows);
+    len += snprintf (buf+len, buflen-len, "name acquired contended "
+	"wait_total wait_max hold_total hold_max\n");
+
+    for (i=0; i<LOCKSTAT_NAMES && buflen-len >= 128; i++)
+      if (lockstat_names[i].name && lockstat_names[i].acquired)
+	len += lockstat__line (buf+len, buflen-len,
+	    lockstat_names[i].name, &lockstat_names[i]);
+
+    if (buflen-len >= 128)
+	len += snprintf (buf+len, buflen-len, "contended locks:\n");
+
+    for (i=0; i<LOCKSTAT_LOCKS && buflen-len >= 128; i++)
+      if (lockstat_locks[i].lockaddr && lockstat_locks[i].contended)
+	{
+	  snprintf (title, sizeof(title), "0x%x(%s)",
+		(u_int32_t) lockstat_locks[i].lockaddr,
+		lockstat_locks[i].name? lockstat_locks[i].name : "");
+	  len += lockstat__line (buf+len, buflen-len, title,
+		&lockstat_locks[i]);
+	}
+
+    interrupts (oldints);
+    return len;
+  }
+
+
+#endif	/*  LOCKSTAT  */
+
@@ -70,6 +70,7 @@
  *	3 Jan 2000	more comments
  *	14 Jan 2000	interrupts enable/disable
  *	7 Mar 2000	adding next and prev fields to mcb
+ *	19 Oct 2026	wakeup(&malloc_lowwater) when free memory runs low
  */
 
 
@@ -78,6 +79,7 @@
 #include <sys/std.h>
 #include <sys/md/machdep.h>	/*  for PAGESIZE  */
 #include <sys/interrupts.h>
+#include <sys/proc.h>
 #include "../config.h"
 
 
@@ -99,6 +101,19 @@ u_int64_t malloc_totalrequested;	/*  The ratio between these two gives the  */
 u_int64_t malloc_totalallocated;	/*  effectiveness (memorywise) of the system  */
 
 
+/*
+ *  When free memory drops below malloc_lowwater bytes, malloc() does a
+ *  wakeup(&malloc_lowwater), once. The one who sleeps on malloc_lowwater
+ *  (the pageout daemon) clears malloc_lowwater_woken before going back
+ *  to sleep. malloc_lowwater = 0 means no wakeups.
+ */
+
+size_t		malloc_lowwater = 0;
+volatile int	malloc_lowwater_woken = 0;
+
+extern volatile struct proc *curproc;
+
+
 
 void malloc_init ()
   {
@@ -510,6 +525,14 @@ void *malloc (size_t len)
     malloc_totalallocated += bsize;
     malloc_totalfreememory -= bsize;
 
+    /*  (wakeup() does nothing useful before the first process runs)  */
+    if (malloc_totalfreememory < malloc_lowwater && !malloc_lowwater_woken
+	&& curproc)
+      {
+	malloc_lowwater_woken = 1;
+	wakeup (&malloc_lowwater);
+      }
+
     interrupts (oldints);
 
     return retvalue;
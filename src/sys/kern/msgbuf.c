@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/msgbuf.c  --  kernel message buffer
+ *
+ *	printk() used to render each message on the console immediately,
+ *	character by character, in whatever context it was called from
+ *	(including interrupt handlers). Instead, messages are now appended
+ *	to msgbuf[], a ring of MSGBUF_SIZE chars with one line per message,
+ *	and a kernel thread copies new lines to the console whenever it
+ *	gets to run. The ring also keeps the most recent messages around
+ *	for dmesg (/proc/dmesg).
+ *
+ *	Before the first process is running, and when something has gone
+ *	badly wrong (panic() and kdb), the ring is flushed to the console
+ *	synchronously instead.
+ *
+ *	There is only one cpu, so appending to the ring simply means
+ *	copying the chars with interrupts disabled. msgbuf_head and
+ *	msgbuf_conspos count all chars ever written and shown on the
+ *	console; if the console falls more than MSGBUF_SIZE chars behind,
+ *	then the oldest lines are not shown there.
+ *
+ *	msgbuf_putline ()
+ *		Append a line to the ring.  (Called by printk().)
+ *
+ *	msgbuf_flush ()
+ *		Show all pending lines on the console, now.
+ *
+ *	msgbuf_init ()
+ *		Start the kernel thread which drains the ring.
+ *
+ *	msgbuf_print ()
+ *		Copy the contents of the ring to a buffer.  (For procfs.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/std.h>
+#include <sys/console.h>
+#include <sys/interrupts.h>
+#include <sys/proc.h>
+#include <sys/msgbuf.h>
+
+
+extern volatile struct proc *curproc;
+extern int printk_enabled;
+
+char msgbuf [MSGBUF_SIZE];
+volatile u_int32_t msgbuf_head = 0;	/*  chars ever written  */
+volatile u_int32_t msgbuf_conspos = 0;	/*  chars ever shown (or skipped)  */
+u_int32_t msgbuf_lost = 0;		/*  skipped, not yet reported  */
+
+struct proc *msgbuf_proc = NULL;
+volatile int msgbuf_proc_waiting = 0;
+
+/*  Longer lines are shown on the console in pieces:  */
+#define	MSGBUF_LINELEN		256
+
+
+
+void msgbuf_putline (char *s)
+  {
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    while (*s)
+	msgbuf [msgbuf_head++ & (MSGBUF_SIZE-1)] = *s++;
+    msgbuf [msgbuf_head++ & (MSGBUF_SIZE-1)] = '\n';
+
+    if (msgbuf_head - msgbuf_conspos > MSGBUF_SIZE)
+      {
+	msgbuf_lost += msgbuf_head - MSGBUF_SIZE - msgbuf_conspos;
+	msgbuf_conspos = msgbuf_head - MSGBUF_SIZE;
+      }
+
+    /*  No thread to do it for us? Then show the line now:  */
+    if (!msgbuf_proc || !curproc)
+      {
+	interrupts (oldints);
+	msgbuf_flush ();
+	return;
+      }
+
+    if (msgbuf_proc_waiting)
+      {
+	msgbuf_proc_waiting = 0;
+	wakeup ((void *) &msgbuf_proc_waiting);
+      }
+
+    interrupts (oldints);
+  }
+
+
+
+int msgbuf_getline (char *line)
+  {
+    /*
+     *	Remove the next line (at most MSGBUF_LINELEN-1 chars of it) which
+     *	hasn't been shown on the console yet from the ring, and copy it to
+     *	line. Returns 1 if there was a line, 0 otherwise.
+     */
+
+    int oldints, len = 0;
+    char c;
+
+    oldints = interrupts (DISABLE);
+
+    if (msgbuf_lost)
+      {
+	snprintf (line, MSGBUF_LINELEN, "msgbuf: %i chars were not shown",
+	    msgbuf_lost);
+	msgbuf_lost = 0;
+	interrupts (oldints);
+	return 1;
+      }
+
+    if (msgbuf_conspos == msgbuf_head)
+      {
+	interrupts (oldints);
+	return 0;
+      }
+
+    while (msgbuf_conspos != msgbuf_head && len < MSGBUF_LINELEN-1)
+      {
+	c = msgbuf [msgbuf_conspos++ & (MSGBUF_SIZE-1)];
+	if (c == '\n')
+	    break;
+	line [len++] = c;
+      }
+    line [len] = '\0';
+
+    interrupts (oldints);
+    return 1;
+  }
+
+
+
+void msgbuf_flush ()
+  {
+    char line [MSGBUF_LINELEN];
+
+    while (msgbuf_getline (line))
+	if (printk_enabled)
+	    console_puts (line, CONSOLE_KERNEL_COLOR);
+  }
+
+
+
+void msgbuf_daemon ()
+  {
+    /*
+     *	The message buffer thread: show new lines on the console, and
+     *	sleep until msgbuf_putline() wakes us up again.
+     */
+
+    int oldints;
+
+    for (;;)
+      {
+	msgbuf_flush ();
+
+	oldints = interrupts (DISABLE);
+	if (msgbuf_conspos == msgbuf_head && !msgbuf_lost)
+	  {
+	    msgbuf_proc_waiting = 1;
+	    sleep ((void *) &msgbuf_proc_waiting, "msgbuf");
+	  }
+	interrupts (oldints);
+      }
+  }
+
+
+
+void msgbuf_init ()
+  {
+    /*
+     *	Create the message buffer thread. It is created asleep, and
+     *	started by the first printk() after process 1 is running. Until
+     *	then (or if it can't be created), messages are shown directly.
+     */
+
+    struct proc *p;
+
+    msgbuf_proc_waiting = 1;
+    p = proc_kthread_create (msgbuf_daemon, (void *) &msgbuf_proc_waiting,
+	"msgbuf");
+    if (!p)
+      {
+	msgbuf_proc_waiting = 0;
+	printk ("msgbuf_init(): could not create the msgbuf thread");
+	return;
+      }
+
+    msgbuf_proc = p;
+  }
+
+
+
+size_t msgbuf_print (char *buf, size_t buflen)
+  {
+    /*
+     *	Copy the whole lines in the ring, oldest first, to buf (at most
+     *	buflen-1 chars, nul terminated). Returns the number of chars.
+     */
+
+    u_int32_t pos, n;
+    size_t len = 0;
+    int oldints;
+
+    if (buflen < 1)
+	return 0;
+
+    oldints = interrupts (DISABLE);
+
+    n = msgbuf_head < MSGBUF_SIZE? msgbuf_head : MSGBUF_SIZE;
+    if (n > buflen - 1)
+	n = buflen - 1;
+    pos = msgbuf_head - n;
+
+    /*
+     *	Skip the partial line at the start, if any. If the whole ring is
+     *	copied, then the char before pos has been overwritten (by the
+     *	newest char), so we can't tell and must always skip:
+     */
+    if (pos > 0 && (n == MSGBUF_SIZE
+	|| msgbuf [(pos-1) & (MSGBUF_SIZE-1)] != '\n'))
+	while (pos != msgbuf_head && msgbuf [pos++ & (MSGBUF_SIZE-1)] != '\n')
+	    ;
+
+    while (pos != msgbuf_head)
+	buf [len++] = msgbuf [pos++ & (MSGBUF_SIZE-1)];
+    buf [len] = '\0';
+
+    interrupts (oldints);
+    return len;
+  }
@@ -61,6 +61,9 @@
  *	proc_remove()
  *		Remove a process from memory (and the process queue)
  *
+ *	proc_kthread_create()
+ *		Create a kernel thread.
+ *
  *	superuser()
  *		Returns 1 if the uid of curproc is zero.
  *
@@ -100,6 +103,12 @@
  *	22 Mar 2000	reserving space for filedescriptors in proc_alloc()
  *	3 Nov 2000	adding find_proc_by_pid()
  *	7 Nov 2000	adding proc_exit()
+ *	19 Oct 2026	the idle loop in pswitch() fills the zero page pool
+ *	19 Oct 2026	adding proc_kthread_create()
+ *	19 Oct 2026	proc_exit() gives back a vfork() parent's address space
+ *	19 Oct 2026	proc_remove() frees per-process syscall statistics
+ *	19 Oct 2026	event trace points in pswitch(), sleep() and wakeup()
+ *	19 Oct 2026	adding superuser()
  */
 
 
@@ -112,6 +121,8 @@
 #include <sys/vm.h>
 #include <sys/errno.h>
 #include <sys/syscalls.h>
+#include <sys/syscallstat.h>
+#include <sys/evtrace.h>
 #include <string.h>
 
 
@@ -316,6 +327,10 @@ int proc_remove (struct proc *p)
     if (p->fcntl_dflag)
 	free (p->fcntl_dflag);
 
+#ifdef SYSCALLSTAT
+    syscallstat_procfree (p);
+#endif
+
     /*	Free the process structure itself:  */
     free (p);
 
@@ -327,6 +342,89 @@ int proc_remove (struct proc *p)
 
 
 
+struct proc *proc_kthread_create (void (*func)(), void *wchan, char *wmesg)
+  {
+    /*
+     *	proc_kthread_create ()
+     *	----------------------
+     *
+     *	Create a kernel thread, ie. a process which runs func() in kernel
+     *	mode and has no userland. The thread is created asleep on wchan,
+     *	and starts running when someone calls wakeup(wchan). (This makes
+     *	it safe to create kernel threads before process 1 is running.)
+     *	func() should never return.
+     *
+     *	Returns a pointer to the new process, or NULL on failure.
+     */
+
+    struct proc *p;
+    int oldints;
+
+    p = proc_alloc ();
+    if (!p)
+	return NULL;
+
+    p->pid = get_unused_pid ();
+    if (!p->pid || !machdep_kthread_init (p, func))
+      {
+	if (p->pid)
+	    remove_pid (p->pid);
+	machdep_proc_remove (p);
+	free (p->fcntl_dflag);
+	free (p->fdesc);
+	free (p);
+	return NULL;
+      }
+
+    p->ppid = 0;
+    p->flags |= PFLAG_KTHREAD;
+
+    /*  Put it on the sleep queue:  */
+    oldints = interrupts (DISABLE);
+
+    p->status = P_SLEEP;
+    p->wchan = wchan;
+    p->wmesg = wmesg;
+
+    if (sleepqueue)
+      {
+	sleepqueue->prev->next = p;
+	p->prev = sleepqueue->prev;
+	p->next = (struct proc *) sleepqueue;
+	sleepqueue->prev = p;
+      }
+    else
+      {
+	p->next = p;
+	p->prev = p;
+	sleepqueue = p;
+      }
+
+    interrupts (oldints);
+
+    return p;
+  }
+
+
+
+int superuser ()
+  {
+    /*
+     *	superuser ()
+     *	------------
+     *
+     *	Returns 1 if the effective uid of curproc is zero (or if there
+     *	is no curproc, ie the kernel itself is running), 0 otherwise.
+     */
+
+    if (!curproc)
+	return 1;
+
+    return curproc->cred.uid == 0;
+  }
+
+
+
 void pswitch ()
   {
     /*
@@ -390,8 +488,9 @@ void pswitch ()
 	idle = 1;
 	interrupts (ENABLE);
 
+	/*  Prepare zero-filled pages while waiting:  */
 	while (idle)
-	    ;
+	    vm_zeropool_fill ();
 
 	interrupts (DISABLE);
 
@@ -416,6 +515,8 @@ void pswitch ()
     need_to_pswitch = 0;
     nr_of_switches++;		/*  statistics  */
 
+    EVTRACE_EVENT (EVT_PSWITCH, curproc? curproc->pid : 0, runqueue->pid, 0);
+
 
     /*
      *	Call machine dependant routine to actually "launch" the process,
@@ -470,6 +571,8 @@ void sleep (void *addr, char *msg)
     curproc->wchan = addr;
     curproc->wmesg = msg;
 
+    EVTRACE_EVENT (EVT_SLEEP, addr, evtrace_name4 (msg), 0);
+
 
     /*
      *	Move the process to the sleep queue:
@@ -576,6 +679,8 @@ int wakeup_proc (struct proc *p)
     p->wchan = NULL;
     p->wmesg = NULL;
 
+    EVTRACE_EVENT (EVT_WAKEUP_PROC, p->pid, 0, 0);
+
     interrupts (oldints);
 
     return 0;
@@ -707,7 +812,10 @@ void wakeup (void *addr)
 	idle = 0;
 
     if (any_moved)
+      {
 	need_to_pswitch = 1;
+	EVTRACE_EVENT (EVT_WAKEUP, addr, 0, 0);
+      }
 
     interrupts (oldints);
   }
@@ -783,6 +891,20 @@ printk ("proc_exit(): pid=%i, ppid=%i", p->pid, p->ppid);
     p->status = P_IDL;
 
 
+    /*
+     *	A vfork() child's address space belongs to its parent, so it is
+     *	given back instead of being unmapped:
+     */
+
+    if (p->flags & PFLAG_VFORK)
+      {
+	p->vmregions = NULL;
+	p->dataregion = NULL;
+	machdep_proc_returnmaps (p);
+	vfork_release (p);
+      }
+
+
     /*
      *	Unmap all mapped memory regions (the entire address space):
      *	(This is not a call to munmap(), because it is too slow.)
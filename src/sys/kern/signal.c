@@ -110,6 +110,10 @@ printk ("sig_post (pfrom=%x,pto=%x,signr=%i)", pfrom,pto,signr);
     if (!pfrom || !pto || signr<=0 || signr>=NSIG)
 	return EINVAL;
 
+    /*  Kernel threads don't take signals:  */
+    if (pto->flags & PFLAG_KTHREAD)
+	return EPERM;
+
     sigval = 1 << signr;
 
     /*
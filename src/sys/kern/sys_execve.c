@@ -32,6 +32,10 @@
  *	18 Feb 2000	continuing
  *	25 Feb 2000	can execute /sbin/init using openbsd_aout emulation,
  *			but it's far from perfect
+ *	19 Oct 2026	vfork() children give back the parent's address space
+ *	19 Oct 2026	recently executed programs are looked up in the
+ *			exec image cache
+ *	19 Oct 2026	maps the shared time page
  */
 
 
@@ -47,6 +51,7 @@
 #include <sys/vfs.h>
 #include <sys/vm.h>
 #include <sys/emul.h>
+#include <sys/timepage.h>
 #include <fcntl.h>
 
 
@@ -96,7 +101,9 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[],
      *	no need to do it manually.)  The original process' vmregion chain
      *	is "backed up", so that it can be restored in case the new region
      *	mapping fails. If everything is successfull, the backed up chain
-     *	is freed from memory.
+     *	is freed from memory.  (A vfork() child's regions and page tables
+     *	belong to its parent. The child gets page tables of its own, and
+     *	the parent is woken up instead.)
      *
      *	---  Before this point, the old process still exists, and should
      *	     get the error code produced by an error. Below, the old process
@@ -114,13 +121,13 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[],
 
     int e=0, res, n, i;
     struct vnode *programvnode;
-    byte program_header [HEADER_SIZE];
-    off_t actually_read;
-    struct emul *emul, *found;
+    byte program_header [EXEC_CACHE_HEADERLEN];
+    off_t actually_read = 0;
+    struct emul *emul, *found, *cached;
     struct vm_object *vmobj;
     struct vm_region *region_backup;
     struct vm_region *region_to_free;
-    int oldints;
+    int oldints, vforked;
     char **argv_backup = NULL;
     int nr_argv_backup;
     char **envp_backup = NULL;
@@ -185,19 +192,28 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[],
      *	If the format is unknown, restore the flags and return an error.
      */
 
-    /*  Read the file's header into the 'program_header' buf:  */
-    res = programvnode->read (programvnode, (off_t) 0, program_header, (off_t) HEADER_SIZE, &actually_read);
-    if (res || actually_read < HEADER_SIZE)
+    /*  Recently executed programs don't need to be read or recognized:  */
+    cached = exec_cache_lookup (programvnode, program_header, HEADER_SIZE);
+
+    /*  Read the file's header into the 'program_header' buf. (A bit
+	more than HEADER_SIZE is read, so that loadexec() can use the
+	header from the exec cache the next time.)  */
+    if (!cached)
       {
-	programvnode->refcount_exec --;
-	unlock (&programvnode->lock);
-	return res;
+	res = programvnode->read (programvnode, (off_t) 0, program_header,
+	    (off_t) EXEC_CACHE_HEADERLEN, &actually_read);
+	if (res || actually_read < HEADER_SIZE)
+	  {
+	    programvnode->refcount_exec --;
+	    unlock (&programvnode->lock);
+	    return res? res : ENOEXEC;
+	  }
       }
 
 
     /*  Find an emulation which understands the header:  */
-    emul = first_emul;
-    found = NULL;
+    emul = cached? NULL : first_emul;
+    found = cached;
     while (emul)
       {
 	if (emul->check_magic (program_header, HEADER_SIZE))
@@ -336,6 +352,26 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[],
     region_backup = p->vmregions;
     p->vmregions = NULL;
 
+    vforked = p->flags & PFLAG_VFORK;
+    if (vforked && !machdep_proc_returnmaps (p))
+      {
+	machdep_proc_borrowmaps (p, p->parent);
+	p->vmregions = region_backup;
+	programvnode->refcount_exec --;
+	programvnode->refcount --;
+
+	i=0;
+	while (argv_backup[i])  free (argv_backup[i++]);
+	free (argv_backup);
+	i=0;
+	while (envp_backup[i])  free (envp_backup[i++]);
+	free (envp_backup);
+
+	/*  vmobj stays with the vnode (and maybe the exec cache)  */
+	unlock (&programvnode->lock);
+	return ENOMEM;
+      }
+
 
     /*  BEFORE THIS, the old process can be returned to...
 	but if emul->loadexec() succeeds, then the process
@@ -350,6 +386,8 @@ int sys_execve (ret_t *retval, struct proc *p, char *path, char *argv[],
 printk ("  execve(): loadexec() failed: %i", res);
 
 	p->vmregions = region_backup;
+	if (vforked)
+	    machdep_proc_borrowmaps (p, p->parent);
 	programvnode->refcount_exec --;
 	programvnode->refcount --;
 
@@ -360,16 +398,28 @@ printk ("  execve(): loadexec() failed: %i", res);
 	while (envp_backup[i])  free (envp_backup[i++]);
 	free (envp_backup);
 
-	free (vmobj);
+	/*  vmobj stays with the vnode (and maybe the exec cache)  */
 	unlock (&programvnode->lock);
 	return res;
       }
 
 
+    /*  Remember the program, so that it is faster to execute again:  */
+    if (!cached)
+	exec_cache_enter (programvnode, vmobj, emul, program_header,
+	    (size_t) actually_read);
+
+
     /*
      *	Free the region_backup chain from memory.
      */
 
+    if (vforked)
+      {
+	region_backup = NULL;
+	vfork_release (p);
+      }
+
     while (region_backup)
       {
 	vm_object_free (region_backup->source);
@@ -412,6 +462,9 @@ printk ("  execve(): loadexec() failed: %i", res);
 	panic ("sys_execve: fail 2. TODO: kill the process");
       }
 
+    /*  Not fatal, userland falls back to system calls without it:  */
+    timepage_attach (p);
+
     p->emul = emul;
 
 
@@ -31,6 +31,7 @@
  *	14 Apr 2000	first version
  *	24 May 2000	continuing, not finished yet
  *	19 Jul 2000	moving vm_region duplication to vm_fork()
+ *	19 Oct 2026	vfork()
  */
 
 
@@ -159,11 +160,11 @@ pid_t get_unused_pid ()
 
 
 
-int sys_fork (ret_t *res, struct proc *p)
+int fork1 (ret_t *res, struct proc *p, int vforkflag)
   {
     /*
-     *	sys_fork ()
-     *	-----------
+     *	fork1 ()
+     *	--------
      *
      *	The fork() syscall should create a child process which is an identical
      *	copy of its parent process except for the following:
@@ -181,6 +182,10 @@ int sys_fork (ret_t *res, struct proc *p)
      *	into Copy-On-Write pages. Read-only pages (or actually entire read-only
      *	vm_objects) can still be shared, though.
      *
+     *	If vforkflag is set, then the child borrows the parent's address
+     *	space (regions and page tables) instead, and the parent sleeps
+     *	until the child calls execve() or exits. See vfork_release().
+     *
      *	The res return value after a successfull fork() is the child's PID
      *	or 0 (to the child).  Otherwise, errno is returned.
      */
@@ -280,9 +285,20 @@ int sys_fork (ret_t *res, struct proc *p)
 
     /*
      *	Duplicate the parent's virtual memory regions etc.:
+     *	(vfork() children share them with the parent.)
      */
 
-    tmp = vm_fork (p, child_proc);
+    if (vforkflag)
+      {
+	child_proc->vmregions = p->vmregions;
+	child_proc->dataregion = p->dataregion;
+	child_proc->flags |= PFLAG_VFORK;
+	machdep_proc_borrowmaps (child_proc, p);
+	tmp = 0;
+      }
+    else
+	tmp = vm_fork (p, child_proc);
+
     if (tmp)
       {
 	/*  Remove all vm_objects references:  */
@@ -314,8 +330,73 @@ int sys_fork (ret_t *res, struct proc *p)
     *res = machdep_fork (p, child_proc);
 
     need_to_pswitch = 1;
+
+    /*
+     *	A vfork() parent waits until the child gives back the address
+     *	space. (The pageout daemon stays away from it meanwhile.)
+     */
+
+    if (vforkflag)
+      {
+	p->vm_busy ++;
+	while (child_proc->flags & PFLAG_VFORK)
+	    sleep (&child_proc->flags, "vfork");
+	p->vm_busy --;
+      }
+
     interrupts (oldints);
 
     return 0;
   }
 
+
+
+int sys_fork (ret_t *res, struct proc *p)
+  {
+    /*
+     *	sys_fork ()
+     *	-----------
+     */
+
+    return fork1 (res, p, 0);
+  }
+
+
+
+int sys_vfork (ret_t *res, struct proc *p)
+  {
+    /*
+     *	sys_vfork ()
+     *	------------
+     *
+     *	Like fork(), but nothing is copied or marked copy-on-write. The
+     *	child runs in the parent's address space, and the parent is
+     *	suspended until the child calls execve() or exits.
+     */
+
+    return fork1 (res, p, 1);
+  }
+
+
+
+void vfork_release (struct proc *p)
+  {
+    /*
+     *	vfork_release ()
+     *	----------------
+     *
+     *	Called by a vfork() child which stops using its parent's address
+     *	space (from execve() and proc_exit()). The caller should already
+     *	have given the child regions and page tables of its own.
+     */
+
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    p->flags &= ~PFLAG_VFORK;
+    wakeup (&p->flags);
+
+    interrupts (oldints);
+  }
+
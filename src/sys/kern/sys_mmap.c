@@ -33,6 +33,13 @@
  *	sys_munmap ()
  *		Unmaps regions (or parts of regions) from a process.
  *
+ *	sys_msync ()
+ *		Writes back changes made through shared file mappings.
+ *
+ *	sys_madvise ()
+ *		Access pattern hints (read-ahead, and pages which are
+ *		not needed).
+ *
  *	sys_break ()
  *		Traditional Unix syscall to set the size of the process'
  *		data segment.
@@ -43,6 +50,9 @@
  *	19 Jul 2000	adding sys_munmap(), sys_mmap()
  *	20 Jul 2000	sys_break() (doesn't free pages if break addr is lowered)
  *	26 Jul 2000
+ *	19 Oct 2026	p->vm_busy is set while regions are modified
+ *	19 Oct 2026	writable MAP_SHARED file mappings, sys_msync(),
+ *			sys_madvise()
  */
 
 
@@ -53,6 +63,8 @@
 #include <sys/syscalls.h>
 #include <sys/interrupts.h>
 #include <sys/vm.h>
+#include <sys/vnode.h>
+#include <sys/filedesc.h>
 #include <sys/mman.h>
 #include <sys/md/machdep.h>
 
@@ -76,6 +88,11 @@ int sys_mmap (ret_t *res, struct proc *p, void *addr, size_t len, int prot,
      *	If addr!=NULL and on a page boundary, then we use that address.
      *	Otherwise, we look up a free memory range.
      *
+     *	A writable MAP_SHARED file mapping requires a descriptor which is
+     *	open for writing, and a filesystem which can write. Changes are
+     *	written back to the file by msync(), munmap() and the pageout
+     *	daemon.
+     *
      *	Returns the address of the mmap:ed region on success, MAP_FAILED
      *	on failure.
      */
@@ -83,8 +100,10 @@ int sys_mmap (ret_t *res, struct proc *p, void *addr, size_t len, int prot,
     int tmp;
     struct vm_object *new_object;
     struct vnode *v;
+    u_int32_t type;
     int anonymous = 0;
     int filemap = 0;
+    int shared = 0;
 
 
     *res = (size_t) MAP_FAILED;
@@ -116,6 +135,9 @@ int sys_mmap (ret_t *res, struct proc *p, void *addr, size_t len, int prot,
     if (!(flags & MAP_ANON) && (flags & MAP_COPY))
 	filemap = 1;
 
+    if (!(flags & MAP_ANON) && (flags & MAP_SHARED) && !(flags & MAP_COPY))
+	filemap = shared = 1;
+
     if (!anonymous && !filemap)
       {
 	printk ("sys_mmap: unimplemented addr=%x len=%i prot=%i flags=%i fd=%i offset=%i",
@@ -123,9 +145,17 @@ int sys_mmap (ret_t *res, struct proc *p, void *addr, size_t len, int prot,
 	return EINVAL;
       }
 
-    if (filemap && (fd<0 || fd>=p->nr_of_fdesc))
+    if (filemap && (fd<0 || fd>=p->nr_of_fdesc || !p->fdesc[fd]))
 	return EBADF;
 
+    if (shared && (prot & PROT_WRITE))
+      {
+	if (!(p->fdesc[fd]->mode & FDESC_MODE_WRITE))
+	    return EACCES;
+	if (!p->fdesc[fd]->v || !p->fdesc[fd]->v->write)
+	    return ENODEV;
+      }
+
 
     /*
      *	If addr==NULL or addr is not on a page boundary, then we use
@@ -217,12 +247,16 @@ printk ("! v->vmobj=%x refc=%i name='%s'", (int)v->vmobj, v->refcount,
 			);
 */
 
+    /*  Shared regions write to the object itself, others use COW:  */
+    type = (prot & PROT_READ)? VMREGION_READABLE : 0;
+    if (shared)
+	type |= VMREGION_SHARED | ((prot & PROT_WRITE)? VMREGION_WRITABLE : 0);
+    else
+    if ((flags & MAP_COPY) || (prot & PROT_WRITE))
+	type |= VMREGION_WRITABLE | VMREGION_COW;
+
     tmp = vm_region_attach (p, new_object, offset,
-		(size_t)addr, (size_t)addr+len-1,
-		  ((prot & PROT_READ)? VMREGION_READABLE : 0)
-		+ (((flags & MAP_COPY) || (prot & PROT_WRITE))? VMREGION_WRITABLE : 0)
-		+ (((flags & MAP_COPY) || (prot & PROT_WRITE))? VMREGION_COW : 0)
-		);
+		(size_t)addr, (size_t)addr+len-1, type);
 
 printk (" (2)mmap: addr=%x attach=%i obj->vnode=%x", addr, tmp, new_object->vnode);
 
@@ -298,10 +332,18 @@ int sys_munmap (ret_t *res, struct proc *p, void *addr, size_t len)
 
 
     /*
-     *	"Physically" unmap all the pages, nomatter if we
-     *	succeed in unmapping the actual regions:
+     *	Write back any changes made through shared file mappings in
+     *	the range, and then "physically" unmap all the pages, nomatter
+     *	if we succeed in unmapping the actual regions:  (The pageout
+     *	daemon leaves p alone until we are done.)
      */
 
+    p->vm_busy ++;
+
+    for (region=p->vmregions; region; region=region->next)
+	if (region->start_addr <= end_addr && region->end_addr >= start_addr)
+	    vm_writeback_region (region, start_addr, end_addr);
+
     pmap_unmappages (p, start_addr, end_addr);
 
 
@@ -364,6 +406,163 @@ int sys_munmap (ret_t *res, struct proc *p, void *addr, size_t len)
 	region = nextregion;
       }
 
+    p->vm_busy --;
+    return 0;
+  }
+
+
+
+int sys_msync (ret_t *res, struct proc *p, void *addr, size_t len, int flags)
+  {
+    /*
+     *	sys_msync ()
+     *	------------
+     *
+     *	Write back the dirty pages of all shared file mappings within the
+     *	range addr to addr+len-1.
+     *
+     *	MS_ASYNC is treated like MS_SYNC, since a write can't be started
+     *	without waiting for it. MS_INVALIDATE has nothing to do, as all
+     *	mappings of a file use the same pages.
+     *
+     *	Returns 0 on success, ENOMEM if nothing is mapped in the range,
+     *	otherwise the errno of the first failed write.
+     */
+
+    size_t start_addr, end_addr;
+    struct vm_region *region;
+    int err = 0, res2, found = 0;
+
+    if (!p || !res)
+	return EINVAL;
+
+    if (((size_t)addr & (PAGESIZE-1)) != 0
+	|| (flags & ~(MS_ASYNC | MS_SYNC | MS_INVALIDATE))
+	|| ((flags & MS_ASYNC) && (flags & MS_SYNC)))
+	return EINVAL;
+
+    len = round_up_to_page (len);
+    if (len == 0)
+	return 0;
+
+    start_addr = (size_t)addr;
+    end_addr = start_addr + len - 1;
+    if (end_addr < start_addr)
+	return EINVAL;
+
+    p->vm_busy ++;
+
+    for (region=p->vmregions; region; region=region->next)
+	if (region->start_addr <= end_addr && region->end_addr >= start_addr)
+	  {
+	    found = 1;
+	    res2 = vm_writeback_region (region, start_addr, end_addr);
+	    if (res2 && !err)
+		err = res2;
+	  }
+
+    p->vm_busy --;
+
+    if (!found)
+	return ENOMEM;
+
+    return err;
+  }
+
+
+
+int sys_madvise (ret_t *res, struct proc *p, void *addr, size_t len, int behav)
+  {
+    /*
+     *	sys_madvise ()
+     *	--------------
+     *
+     *	Give the vm system a hint about how the range addr to addr+len-1
+     *	will be used:
+     *
+     *	MADV_NORMAL, MADV_RANDOM, MADV_SEQUENTIAL
+     *		Set the access pattern of every region which overlaps the
+     *		range. (Regions are not split up.) A fault in a sequential
+     *		file mapping reads VM_READAHEAD_PAGES pages ahead.
+     *
+     *	MADV_WILLNEED
+     *		Read the file pages of the range now, without mapping
+     *		them. (At most VM_WILLNEED_MAXPAGES pages.)
+     *
+     *	MADV_DONTNEED
+     *		The pages won't be needed soon: dirty shared file pages
+     *		are written back, and all pages in the range are unmapped,
+     *		which makes them the first candidates for reclaim. The
+     *		contents stay the same, and the next access is a minor
+     *		fault if the page is still resident.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    size_t start_addr, end_addr, s, e, maxpages = VM_WILLNEED_MAXPAGES;
+    struct vm_region *region;
+    int found = 0;
+
+    if (!p || !res)
+	return EINVAL;
+
+    if (((size_t)addr & (PAGESIZE-1)) != 0 || behav < MADV_NORMAL
+	|| behav > MADV_DONTNEED)
+	return EINVAL;
+
+    len = round_up_to_page (len);
+    if (len == 0)
+	return 0;
+
+    start_addr = (size_t)addr;
+    end_addr = start_addr + len - 1;
+    if (end_addr < start_addr)
+	return EINVAL;
+
+    p->vm_busy ++;
+
+    for (region=p->vmregions; region; region=region->next)
+      {
+	if (region->start_addr > end_addr || region->end_addr < start_addr)
+	    continue;
+
+	found = 1;
+	s = region->start_addr > start_addr? region->start_addr : start_addr;
+	e = region->end_addr < end_addr? region->end_addr : end_addr;
+
+	switch (behav)
+	  {
+	    case MADV_NORMAL:
+	    case MADV_RANDOM:
+	    case MADV_SEQUENTIAL:
+		region->type &= ~(VMREGION_SEQUENTIAL | VMREGION_RANDOM);
+		if (behav == MADV_SEQUENTIAL)
+		    region->type |= VMREGION_SEQUENTIAL;
+		if (behav == MADV_RANDOM)
+		    region->type |= VMREGION_RANDOM;
+		break;
+
+	    case MADV_WILLNEED:
+		if (maxpages > 0)
+		  {
+		    if ((e - s) / PAGESIZE >= maxpages)
+			e = s + maxpages*PAGESIZE - 1;
+		    maxpages -= vm_fault_prefetch (p, region, s, e);
+		  }
+		break;
+
+	    case MADV_DONTNEED:
+		vm_writeback_region (region, s, e);
+		pmap_unmappages (p, s, e);
+		break;
+	  }
+      }
+
+    p->vm_busy --;
+
+    if (!found)
+	return ENOMEM;
+
     return 0;
   }
 
@@ -416,6 +615,8 @@ int sys_break (ret_t *res, struct proc *p, char *nsize)
     if ((size_t)nsize < p->dataregion->start_addr)
 	return ENOMEM;
 
+    p->vm_busy ++;
+
     diff = (size_t)nsize - endaddraligned;
     tmp = 0;
     tmp2 = 0;
@@ -426,9 +627,13 @@ int sys_break (ret_t *res, struct proc *p, char *nsize)
 	tmp2 = sys_munmap (&tmp, p, (void *)endaddraligned, diff);
 
     if (tmp2)
+      {
+	p->vm_busy --;
 	return tmp2;
+      }
 
     p->dataregion->end_addr = (size_t)nsize - 1;
+    p->vm_busy --;
     return 0;
   }
 
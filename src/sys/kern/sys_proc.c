@@ -56,6 +56,7 @@
  *	8 Mar 2000	first version
  *	...
  *	15 Jun 2000	adding sys_nanosleep()
+ *	19 Oct 2026	sys_nanosleep() rejects tv_nsec = 1000000000
  */
 
 
@@ -472,7 +473,7 @@ int sys_nanosleep (ret_t *res, struct proc *p, const struct timespec *rqtp,
     ts = (struct timespec *) ((byte *)rqtp + userland_startaddr);
     rmtp = (struct timespec *) ((byte *)rmtp + userland_startaddr);
 
-    if (ts->tv_sec<0 || ts->tv_nsec<0 || ts->tv_nsec>1000000000)
+    if (ts->tv_sec<0 || ts->tv_nsec<0 || ts->tv_nsec>=1000000000)
 	return EINVAL;
 
     *res = timer_sleep (p, ts, "nanosleep");
@@ -29,6 +29,8 @@
  *
  *  History:
  *	24 Jul 2000	sys_gettimeofday()
+ *	19 Oct 2026	sys_gettimeofday() interpolates between ticks,
+ *			sys_clock_gettime(), sys_clock_getres()
  */
 
 
@@ -39,11 +41,13 @@
 #include <sys/errno.h>
 #include <sys/syscalls.h>
 #include <sys/time.h>
+#include <sys/timer.h>
 #include <sys/vm.h>
 
 
 extern size_t userland_startaddr;
-extern volatile struct timespec system_time;
+extern long nanosec_tick_length;
+extern struct clocksource *timer_clocksource;
 
 
 
@@ -54,9 +58,11 @@ int sys_gettimeofday (ret_t *res, struct proc *p, struct timeval *tp,
      *	sys_gettimeofday ()
      *	-------------------
      *
-     *	Return the contents of the system_time variable.
+     *	Return the current time. (system_time, plus the time since the
+     *	last tick if there is a clocksource.)
      */
 
+    struct timespec now;
     int return_tp=1, return_tz=1;
 
     if (!res || !p)
@@ -88,9 +94,10 @@ int sys_gettimeofday (ret_t *res, struct proc *p, struct timeval *tp,
 
     if (return_tp)
       {
+	timer_gettime (&now);
 	tp = (struct timeval *) ((byte *)tp + userland_startaddr);
-	tp->tv_sec = system_time.tv_sec;
-	tp->tv_usec = system_time.tv_nsec / 1000;
+	tp->tv_sec = now.tv_sec;
+	tp->tv_usec = now.tv_nsec / 1000;
       }
 
 /*  TODO: handle the timezone stuff; at least it should be zeroed  */
@@ -98,3 +105,85 @@ int sys_gettimeofday (ret_t *res, struct proc *p, struct timeval *tp,
     return 0;
   }
 
+
+
+int sys_clock_gettime (ret_t *res, struct proc *p, int clock_id,
+	struct timespec *tp)
+  {
+    /*
+     *	sys_clock_gettime ()
+     *	--------------------
+     *
+     *	CLOCK_REALTIME is the time since 1970, CLOCK_MONOTONIC is the
+     *	time since boot. Both have nanosecond resolution if there is a
+     *	clocksource, otherwise tick resolution.
+     */
+
+    u_int64_t uptime;
+
+    if (!res || !p)
+	return EINVAL;
+
+    if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+	return EINVAL;
+
+    if (!p->sc_params_ok)
+      {
+	if (!vm_prot_accessible (p, tp, sizeof(struct timespec),
+	    VMREGION_WRITABLE))
+	    return EFAULT;
+
+	p->sc_params_ok = 1;
+      }
+
+    tp = (struct timespec *) ((byte *)tp + userland_startaddr);
+
+    if (clock_id == CLOCK_REALTIME)
+	timer_gettime (tp);
+    else
+      {
+	uptime = timer_getuptime ();
+	tp->tv_sec = timer_div64 (uptime, 1000000000);
+	tp->tv_nsec = (long) (uptime - (u_int64_t) tp->tv_sec * 1000000000);
+      }
+
+    return 0;
+  }
+
+
+
+int sys_clock_getres (ret_t *res, struct proc *p, int clock_id,
+	struct timespec *tp)
+  {
+    /*
+     *	sys_clock_getres ()
+     *	-------------------
+     *
+     *	1 ns with a clocksource, one tick without.
+     */
+
+    if (!res || !p)
+	return EINVAL;
+
+    if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+	return EINVAL;
+
+    if (!tp)
+	return 0;
+
+    if (!p->sc_params_ok)
+      {
+	if (!vm_prot_accessible (p, tp, sizeof(struct timespec),
+	    VMREGION_WRITABLE))
+	    return EFAULT;
+
+	p->sc_params_ok = 1;
+      }
+
+    tp = (struct timespec *) ((byte *)tp + userland_startaddr);
+    tp->tv_sec = 0;
+    tp->tv_nsec = timer_clocksource? 1 : nanosec_tick_length;
+
+    return 0;
+  }
+
@@ -29,7 +29,7 @@
  *	When a process wants the kernel to do something for it, it calls the
  *	kernel via a system call. The exact mechanism may differ between
  *	hardware architectures, but we always end up in syscall() with a
- *	syscall number and a number of arguments.
+ *	syscall number and a pointer to the arguments on the userland stack.
  *
  *	The call is then redirected to the correct "handler", depending on
  *	which emulation the process is using.  This was set when the
@@ -49,12 +49,15 @@
  *	24 Oct 1999	first version
  *	13 Jan 2000	working again
  *	20 Jan 2000	adding "emul" module at "virtual"
+ *	19 Oct 2026	only copy as many arguments as the syscall takes
+ *	19 Oct 2026	syscall statistics
  */
 
 
 #include "../config.h"
 
 #include <sys/std.h>
+#include <string.h>
 #include <sys/proc.h>
 #include <sys/errno.h>
 #include <sys/emul.h>
@@ -62,12 +65,15 @@
 #include <sys/module.h>
 #include <sys/syscalls.h>
 #include <sys/signal.h>
+#include <sys/syscallstat.h>
+#include <sys/md/machdep.h>
 
 
 
 extern volatile struct proc *curproc;
 extern volatile int need_to_pswitch;
 extern volatile int nr_of_switches;
+extern size_t userland_startaddr;
 
 
 void syscall_init ()
@@ -79,8 +85,7 @@ void syscall_init ()
 
 
 
-ret_t syscall (int *errno, int nr, int r1, int r2, int r3, int r4, int r5, int r6,
-	int r7, int r8, int r9, int r10)
+ret_t syscall (int *errno, int nr, size_t usp)
   {
     /*
      *	syscall ()  --  Machine independant syscall entry
@@ -95,12 +100,22 @@ ret_t syscall (int *errno, int nr, int r1, int r2, int r3, int r4, int r5, int r
      *
      *	What we must do here is simply to call the correct syscall
      *	function (which depends on which emulation the process is using).
+     *
+     *	usp is the userland stack pointer at the time of the syscall.
+     *	The arguments start one word above it (above the return address
+     *	of the libc syscall stub). Only as many words as the syscall
+     *	actually takes are copied in; the rest are passed as zero.
      */
 
     ret_t res = 0;
     int (*func)();
     struct emul *e;
     struct proc *p;
+    int a[SYSCALL_MAXARGS];
+    int nargs;
+#ifdef SYSCALLSTAT
+    u_int64_t starttime;
+#endif
 
 
     /*
@@ -116,6 +131,9 @@ ret_t syscall (int *errno, int nr, int r1, int r2, int r3, int r4, int r5, int r
 
     p = (struct proc *) curproc;
     p->ticks = &p->sticks;
+#ifdef SYSCALLSTAT
+    starttime = machdep_cyclecounter ();
+#endif
     interrupts (ENABLE);
     p->sc_params_ok = 0;
 
@@ -137,29 +155,56 @@ ret_t syscall (int *errno, int nr, int r1, int r2, int r3, int r4, int r5, int r
 	printk ("syscall(%s#%i,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x): TODO",
 		e->name, nr, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10);
 */
-	printk ("syscall(%s#%i,%x,%x,%x,%x,%x,%x)",
-		e->name, nr, r1, r2, r3, r4, r5, r6);
+	printk ("syscall(%s#%i): TODO", e->name, nr);
 #endif
 	*errno = ENOSYS;
 	return 0;
       }
 
+
+    /*
+     *	Copy the arguments from the userland stack. The stack must be
+     *	within the userland segment, or we would read kernel memory:
+     */
+
+    nargs = e->syscall_nargs? e->syscall_nargs[nr] : SYSCALL_MAXARGS;
+    memset (a, 0, sizeof(a));
+
+    if (nargs > 0)
+      {
+	if (usp > (size_t)0 - userland_startaddr - sizeof(int)*(nargs+1))
+	  {
+	    *errno = EFAULT;
+	    p->ticks = &p->uticks;
+	    return 0;
+	  }
+
+	memcpy (a, (byte *)usp + userland_startaddr + sizeof(int),
+		sizeof(int) * nargs);
+      }
+
 /*
 printk ("pid %i #%i,%x,%x,%x,%x,%x,%x)",
-	p->pid, nr, r1, r2, r3, r4, r5, r6);
+	p->pid, nr, a[0], a[1], a[2], a[3], a[4], a[5]);
 */
 
     /*
      *	Do the actual syscall:
      */
 
-    *errno = func (&res, p, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10);
+    *errno = func (&res, p, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7],
+	a[8], a[9]);
 
 /*
 printk ("done%i #%i,%x,%x,%x,%x,%x,%x)",
-	p->pid, nr, r1, r2, r3, r4, r5, r6);
+	p->pid, nr, a[0], a[1], a[2], a[3], a[4], a[5]);
 */
 
+#ifdef SYSCALLSTAT
+    /*  (e, not p->emul, since execve may have changed the emulation)  */
+    syscallstat_account (e, p, nr, *errno, starttime);
+#endif
+
     /*
      *	In case the syscall wants us to do a pswitch here, then
      *	we do so. If pswitch() is successful it will clear the
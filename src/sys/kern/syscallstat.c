@@ -0,0 +1,268 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/syscallstat.c  --  syscall statistics
+ *
+ *	When SYSCALLSTAT is defined in config.h, syscall() reports every
+ *	completed syscall here. For each emulation there is one table,
+ *	indexed by syscall number, with the number of calls, the number of
+ *	calls which returned an errno, the total number of cycles spent,
+ *	and a log2 histogram of the latency. (Bucket n counts calls which
+ *	took 2^n .. 2^(n+1)-1 cycles.) Times are in machdep_cyclecounter()
+ *	units; without a cycle counter only the counts are kept.
+ *
+ *	If SYSCALLSTAT_PERPROC is defined, then each process also keeps
+ *	its own totals and the number of calls per syscall number.
+ *
+ *	There is only one cpu, so the counters are simply updated with
+ *	interrupts disabled for a few instructions; no locks are taken.
+ *	The tables are allocated on first use. Syscalls which never
+ *	return (exit) are not counted.
+ *
+ *	syscallstat_account ()
+ *		Called by syscall() when a syscall is done.
+ *
+ *	syscallstat_procfree ()
+ *		Free per-process statistics when a process is removed.
+ *
+ *	syscallstat_reset ()
+ *		Clear all statistics.
+ *
+ *	syscallstat_print ()
+ *		Print the statistics as text.  (Used by kdb and procfs.)
+ *
+ *	syscallstat_procprint ()
+ *		Print one process' statistics.  (Used by procfs.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/std.h>
+#include <sys/md/machdep.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/emul.h>
+#include <sys/proc.h>
+#include <sys/syscallstat.h>
+
+
+#ifdef SYSCALLSTAT
+
+
+extern struct emul *first_emul;
+
+
+
+void syscallstat_account (struct emul *e, struct proc *p, int nr, int error,
+	u_int64_t starttime)
+  {
+    /*
+     *	syscallstat_account ()
+     *	----------------------
+     *
+     *	Account one call to syscall nr of emulation e, made by process p.
+     *	error is the errno returned by the syscall, and starttime the
+     *	cycle counter when the syscall was entered (or 0 if there is no
+     *	cycle counter). nr must be valid for e.
+     */
+
+    struct syscallstat *s;
+    u_int64_t cycles = 0, c;
+    int oldints, bucket = 0;
+    size_t len;
+
+    if (starttime)
+	cycles = machdep_cyclecounter () - starttime;
+
+    /*  Allocate tables on first use:  (someone else may beat us to it)  */
+    if (!e->syscallstat)
+      {
+	len = sizeof(struct syscallstat) * e->highest_syscall_nr;
+	s = (struct syscallstat *) malloc (len);
+	if (!s)
+	    return;
+	memset (s, 0, len);
+
+	oldints = interrupts (DISABLE);
+	if (e->syscallstat)
+	    free (s);
+	else
+	    e->syscallstat = s;
+	interrupts (oldints);
+      }
+
+#ifdef SYSCALLSTAT_PERPROC
+    if (!p->sc_count && nr < e->highest_syscall_nr)
+      {
+	len = sizeof(u_int32_t) * e->highest_syscall_nr;
+	p->sc_count = (u_int32_t *) malloc (len);
+	if (p->sc_count)
+	  {
+	    memset (p->sc_count, 0, len);
+	    p->sc_count_n = e->highest_syscall_nr;
+	  }
+      }
+#endif
+
+    c = cycles;
+    while (c > 1 && bucket < SYSCALLSTAT_BUCKETS-1)
+      {
+	c >>= 1;
+	bucket ++;
+      }
+
+    oldints = interrupts (DISABLE);
+
+    s = &e->syscallstat[nr];
+    s->calls ++;
+    s->cycles += cycles;
+    if (error)
+	s->errors ++;
+    if (starttime)
+	s->hist[bucket] ++;
+
+#ifdef SYSCALLSTAT_PERPROC
+    p->sc_calls ++;
+    p->sc_cycles += cycles;
+    if (error)
+	p->sc_errors ++;
+    if (p->sc_count && nr < p->sc_count_n)
+	p->sc_count[nr] ++;
+#endif
+
+    interrupts (oldints);
+  }
+
+
+
+void syscallstat_procfree (struct proc *p)
+  {
+    if (p->sc_count)
+	free (p->sc_count);
+    p->sc_count = NULL;
+    p->sc_count_n = 0;
+  }
+
+
+
+void syscallstat_reset ()
+  {
+    struct emul *e;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    for (e=first_emul; e; e=e->next)
+      if (e->syscallstat)
+	memset (e->syscallstat, 0,
+	    sizeof(struct syscallstat) * e->highest_syscall_nr);
+    interrupts (oldints);
+  }
+
+
+
+size_t syscallstat_print (char *buf, size_t buflen)
+  {
+    /*
+     *	syscallstat_print ()
+     *	--------------------
+     *
+     *	Print statistics for all syscalls which have been called, to buf
+     *	(at most buflen-1 chars). Each line has the emulation name, the
+     *	syscall number, calls, errors, total time, and then bucket:count
+     *	for each non-empty histogram bucket. Output stops when buf is
+     *	nearly full.
+     *
+     *	Returns the number of chars printed.
+     */
+
+    struct emul *e;
+    struct syscallstat *s;
+    size_t len = 0;
+    int oldints, nr, i;
+
+    if (buflen < 256)
+	return 0;
+
+    oldints = interrupts (DISABLE);
+
+    len += snprintf (buf+len, buflen-len, "syscallstat: times in units "
+	"of 1024 cycles, histograms in log2(cycles)\n");
+    len += snprintf (buf+len, buflen-len, "emul nr calls errors "
+	"time_total bucket:count...\n");
+
+    for (e=first_emul; e && buflen-len >= 512; e=e->next)
+      {
+	if (!e->syscallstat)
+	    continue;
+
+	for (nr=0; nr<e->highest_syscall_nr && buflen-len >= 512; nr++)
+	  {
+	    s = &e->syscallstat[nr];
+	    if (!s->calls)
+		continue;
+
+	    len += snprintf (buf+len, buflen-len, "%s %i %u %u %u", e->name,
+		nr, s->calls, s->errors, (u_int32_t) (s->cycles >> 10));
+	    for (i=0; i<SYSCALLSTAT_BUCKETS; i++)
+	      if (s->hist[i])
+		len += snprintf (buf+len, buflen-len, " %i:%u", i, s->hist[i]);
+	    len += snprintf (buf+len, buflen-len, "\n");
+	  }
+      }
+
+    interrupts (oldints);
+    return len;
+  }
+
+
+
+size_t syscallstat_procprint (struct proc *p, char *buf, size_t buflen)
+  {
+    /*
+     *	Print process p's syscall totals (time in units of 1024 cycles),
+     *	followed by one line per syscall number which p has called.
+     */
+
+    size_t len = 0;
+    int nr;
+
+    len += snprintf (buf+len, buflen-len, "calls %u\nerrors %u\ntime %u\n",
+	p->sc_calls, p->sc_errors, (u_int32_t) (p->sc_cycles >> 10));
+
+    for (nr=0; p->sc_count && nr<p->sc_count_n && len<buflen-32; nr++)
+      if (p->sc_count[nr])
+	len += snprintf (buf+len, buflen-len, "%i %u\n", nr, p->sc_count[nr]);
+
+    return len;
+  }
+
+
+#endif	/*  SYSCALLSTAT  */
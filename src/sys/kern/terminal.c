@@ -209,6 +209,52 @@ size_t terminal_write (struct termstate *ts, char *buf, size_t len)
 
 
 
+size_t terminal__inputlen (struct termstate *ts)
+  {
+    /*
+     *	Return the number of characters in ts->inputbuf.
+     */
+
+    return (ts->inputhead - ts->inputtail) & (MAX_INPUT - 1);
+  }
+
+
+
+size_t terminal__vmin (struct termstate *ts)
+  {
+    /*
+     *	Return the number of characters which must be available before
+     *	a non-canonical read returns.  (At least one.)
+     */
+
+    return ts->termio.c_cc[VMIN]? ts->termio.c_cc[VMIN] : 1;
+  }
+
+
+
+void terminal__copyout (struct termstate *ts, char *buf, size_t len)
+  {
+    /*
+     *	Copy len characters from the beginning of ts->inputbuf to buf,
+     *	and remove them from inputbuf. (At most two memcpy()s are needed,
+     *	one if the data doesn't wrap around the end of inputbuf.)
+     */
+
+    size_t n;
+
+    n = MAX_INPUT - ts->inputtail;
+    if (n > len)
+	n = len;
+
+    memcpy (buf, ts->inputbuf + ts->inputtail, n);
+    if (len > n)
+	memcpy (buf + n, ts->inputbuf, len - n);
+
+    ts->inputtail = (ts->inputtail + len) & (MAX_INPUT - 1);
+  }
+
+
+
 int terminal_add_to_inputbuf (struct termstate *ts, char ch)
   {
     /*
@@ -227,8 +273,9 @@ int terminal_add_to_inputbuf (struct termstate *ts, char ch)
      *	If we are running in canonical mode, we also handle ERASE
      *	and KILL characters.
      *
-     *	TODO: wakeup a process sleeping on input from the terminal
-     *	whenever an EOF, EOL, or newline arrives (??)
+     *	Processes sleeping in terminal_read() are woken up when a line
+     *	has been completed (canonical mode), or when at least VMIN
+     *	characters are available (non-canonical mode).
      */
 
     tcflag_t iflag;
@@ -275,13 +322,9 @@ int terminal_add_to_inputbuf (struct termstate *ts, char ch)
 	    if (ts->inputhead == ts->inputtail)
 		return -1;
 
-	    lastindex = ts->inputhead - 1;
-	    if (lastindex < 0)
-	      lastindex = MAX_INPUT - 1;
+	    lastindex = ts->inputhead? ts->inputhead - 1 : MAX_INPUT - 1;
 
-	    if (ts->inputbuf[lastindex] == ts->termio.c_cc[VEOF] ||
-		ts->inputbuf[lastindex] == ts->termio.c_cc[VEOL] ||
-		ts->inputbuf[lastindex] == '\n')
+	    if (TERMINAL_ISLINEEND(ts, lastindex))
 	      {
 		/*  TODO:  should we check ECHOK here too? probably...  */
 	        return -1;
@@ -312,13 +355,9 @@ int terminal_add_to_inputbuf (struct termstate *ts, char ch)
 		    if (ts->inputhead == ts->inputtail)
 			return 0;
 
-		    lastindex = ts->inputhead - 1;
-		    if (lastindex < 0)
-			lastindex = MAX_INPUT - 1;
+		    lastindex = ts->inputhead? ts->inputhead - 1 : MAX_INPUT - 1;
 
-		    if (ts->inputbuf[lastindex] == ts->termio.c_cc[VEOF] ||
-			ts->inputbuf[lastindex] == ts->termio.c_cc[VEOL] ||
-			ts->inputbuf[lastindex] == '\n')
+		    if (TERMINAL_ISLINEEND(ts, lastindex))
 		      {
 			/*  ECHOK:  echo NL after line kill  */
 			if (ts->termio.c_lflag & ECHOK)
@@ -336,26 +375,6 @@ int terminal_add_to_inputbuf (struct termstate *ts, char ch)
 
 	    return 0;
 	  }
-
-
-	/*
-         *  Wakeup any process (can there be several??? TODO) that
-	 *  are waiting for input in canonical mode.
-	 */
-
-	if (ch == ts->termio.c_cc[VEOF] ||
-		ch == ts->termio.c_cc[VEOL] || ch == '\n')
-	  wakeup (&ts->linemode_sleep);
-      }
-    else
-      {
-	/*  In non-canonical mode, we always wake up the process:  */
-	/*  TODO: first of all, this should be done with interrupts
-		disabled etc and we should check the contents of the
-		sleep variable to see if we actually need to call wakeup()
-		since it takes a lot of CPU cycles... second of all,
-		there should be one linemode_sleep and one other XX_sleep  */
-	wakeup (&ts->linemode_sleep);
       }
 
 
@@ -408,8 +427,44 @@ int terminal_add_to_inputbuf (struct termstate *ts, char ch)
 	return -1;
 
     ts->inputbuf [ts->inputhead] = ch;
+
+    /*
+     *	Line terminators are counted (and marked in ts->lineend) in both
+     *	canonical and non-canonical mode, so that nlines is correct if
+     *	the mode is changed. Readers only look at the marks, so changing
+     *	VEOF or VEOL doesn't affect lines which are already in inputbuf.
+     */
+
+    if (TERMINAL_LINEEND(ts, ch))
+      {
+	ts->lineend [ts->inputhead >> 3] |= (1 << (ts->inputhead & 7));
+	if (ts->nlines++ == 0)
+	  ts->firstlineend = ts->inputhead;
+      }
+    else
+	ts->lineend [ts->inputhead >> 3] &= ~(1 << (ts->inputhead & 7));
+
     ts->inputhead = next;
 
+
+    /*
+     *	Wakeup any processes waiting for input, but only if there
+     *	is anything for them to read.  (wakeup() is expensive.)
+     *	TODO: there should be one linemode_sleep and one other XX_sleep
+     */
+
+    if (ts->linemode_sleep)
+      {
+	if (ts->termio.c_lflag & ICANON)
+	  {
+	    if (ts->nlines > 0)
+	      wakeup (&ts->linemode_sleep);
+	  }
+	else
+	if (terminal__inputlen (ts) >= terminal__vmin (ts))
+	  wakeup (&ts->linemode_sleep);
+      }
+
     return 0;
   }
 
@@ -427,90 +482,80 @@ size_t terminal_read (struct termstate *ts, char *buf, size_t maxlen)
      *
      *	Return 0 on error, or of nothing was read.
      *
-     *	In non-canonical mode (ie character mode) we simply return
-     *	as much data as possible (only limited by maxlen).
+     *	In non-canonical mode (ie character mode) we wait until at
+     *	least VMIN characters (or one, if VMIN is 0) are available,
+     *	and then return as much data as possible (only limited by
+     *	maxlen).  VTIME is not supported; there is no read timeout.
      */
 
-    size_t chars_read = 0;
-    size_t tmplen;
-    int index;
-    char ch;
+    size_t len, index, oldtail, lineoff = 0;
     int oldints;
-    int linefound;
+    int canonical;
 
 
-    if (!ts || !buf)
+    if (!ts || !buf || maxlen < 1)
 	return 0;
 
-    if (ts->termio.c_lflag & ICANON)
+    oldints = interrupts (DISABLE);
+
+    canonical = ts->termio.c_lflag & ICANON;
+
+    /*  Sleep until there is something to read:  */
+    while (canonical? ts->nlines == 0 :
+	terminal__inputlen (ts) < terminal__vmin (ts))
       {
-	oldints = interrupts (DISABLE);
+	ts->linemode_sleep ++;
+	sleep (&ts->linemode_sleep, "terminal_read");
+	ts->linemode_sleep --;
 
-	while (chars_read == 0)
-	  {
-	    /*  Do we have a whole line already?  */
-	    linefound = 0;
-	    index = ts->inputtail;
+	canonical = ts->termio.c_lflag & ICANON;
+      }
 
-	    while (index != ts->inputhead)
-	      {
-		ch = ts->inputbuf [index++];
-		if (index >= MAX_INPUT)
-		  index = 0;
+    /*  lineoff = offset of the first line terminator:  */
+    if (ts->nlines > 0)
+	lineoff = (ts->firstlineend - ts->inputtail) & (MAX_INPUT - 1);
 
-		if (ch == ts->termio.c_cc[VEOF] ||
-			ch == ts->termio.c_cc[VEOL] || ch == '\n')
-		  linefound = 1;
-	      }
+    if (canonical)
+	len = lineoff + 1;
+    else
+	len = terminal__inputlen (ts);
 
-	    if (linefound)
-	      {
-		/*  Return the line we found:  */
-		tmplen = 0;
-		index = ts->inputtail;
-		while (tmplen < maxlen)
-		  {
-		    ch = ts->inputbuf [index++];
-		    if (index >= MAX_INPUT)
-			index = 0;
-		    buf[tmplen++] = ch;
-		    if (ch == ts->termio.c_cc[VEOF] ||
-			ch == ts->termio.c_cc[VEOL] || ch == '\n')
-		      tmplen = maxlen;
-		    chars_read ++;
-		  }
-		ts->inputtail = index;
-	      }
-	    else
-	      {
-		/*  Let's sleep until a line is read:  */
-		sleep (&ts->linemode_sleep, "terminal_read");
-	      }
-	  }
+    if (len > maxlen)
+	len = maxlen;
 
-	interrupts (oldints);
-	return chars_read;
-      }
+    oldtail = ts->inputtail;
+    terminal__copyout (ts, buf, len);
 
-    /*  Non-canonical mode, return data from inputbuf:  */
-    /*  TODO:  rename linemode_sleep to something else...  */
-    if (ts->inputtail == ts->inputhead)
-	sleep (&ts->linemode_sleep, "terminal_read");
+    /*
+     *	Were any line terminators read?  In canonical mode, this is
+     *	only the first one (if the whole line fit in buf), but in
+     *	non-canonical mode any number of lines may have been read.
+     *	Then find the terminator of the new first line.
+     */
 
-    while (maxlen > 0)
+    if (ts->nlines > 0 && lineoff < len)
       {
-	if (ts->inputtail == ts->inputhead)
-	  return chars_read;
+	ts->nlines --;
 
-	buf[0] = ts->inputbuf[ts->inputtail++];
-	if (ts->inputtail >= MAX_INPUT)
-	  ts->inputtail = 0;
+	for (index=lineoff+1; index<len && ts->nlines > 0; index++)
+	  if (TERMINAL_ISLINEEND(ts, (oldtail + index) & (MAX_INPUT - 1)))
+	    ts->nlines --;
 
-	buf ++;
-	maxlen --;
-	chars_read ++;
+	/*  nlines > 0 means that a marked terminator is left in inputbuf,
+	    so inputhead should never be reached (but don't spin if it is):  */
+	if (ts->nlines > 0)
+	  {
+	    index = ts->inputtail;
+	    while (!TERMINAL_ISLINEEND(ts, index) && index != ts->inputhead)
+		index = (index + 1) & (MAX_INPUT - 1);
+	    if (index == ts->inputhead)
+		ts->nlines = 0;
+	    else
+		ts->firstlineend = index;
+	  }
       }
 
-    return chars_read;
+    interrupts (oldints);
+    return len;
   }
 
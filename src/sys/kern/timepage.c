@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  kern/timepage.c  --  the shared time page
+ *
+ *	Programs ask for the time very often, and each gettimeofday() used
+ *	to be a full system call. Instead, the kernel keeps the time at the
+ *	last tick, and the calibration of the clocksource, in a page which
+ *	is mapped read-only into every process at TIMEPAGE_ADDR (see
+ *	sys/timepage.h). If the clocksource can be read from userland (the
+ *	TSC on i386), then userland can interpolate between ticks exactly
+ *	like timer_gettime() does.
+ *
+ *	The page belongs to an anonymous vm_object which the kernel keeps a
+ *	reference to, so it is never freed, and since it is always shared
+ *	the pageout daemon leaves it alone.
+ *
+ *	timepage_init ()
+ *		Allocate the page.
+ *
+ *	timepage_update ()
+ *		Copy the current time to the page.  (Called by timer() on
+ *		each tick.)
+ *
+ *	timepage_attach ()
+ *		Map the page into a process.  (Called by sys_execve().)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/defs.h>
+#include <sys/interrupts.h>
+#include <sys/timer.h>
+#include <sys/time.h>
+#include <sys/proc.h>
+#include <sys/vm.h>
+#include <sys/malloc.h>
+#include <sys/errno.h>
+#include <sys/timepage.h>
+
+
+extern volatile struct timespec system_time;
+extern volatile u_int64_t timer_uptime;
+extern volatile u_int64_t timer_tickstamp;
+extern struct clocksource *timer_clocksource;
+extern long nanosec_tick_length;
+extern size_t userland_startaddr;
+extern size_t default_stack_size;
+
+struct timepage *timepage = NULL;
+struct vm_object *timepage_object = NULL;
+
+
+
+void timepage_init ()
+  {
+    /*
+     *	timepage_init ()
+     *	----------------
+     *
+     *	Allocate the time page and its vm_object. The kernel's own
+     *	reference keeps the object alive when no process has it mapped.
+     */
+
+    struct timepage *tp;
+    int oldints;
+
+    tp = (struct timepage *) malloc (PAGESIZE);
+    timepage_object = vm_object_create (VM_OBJECT_ANONYMOUS);
+    if (!tp || !timepage_object)
+	panic ("timepage_init: out of memory");
+
+    memset (tp, 0, PAGESIZE);
+    tp->magic = TIMEPAGE_MAGIC;
+    tp->version = TIMEPAGE_VERSION;
+    tp->shift = CLOCKSOURCE_SHIFT;
+
+    timepage_object->refcount = 1;
+    vm_object_addpage (timepage_object, (byte *) tp, 0);
+
+    oldints = interrupts (DISABLE);
+    timepage = tp;
+    timepage_update ();
+    interrupts (oldints);
+  }
+
+
+
+void timepage_update ()
+  {
+    /*
+     *	timepage_update ()
+     *	------------------
+     *
+     *	Copy system_time and the clocksource data to the time page. seq
+     *	is odd while the fields are being written, so that a reader
+     *	which is interrupted in the middle can tell that it must try
+     *	again. Interrupts should be disabled.
+     */
+
+    struct timepage *tp = timepage;
+
+    if (!tp)
+	return;
+
+    tp->seq ++;
+
+    tp->sec = system_time.tv_sec;
+    tp->nsec = system_time.tv_nsec;
+    tp->uptime = timer_uptime;
+    tp->tick_nsec = nanosec_tick_length;
+
+    if (timer_clocksource && (timer_clocksource->flags & CLOCKSOURCE_USERREAD))
+      {
+	tp->flags = TIMEPAGE_USERCLOCK;
+	tp->tickstamp = timer_tickstamp;
+	tp->cycles_per_tick = timer_clocksource->cycles_per_tick;
+	tp->mult = timer_clocksource->mult;
+      }
+    else
+	tp->flags = 0;
+
+    tp->seq ++;
+  }
+
+
+
+int timepage_attach (struct proc *p)
+  {
+    /*
+     *	timepage_attach ()
+     *	------------------
+     *
+     *	Map the time page read-only at TIMEPAGE_ADDR in process p. If
+     *	that address is taken by the stack (a very large kernel, or a
+     *	very large stack), then the page is simply not mapped; userland
+     *	will use the system call instead.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    if (!p || !timepage_object)
+	return EINVAL;
+
+    if ((u_int64_t)TIMEPAGE_ADDR + PAGESIZE > (u_int64_t)0x100000000
+	- userland_startaddr - default_stack_size)
+	return ENOMEM;
+
+    if (!vm_region_attach (p, timepage_object, 0, TIMEPAGE_ADDR,
+	TIMEPAGE_ADDR + PAGESIZE - 1, VMREGION_READABLE))
+	return ENOMEM;
+
+    return 0;
+  }
+
@@ -41,9 +41,26 @@
  *	timer_sleep()
  *		Add a process to the timer sleep "queue".
  *
+ *	timer_setclocksource()
+ *		Called by machine dependant code to register a clocksource.
+ *
+ *	timer_gettime(), timer_getuptime()
+ *		Read the current time (since 1970, or since boot) with
+ *		better than tick resolution, if there is a clocksource.
+ *
+ *	Sleeping processes and kernel timers are kept in the timer wakeup
+ *	chain, sorted by their deadline (in nanoseconds since boot). They
+ *	are woken up at the first tick after their deadline, unless there
+ *	is a clocksource and the machine dependant code can arrange for an
+ *	extra timer interrupt in the middle of a tick (a "one-shot"). Then
+ *	the first deadline within the next tick gets its own interrupt.
+ *
  *  History:
  *	28 Dec 1999	first version
  *	15 Jun 2000	adding timer sleep queues
+ *	19 Oct 2026	clocksources, nanosecond deadlines in the wakeup
+ *			chain, and one-shot timer interrupts
+ *	19 Oct 2026	updating the shared time page on each tick
  */
 
 
@@ -57,6 +74,7 @@
 #include <sys/proc.h>
 #include <sys/malloc.h>
 #include <sys/errno.h>
+#include <sys/timepage.h>
 
 
 /*  This variable (and curproc->[usi]ticks) should be updated HZ times per second  */
@@ -75,6 +93,17 @@ volatile struct timespec system_time;
 volatile int		ticks_until_systimeinc;
 long			nanosec_tick_length;
 
+/*  Nanoseconds since boot, at the last tick:  */
+volatile u_int64_t	timer_uptime;
+
+/*  The clocksource (if any), and its value at the last tick:  */
+struct clocksource	*timer_clocksource = NULL;
+volatile u_int64_t	timer_tickstamp;
+
+/*  One-shot interrupt state, and the time (after the tick) it was set for:  */
+volatile int		timer_oneshot;
+u_int32_t		timer_oneshot_nsec;
+
 
 /*  *****  TODO: ta bort  */
 extern struct mcb      *first_mcb;
@@ -82,6 +111,7 @@ extern size_t          nr_of_mcbs;
 
 
 extern volatile struct proc *curproc;
+extern volatile int need_to_pswitch;
 extern int switchratio;
 
 
@@ -98,6 +128,8 @@ void timer_init ()
     system_ticks = 0;
     ticks_until_pswitch = 0;
     ticks_until_systimeinc = 0;
+    timer_uptime = 0;
+    timer_oneshot = TIMER_ONESHOT_NONE;
     first_twc = NULL;				/*  timer wakeup chain  */
     nanosec_tick_length = 1000000000 / HZ;
 
@@ -107,6 +139,189 @@ void timer_init ()
 
 
 
+u_int32_t timer_div64 (u_int64_t n, u_int32_t d)
+  {
+    /*
+     *	Return n / d, without using a 64-bit division from libgcc.
+     *	The result must fit in 32 bits.
+     */
+
+    u_int64_t r = 0;
+    u_int32_t q = 0;
+    int i;
+
+    for (i=63; i>=0; i--)
+      {
+	r = (r << 1) | ((n >> i) & 1);
+	q <<= 1;
+	if (r >= d)
+	  {
+	    r -= d;
+	    q |= 1;
+	  }
+      }
+
+    return q;
+  }
+
+
+
+void timer_setclocksource (struct clocksource *cs)
+  {
+    /*
+     *	timer_setclocksource ()
+     *	-----------------------
+     *
+     *	Use cs to interpolate between ticks. cs->cycles_per_tick must have
+     *	been measured by the caller.
+     */
+
+    int oldints;
+
+    if (!cs || !cs->read || !cs->cycles_per_tick)
+	return;
+
+    cs->mult = timer_div64 ((u_int64_t) nanosec_tick_length
+	<< CLOCKSOURCE_SHIFT, cs->cycles_per_tick);
+
+    oldints = interrupts (DISABLE);
+    timer_tickstamp = cs->read ();
+    timer_clocksource = cs;
+    interrupts (oldints);
+
+    printk ("timer: clocksource %s, %i cycles per tick", cs->name,
+	cs->cycles_per_tick);
+  }
+
+
+
+u_int32_t timer_phase ()
+  {
+    /*
+     *	Return the number of nanoseconds since the last tick (0 if there
+     *	is no clocksource). It never reaches a whole tick, so time doesn't
+     *	go backwards if a tick is late. Interrupts should be disabled.
+     */
+
+    u_int64_t delta;
+    u_int32_t ns;
+
+    if (!timer_clocksource)
+	return 0;
+
+    delta = timer_clocksource->read () - timer_tickstamp;
+    if (delta >= timer_clocksource->cycles_per_tick)
+	return nanosec_tick_length - 1;
+
+    ns = (u_int32_t) ((delta * timer_clocksource->mult) >> CLOCKSOURCE_SHIFT);
+    if (ns >= nanosec_tick_length)
+	ns = nanosec_tick_length - 1;
+
+    return ns;
+  }
+
+
+
+void timer_gettime (struct timespec *ts)
+  {
+    /*  Current time (since 1970):  */
+
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    ts->tv_sec = system_time.tv_sec;
+    ts->tv_nsec = system_time.tv_nsec + timer_phase ();
+    interrupts (oldints);
+
+    if (ts->tv_nsec >= 1000000000)
+      {
+	ts->tv_sec ++;
+	ts->tv_nsec -= 1000000000;
+      }
+  }
+
+
+
+u_int64_t timer_getuptime ()
+  {
+    /*  Nanoseconds since boot:  */
+
+    u_int64_t t;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    t = timer_uptime + timer_phase ();
+    interrupts (oldints);
+
+    return t;
+  }
+
+
+
+void timer_wakeups (u_int64_t now)
+  {
+    /*
+     *	Wake up all processes (and run all kernel functions) in the timer
+     *	wakeup chain whose deadline is not later than now. Interrupts
+     *	should be disabled.
+     */
+
+    volatile struct timer_wakeup_chain *twentry;
+    void (*k_func)();
+
+    while (first_twc && first_twc->deadline <= now)
+      {
+	/*  Remove the entry first, k_func() may add new entries:  */
+	twentry = first_twc;
+	first_twc = twentry->next;
+
+	if (twentry->flags == TWC_USER)
+	    wakeup (twentry->wakeup_addr);
+	else
+	  {
+	    k_func = twentry->wakeup_addr;
+	    k_func ();
+	  }
+
+	free ((struct timer_wakeup_chain *)twentry);
+      }
+  }
+
+
+
+void timer_arm ()
+  {
+    /*
+     *	timer_arm ()
+     *	------------
+     *
+     *	If the first deadline in the timer wakeup chain comes before the
+     *	next tick, ask the machine dependant code for a one-shot interrupt
+     *	at that time. Only one is used per tick, and only if there is a
+     *	clocksource (otherwise we don't know where in the tick we are).
+     *	If the machine dependant code can't do it, the deadline is handled
+     *	at the next tick instead.
+     *
+     *	Interrupts should be disabled.
+     */
+
+    u_int32_t nsec;
+
+    if (!timer_clocksource || timer_oneshot != TIMER_ONESHOT_NONE
+	|| !first_twc || first_twc->deadline >= timer_uptime
+	+ nanosec_tick_length)
+	return;
+
+    nsec = (u_int32_t) (first_twc->deadline - timer_uptime);
+    if (machdep_timer_oneshot (nsec))
+      {
+	timer_oneshot = TIMER_ONESHOT_ARMED;
+	timer_oneshot_nsec = nsec;
+      }
+  }
+
+
+
 void timer ()
   {
     /*
@@ -121,22 +336,35 @@ void timer ()
      *		(o)  Increase the correct ticks field
      *			of the current process
      *
-     *		(o)  If there are any processes sleeping on the timer,
-     *		     then decrease the time remaining on the first
-     *		     sleeping process and wake up one or more from the
-     *		     timer sleep chain.
+     *		(o)  Increase system_time and timer_uptime, and
+     *		     copy them to the shared time page
      *
-     *		(o)  Increase system_time
+     *		(o)  Wake up processes from the timer wakeup chain
+     *		     whose deadlines have passed, and perhaps arrange
+     *		     for a one-shot interrupt before the next tick.
      *
      *		(o)  Call pswitch() if enough time has passed since
      *		     the last time we switched processes.
      *
+     *	If a one-shot interrupt has been armed, then the next call is
+     *	that interrupt, not a tick. Then we only wake up processes.
+     *
      *	Interrupts should be DISABLED by timer_asm before calling this
      *	routine.
      */
 
-    volatile struct timer_wakeup_chain *twentry;
-    void (*k_func)();
+    if (timer_oneshot == TIMER_ONESHOT_ARMED)
+      {
+	timer_oneshot = TIMER_ONESHOT_FIRED;
+	machdep_timer_oneshot_done ();
+
+	timer_wakeups (timer_uptime + timer_oneshot_nsec);
+
+	/*  Let a woken process run right away:  */
+	if (need_to_pswitch)
+	    pswitch ();
+	return;
+      }
 
 
     /*
@@ -144,6 +372,9 @@ void timer ()
      */
 
     system_ticks ++;
+    if (timer_clocksource)
+	timer_tickstamp = timer_clocksource->read ();
+    timer_oneshot = TIMER_ONESHOT_NONE;
 
 
 /*  TODO: temporary i386 hack to see if we are running at all...  */
@@ -155,49 +386,11 @@ void timer ()
 
 
     /*
-     *	Check the timer sleep chain, and wake up one or more processes
-     *	if they have slept enough:
+     *	Advance the system_time (nr of seconds since 1970) and the time
+     *	since boot:
      */
 
-    if (first_twc)
-      {
-	twentry = first_twc;
-
-	/*  There may be more than one process to wake up, so we
-	    loop for a little while here:  :-)  */
-	while (twentry)
-	  {
-	    if (twentry->ticks <= 0)
-	      {
-		/*  Wake up the process, or run the kernel function:  */
-		if (twentry->flags == TWC_USER)
-		  wakeup (twentry->wakeup_addr);
-		else
-		  {
-		    k_func = twentry->wakeup_addr;
-		    k_func ();
-		  }
-
-		/*  Remove this entry from the wakeup chain:  */
-		first_twc = twentry->next;
-		free ((struct timer_wakeup_chain *)twentry);
-
-		/*  Continue the loop to try to wake up others...  */
-		twentry = first_twc;
-	      }
-	    else
-	      {
-		/*  Don't awaken anyone...  */
-		twentry->ticks --;
-		twentry = NULL;		/*  to abort the while()  */
-	      }
-	  }
-      }
-
-
-    /*
-     *	Advance the system_time (nr of seconds since 1970):
-     */
+    timer_uptime += nanosec_tick_length;
 
     system_time.tv_nsec += nanosec_tick_length;
     if (--ticks_until_systimeinc <= 0)
@@ -207,6 +400,17 @@ void timer ()
 	system_time.tv_nsec = 0;
       }
 
+    timepage_update ();
+
+
+    /*
+     *	Wake up processes (or run kernel functions) which have slept
+     *	enough:
+     */
+
+    timer_wakeups (timer_uptime);
+    timer_arm ();
+
 
     /*
      *	Call pswitch() at regular intervals. switchratio is set by machine
@@ -266,63 +470,40 @@ int timer_sleep__internal (struct proc *p, struct timespec *ts, char *sleepmsg,
 
     volatile struct timer_wakeup_chain *newtwentry, *curlink, *lastlink;
     int oldints;
-    int added;
 
 
     newtwentry = (struct timer_wakeup_chain *) malloc (sizeof(struct timer_wakeup_chain));
     if (!newtwentry)
 	return ENOMEM;
 
-    /*  TODO:  this drops accuracy to microseconds instead of nanoseconds:  */
-    newtwentry->ticks = ts->tv_sec * HZ +
-	(((s_int32_t)ts->tv_nsec/1000) * HZ / 1000000);
     newtwentry->wakeup_addr = (p==NULL)? k_func : &p->ticks;
     newtwentry->next = NULL;
     newtwentry->flags = (p==NULL)? TWC_KERNEL : TWC_USER;
 
     oldints = interrupts (DISABLE);
 
-    /*  Find a place in the first_twc where we should insert newtwentry:  */
-    if (first_twc)
+    newtwentry->deadline = timer_getuptime () + (u_int64_t) ts->tv_sec
+	* 1000000000 + (u_int32_t) ts->tv_nsec;
+
+    /*  Insert newtwentry after all entries with the same or earlier
+	deadlines:  */
+    lastlink = NULL;
+    curlink = first_twc;
+    while (curlink && curlink->deadline <= newtwentry->deadline)
       {
-	curlink = first_twc;
-	lastlink = NULL;
-	added = 0;
-	while (curlink)
-	  {
-	    if (newtwentry->ticks < curlink->ticks)
-	      {
-		/*  Insert newtwentry before this curlink...  */
-		newtwentry->next = curlink;
-		curlink->ticks -= newtwentry->ticks;
-		if (lastlink)
-		    lastlink->next = newtwentry;
-		else
-		    first_twc = newtwentry;
-		curlink = NULL; 	/*  to abort the while loop  */
-		added = 1;
-	      }
-	    else
-	      {
-		newtwentry->ticks -= curlink->ticks;
-		lastlink = curlink;
-		curlink = curlink->next;
-	      }
-	  }
-	if (!added)
-	  {
-	    /*  Add this entry last in the chain:  */
-	    if (lastlink)
-	      {
-		lastlink->next = newtwentry;
-	      }
-	    else
-		panic ("timer_sleep: lastlink==NULL");
-	  }
+	lastlink = curlink;
+	curlink = curlink->next;
       }
+
+    newtwentry->next = curlink;
+    if (lastlink)
+	lastlink->next = newtwentry;
     else
       {
 	first_twc = newtwentry;
+
+	/*  The new entry may need a one-shot interrupt in this tick:  */
+	timer_arm ();
       }
 
     if (p)
@@ -372,10 +553,6 @@ printk ("ts=%x k_func=%x resetflag=%x", (int)ts, (int)k_func, (int)resetflag);
 
 	    if (curlink->wakeup_addr == k_func)
 	      {
-		/*  Add ticks from this link to the next link:  */
-		if (nextlink)
-		  nextlink->ticks += curlink->ticks;
-
 		/*  Link from previous to next:  */
 		if (lastlink)
 		  lastlink->next = nextlink;
@@ -36,6 +36,9 @@
  *	5 Feb 2000	read single sector works
  *	15 Mar 2000	read multiple sectors in one call
  *	29 Jul 2000	motors are turned off after 3 seconds of inactivity
+ *	19 Oct 2026	per-drive track cache (both heads of a cylinder),
+ *			two DMA buffers with read-ahead of the other head,
+ *			SPECIFY is only sent when the drive type changes
  */
 
 
@@ -45,6 +48,7 @@
 #include <stdio.h>
 #include <sys/std.h>
 #include <sys/errno.h>
+#include <sys/malloc.h>
 #include <sys/module.h>
 #include <sys/ports.h>
 #include <sys/proc.h>
@@ -72,6 +76,18 @@ extern struct timespec system_time;
 /*  Nr of retries on errors:  */
 #define	NR_RETRIES		3
 
+/*  Max nr of sectors per track (2.88 MB drives), and max nr of heads:  */
+#define	MAX_TRACKSECS		36
+#define	MAX_HEADS		2
+
+/*  Size of each DMA buffer (one full track):  */
+#define	DMABUF_SIZE		(512*MAX_TRACKSECS)
+
+/*  DMA buffers: one for demand reads and writes, one for read-ahead  */
+#define	DMABUF_DEMAND		0
+#define	DMABUF_AHEAD		1
+#define	NR_DMABUFS		2
+
 
 char *fdc_fdid[MAX_FDIDS] =
       {
@@ -102,6 +118,37 @@ struct fdc_drivestatus
 struct fdc_drivestatus fdc_drivestatus [MAX_DRIVES];
 
 
+/*
+ *  Track cache:  The contents of one cylinder (both heads) is kept for
+ *  each drive. cyl is -1 when nothing is cached.
+ */
+
+struct fdc_trackcache
+      {
+	int	cyl;
+	int	valid [MAX_HEADS];
+	byte	*data [MAX_HEADS];
+      };
+
+struct fdc_trackcache fdc_trackcache [MAX_DRIVES];
+
+
+/*
+ *  A read-ahead of the other head of the cylinder may be running on the
+ *  controller (into fdc_dmabuf[DMABUF_AHEAD]) after fdc_read_track() has
+ *  returned. drive is -1 when no read-ahead is pending.
+ */
+
+struct fdc_readahead
+      {
+	int	drive;
+	int	cyl;
+	int	head;
+      };
+
+struct fdc_readahead fdc_pending;
+
+
 /*  These are offsets from fdc_portbase:  */
 #define	FDCPORT_DOR		2		/*  Digital Output Register  */
 #define	FDCPORT_STATUS		4		/*  Status register  */
@@ -132,14 +179,19 @@ int fdc_portmax;
 int fdc_irqnr;
 int fdc_dmanr;
 int fdc_type;
-size_t fdc_bufferaddr;
+size_t fdc_dmabuf [NR_DMABUFS];
 int fdc_controllertype;
 volatile int fdc_irqexpect = 0;
 
+/*  Drive type for which SPECIFY and data rate were last sent (-1 = none):  */
+int fdc_specified_type = -1;
+
 struct lockstruct fdc_lock;
 
 struct module *fdc_m;
 
+void fdc_readahead_complete (int canwait);
+
 char fdc_skewexperiment [80] =
       {
 	 3,  4,  5,  5,  5,  5,  6,  6,  7,  7,
@@ -284,6 +336,9 @@ void fdc_disablemotors ()
 	LOCK_NOINTERRUPTS | LOCK_RW) < 0)
       return;
 
+    /*  We are called from the timer, so we may not sleep here:  */
+    fdc_readahead_complete (0);
+
     fdc_drivestatus[0].motor_enabled = 0;
     fdc_drivestatus[1].motor_enabled = 0;
     fdc_enable_motors ();
@@ -435,83 +490,294 @@ seek_retry:
 
 
 
-int fdc_read_sectors (int drive, int abssector, int nrofsectors, byte *buf)
+void fdc_specify (int drive)
+  {
+    /*
+     *	Send SPECIFY (step rate, head load/unload time) and set the data
+     *	rate, unless that has already been done for this drive type.
+     *	These settings are per controller and survive seeks and
+     *	recalibrations, so there is no need to send them on every read.
+     */
+
+    int type = fdc_drivestatus[drive].type;
+
+    if (fdc_specified_type == type)
+	return;
+
+    fdc_sendcommand (FDCCMD_SPECIFY);
+    fdc_sendcommand (fdc_stephl[type]);
+    fdc_sendcommand (6);
+
+    outb (fdc_portbase+FDCPORT_SETRATE, 0);
+
+    fdc_specified_type = type;
+  }
+
+
+
+int fdc_startread (int drive, int cyl, int head, int bufnr)
   {
     /*
-     *	Read sectors starting at abssector into buf.
+     *	Start reading an entire track into fdc_dmabuf[bufnr]. The
+     *	command is sent to the controller, but we don't wait for it
+     *	to complete; fdc_finishcommand() does that.
+     *
+     *	Returns 1 on success, 0 on failure.
+     */
+
+    int type = fdc_drivestatus[drive].type;
+
+    /*  Prepare the DMA for reading the track:  */
+    isadma_startdma (fdc_dmanr, (void *) fdc_dmabuf[bufnr],
+		(size_t)(512*fdc_nrsec[type]), 0x44);
+
+    /*  Seek:  (nothing is done if the head is already there)  */
+    if (!fdc_seek_to_cylinder (drive, cyl, head))
+	return 0;
+
+    fdc_specify (drive);
+
+    fdc_irqexpect = 1;
+    fdc_sendcommand (FDCCMD_READ);
+    fdc_sendcommand (head*4 + drive);
+    fdc_sendcommand (cyl);		/*  Cylinder  */
+    fdc_sendcommand (head);		/*  Head  */
+    fdc_sendcommand (1);		/*  Sector  */
+    fdc_sendcommand (2);		/*  0=128, 1=256, 2=512, 3=1024, ...  */
+    fdc_sendcommand (fdc_nrsec[type]);	/*  Last sector in track  */
+    fdc_sendcommand (fdc_gap3[type]);
+    fdc_sendcommand (0xff);
+
+    return 1;
+  }
+
+
+
+int fdc_finishcommand (int *res)
+  {
+    /*
+     *	Wait for a read or write command to complete, and read the
+     *	7 result bytes into res[].
+     *
+     *	Returns 1 if the command was successful, 0 otherwise.
+     */
+
+    int i, oldints;
+
+    /*  Interrupts are disabled so that the irq cannot slip in between
+	the test and the sleep:  */
+    oldints = interrupts (DISABLE);
+    if (fdc_irqexpect)
+	sleep (fdc_irqhandler, fdc_m->shortname);
+    interrupts (oldints);
+
+    for (i=0; i<=6; i++)
+	res[i] = fdc_readdata();
+
+    return ((res[0]&0xf8)==0 && res[1]==0 && res[2]==0);
+  }
+
+
+
+void fdc_readahead_complete (int canwait)
+  {
+    /*
+     *	If a read-ahead is pending, then wait for it to finish and move
+     *	the data into the track cache. This must be called before any
+     *	other command is sent to the controller.
+     *
+     *	If canwait is zero and the read-ahead has not yet completed, it
+     *	is abandoned instead.
+     */
+
+    struct fdc_trackcache *tc;
+    int drive, res[7];
+
+    drive = fdc_pending.drive;
+    if (drive < 0)
+	return;
+
+    fdc_pending.drive = -1;
+
+    if (!canwait && fdc_irqexpect)
+      {
+	fdc_irqexpect = 0;
+	fdc_drivestatus[drive].needs_recalibration = 1;
+	fdc_specified_type = -1;
+	return;
+      }
+
+    if (!fdc_finishcommand (res))
+      {
+	/*  Not fatal; the track will be read on demand instead.  */
+	fdc_drivestatus[drive].needs_recalibration = 1;
+	return;
+      }
+
+    tc = &fdc_trackcache[drive];
+    if (tc->cyl != fdc_pending.cyl)
+	return;
+
+    memcpy (tc->data[fdc_pending.head], (void *) fdc_dmabuf[DMABUF_AHEAD],
+	512*fdc_nrsec[fdc_drivestatus[drive].type]);
+    tc->valid[fdc_pending.head] = 1;
+  }
+
+
+
+void fdc_trackcache_invalidate (int drive)
+  {
+    fdc_readahead_complete (1);
+
+    fdc_trackcache[drive].cyl = -1;
+    fdc_trackcache[drive].valid[0] = 0;
+    fdc_trackcache[drive].valid[1] = 0;
+  }
+
+
+
+int fdc_read_track (int drive, int cyl, int head)
+  {
+    /*
+     *	Make sure that one track (cyl, head) is in the track cache.
+     *
+     *	If it has to be read from the disk, then a read-ahead of the
+     *	other head of the same cylinder is queued on the controller
+     *	(into the second DMA buffer) before the data we just read is
+     *	copied out of the first DMA buffer. The next read of the other
+     *	head then doesn't have to wait for a full rotation.
      *
      *	Return 1 on success, 0 on failure.
      */
 
+    struct fdc_trackcache *tc = &fdc_trackcache[drive];
+    int type = fdc_drivestatus[drive].type;
     int retries = NR_RETRIES;
     int hardretries = NR_RETRIES;
-    int c,h,s, i, res[7];
+    int res[7], other;
 
-    if (nrofsectors<1)
+    /*  The read-ahead may be the track we want:  */
+    fdc_readahead_complete (1);
+
+    if (tc->cyl == cyl && tc->valid[head])
+	return 1;
+
+    if (tc->cyl != cyl)
       {
-	printk ("fdc_read_sectors(): nrofsectors=%i", nrofsectors);
-	return 0;
+	tc->cyl = cyl;
+	tc->valid[0] = 0;
+	tc->valid[1] = 0;
       }
 
 read_retry:
 
-    /*  Prepare the DMA for reading a sector:  */
-    isadma_startdma (fdc_dmanr, (void *) fdc_bufferaddr,
-		(size_t)(512*nrofsectors), 0x44);
+    if (!fdc_startread (drive, cyl, head, DMABUF_DEMAND))
+	return 0;
+
+    if (!fdc_finishcommand (res))
+      {
+/*	printk ("fd%i: soft error: read failed (r0=%y, r1=%y r2=%y)", drive,res[0],res[1],res[2]);  */
+	fdc_drivestatus[drive].needs_recalibration = 1;
+	fdc_specified_type = -1;
 
-    /*  Convert the absolute sector number to CHS:  */
-    fdc_whichsector (abssector, drive, &c, &h, &s);
+	if (retries-- > 0)
+	    goto read_retry;
+
+	printk ("fd%i: hard error: read failed (chs=%i,%i,1) (r0=%y, r1=%y r2=%y)",
+	    drive, cyl,head, res[0],res[1],res[2]);
+
+	retries = NR_RETRIES;
+	if (hardretries-- > 0)
+	    goto read_retry;
 
-    /*  Seek:  */
-    i = fdc_seek_to_cylinder (drive, c, h);
-    if (i==0)
 	return 0;
+      }
 
-    /*  Specify head load time, step rate time:  */
-    fdc_sendcommand (FDCCMD_SPECIFY);
-    fdc_sendcommand (fdc_stephl[fdc_drivestatus[drive].type]);
-    fdc_sendcommand (6);
+    /*  Queue the read-ahead of the other head, if it isn't cached:  */
+    other = head ^ 1;
+    if (fdc_nrheads[type] > 1 && !tc->valid[other])
+      {
+	if (fdc_startread (drive, cyl, other, DMABUF_AHEAD))
+	  {
+	    fdc_pending.drive = drive;
+	    fdc_pending.cyl   = cyl;
+	    fdc_pending.head  = other;
+	  }
+      }
 
-    outb (fdc_portbase+FDCPORT_SETRATE, 0);
+    /*  ... and copy the data while the controller is busy:  */
+    memcpy (tc->data[head], (void *) fdc_dmabuf[DMABUF_DEMAND],
+	512*fdc_nrsec[type]);
+    tc->valid[head] = 1;
 
-    fdc_irqexpect = 1;
-/*    interrupt_to_wait_for = fdc_irqnr;*/
-    fdc_sendcommand (FDCCMD_READ);
-    fdc_sendcommand (h*4 + drive);
-    fdc_sendcommand (c);		/*  Cylinder  */
-    fdc_sendcommand (h);		/*  Head  */
-    fdc_sendcommand (s);		/*  Sector  */
-    fdc_sendcommand (2);		/*  0=128, 1=256, 2=512, 3=1024, ...  */
-    fdc_sendcommand (s+nrofsectors-1);	/*  Last sector in track  */
-    fdc_sendcommand (fdc_gap3[fdc_drivestatus[drive].type]);
-    fdc_sendcommand (0xff);
-    sleep (fdc_irqhandler, fdc_m->shortname);
-    for (i=0; i<=6; i++)
-	res[i] = fdc_readdata();
+    return 1;
+  }
 
-    if ((res[0]&0xf8)==0 && res[1]==0 && res[2]==0)
+
+
+int fdc_read_sectors (int drive, int abssector, int nrofsectors, byte *buf)
+  {
+    /*
+     *	Read sectors starting at abssector into buf. Data is always read
+     *	a full track at a time via the track cache.
+     *
+     *	Return 1 on success, 0 on failure.
+     */
+
+    int c,h,s, n, nrsec;
+
+    if (nrofsectors<1)
       {
-	/*  Copy the resulting data to 'buf':  */
-	memcpy (buf, (void *) fdc_bufferaddr, 512*nrofsectors);
+	printk ("fdc_read_sectors(): nrofsectors=%i", nrofsectors);
+	return 0;
+      }
 
-	return 1;
+    nrsec = fdc_nrsec[fdc_drivestatus[drive].type];
+
+    while (nrofsectors > 0)
+      {
+	/*  Convert the absolute sector number to CHS:  */
+	if (!fdc_whichsector (abssector, drive, &c, &h, &s))
+	    return 0;
+
+	if (!fdc_read_track (drive, c, h))
+	    return 0;
+
+	/*  Copy the part of this track that we want:  */
+	n = nrsec - s + 1;
+	if (n > nrofsectors)
+	    n = nrofsectors;
+
+	memcpy (buf, fdc_trackcache[drive].data[h] + 512*(s-1), 512*n);
+
+	buf += 512*n;
+	abssector += n;
+	nrofsectors -= n;
       }
 
+    return 1;
+  }
 
-/*    printk ("fd%i: soft error: read failed (r0=%y, r1=%y r2=%y)", drive,res[0],res[1],res[2]);  */
-    fdc_drivestatus[drive].needs_recalibration = 1;
 
-    if (retries-- > 0)
-	goto read_retry;
 
-    printk ("fd%i: hard error: read failed abssec=%i (chs=%i,%i,%i) (r0=%y, r1=%y r2=%y)",
-	drive, abssector, c,h,s, res[0],res[1],res[2]);
+void fdc_trackcache_update (int drive, int abssector, int nrofsectors, byte *buf)
+  {
+    /*
+     *	Copy sectors that have been written to the disk into the track
+     *	cache, if their track is cached.
+     */
 
-    retries = NR_RETRIES;
-    if (hardretries-- > 0)
-	goto read_retry;
+    struct fdc_trackcache *tc = &fdc_trackcache[drive];
+    int c,h,s;
 
-    return 0;
+    for (; nrofsectors > 0; nrofsectors--, abssector++, buf += 512)
+      {
+	if (!fdc_whichsector (abssector, drive, &c, &h, &s))
+	    return;
+
+	if (tc->cyl == c && tc->valid[h])
+	    memcpy (tc->data[h] + 512*(s-1), buf, 512);
+      }
   }
 
 
@@ -534,13 +800,16 @@ int fdc_write_sectors (int drive, int abssector, int nrofsectors, byte *buf)
 	return 0;
       }
 
+    /*  The controller must be idle before we start a new command:  */
+    fdc_readahead_complete (1);
+
 write_retry:
 
     /*  Prepare the DMA for writinging a sector:  */
-    isadma_startdma (fdc_dmanr, (void *) fdc_bufferaddr,
+    isadma_startdma (fdc_dmanr, (void *) fdc_dmabuf[DMABUF_DEMAND],
 		(size_t)(512*nrofsectors), 0x48);
 
-    memcpy ((void *) fdc_bufferaddr, buf, 512*nrofsectors);
+    memcpy ((void *) fdc_dmabuf[DMABUF_DEMAND], buf, 512*nrofsectors);
 
     /*  Convert the absolute sector number to CHS:  */
     fdc_whichsector (abssector, drive, &c, &h, &s);
@@ -551,11 +820,7 @@ write_retry:
 	return 0;
 
     /*  Specify head load time, step rate time:  */
-    fdc_sendcommand (FDCCMD_SPECIFY);
-    fdc_sendcommand (fdc_stephl[fdc_drivestatus[drive].type]);
-    fdc_sendcommand (6);
-
-    outb (fdc_portbase+FDCPORT_SETRATE, 0);
+    fdc_specify (drive);
 
     fdc_irqexpect = 1;
 /*    interrupt_to_wait_for = fdc_irqnr;*/
@@ -574,12 +839,14 @@ write_retry:
 
     if ((res[0]&0xf8)==0 && res[1]==0 && res[2]==0)
       {
-	/*  Write went okay...  */
+	/*  Write went okay. Keep the track cache up to date:  */
+	fdc_trackcache_update (drive, abssector, nrofsectors, buf);
 	return 1;
       }
 
     printk ("fd%i: soft error: write failed (r0=%y, r1=%y r2=%y)", drive,res[0],res[1],res[2]);
     fdc_drivestatus[drive].needs_recalibration = 1;
+    fdc_specified_type = -1;
 
     if (retries-- > 0)
 	goto write_retry;
@@ -607,6 +874,11 @@ int fdc_open (struct device *dev)
     if (drive<0 || drive>=MAX_DRIVES)
 	return ENXIO;
 
+    /*  The disk may have been changed since it was last open:  */
+    lock (&fdc_lock, (void *) "fdc_open", LOCK_BLOCKING | LOCK_RW);
+    fdc_trackcache_invalidate (drive);
+    unlock (&fdc_lock);
+
     fdc_drivestatus [drive].motor_enabled = 0;
     fdc_drivestatus [drive].cur_track = 0;
     fdc_drivestatus [drive].needs_recalibration = 1;
@@ -633,6 +905,10 @@ int fdc_close (struct device *dev)
     if (drive<0 || drive>=MAX_DRIVES)
 	return ENXIO;
 
+    lock (&fdc_lock, (void *) "fdc_close", LOCK_BLOCKING | LOCK_RW);
+    fdc_trackcache_invalidate (drive);
+    unlock (&fdc_lock);
+
     fdc_drivestatus [drive].motor_enabled = 0;
     fdc_drivestatus [drive].cur_track = 0;
     fdc_drivestatus [drive].needs_recalibration = 1;
@@ -730,7 +1006,8 @@ int fdc_readtip (struct device *dev, daddr_t blocknr, daddr_t *blocks_to_read,
      *	block nr where to start reading.
      *
      *	On floppies, the tip is always to read the full track (on one side
-     *	of the disk).
+     *	of the disk). The track cache in fdc_read_track() makes reading
+     *	the other side of the same cylinder right afterwards cheap.
      */
 
     int drive, c,h,s;
@@ -795,9 +1072,26 @@ void fdc_driveprobe (int unit, int type)
     fdc_drivestatus [unit].cur_track = 0;
     fdc_drivestatus [unit].needs_recalibration = 1;
 
+    fdc_trackcache [unit].cyl = -1;
+    fdc_trackcache [unit].valid[0] = 0;
+    fdc_trackcache [unit].valid[1] = 0;
+
     /*  TODO:  true non-BIOS detection  */
-    if (type < 1)
+    if (type < 1 || type >= MAX_FDIDS)
+	return;
+
+    fdc_trackcache [unit].data[0] = (byte *) malloc (512*fdc_nrsec[type]);
+    fdc_trackcache [unit].data[1] = (byte *) malloc (512*fdc_nrsec[type]);
+    if (!fdc_trackcache[unit].data[0] || !fdc_trackcache[unit].data[1])
+      {
+	printk ("fdc: could not allocate track cache for fd%i", unit);
+	if (fdc_trackcache[unit].data[0])
+	    free (fdc_trackcache[unit].data[0]);
+	if (fdc_trackcache[unit].data[1])
+	    free (fdc_trackcache[unit].data[1]);
+	fdc_drivestatus [unit].type = 0;
 	return;
+      }
 
 
     c = fdc_nrcyls [type];
@@ -842,6 +1136,9 @@ int fdc_probecontroller (int baseport)
 
     fdc_portbase = baseport;  fdc_portmax = baseport + 7;
 
+    /*  A reset clears the SPECIFY settings:  */
+    fdc_specified_type = -1;
+
     /*  reset fdc  */
     fdc_irqexpect = 1;
     outb (baseport + FDCPORT_DOR, 0);
@@ -957,11 +1254,16 @@ void fdc_init (int arg)
     printk ("%s", buf);
 
 
-    /*  Allocate 512*36 bytes for the floppy DMA buffer:  */
-    fdc_bufferaddr = (size_t) i386_lowalloc (512*36);
-    tmp = fdc_bufferaddr & 65535;
-    if (tmp > 65535-512*36)
-	fdc_bufferaddr = (size_t) i386_lowalloc (512*36);
+    /*  Allocate the floppy DMA buffers (one full track each).
+	A DMA buffer may not cross a 64KB boundary:  */
+    for (tmp=0; tmp<NR_DMABUFS; tmp++)
+      {
+	fdc_dmabuf[tmp] = (size_t) i386_lowalloc (DMABUF_SIZE);
+	if ((fdc_dmabuf[tmp] & 65535) > 65535-DMABUF_SIZE)
+	    fdc_dmabuf[tmp] = (size_t) i386_lowalloc (DMABUF_SIZE);
+      }
+
+    fdc_pending.drive = -1;
 
 
     /*
@@ -26,8 +26,23 @@
 /*
  *  modules/bus/isa/pccom/pccom.c  --  PC serial port driver
  *
+ *  The driver supports 8250, 16450, and 16550(A) UARTs. On a 16550A the
+ *  FIFOs are used, with the receive trigger level chosen depending on the
+ *  line speed.
+ *
+ *  All I/O is interrupt driven. The interrupt handler empties the receive
+ *  FIFO into a ring buffer, and refills the transmit FIFO from another ring
+ *  buffer whenever the UART signals that the transmitter holding register
+ *  is empty. Received characters are then handed to the general terminal
+ *  driver (kern/terminal.c).
+ *
+ *  If PCCOM_CONSOLE is defined (see md/config.h), kernel messages are also
+ *  written to that port (polled, so that they are seen even if interrupts
+ *  are disabled, for example during a panic).
+ *
  *  History:
  *	8 Dec 2000	test
+ *	19 Oct 2026	interrupt driven tty driver, FIFO support, console
  */
 
 
@@ -36,121 +51,726 @@
 #include <string.h>
 #include <stdio.h>
 #include <sys/std.h>
+#include <sys/malloc.h>
 #include <sys/module.h>
 #include <sys/proc.h>
 #include <sys/ports.h>
+#include <sys/console.h>
+#include <sys/errno.h>
+#include <sys/device.h>
 #include <sys/interrupts.h>
 #include <sys/arch/i386/pio.h>
 #include <sys/modules/bus/isa/isa.h>
+#include <sys/lock.h>
 
+#include "pccom.h"
 
-#define	PCCOM_BIOSPORTS		0x00000400
-#define	PCCOM_MAXPORTS		4
 
+extern size_t userland_startaddr;
 
-struct module *pccom_m [PCCOM_MAXPORTS];
+struct pccom_port *pccom_port [PCCOM_MAXPORTS];
 
+/*  Output (write) locks:  */
+struct lockstruct pccom_lock [PCCOM_MAXPORTS];
 
+char *pccom_uartname [] = { "8250", "16450", "16550", "16550A" };
 
-volatile int pccom_irq4expect = 0;
-volatile int pccom_irq3expect = 0;
+#ifdef PCCOM_CONSOLE
+void (*pccom_oldconsputs) (char *s, int color);
+#endif
 
 
 
-void pccom_irq4handler ()
-  {     
-    if (!pccom_irq4expect)
-      printk ("* stray pccom interrupt 4");
-    else
-      printk ("* pccom interrupt 4: okay");
+void pccom_txfill (struct pccom_port *p)
+  {
+    /*
+     *	Move bytes from the transmit ring to the UART, at most one FIFO
+     *	full. Must be called with interrupts disabled.
+     *
+     *	If the transmitter is still busy, nothing is written. (A THRE
+     *	interrupt will then arrive when it has become empty.)
+     */
+
+    int n;
+    size_t tail;
+
+    if (!(inb (p->baseport + PCCOM_LSR) & PCCOM_LSR_THRE))
+      {
+	p->txbusy = 1;
+	return;
+      }
+
+    tail = p->txtail;
+    for (n=0; n<p->fifosize && tail != p->txhead; n++)
+      {
+	outb (p->baseport + PCCOM_DATA, p->txbuf[tail]);
+	tail = (tail + 1) & (PCCOM_TXBUFSIZE - 1);
+      }
+    p->txtail = tail;
+
+    p->txbusy = (n > 0);
+
+    if (p->txsleep)
+	wakeup (&p->txsleep);
+  }
+
+
+
+void pccom_service (struct pccom_port *p)
+  {
+    /*
+     *	Handle all pending interrupt conditions of one UART.
+     *
+     *	Received bytes are only stored in the receive ring here, since
+     *	emptying the receive FIFO is the time critical part. They are
+     *	given to the terminal driver afterwards.
+     */
+
+    int iir, lsr;
+    size_t next;
+    char ch;
+
+    while (!((iir = inb (p->baseport + PCCOM_IIR)) & PCCOM_IIR_NOPEND))
+      {
+	switch (iir & PCCOM_IIR_MASK)
+	  {
+	    case PCCOM_IIR_RLS:
+		lsr = inb (p->baseport + PCCOM_LSR);
+		if (lsr & PCCOM_LSR_OE)
+		  p->overruns ++;
+		break;
+
+	    case PCCOM_IIR_RDA:
+	    case PCCOM_IIR_TIMEOUT:
+		while (inb (p->baseport + PCCOM_LSR) & PCCOM_LSR_DR)
+		  {
+		    ch = inb (p->baseport + PCCOM_DATA);
+		    next = (p->rxhead + 1) & (PCCOM_RXBUFSIZE - 1);
+		    if (next == p->rxtail)
+			p->rxdropped ++;
+		    else
+		      {
+			p->rxbuf[p->rxhead] = ch;
+			p->rxhead = next;
+		      }
+		  }
+		break;
+
+	    case PCCOM_IIR_THRE:
+		pccom_txfill (p);
+		break;
+
+	    case PCCOM_IIR_MS:
+		inb (p->baseport + PCCOM_MSR);
+		break;
+
+	    default:
+		/*  Unknown interrupt id. Make sure we don't loop forever:  */
+		return;
+	  }
+      }
 
-    pccom_irq4expect = 0;
-    wakeup (pccom_irq4handler);
+    /*  Give received characters to the terminal driver:  */
+    while (p->rxtail != p->rxhead)
+      {
+	ch = p->rxbuf[p->rxtail];
+	p->rxtail = (p->rxtail + 1) & (PCCOM_RXBUFSIZE - 1);
+	terminal_add_to_inputbuf (p->ts, ch);
+      }
+  }
+
+
+
+void pccom_irqhandler (int irq)
+  {
+    /*
+     *	COM1 and COM3 share irq 4, COM2 and COM4 share irq 3, so each
+     *	interrupt may have to be serviced by more than one port.
+     */
+
+    int i;
+
+    for (i=0; i<PCCOM_MAXPORTS; i++)
+	if (pccom_port[i] && pccom_port[i]->irq == irq)
+	  pccom_service (pccom_port[i]);
+  }
+
+
+
+void pccom_irq4handler ()
+  {
+    pccom_irqhandler (4);
   }
 
 
 
 void pccom_irq3handler ()
-  {     
-    if (!pccom_irq3expect)
-      printk ("* stray pccom interrupt 3");
+  {
+    pccom_irqhandler (3);
+  }
+
+
+
+int pccom_setspeed (struct pccom_port *p, int speed)
+  {
+    /*
+     *	Set the line speed (and 8N1). On a 16550A, the receive FIFO trigger
+     *	level is lowered at high speeds so that there is time to take the
+     *	interrupt before the FIFO overflows.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    int divisor, fcr, oldints;
+
+    if (speed <= 0)
+	return EINVAL;
+
+    divisor = PCCOM_FREQ / speed;
+    if (divisor < 1 || divisor > 65535)
+	return EINVAL;
+
+    oldints = interrupts (DISABLE);
+
+    outb (p->baseport + PCCOM_LCR, PCCOM_LCR_DLAB);
+    outb (p->baseport + PCCOM_DLL, divisor & 255);
+    outb (p->baseport + PCCOM_DLM, divisor / 256);
+    outb (p->baseport + PCCOM_LCR, PCCOM_LCR_8N1);
+
+    if (p->uarttype == PCCOM_UART_16550A)
+      {
+	fcr = PCCOM_FCR_ENABLE;
+	if (speed >= 38400)
+	  fcr |= PCCOM_FCR_TRIGGER_8;
+	else
+	  fcr |= PCCOM_FCR_TRIGGER_14;
+	outb (p->baseport + PCCOM_FCR, fcr);
+      }
+
+    p->speed = PCCOM_FREQ / divisor;
+
+    interrupts (oldints);
+    return 0;
+  }
+
+
+
+int pccom_probeuart (struct pccom_port *p)
+  {
+    /*
+     *	Detect the UART type by checking which FIFO bits come back in the
+     *	IIR after enabling the FIFOs. A 16550 (without A) has a broken FIFO,
+     *	so it is disabled again. 8250 and 16450 differ in that only the
+     *	16450 has a scratch register.
+     *
+     *	Returns 1 if a UART was found, 0 otherwise.
+     */
+
+    int iir;
+
+    if (inb (p->baseport + PCCOM_LSR) == 0xff)
+	return 0;
+
+    outb (p->baseport + PCCOM_FCR, PCCOM_FCR_ENABLE | PCCOM_FCR_RXRESET |
+	PCCOM_FCR_TXRESET | PCCOM_FCR_TRIGGER_14);
+    iir = inb (p->baseport + PCCOM_IIR) & PCCOM_IIR_FIFOMASK;
+
+    p->fifosize = 1;
+
+    if (iir == PCCOM_IIR_FIFOMASK)
+      {
+	p->uarttype = PCCOM_UART_16550A;
+	p->fifosize = 16;
+	return 1;
+      }
+
+    outb (p->baseport + PCCOM_FCR, 0);
+
+    if (iir == 0x80)
+      {
+	p->uarttype = PCCOM_UART_16550;
+	return 1;
+      }
+
+    outb (p->baseport + PCCOM_SCR, 0x5a);
+    if (inb (p->baseport + PCCOM_SCR) == 0x5a)
+	p->uarttype = PCCOM_UART_16450;
     else
-      printk ("* pccom interrupt 3: okay");
+	p->uarttype = PCCOM_UART_8250;
 
-    pccom_irq3expect = 0;
-    wakeup (pccom_irq3handler);
+    return 1;
   }
 
 
 
-void pccom_init (int arg)
+void pccom_txstart (struct pccom_port *p)
   {
-    char buf[100];
-    int res;
-    int i, p, intr;
-    u_int16_t *portptr = (u_int16_t *) PCCOM_BIOSPORTS;
+    int oldints;
 
+    oldints = interrupts (DISABLE);
+    if (!p->txbusy)
+	pccom_txfill (p);
+    interrupts (oldints);
+  }
 
-    memset (pccom_m, 0, sizeof(pccom_m));
 
 
+int pccom_termread ()
+  {
     /*
-     *	Register ports as found by BIOS:   (i386 specific)
+     *	Special termios code to process incomming characters:  none.
      */
 
-    for (i=0; i<4; i++)
+    return 0;
+  }
+
+
+
+int pccom_termwrite (int id, char *buf, size_t len)
+  {
+    /*
+     *	Termios code which handles outgoing data. The data is copied to
+     *	the transmit ring, and the transmitter is started if it was idle.
+     *
+     *	If the ring is full, we sleep until the interrupt handler has made
+     *	room. When called with interrupts disabled (for example local echo
+     *	from the interrupt handler) we can't sleep, and the UART is polled
+     *	instead.
+     */
+
+    struct pccom_port *p;
+    int oldints;
+    size_t room, n;
+
+    if (!buf || id >= PCCOM_MAXPORTS || id < 0 || !pccom_port[id])
+      return EINVAL;
+
+    p = pccom_port[id];
+
+    oldints = interrupts (DISABLE);
+    interrupts (oldints);
+
+    if (oldints == ENABLE)
+      lock (&pccom_lock[id], "pccom_write", LOCK_BLOCKING | LOCK_RW);
+
+    while (len > 0)
       {
-	p = portptr[i];
-	intr = 4 - (i&1);	/*  4, 3, 4, 3  */
+	room = PCCOM_TXBUFSIZE - 1 - PCCOM_RING_LEN(p->txhead, p->txtail,
+	    PCCOM_TXBUFSIZE);
 
-	if (p)
+	if (room == 0)
 	  {
-	    pccom_m[i] = module_register ("isa0", MODULETYPE_NUMBERED,
-		"pccom", "PC serial (COM) port");
-	    if (!pccom_m[i])
-	      {
-		printk ("pccom: out of memory?");
-		continue;
-	      }
-
-	    res = ports_register (p, 8, pccom_m[i]->shortname);
-	    if (!res)
-	      {
-		module_unregister (pccom_m[i]);
-		continue;
-	      }
+	    interrupts (DISABLE);
+	    if (!p->txbusy)
+		pccom_txfill (p);
 
-	    if (i==0)
+	    if (oldints == ENABLE)
 	      {
-		if (!irq_register (intr, (void *)&pccom_irq4handler,
-			pccom_m[i]->shortname))
+		if (PCCOM_RING_LEN(p->txhead, p->txtail, PCCOM_TXBUFSIZE)
+		    == PCCOM_TXBUFSIZE - 1)
 		  {
-		    printk ("%s: irq %i already in use",
-			pccom_m[i]->shortname, intr);
-		    module_unregister (pccom_m[i]);
+		    p->txsleep ++;
+		    sleep (&p->txsleep, "pccom_write");
+		    p->txsleep --;
 		  }
+		interrupts (ENABLE);
 	      }
+	    else
+		pccom_txfill (p);
+
+	    continue;
+	  }
+
+	/*
+	 *  Copy as much as fits without wrapping around the end. Local
+	 *  echo from the interrupt handler also adds to the ring, so
+	 *  interrupts are disabled while txhead is being updated.
+	 */
+
+	interrupts (DISABLE);
+
+	room = PCCOM_TXBUFSIZE - 1 - PCCOM_RING_LEN(p->txhead, p->txtail,
+	    PCCOM_TXBUFSIZE);
+	n = PCCOM_TXBUFSIZE - p->txhead;
+	if (n > room)
+	  n = room;
+	if (n > len)
+	  n = len;
+
+	memcpy (p->txbuf + p->txhead, buf, n);
+	p->txhead = (p->txhead + n) & (PCCOM_TXBUFSIZE - 1);
+	buf += n;
+	len -= n;
+
+	interrupts (oldints);
+      }
+
+    pccom_txstart (p);
+
+    if (oldints == ENABLE)
+      unlock (&pccom_lock[id]);
+
+    return 0;
+  }
+
+
 
-	    if (i==1)
+int pccom__get_port_nr (struct device *dev)
+  {
+    /*
+     *	Get the port number from dev->name ("tty00" .. "tty03").
+     *	Returns -1 on error.
+     */
+
+    int nr;
+
+    if (!dev)
+	return -1;
+
+    nr = dev->name[4] - '0';
+    if (nr<0 || nr>=PCCOM_MAXPORTS || !pccom_port[nr])
+	return -1;
+
+    return nr;
+  }
+
+
+
+int pccom_open (struct device *dev, struct proc *p)
+  {
+    int nr;
+
+    nr = pccom__get_port_nr (dev);
+    if (nr<0)
+	return ENXIO;
+
+    dev->refcount++;
+    return 0;
+  }
+
+
+
+int pccom_close (struct device *dev, struct proc *p)
+  {
+    int nr;
+
+    nr = pccom__get_port_nr (dev);
+    if (nr<0)
+	return ENXIO;
+
+    if (dev->refcount == 0)
+	panic ("pccom_close: tty0%i refcount already 0!", nr);
+
+    dev->refcount--;
+    return 0;
+  }
+
+
+
+int pccom_read (off_t *res, struct device *dev, byte *buf, off_t buflen, struct proc *p)
+  {
+    int nr;
+
+    nr = pccom__get_port_nr (dev);
+    if (nr<0 || !res || !buf)
+	return ENXIO;
+
+    *res = terminal_read (pccom_port[nr]->ts, (char *)buf, buflen);
+    return 0;
+  }
+
+
+
+int pccom_write (off_t *res, struct device *dev, byte *buf, off_t buflen, struct proc *p)
+  {
+    size_t len;
+    size_t origlen = buflen;
+    int nr;
+
+    nr = pccom__get_port_nr (dev);
+    if (nr<0 || !res || !buf)
+	return ENXIO;
+
+    while (buflen > 0)
+      {
+	len = terminal_write (pccom_port[nr]->ts, (char *)buf, buflen);
+	if (len < 1)
+	  buflen = 0;
+	else
+	  {
+	    buflen -= len;
+	    buf += len;
+	  }
+      }
+
+    *res = origlen;
+    return 0;
+  }
+
+
+
+int pccom_ioctl (struct device *dev, int *res, struct proc *p, unsigned long req, unsigned long arg1)
+  {
+    /*
+     *	pccom_ioctl ()
+     *	--------------
+     *
+     *	Same as pccon_ioctl(), except that TIOCSETA also sets the line
+     *	speed.  TODO:  argument checking...
+     */
+
+    byte *outaddr, *inaddr;
+    struct pccom_port *port;
+    int nr, err;
+
+    nr = pccom__get_port_nr (dev);
+    if (nr<0)
+	return ENXIO;
+
+    port = pccom_port[nr];
+    *res = 0;
+
+    /*  TIOCGETA:  */
+    if (req == 0x402c7413)
+      {
+	outaddr = (byte *)arg1 + userland_startaddr;
+	memcpy (outaddr, &port->ts->termio, sizeof(struct termios));
+	return 0;
+      }
+
+    /*  TIOCGPGRP:  */
+    if (req == 0x40047477)
+      {
+	outaddr = (byte *)arg1 + userland_startaddr;
+	memcpy (outaddr, &port->ts->pgrp, sizeof(pid_t));
+	return 0;
+      }
+
+    /*  TIOCSPGRP:  */
+    if (req == 0x80047476)
+      {
+	inaddr = (byte *)arg1 + userland_startaddr;
+	memcpy (&port->ts->pgrp, inaddr, sizeof(pid_t));
+	return 0;
+      }
+
+    /*  TIOCSETA or TIOCSETAW:  */
+    if (req == 0x802c7414 || req == 0x802c7415)
+      {
+	inaddr = (byte *)arg1 + userland_startaddr;
+	memcpy (&port->ts->termio, inaddr, sizeof(struct termios));
+	if (port->ts->termio.c_ospeed != port->speed)
+	  {
+	    /*  Unsupported speed? Then keep the old one:  */
+	    err = pccom_setspeed (port, port->ts->termio.c_ospeed);
+	    port->ts->termio.c_ispeed = port->ts->termio.c_ospeed = port->speed;
+	    return err;
+	  }
+	return 0;
+      }
+
+    printk ("pccom_ioctl: unimplemented req=%x arg=%x", (int)req, (int)arg1);
+    return 0;
+  }
+
+
+
+#ifdef PCCOM_CONSOLE
+
+void pccom_consputs (char *s, int color)
+  {
+    /*
+     *	Output a kernel message on the console port (polled), and then
+     *	on the previous console as well.
+     */
+
+    struct pccom_port *p = pccom_port [PCCOM_CONSOLE];
+    int oldints, i, n, timeout;
+    char *str;
+
+    if (p)
+      {
+	oldints = interrupts (DISABLE);
+
+	for (i=0; i<2; i++)
+	  {
+	    str = i? "\r\n" : s;
+
+	    while (*str)
 	      {
-		if (!irq_register (intr, (void *)&pccom_irq3handler,
-			pccom_m[i]->shortname))
-		  {
-		    printk ("%s: irq %i already in use",
-			pccom_m[i]->shortname, intr);
-		    module_unregister (pccom_m[i]);
-		  }
+		timeout = 100000;
+		while (!(inb (p->baseport + PCCOM_LSR) & PCCOM_LSR_THRE)
+		    && timeout > 0)
+		  timeout --;
+
+		for (n=0; n<p->fifosize && *str; n++)
+		  outb (p->baseport + PCCOM_DATA, *str++);
 	      }
+	  }
+
+	/*  A THRE interrupt will arrive when this has been sent:  */
+	p->txbusy = 1;
+
+	interrupts (oldints);
+      }
+
+    if (pccom_oldconsputs)
+	pccom_oldconsputs (s, color);
+  }
+
+#endif
+
+
+
+void pccom_init (int arg)
+  {
+    char buf[100];
+    int i, res, baseport;
+    char tmp_name[20];
+    u_int16_t *portptr = (u_int16_t *) PCCOM_BIOSPORTS;
+    struct pccom_port *p;
 
 
-/*  TODO:  Detect UART type etc.  */
+    memset (pccom_port, 0, sizeof(pccom_port));
+    memset (pccom_lock, 0, sizeof(pccom_lock));
 
 
-	    isa_module_nametobuf (pccom_m[i], buf, sizeof(buf));
-	    printk ("%s", buf);
+    /*
+     *	Register ports as found by BIOS:   (i386 specific)
+     */
+
+    for (i=0; i<PCCOM_MAXPORTS; i++)
+      {
+	baseport = portptr[i];
+	if (!baseport)
+	  break;
+
+	p = (struct pccom_port *) malloc (sizeof(struct pccom_port));
+	if (!p)
+	  {
+	    printk ("pccom: out of memory");
+	    break;
+	  }
+
+	memset (p, 0, sizeof(struct pccom_port));
+	p->baseport = baseport;
+	p->irq = 4 - (i&1);	/*  4, 3, 4, 3  */
+
+	p->m = module_register ("isa0", MODULETYPE_NUMBERED,
+		"pccom", "PC serial (COM) port");
+	if (!p->m)
+	  {
+	    printk ("pccom: out of memory?");
+	    free (p);
+	    continue;
+	  }
+
+	res = ports_register (baseport, 8, p->m->shortname);
+	if (!res || !pccom_probeuart (p))
+	  {
+	    if (res)
+	      ports_unregister (baseport);
+	    module_unregister (p->m);
+	    free (p);
+	    continue;
 	  }
+
+	/*  COM3 and COM4 share the irq with COM1 and COM2:  */
+	if (i < 2)
+	  if (!irq_register (p->irq, p->irq==4? (void *)&pccom_irq4handler :
+		(void *)&pccom_irq3handler, p->m->shortname))
+	    {
+		printk ("%s: irq %i already in use", p->m->shortname, p->irq);
+		ports_unregister (baseport);
+		module_unregister (p->m);
+		free (p);
+		continue;
+	    }
+
+	p->ts = terminal_open ();
+	if (!p->ts)
+	  {
+	    printk ("%s: out of memory", p->m->shortname);
+	    if (i < 2)
+		irq_unregister (p->irq);
+	    ports_unregister (baseport);
+	    module_unregister (p->m);
+	    free (p);
+	    continue;
+	  }
+
+	p->ts->id		= i;
+	p->ts->write		= pccom_termwrite;
+	p->ts->read		= pccom_termread;
+	p->ts->termio.c_oflag	= OPOST | ONLCR;
+	p->ts->termio.c_iflag	= ICRNL;
+	p->ts->termio.c_lflag	= ECHO | ECHOE | ICANON;
+	p->ts->termio.c_cflag	= CS8 | CREAD | CLOCAL;
+
+#ifdef PCCOM_CONSOLE
+	if (i == PCCOM_CONSOLE)
+	  pccom_setspeed (p, PCCOM_CONSOLE_SPEED);
 	else
-	  break;
+#endif
+	  pccom_setspeed (p, PCCOM_DEFAULT_SPEED);
+
+	p->ts->termio.c_ispeed = p->ts->termio.c_ospeed = p->speed;
+
+	/*  Enable interrupts. (OUT2 connects the UART to the irq line.)  */
+	outb (baseport + PCCOM_MCR, PCCOM_MCR_DTR | PCCOM_MCR_RTS |
+	    PCCOM_MCR_OUT2);
+	outb (baseport + PCCOM_IER, PCCOM_IER_RDA | PCCOM_IER_THRE |
+	    PCCOM_IER_RLS);
+
+	/*  Clear any pending conditions:  */
+	inb (baseport + PCCOM_LSR);
+	inb (baseport + PCCOM_DATA);
+	inb (baseport + PCCOM_IIR);
+	inb (baseport + PCCOM_MSR);
+
+	pccom_port[i] = p;
+
+	/*  Register the device:  (tty00 .. tty03)  */
+	snprintf (tmp_name, 20, "tty0%i", i);
+	p->dev = device_alloc (tmp_name, p->m->shortname, DEVICETYPE_CHAR,
+		0600, 0, 0, 0);
+	if (!p->dev)
+	  printk ("%s: warning: could not allocate device struct",
+		p->m->shortname);
+	else
+	  {
+	    p->dev->open  = pccom_open;
+	    p->dev->close = pccom_close;
+	    p->dev->read  = pccom_read;
+	    p->dev->write = pccom_write;
+	    p->dev->ioctl = pccom_ioctl;
+
+	    if ((res = device_register (p->dev)))
+	      {
+		printk ("%s: device_register() = %i (error)",
+		    p->m->shortname, res);
+		device_free (p->dev);
+		p->dev = NULL;
+	      }
+	  }
+
+	isa_module_nametobuf (p->m, buf, sizeof(buf));
+	snprintf (buf+strlen(buf), sizeof(buf)-strlen(buf), ": %s",
+	    pccom_uartname[p->uarttype]);
+	if (p->fifosize > 1)
+	  snprintf (buf+strlen(buf), sizeof(buf)-strlen(buf), ", %i byte fifo",
+	      p->fifosize);
+	snprintf (buf+strlen(buf), sizeof(buf)-strlen(buf), ", %i bps",
+	    p->speed);
+	printk ("%s", buf);
+
+#ifdef PCCOM_CONSOLE
+	if (i == PCCOM_CONSOLE)
+	  {
+	    pccom_oldconsputs = console_puts;
+	    console_puts = pccom_consputs;
+	  }
+#endif
       }
   }
 
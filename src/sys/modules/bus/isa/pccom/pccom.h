@@ -0,0 +1,158 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  modules/bus/isa/pccom/pccom.h  --  PC serial port driver
+ */
+
+
+#include "../../../../config.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/std.h>
+#include <sys/module.h>
+#include <sys/interrupts.h>
+#include <sys/arch/i386/pio.h>
+#include <sys/terminal.h>
+
+
+#define	PCCOM_BIOSPORTS		0x00000400
+#define	PCCOM_MAXPORTS		4
+
+
+/*
+ *  8250/16450/16550 UART registers (offsets from the base port):
+ */
+
+#define	PCCOM_DATA		0	/*  RBR (read), THR (write)  */
+#define	PCCOM_IER		1	/*  Interrupt enable  */
+#define	PCCOM_IIR		2	/*  Interrupt identification (read)  */
+#define	PCCOM_FCR		2	/*  FIFO control (write)  */
+#define	PCCOM_LCR		3	/*  Line control  */
+#define	PCCOM_MCR		4	/*  Modem control  */
+#define	PCCOM_LSR		5	/*  Line status  */
+#define	PCCOM_MSR		6	/*  Modem status  */
+#define	PCCOM_SCR		7	/*  Scratch  */
+#define	PCCOM_DLL		0	/*  Divisor latch low (when DLAB=1)  */
+#define	PCCOM_DLM		1	/*  Divisor latch high (when DLAB=1)  */
+
+#define	PCCOM_IER_RDA		0x01	/*  Received data available  */
+#define	PCCOM_IER_THRE		0x02	/*  Transmitter holding register empty  */
+#define	PCCOM_IER_RLS		0x04	/*  Receiver line status  */
+#define	PCCOM_IER_MS		0x08	/*  Modem status  */
+
+#define	PCCOM_IIR_NOPEND	0x01	/*  No interrupt pending  */
+#define	PCCOM_IIR_MASK		0x0e
+#define	PCCOM_IIR_MS		0x00
+#define	PCCOM_IIR_THRE		0x02
+#define	PCCOM_IIR_RDA		0x04
+#define	PCCOM_IIR_RLS		0x06
+#define	PCCOM_IIR_TIMEOUT	0x0c
+#define	PCCOM_IIR_FIFOMASK	0xc0
+
+#define	PCCOM_FCR_ENABLE	0x01
+#define	PCCOM_FCR_RXRESET	0x02
+#define	PCCOM_FCR_TXRESET	0x04
+#define	PCCOM_FCR_TRIGGER_1	0x00
+#define	PCCOM_FCR_TRIGGER_4	0x40
+#define	PCCOM_FCR_TRIGGER_8	0x80
+#define	PCCOM_FCR_TRIGGER_14	0xc0
+
+#define	PCCOM_LCR_8N1		0x03
+#define	PCCOM_LCR_DLAB		0x80
+
+#define	PCCOM_MCR_DTR		0x01
+#define	PCCOM_MCR_RTS		0x02
+#define	PCCOM_MCR_OUT2		0x08	/*  Gates the IRQ line on PCs  */
+
+#define	PCCOM_LSR_DR		0x01	/*  Data ready  */
+#define	PCCOM_LSR_OE		0x02	/*  Overrun error  */
+#define	PCCOM_LSR_THRE		0x20	/*  Transmitter holding register empty  */
+
+#define	PCCOM_FREQ		115200	/*  1.8432 MHz / 16  */
+#define	PCCOM_DEFAULT_SPEED	115200
+
+
+/*  UART types:  */
+#define	PCCOM_UART_8250		0
+#define	PCCOM_UART_16450	1
+#define	PCCOM_UART_16550	2	/*  broken FIFO  */
+#define	PCCOM_UART_16550A	3
+
+
+/*
+ *  Ring buffers:
+ *
+ *  Each ring has exactly one producer and one consumer. The producer only
+ *  modifies head and the consumer only modifies tail, so no locking is
+ *  needed between the interrupt handler and the rest of the driver. The
+ *  sizes must be powers of two.
+ */
+
+#define	PCCOM_RXBUFSIZE		1024
+#define	PCCOM_TXBUFSIZE		2048
+
+#define	PCCOM_RING_LEN(head,tail,size)	(((head) - (tail)) & ((size) - 1))
+
+
+struct pccom_port
+      {
+	int		baseport;
+	int		irq;
+	int		uarttype;
+	int		fifosize;	/*  nr of bytes the tx FIFO holds  */
+	int		speed;
+
+	struct module	*m;
+	struct device	*dev;
+	struct termstate *ts;
+
+	/*  Receive ring:  filled by the irq handler  */
+	volatile size_t	rxhead, rxtail;
+	char		rxbuf [PCCOM_RXBUFSIZE];
+
+	/*  Transmit ring:  emptied by the irq handler  */
+	volatile size_t	txhead, txtail;
+	char		txbuf [PCCOM_TXBUFSIZE];
+	volatile int	txbusy;		/*  THRE interrupt expected  */
+	int		txsleep;	/*  writers waiting for room  */
+
+	/*  Statistics:  */
+	volatile int	overruns;
+	volatile int	rxdropped;
+      };
+
+
+/*
+ *  pccom_  functions
+ */
+
+void pccom_irq4handler ();
+void pccom_irq3handler ();
+int pccom_setspeed (struct pccom_port *p, int speed);
+int pccom_termwrite (int id, char *buf, size_t len);
+int pccom_termread ();
+void pccom_consputs (char *s, int color);
+
@@ -169,11 +169,12 @@ int pccon_termwrite (int id, char *buf, size_t len)
      *	local echo was enabled).  This funcion should only be called by
      *	the termios subsystem.
      *
-     *	TODO: This is slow, the pccon_printchar() stuff should probably
-     *	be inlined in some way...
+     *	Runs of printable characters are output using pccon_printrun(),
+     *	everything else goes through pccon_printchar().
      */
 
     int oldints;
+    size_t n;
 
     if (!buf || id >= MAX_NR_OF_VCS || id < 0)
       return EINVAL;
@@ -185,7 +186,15 @@ int pccon_termwrite (int id, char *buf, size_t len)
       lock (&pccon_vc[id]->lock, "pccon_write", LOCK_BLOCKING | LOCK_RW);
 
     while (len > 0)
-      pccon_printchar (id, buf[0]), buf++, len--;
+      {
+	for (n=0; n<len && PCCON_PRINTABLE(buf[n]); n++)
+	  ;
+
+	if (n > 0)
+	  pccon_printrun (id, buf, n), buf += n, len -= n;
+	else
+	  pccon_printchar (id, buf[0]), buf++, len--;
+      }
 
     if (oldints == ENABLE)
       unlock (&pccon_vc[id]->lock);
@@ -562,6 +571,7 @@ void pccon_init (int arg)
 
     pccon_current_vc = 0;
     pccon_vc [0] = pccon_vc_init (25, 80, 0);
+    pccon_sethwstart (0);
     pccon_gethwcursorpos (&pccon_vc[0]->cursor_row,
 	&pccon_vc[0]->cursor_column);
 
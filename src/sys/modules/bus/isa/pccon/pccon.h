@@ -62,6 +62,25 @@
 #define	KEYBOARD_BUFFER_LEN	512
 
 
+/*
+ *  Size of text mode video memory. On color adapters, the rows below the
+ *  visible screen are used for hardware scrolling.
+ */
+
+#define	PCCON_COLOR_VIDEOLEN	32768
+#define	PCCON_MONO_VIDEOLEN	4096
+
+
+/*
+ *  Characters which pccon_printchar() doesn't treat specially, and which
+ *  can therefore be output using pccon_printrun():
+ */
+
+#define	PCCON_PRINTABLE(c)	((c) != '\0' && (c) != '\a' && (c) != '\b' && \
+				 (c) != '\f' && (c) != '\r' && (c) != '\n' && \
+				 (c) != '\t')
+
+
 /*
  *  A textmode character cell consists of character
  *  code and color code:
@@ -157,10 +176,13 @@ void pccon_keymapinit ();
 
 void pccon_gethwcursorpos (int *row, int *col);
 void pccon_sethwcursorpos (int row, int col);
+void pccon_sethwstart (int origin);
+struct charcell *pccon_screenbase (int vc_nr);
 int pccon_nextvc (int oldvc, int direction);
 void pccon_switch_vc (int newvc);
 void pccon_clearscreen (int vc_nr);
 void pccon_checkscroll (int vc_nr);
 void pccon_printchar (int vc_nr, char ch);
+void pccon_printrun (int vc_nr, char *buf, int len);
 void pccon_slowputs (char *s, int color);
 
@@ -29,6 +29,8 @@
  *  History:
  *	14 Jan 2000	first version
  *	13 Jun 2000	fixed TAB -> space...
+ *	19 Oct 2026	hardware scrolling using the CRTC start address,
+ *			batched output of printable runs
  */
 
 
@@ -64,6 +66,17 @@ struct lockstruct pccon_crtclock;
 int		pccon_crtcbase = 0x3d0;
 size_t		pccon_videoaddr = 0xb8000;
 
+/*
+ *  Hardware scrolling:  The visible screen of the current vc starts at row
+ *  pccon_origin of video memory, and the CRTC start address register is
+ *  moved one row down on every scroll instead of copying the screen
+ *  contents. Only when the screen reaches the end of video memory
+ *  (pccon_videolen bytes) is it copied back to row 0.
+ */
+
+int		pccon_origin = 0;
+size_t		pccon_videolen = PCCON_COLOR_VIDEOLEN;
+
 
 
 void pccon_detect_color ()
@@ -84,12 +97,14 @@ void pccon_detect_color ()
       {
 	pccon_crtcbase = 0x3b0;
 	pccon_videoaddr = 0xb0000;
+	pccon_videolen = PCCON_MONO_VIDEOLEN;
 	tot = 12;
       }
     else
       {
 	pccon_crtcbase = 0x3d0;
 	pccon_videoaddr = 0xb8000;
+	pccon_videolen = PCCON_COLOR_VIDEOLEN;
 	tot = 16;
       }
 
@@ -114,6 +129,8 @@ void pccon_gethwcursorpos (int *row, int *col)
     outb (pccon_crtcbase + 4, 0xf);
     p = p*256 + inb (pccon_crtcbase + 5);
 
+    p -= pccon_origin * pccon_vc[pccon_current_vc]->ncols;
+
     *row = p / pccon_vc[pccon_current_vc]->ncols;
     *col = p % pccon_vc[pccon_current_vc]->ncols;
   }
@@ -128,7 +145,7 @@ void pccon_sethwcursorpos (int row, int col)
 
     int p;
 
-    p = row * pccon_vc[pccon_current_vc]->ncols + col;
+    p = (pccon_origin + row) * pccon_vc[pccon_current_vc]->ncols + col;
     outb (pccon_crtcbase + 4, 0xe);
     outb (pccon_crtcbase + 5, p / 256);
     outb (pccon_crtcbase + 4, 0xf);
@@ -137,6 +154,45 @@ void pccon_sethwcursorpos (int row, int col)
 
 
 
+void pccon_sethwstart (int origin)
+  {
+    /*
+     *	Set the origin (the row in video memory which is displayed at the
+     *	top of the screen) of the current vc, by changing the CRTC start
+     *	address registers.
+     */
+
+    int p;
+
+    pccon_origin = origin;
+
+    p = origin * pccon_vc[pccon_current_vc]->ncols;
+    outb (pccon_crtcbase + 4, 0xc);
+    outb (pccon_crtcbase + 5, p / 256);
+    outb (pccon_crtcbase + 4, 0xd);
+    outb (pccon_crtcbase + 5, p & 255);
+  }
+
+
+
+struct charcell *pccon_screenbase (int vc_nr)
+  {
+    /*
+     *	Return a pointer to the first character cell of a vc's screen.
+     *	For the current vc this is the (hardware scrolled) video memory,
+     *	for all other vcs it is the "cells" buffer.
+     */
+
+    struct pccon_vc *p = pccon_vc [vc_nr];
+
+    if (vc_nr != pccon_current_vc)
+	return p->cells;
+
+    return (struct charcell *) pccon_videoaddr + pccon_origin * p->ncols;
+  }
+
+
+
 int pccon_nextvc (int oldvc, int direction)
   {
     /*
@@ -189,7 +245,7 @@ void pccon_switch_vc (int newvc)
 
     /*  Copy video memory to the "cells" of the old vc:  */
     videolen = sizeof(struct charcell) * p->nrows * p->ncols;
-    memcpy (p->cells, (void *)pccon_videoaddr, videolen);
+    memcpy (p->cells, pccon_screenbase (pccon_current_vc), videolen);
 
     /*  Change video mode to what the new vc uses:  */
     p = pccon_vc [newvc];
@@ -202,6 +258,7 @@ void pccon_switch_vc (int newvc)
 
     pccon_current_vc = newvc;
 
+    pccon_sethwstart (0);
     pccon_sethwcursorpos (p->cursor_row, p->cursor_column);
 
     /*  Update keyboard leds:  */
@@ -225,10 +282,10 @@ void pccon_clearscreen (int vc_nr)
     struct pccon_vc *p = pccon_vc [vc_nr];
     struct charcell *cc;
 
-    if (vc_nr != pccon_current_vc)
-      cc = p->cells;
-    else
-      cc = (struct charcell *) pccon_videoaddr;
+    if (vc_nr == pccon_current_vc)
+	pccon_sethwstart (0);
+
+    cc = pccon_screenbase (vc_nr);
 
     for (i = p->ncols*p->nrows - 1; i>=0; i--)
       {
@@ -245,19 +302,25 @@ void pccon_clearscreen (int vc_nr)
 
 
 
-void pccon_checkscroll (vc_nr)
+void pccon_checkscroll (int vc_nr)
   {
     /*
      *	Check if the cursor is beyond the end of the last line
      *	and in that case scroll up.
      *
+     *	The current vc is scrolled by moving the CRTC start address one row
+     *	down in video memory. The screen contents is only copied when
+     *	there is no room left below the screen; it is then moved back to
+     *	the beginning of video memory. Other vcs are scrolled in their
+     *	"cells" buffer.
+     *
      *	TODO:  locking instead of disabled interrupts?
      */
 
     struct pccon_vc *p = pccon_vc [vc_nr];
     struct charcell *cc;
     int oldints;
-    int i, base;
+    int i, base, rowlen;
 
     oldints = interrupts (DISABLE);
 
@@ -269,13 +332,27 @@ void pccon_checkscroll (vc_nr)
 
     p->cursor_row = p->nrows - 1;
 
-    if (vc_nr != pccon_current_vc)
-      cc = p->cells;
-    else
-      cc = (struct charcell *) pccon_videoaddr;
+    rowlen = sizeof(struct charcell) * p->ncols;
+    cc = pccon_screenbase (vc_nr);
 
-    memcpy ((void *)cc, (void *)cc + sizeof(struct charcell)*p->ncols,
-	sizeof(struct charcell)*p->ncols*(p->nrows-1));
+    if (vc_nr == pccon_current_vc &&
+	(pccon_origin + p->nrows + 1) * rowlen <= pccon_videolen)
+      {
+	/*  Scroll in hardware:  */
+	cc += p->ncols;
+      }
+    else
+      {
+	/*  Copy all but the first line to the beginning of the buffer:  */
+	if (vc_nr == pccon_current_vc)
+	  {
+	    memcpy ((void *)pccon_videoaddr, (void *)cc + rowlen,
+		rowlen * (p->nrows-1));
+	    cc = (struct charcell *) pccon_videoaddr;
+	  }
+	else
+	  memcpy ((void *)cc, (void *)cc + rowlen, rowlen * (p->nrows-1));
+      }
 
     /*  base = base offset to the last line  */
     base = p->ncols*(p->nrows-1);
@@ -286,6 +363,14 @@ void pccon_checkscroll (vc_nr)
 	cc[i+base].color = p->current_color;
       }
 
+    /*
+     *	The new last line is cleared before the start address is changed,
+     *	so that it is never displayed with old contents:
+     */
+
+    if (vc_nr == pccon_current_vc)
+	pccon_sethwstart (((size_t)cc - pccon_videoaddr) / rowlen);
+
     interrupts (oldints);
   }
 
@@ -376,11 +461,6 @@ void pccon_printchar (int vc_nr, char ch)
 
     ch = pccon_charconvert [(unsigned char)ch];
 
-    if (vc_nr != pccon_current_vc)
-      cc = p->cells;
-    else
-      cc = (struct charcell *) pccon_videoaddr;
-
     if (p->cursor_column >= p->ncols)
       {
 	p->cursor_column = 0;
@@ -388,6 +468,8 @@ void pccon_printchar (int vc_nr, char ch)
 	pccon_checkscroll (vc_nr);
       }
 
+    cc = pccon_screenbase (vc_nr);
+
     /*  Now we actually output the char:  */
     i = p->ncols * p->cursor_row + p->cursor_column;
     cc[i].ch = ch;
@@ -406,6 +488,68 @@ void pccon_printchar (int vc_nr, char ch)
 
 
 
+void pccon_printrun (int vc_nr, char *buf, int len)
+  {
+    /*
+     *	Print a run of characters on the virtual console
+     *	------------------------------------------------
+     *
+     *	This is a faster version of calling pccon_printchar() for each
+     *	character. All characters in buf must be "printable", that is,
+     *	none of the special characters handled by pccon_printchar().
+     *	Characters are written directly into the character cells one line
+     *	at a time, and the hardware cursor is only updated once per line.
+     */
+
+    struct pccon_vc *p = pccon_vc [vc_nr];
+    struct charcell *cc;
+    int oldints;
+    int i, n, color;
+
+    while (len > 0)
+      {
+	oldints = interrupts (DISABLE);
+
+	if (p->cursor_column >= p->ncols)
+	  {
+	    p->cursor_column = 0;
+	    p->cursor_row ++;
+	    pccon_checkscroll (vc_nr);
+	  }
+
+	/*  n = nr of chars which fit on the current line  */
+	n = p->ncols - p->cursor_column;
+	if (n > len)
+	  n = len;
+
+	cc = pccon_screenbase (vc_nr) + p->ncols * p->cursor_row
+	    + p->cursor_column;
+	color = p->current_color;
+
+	for (i=0; i<n; i++)
+	  {
+	    cc[i].ch = pccon_charconvert [(unsigned char)buf[i]];
+	    cc[i].color = color;
+	  }
+
+	p->cursor_column += n;
+	buf += n;
+	len -= n;
+
+	if (vc_nr == pccon_current_vc)
+	  {
+	    if (p->cursor_column == p->ncols)
+	      pccon_sethwcursorpos (p->cursor_row, p->cursor_column-1);
+	    else
+	      pccon_sethwcursorpos (p->cursor_row, p->cursor_column);
+	  }
+
+	interrupts (oldints);
+      }
+  }
+
+
+
 void pccon_slowputs (char *s, int color)
   {
     /*
@@ -416,16 +560,23 @@ void pccon_slowputs (char *s, int color)
      */
 
     int backupcolor = pccon_vc[0]->current_color;
-    int i=0;
-    char ch;
+    int n;
     int oldints;
 
     oldints = interrupts (DISABLE);
 
     pccon_vc[0]->current_color = color;
 
-    while ((ch = s[i++]))
-	pccon_printchar (0, ch);
+    while (*s)
+      {
+	for (n=0; s[n] && PCCON_PRINTABLE(s[n]); n++)
+	  ;
+
+	if (n > 0)
+	  pccon_printrun (0, s, n), s += n;
+	else
+	  pccon_printchar (0, *s++);
+      }
 
     pccon_printchar (0, '\r');
     pccon_printchar (0, '\n');
@@ -33,6 +33,7 @@
  *	27 Oct 2000	test
  *	2 Jan 2000	reading seems to work okay
  *	5 Jan 2000	simple partition support (PC slices + BSD partitions)
+ *	19 Oct 2026	writing (used for swap partitions)
  */
 
 
@@ -69,6 +70,7 @@
 
 /*  Commands (sent to the WDC_PORT_COMMAND port):  */
 #define	WDC_CMD_READ_WRETRY	0x20
+#define	WDC_CMD_WRITE_WRETRY	0x30
 #define	WDC_CMD_DRIVEID		0xEC
 
 
@@ -216,13 +218,9 @@ int wdc_close (struct device *dev)
 
 #include "wdc_read.c"
 
-#include "wdc_partitions.c"
-
+#include "wdc_write.c"
 
-int wdc_write (struct device *dev)
-  {
-    return ENODEV;
-  }
+#include "wdc_partitions.c"
 
 
 
@@ -24,6 +24,21 @@ int wdc_partition__read (struct device *dev, daddr_t blocknr,
 
 
 
+int wdc_partition__write (struct device *dev, daddr_t blocknr,
+	daddr_t nrofblocks, byte *buf, struct proc *p)
+  {
+    /*  Never write outside the partition:  */
+    if (blocknr + nrofblocks > ((struct wdc_partitiondev *) dev->dspec) -> size)
+      return EINVAL;
+
+    return wdc_write (
+	((struct wdc_partitiondev *) dev->dspec) -> rawdev,
+	blocknr + ((struct wdc_partitiondev *) dev->dspec) -> start_offset,
+	nrofblocks, buf, p);
+  }
+
+
+
 int wdc_register_partition (struct device *rawdev,
 	daddr_t start, daddr_t size, char partitionname)
   {
@@ -57,7 +72,7 @@ int wdc_register_partition (struct device *rawdev,
       {
 	dev->open    = wdc_partition__open;
 	dev->close   = wdc_partition__close;
-/*	dev->write   = wdc_partition__write; */
+	dev->write   = wdc_partition__write;
 	dev->read    = wdc_partition__read;
 /*	dev->seek    = wdc_partition__seek; */
 /*	dev->ioctl   = wdc_partition__ioctl; */
@@ -45,15 +45,21 @@ int wdc_read_sector (int drive, int controller, daddr_t blocknr,
     if (res)
       return EIO;
 
-    /*  Wait for BUSY to go away...  */
-    while ((inb (baseport + WDC_PORT_STATUS) & 0x80)==0x80)
-	;
+    /*  The drive asks for each sector separately:  */
+    while (nrofblocks-- > 0)
+      {
+	/*  Wait for BUSY to go away...  */
+	while ((inb (baseport + WDC_PORT_STATUS) & 0x80)==0x80)
+	    ;
+
+	/*  Wait for DRQ (data request bit) to become active...  */
+	while ((inb (baseport + WDC_PORT_STATUS) & 8)==0)
+	    ;
 
-    /*  Wait for DRQ (data request bit) to become active...  */
-    while ((inb (baseport + WDC_PORT_STATUS) & 8)==0)
-	;
+	insw (baseport, buf, 512/2);
+	buf += 512;
+      }
 
-    insw (baseport, buf, 512/2 * nrofblocks);
     return 0;
   }
 
@@ -76,10 +82,10 @@ int wdc_read (struct device *dev, daddr_t blocknr, daddr_t nrofblocks,
 		2,3 on controller 1.  */
     switch (dev->name[2])
       {
-	case 0:  drive=0, controller=0; break;
-	case 1:  drive=1, controller=0; break;
-	case 2:  drive=0, controller=1; break;
-	case 3:  drive=1, controller=1; break;
+	case '0':  drive=0, controller=0; break;
+	case '1':  drive=1, controller=0; break;
+	case '2':  drive=0, controller=1; break;
+	case '3':  drive=1, controller=1; break;
       }
 
     lock (&wdc_lock, (void *) "wdc_read", LOCK_BLOCKING | LOCK_RW);
@@ -127,10 +133,10 @@ return 0;
 		2,3 on controller 1.  */
     switch (dev->name[2])
       {
-	case 0:  drive=0, controller=0; break;
-	case 1:  drive=1, controller=0; break;
-	case 2:  drive=0, controller=1; break;
-	case 3:  drive=1, controller=1; break;
+	case '0':  drive=0, controller=0; break;
+	case '1':  drive=1, controller=0; break;
+	case '2':  drive=0, controller=1; break;
+	case '3':  drive=1, controller=1; break;
       }
 
     /*  Get cyl, head, sector. Sector is 1-based!!!  */
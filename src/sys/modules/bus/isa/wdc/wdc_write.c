@@ -0,0 +1,69 @@
+int wdc_write_sector (int drive, int controller, daddr_t blocknr,
+	daddr_t nrofblocks, byte *buf)
+  {
+    int baseport, head, sector, cylinder, res;
+
+    baseport = wdc_controller[controller].iobase_lo;
+    wdc_whichsector (blocknr, drive, controller, &cylinder, &head, &sector);
+
+    res = wdc_sendcommand (baseport, drive, head,
+	cylinder, sector, nrofblocks, WDC_CMD_WRITE_WRETRY);
+
+    if (res)
+      return EIO;
+
+    /*  The drive asks for each sector separately:  */
+    while (nrofblocks-- > 0)
+      {
+	/*  Wait for BUSY to go away...  */
+	while ((inb (baseport + WDC_PORT_STATUS) & 0x80)==0x80)
+	    ;
+
+	/*  Wait for DRQ (data request bit) to become active...  */
+	while ((inb (baseport + WDC_PORT_STATUS) & 8)==0)
+	    ;
+
+	outsw (baseport, buf, 512/2);
+	buf += 512;
+      }
+
+    /*  Wait for the last sector to be written:  */
+    while ((inb (baseport + WDC_PORT_STATUS) & 0x80)==0x80)
+	;
+
+    /*  ERR bit set?  */
+    if (inb (baseport + WDC_PORT_STATUS) & 1)
+      return EIO;
+
+    return 0;
+  }
+
+
+
+int wdc_write (struct device *dev, daddr_t blocknr, daddr_t nrofblocks,
+              byte *buf, struct proc *p)
+  {
+    int drive=0, controller=0, res;
+
+    if (!dev || !buf)
+      return EINVAL;
+
+    /*  dev->name = "wdX" where X is 0,1 on controller 0, and
+		2,3 on controller 1.  */
+    switch (dev->name[2])
+      {
+	case '0':  drive=0, controller=0; break;
+	case '1':  drive=1, controller=0; break;
+	case '2':  drive=0, controller=1; break;
+	case '3':  drive=1, controller=1; break;
+      }
+
+    lock (&wdc_lock, (void *) "wdc_write", LOCK_BLOCKING | LOCK_RW);
+    res = wdc_write_sector (drive, controller, blocknr, nrofblocks, buf);
+    unlock (&wdc_lock);
+
+    if (res)
+      return EIO;
+
+    return 0;
+  }
@@ -29,6 +29,10 @@
  *  History:
  *	20 Jan 2000	test (nothing)
  *	18 Feb 2000	beginning
+ *	19 Oct 2026	the header is taken from the exec cache, if possible
+ *	19 Oct 2026	startproc sets up the register frame on the kernel
+ *			stack, instead of in a TSS
+ *	19 Oct 2026	number of argument words for each syscall
  */
 
 
@@ -110,11 +114,14 @@ int openbsd_aout_loadexec (struct proc *p, struct vm_object *vmobj)
     if (!p || !vmobj || !vmobj->vnode)
 	return EINVAL;
 
-    res = vmobj->vnode->read (vmobj->vnode, (off_t) 0, &header, (off_t) sizeof(header),
-	&actually_read);
+    if (exec_cache_header (vmobj->vnode, &header, sizeof(header)))
+      {
+	res = vmobj->vnode->read (vmobj->vnode, (off_t) 0, &header,
+	    (off_t) sizeof(header), &actually_read);
 
-    if (res || actually_read < sizeof(header))
-	return res;
+	if (res || actually_read < sizeof(header))
+	    return res;
+      }
 
 /*
 printk ("openbsd_aout_loadexec: header dump:");
@@ -188,7 +195,7 @@ printk ("  drsize = %x", header.drsize);
       }
     machdep_pagedir_init (p);
 
-    p->md.tss->cr3 = (u_int32_t) p->md.pagedir;
+    p->md.cr3 = (u_int32_t) p->md.pagedir;
 
     return 0;
   }
@@ -230,22 +237,13 @@ int openbsd_aout_setupstackandhwregisters (struct proc *p)
 byte *openbsd_aout__addstackpage (struct vm_object *stackobj, size_t page_nr)
   {
     byte *a_page;
-    struct mcb *a_mcb;
-    size_t i;
 
     a_page = (byte *) malloc (PAGESIZE);
     if (!a_page)
 	return NULL;
     memset (a_page, 0, PAGESIZE);
-    i = ((size_t)a_page - malloc_firstaddr) / PAGESIZE;
-    a_mcb = &first_mcb[i];
-
-    a_mcb->size = MCB_VMOBJECT_PAGE;
-    a_mcb->bitmap = 0;
-    a_mcb->page_nr = page_nr;
-    a_mcb->next = stackobj->page_chain_start;
 
-    stackobj->page_chain_start = i;
+    vm_object_addpage (stackobj, a_page, page_nr);
     return a_page;
   }
 
@@ -464,38 +462,28 @@ int openbsd_aout_startproc (struct proc *p)
   {
     /*
      *	Hardcoded jump to new process...
+     *
+     *	The "+3" in cs and ss are there to allow the process to run
+     *	at all. Flags need to have IF (Interrupts Enable) turned on.
      */
 
+    struct i386frame *frame;
+
     interrupts (DISABLE);
 
-    /*  Turn off busy bit of dummy process:  */
-    gdt [SEL_DUMMYTSS + 5] &= 0xf0;
-    gdt [SEL_DUMMYTSS + 5] |= 9;
-
-    i386_ltr (SEL_DUMMYTSS/8);
-
-    /*  Turn off busy bit of process p:  */
-    gdt [p->md.tss_nr*8 + 5] &= 0xf0;
-    gdt [p->md.tss_nr*8 + 5] |= 9;
-
-    p->md.tss->eax = 0;
-    p->md.tss->ebx = 0;
-    p->md.tss->ecx = 0;
-    p->md.tss->edx = 0;
-    p->md.tss->ebp = 0;
-    p->md.tss->esi = 0;
-    p->md.tss->edi = 0;
-    p->md.tss->eip = 0x1020;
-    p->md.tss->eflags = 0x00000202;
-    p->md.tss->cs = SEL_USERCODE + 3;
-    p->md.tss->ss = SEL_USERDATA + 3;
-    p->md.tss->ds = SEL_USERDATA;
-    p->md.tss->es = SEL_USERDATA;
-    p->md.tss->esp = (size_t) ((u_int64_t)0x100000000 -
+    frame = I386_FRAME(p);
+    memset (frame, 0, sizeof(struct i386frame));
+
+    frame->eip = 0x1020;
+    frame->eflags = 0x00000202;
+    frame->cs = SEL_USERCODE + 3;
+    frame->ss = SEL_USERDATA + 3;
+    frame->ds = SEL_USERDATA;
+    frame->es = SEL_USERDATA;
+    frame->esp = (size_t) ((u_int64_t)0x100000000 -
 	userland_startaddr) - p->md.size_of_argvenvp;
 
-    curproc = NULL;
-    machdep_pswitch (p);
+    i386_proc_start (p);
 
 printk ("openbsd_aout_startproc: not reached?");
     return 0;
@@ -509,6 +497,7 @@ printk ("openbsd_aout_startproc: not reached?");
 void openbsd_aout_init (int arg)
   {
     void **s;
+    u_int8_t *n;
 
     openbsd_aout_m = module_register ("emul", 0, "openbsd_aout", "OpenBSD a.out exec format");
 
@@ -533,7 +522,10 @@ void openbsd_aout_init (int arg)
     s = (void **) malloc (sizeof(void *)*NR_OF_SYSCALLS);
     memset (s, 0, sizeof(void *)*NR_OF_SYSCALLS);
     openbsd_aout_emul->syscall = s;
-    openbsd_aout_syscalls_init (s);
+    n = (u_int8_t *) malloc (sizeof(u_int8_t)*NR_OF_SYSCALLS);
+    memset (n, 0, sizeof(u_int8_t)*NR_OF_SYSCALLS);
+    openbsd_aout_emul->syscall_nargs = n;
+    openbsd_aout_syscalls_init (s, n);
 
     openbsd_aout_emul->active = 1;
   }
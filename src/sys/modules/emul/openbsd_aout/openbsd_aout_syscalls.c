@@ -352,6 +352,73 @@ int openbsd_aout__gettimeofday (ret_t *res, struct proc *p,
 
 
 
+int openbsd_aout__clock_gettime (ret_t *res, struct proc *p, int clock_id,
+	struct openbsd_aout__timespec *oa_tp)
+  {
+    struct timespec ts;
+    int retv;
+
+    if (!res || !p)
+	return EINVAL;
+
+    if (!p->sc_params_ok)
+      {
+	if (!vm_prot_accessible (p, oa_tp, sizeof(struct
+		openbsd_aout__timespec), VMREGION_WRITABLE))
+	    return EFAULT;
+
+	p->sc_params_ok = 1;
+      }
+
+    retv = sys_clock_gettime (res, p, clock_id, (struct timespec *)
+		((byte *)&ts - userland_startaddr));
+    if (retv)
+	return retv;
+
+    oa_tp = (struct openbsd_aout__timespec *)
+		((byte *)oa_tp + userland_startaddr);
+    oa_tp->tv_sec = ts.tv_sec;
+    oa_tp->tv_nsec = ts.tv_nsec;
+
+    return 0;
+  }
+
+
+
+int openbsd_aout__clock_getres (ret_t *res, struct proc *p, int clock_id,
+	struct openbsd_aout__timespec *oa_tp)
+  {
+    struct timespec ts;
+    int retv;
+
+    if (!res || !p)
+	return EINVAL;
+
+    if (!p->sc_params_ok)
+      {
+	if (oa_tp)
+	  if (!vm_prot_accessible (p, oa_tp, sizeof(struct
+		openbsd_aout__timespec), VMREGION_WRITABLE))
+	    return EFAULT;
+
+	p->sc_params_ok = 1;
+      }
+
+    retv = sys_clock_getres (res, p, clock_id, (struct timespec *)
+		((byte *)&ts - userland_startaddr));
+    if (retv || !oa_tp)
+	return retv;
+
+    oa_tp = (struct openbsd_aout__timespec *)
+		((byte *)oa_tp + userland_startaddr);
+    oa_tp->tv_sec = ts.tv_sec;
+    oa_tp->tv_nsec = ts.tv_nsec;
+
+    return 0;
+  }
+
+
+
 int openbsd_aout___syscall (s_int64_t *res, struct proc *p,
 	s_int64_t nr, int p1, int p2, int p3, int p4, int p5, int p6,
 	int p7, int p8, int p9, int p10, int p11, int p12)
@@ -448,7 +515,7 @@ int openbsd_aout__break (ret_t *res, struct proc *p, char *addr)
 
 
 
-void openbsd_aout_syscalls_init (void **s)
+void openbsd_aout_syscalls_init (void **s, u_int8_t *n)
   {
     /*
      *	OpenBSD a.out syscalls
@@ -458,75 +525,82 @@ void openbsd_aout_syscalls_init (void **s)
      *	cases, special conversion or tweaks are neccessary to translate
      *	between the internal Yoctix representation of structs and the way
      *	OpenBSD binaries expect things to be.
+     *
+     *	n[] holds the number of 32-bit words of arguments each syscall
+     *	takes (64-bit off_t arguments count as two words). syscall()
+     *	only copies that many words from the userland stack.
      */
 
-    s [  1] = sys_exit;
-    s [  2] = sys_fork;
-    s [  3] = sys_read;
-    s [  4] = sys_write;
-    s [  5] = sys_open;
-    s [  6] = sys_close;
-    s [  7] = sys_wait4;
+    s [  1] = sys_exit;			n [  1] = 1;
+    s [  2] = sys_fork;			n [  2] = 0;
+    s [  3] = sys_read;			n [  3] = 3;
+    s [  4] = sys_write;		n [  4] = 3;
+    s [  5] = sys_open;			n [  5] = 3;
+    s [  6] = sys_close;		n [  6] = 1;
+    s [  7] = sys_wait4;		n [  7] = 4;
     /*   8    sys_ocreat	(4.3BSD)  */
     /*   9    sys_link;  */
     /*  10    sys_unlink  */
     /*  11    sys_execv		(obsolete)  */
-    s [ 12] = sys_chdir;
-    s [ 13] = sys_fchdir;
+    s [ 12] = sys_chdir;		n [ 12] = 1;
+    s [ 13] = sys_fchdir;		n [ 13] = 1;
     /*  14    sys_mknod  */
     /*  15    sys_chmod  */
     /*  16    sys_chown  */
-    s [ 17] = openbsd_aout__break;
+    s [ 17] = openbsd_aout__break;	n [ 17] = 1;
     /*  18    sys_ogetfsstat  */
     /*  19    sys_olseek	(4.3BSD)  */
-    s [ 20] = sys_getpid;
-    s [ 21] = sys_mount;
+    s [ 20] = sys_getpid;		n [ 20] = 0;
+    s [ 21] = sys_mount;		n [ 21] = 4;
     /*  22    sys_umount  */
-    s [ 23] = sys_setuid;
-    s [ 24] = sys_getuid;
-    s [ 25] = sys_geteuid;
+    s [ 23] = sys_setuid;		n [ 23] = 1;
+    s [ 24] = sys_getuid;		n [ 24] = 0;
+    s [ 25] = sys_geteuid;		n [ 25] = 0;
 
-    s [ 33] = sys_access;
+    s [ 33] = sys_access;		n [ 33] = 2;
 
     /*  36    sys_sync  */
-    s [ 37] = sys_kill;
+    s [ 37] = sys_kill;			n [ 37] = 2;
 
-    s [ 39] = sys_getppid;
+    s [ 39] = sys_getppid;		n [ 39] = 0;
 
-    s [ 43] = sys_getegid;
+    s [ 43] = sys_getegid;		n [ 43] = 0;
 
-    s [ 46] = sys_sigaction;
-    s [ 47] = sys_getgid;
-    s [ 48] = openbsd_aout__sigprocmask;
+    s [ 46] = sys_sigaction;		n [ 46] = 3;
+    s [ 47] = sys_getgid;		n [ 47] = 0;
+    s [ 48] = openbsd_aout__sigprocmask;	n [ 48] = 2;
 
-    s [ 54] = sys_ioctl;
-    s [ 55] = sys_reboot;
+    s [ 54] = sys_ioctl;		n [ 54] = 3;
+    s [ 55] = sys_reboot;		n [ 55] = 1;
     /*  56    sys_revoke  */
     /*  57    sys_symlink  */
-    s [ 58] = sys_readlink;
-    s [ 59] = sys_execve;
-    s [ 60] = sys_umask;
-    s [ 61] = sys_chroot;
+    s [ 58] = sys_readlink;		n [ 58] = 3;
+    s [ 59] = sys_execve;		n [ 59] = 3;
+    s [ 60] = sys_umask;		n [ 60] = 1;
+    s [ 61] = sys_chroot;		n [ 61] = 1;
 
-    s [ 73] = sys_munmap;
-    s [ 74] = sys_mprotect;
-    /*  75    sys_madvice  */
+    s [ 65] = sys_msync;		n [ 65] = 3;
+    s [ 66] = sys_vfork;		n [ 66] = 0;
+
+    s [ 73] = sys_munmap;		n [ 73] = 2;
+    s [ 74] = sys_mprotect;		n [ 74] = 3;
+    s [ 75] = sys_madvise;		n [ 75] = 3;
 
     /*  78    sys_mincore  */
     /*  79    sys_getgroups  */
     /*  80    sys_setgroups  */
 
-    s [ 81] = sys_getpgrp;
-    s [ 82] = sys_setpgid;
+    s [ 81] = sys_getpgrp;		n [ 81] = 0;
+    s [ 82] = sys_setpgid;		n [ 82] = 2;
 
     /*  83    sys_setitimer  */
 
     /*  85    sys_swapon  */
     /*  86    sys_getitimer  */
 
-    s [ 90] = sys_dup2;
+    s [ 90] = sys_dup2;			n [ 90] = 2;
 
-    s [ 92] = sys_fcntl;
+    s [ 92] = sys_fcntl;		n [ 92] = 3;
     /*  93    sys_select  */
 
     /*  95    sys_fsync  */
@@ -536,17 +610,17 @@ void openbsd_aout_syscalls_init (void **s)
 
     /* 100    sys_getpriority  */
 
-    s [103] = sys_sigreturn;
+    s [103] = sys_sigreturn;		n [103] = 1;
     /* 104    sys_bind  */
     /* 105    sys_setsockopt  */
     /* 106    sys_listen  */
 
-    s [111] = sys_sigsuspend;
+    s [111] = sys_sigsuspend;		n [111] = 1;
 
-    s [116] = openbsd_aout__gettimeofday;
+    s [116] = openbsd_aout__gettimeofday;	n [116] = 2;
 
     /* 120    sys_readv  */
-    s [121] = sys_writev;
+    s [121] = sys_writev;		n [121] = 3;
     /* 122    sys_settimeofday  */
     /* 123    sys_fchown  */
     /* 124    sys_fchmod  */
@@ -556,26 +630,29 @@ void openbsd_aout_syscalls_init (void **s)
     /* 136    sys_mkdir  */
     /* 137    sys_rmdir  */
 
-    s [181] = sys_setgid;
-    s [182] = sys_setegid;
-    s [183] = sys_seteuid;
+    s [181] = sys_setgid;		n [181] = 1;
+    s [182] = sys_setegid;		n [182] = 1;
+    s [183] = sys_seteuid;		n [183] = 1;
+
+    s [188] = openbsd_aout__stat;	n [188] = 2;
+    s [189] = openbsd_aout__fstat;	n [189] = 2;
+    s [190] = openbsd_aout__stat;	n [190] = 2;		/*  TODO: actually implement lstat!!!  */
 
-    s [188] = openbsd_aout__stat;
-    s [189] = openbsd_aout__fstat;
-    s [190] = openbsd_aout__stat;		/*  TODO: actually implement lstat!!!  */
+    s [196] = sys_getdirentries;	n [196] = 4;
+    s [197] = openbsd_aout__mmap;	n [197] = 8;
+    s [198] = openbsd_aout___syscall;	n [198] = 10;
+    s [199] = openbsd_aout__lseek;	n [199] = 5;
 
-    s [196] = sys_getdirentries;
-    s [197] = openbsd_aout__mmap;
-    s [198] = openbsd_aout___syscall;
-    s [199] = openbsd_aout__lseek;
+    s [202] = openbsd_aout___sysctl;	n [202] = 6;
 
-    s [202] = openbsd_aout___sysctl;
+    s [232] = openbsd_aout__clock_gettime;	n [232] = 2;
+    s [234] = openbsd_aout__clock_getres;	n [234] = 2;
 
-    s [240] = openbsd_aout__nanosleep;
+    s [240] = openbsd_aout__nanosleep;	n [240] = 2;
 
-    s [253] = sys_issetugid;
+    s [253] = sys_issetugid;		n [253] = 0;
 
-    s [262] = sys_fstatfs;
-    s [263] = sys_pipe;
+    s [262] = sys_fstatfs;		n [262] = 2;
+    s [263] = sys_pipe;			n [263] = 1;
   }
 
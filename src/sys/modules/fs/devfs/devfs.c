@@ -27,14 +27,22 @@
  *  modules/fs/devfs/devfs.c  --  /dev filesystem driver
  *
  *	The /dev filesystem driver is a way of accessing the registered devices
- *	in the system (in the first_device chain) through standard vfs
- *	operations.
+ *	in the system (in the device registry, reg/device.c) through
+ *	standard vfs operations.
+ *
+ *	Names are looked up in the registry's name hash table. Directory
+ *	entries are 64 bytes each, and the entry at offset 64*(n-1) is the
+ *	device with device number n, so reading the directory doesn't need
+ *	to walk all devices to find the starting point. Free device numbers
+ *	give empty entries (d_fileno = 0), which readdir() skips.
  *
  *
  *  History:
  *	22 Mar 2000	test
  *	24 Nov 2000	adding get_direntries()
  *	5 Jan 2000	stat returns {a,m,c}time
+ *	19 Oct 2026	lookups and get_direntries() use the device
+ *			registry's hash tables
  */
 
 
@@ -53,7 +61,7 @@
 #include <sys/device.h>
 
 
-extern struct device *first_device;
+extern dev_t device_highnr;
 
 struct module *devfs_m;
 struct filesystem *devfs_fs;
@@ -87,7 +95,7 @@ int devfs_namestat (struct mountinstance *mi, inode_t dirinode, char *name, stru
      *	Returns 0 on success, errno on failure.
      */
 
-    struct device *d=NULL, *found = NULL;
+    struct device *d;
 
     if (dirinode != mi->superblock->root_inode)
 	return ENOENT;
@@ -108,20 +116,8 @@ int devfs_namestat (struct mountinstance *mi, inode_t dirinode, char *name, stru
 	return 0;
       }
 
-    /*  Find 'name' in the device chain:  */
-    d = first_device;
-    while (d)
-      {
-	if (!strcmp(d->name, name))
-	  {
-	    found = d;
-	    d = NULL;
-	  }
-	if (d)
-	  d = d->next;
-      }
-
-    d = found;
+    /*  Find 'name' in the device registry:  */
+    d = device_lookup (name);
     if (!d)
 	return ENOENT;
 
@@ -196,30 +192,33 @@ int devfs_get_direntries (struct proc *p, struct vnode *v,
      */
 
     struct device *d;
-    off_t fakeoffset = 0;
+    dev_t nr;
     u_int32_t *p32;
     u_int16_t *p16;
     int len;
 
     *offtres = 0;
 
-    if (buflen < 64)
+    if (buflen < 64 || (curofs & 63))
 	return 0;
 
-    d = first_device;
-    while (d)
+    for (nr = curofs / 64 + 1; nr <= device_highnr; nr++)
       {
-	if (curofs == fakeoffset)
-	  {
-	    /*  fill in one entry:  */
-	    memset (buf, 0, 64);
+	if (buflen - *offtres < 64)
+	    return 0;
 
+	/*  fill in one entry (or an empty one, if nr is free):  */
+	memset (buf, 0, 64);
+
+	p16 = (u_int16_t *)((byte *)(buf + 4));
+	*p16 = 64;
+
+	d = device_lookup_nr (nr);
+	if (d)
+	  {
 	    p32 = (u_int32_t *)((byte *)(buf));
 	    *p32 = (long) d;
 
-	    p16 = (u_int16_t *)((byte *)(buf + 4));
-	    *p16 = 64;
-
 	    len = strlen(d->name);
 	    if (len > 50)
 		len=50;
@@ -227,20 +226,12 @@ int devfs_get_direntries (struct proc *p, struct vnode *v,
 	    *p16 = len;
 
 	    strlcpy (buf+8, d->name, 50);
-
-	    buf += 64;
-
-	    curofs += 64;
-	    *offtres += 64;
-	    if (buflen - *offtres < 64)
-		return 0;
 	  }
 
-	/*  next:  */
-	fakeoffset += 64;
-	d = d->next;
+	buf += 64;
+	*offtres += 64;
       }
-    
+
     return 0;
   }
 
@@ -30,9 +30,29 @@
  *	about processes running on the system, without the need of parsing
  *	/dev/mem or such, through standard vfs operations.
  *
+ *	The root directory contains one directory per process (named by
+ *	pid), and a few files with system wide information. Each process
+ *	directory contains files with per-process information. The contents
+ *	of a file is generated (as text) every time the file is read.
+ *	Files with a control function are also writable (by root); the
+ *	written text is passed to the control function as a command.
+ *
+ *	Inode numbers:
+ *
+ *		1 .. PID_MAX		process directories
+ *		PID_MAX+1		the root directory
+ *		PID_MAX+2 ...		files in the root directory
+ *		(pid << 16) + n		file n in a process directory
+ *
  *
  *  History:
  *	25 Nov 2000	test
+ *	19 Oct 2026	files: /proc/vmstat and /proc/<pid>/maps
+ *	19 Oct 2026	/proc/lockstat, and writable control files
+ *	19 Oct 2026	/proc/syscallstat and /proc/<pid>/syscalls
+ *	19 Oct 2026	/proc/kprof, and per-file buffer sizes
+ *	19 Oct 2026	stream files, /proc/evtrace
+ *	19 Oct 2026	/proc/dmesg
  */
 
 
@@ -45,11 +65,19 @@
 #include <sys/stat.h>
 #include <sys/interrupts.h>
 #include <sys/errno.h>
+#include <sys/malloc.h>
 #include <sys/vfs.h>
+#include <sys/vm.h>
+#include <sys/emul.h>
 #include <sys/proc.h>
 #include <sys/vnode.h>
 #include <sys/module.h>
 #include <sys/device.h>
+#include <sys/lockstat.h>
+#include <sys/syscallstat.h>
+#include <sys/kprof.h>
+#include <sys/evtrace.h>
+#include <sys/msgbuf.h>
 
 
 struct module *procfs_m;
@@ -60,11 +88,428 @@ extern volatile struct timespec system_time;
 struct timespec procfs_ctime;
 
 
+#define	PROCFS_ROOT_INODE		(PID_MAX+1)
+#define	PROCFS_ROOTFILE_INODE(n)	((inode_t)PID_MAX+2+(n))
+#define	PROCFS_PIDFILE_SHIFT		16
+#define	PROCFS_PIDFILE_INODE(pid,n)	(((inode_t)(pid) << PROCFS_PIDFILE_SHIFT) + (n))
+
+/*  Default max size of a generated file. (Also returned as st_size.)  */
+#define	PROCFS_BUFSIZE			16384
+
+/*  Max length of a command written to a control file:  */
+#define	PROCFS_CMDLEN			64
+
+/*  st_size of stream files, so that sys_read() never stops reading:  */
+#define	PROCFS_STREAMSIZE		0x7fffffff
+
+
+/*
+ *  A procfs file: the generate function fills buf with at most buflen-1
+ *  chars of text, and returns the number of chars. p is the process
+ *  the file describes (NULL for files in the root directory). It is
+ *  called with interrupts disabled.
+ *
+ *  If control is not NULL, the file may be written to. control is called
+ *  with the written text (nul terminated, without trailing newline), and
+ *  returns 0 on success or an errno.
+ *
+ *  bufsize is the max size of the file, or 0 for PROCFS_BUFSIZE.
+ *
+ *  A file with the PROCFS_STREAM flag is not generated from scratch on
+ *  each read. Instead, generate removes data from some queue and returns
+ *  at most buflen bytes of it (not necessarily text). The read offset is
+ *  ignored, and a read returning 0 bytes means that the queue is empty
+ *  for now. bufsize limits the size of a single read.
+ */
+
+struct procfs_file
+      {
+	char		*name;
+	size_t		(*generate) (struct proc *p, char *buf, size_t buflen);
+	int		(*control) (struct proc *p, char *cmd);
+	size_t		bufsize;
+	int		flags;
+      };
+
+#define	PROCFS_STREAM		1
+
+#define	PROCFS_FILESIZE(pf)	((pf)->bufsize? (pf)->bufsize : PROCFS_BUFSIZE)
+
+size_t procfs_vmstat (struct proc *p, char *buf, size_t buflen);
+size_t procfs_dmesg (struct proc *p, char *buf, size_t buflen);
+size_t procfs_maps (struct proc *p, char *buf, size_t buflen);
+#ifdef LOCKSTAT
+size_t procfs_lockstat (struct proc *p, char *buf, size_t buflen);
+int procfs_lockstat_control (struct proc *p, char *cmd);
+#endif
+#ifdef SYSCALLSTAT
+size_t procfs_syscallstat (struct proc *p, char *buf, size_t buflen);
+int procfs_syscallstat_control (struct proc *p, char *cmd);
+#endif
+#ifdef SYSCALLSTAT_PERPROC
+size_t procfs_syscalls (struct proc *p, char *buf, size_t buflen);
+#endif
+#ifdef KPROF
+size_t procfs_kprof (struct proc *p, char *buf, size_t buflen);
+int procfs_kprof_control (struct proc *p, char *cmd);
+#endif
+#ifdef EVTRACE
+size_t procfs_evtrace (struct proc *p, char *buf, size_t buflen);
+int procfs_evtrace_control (struct proc *p, char *cmd);
+#endif
+
+struct procfs_file procfs_rootfiles [] =
+      {
+	{  "vmstat",	procfs_vmstat,		NULL  },
+	{  "dmesg",	procfs_dmesg,		NULL,	MSGBUF_SIZE+1  },
+#ifdef LOCKSTAT
+	{  "lockstat",	procfs_lockstat,	procfs_lockstat_control  },
+#endif
+#ifdef SYSCALLSTAT
+	{  "syscallstat", procfs_syscallstat,	procfs_syscallstat_control  },
+#endif
+#ifdef KPROF
+	{  "kprof",	procfs_kprof,		procfs_kprof_control,	65536  },
+#endif
+#ifdef EVTRACE
+	{  "evtrace",	procfs_evtrace,		procfs_evtrace_control,	32768,
+	   PROCFS_STREAM  },
+#endif
+	{  NULL,	NULL,			NULL  }
+      };
+
+struct procfs_file procfs_pidfiles [] =
+      {
+	{  "maps",	procfs_maps,		NULL  },
+#ifdef SYSCALLSTAT_PERPROC
+	{  "syscalls",	procfs_syscalls,	NULL  },
+#endif
+	{  NULL,	NULL,			NULL  }
+      };
+
+
+
+size_t procfs_vmstat (struct proc *p, char *buf, size_t buflen)
+  {
+    /*
+     *	Page fault counts and latency histograms (log2 of the number of
+     *	cycles), shadow chain statistics, zero page statistics, and
+     *	pageout and swap statistics.
+     */
+
+    size_t len = 0;
+    int kind, i;
+
+    for (kind=VM_FAULT_MINOR; kind<=VM_FAULT_MAJOR; kind++)
+      {
+	len += snprintf (buf+len, buflen-len, "%s_faults %i\n",
+	    kind==VM_FAULT_MINOR? "minor" : "major", vm_fault_count[kind]);
+
+	for (i=0; i<VM_FAULT_HISTBUCKETS && len<buflen-1; i++)
+	  if (vm_fault_hist[kind][i])
+	    len += snprintf (buf+len, buflen-len, "%s_hist %i %i\n",
+		kind==VM_FAULT_MINOR? "minor" : "major", i,
+		vm_fault_hist[kind][i]);
+      }
+
+    len += snprintf (buf+len, buflen-len, "shadow_collapses %i\n"
+	"shadow_bypasses %i\n", vm_object_collapses, vm_object_bypasses);
+
+    len += snprintf (buf+len, buflen-len, "zeropage_maps %i\n"
+	"zeropool_pages %i\nzeropool_hits %i\nzeropool_misses %i\n",
+	vm_zeropage_maps, vm_zeropool_count, vm_zeropool_hits,
+	vm_zeropool_misses);
+
+    len += snprintf (buf+len, buflen-len, "pageout_passes %i\n"
+	"pageout_reclaimed %i\nswap_used %i\nswap_total %i\n"
+	"swap_ins %i\nswap_outs %i\n", vm_pageout_passes,
+	vm_pageout_reclaimed, vm_swap_used, vm_swap_nslots,
+	vm_swap_ins, vm_swap_outs);
+
+    len += snprintf (buf+len, buflen-len, "writeback_pages %i\n"
+	"readahead_pages %i\n", vm_writeback_pages, vm_readahead_pages);
+
+    len += snprintf (buf+len, buflen-len, "exec_cache_hits %i\n"
+	"exec_cache_misses %i\n", exec_cache_hits, exec_cache_misses);
+
+    return len;
+  }
+
+
+
+#ifdef LOCKSTAT
+size_t procfs_lockstat (struct proc *p, char *buf, size_t buflen)
+  {
+    /*
+     *	Lock contention statistics, per lock name and per contended lock.
+     *	(See kern/lockstat.c.)
+     */
+
+    return lockstat_print (buf, buflen);
+  }
+
+
+
+int procfs_lockstat_control (struct proc *p, char *cmd)
+  {
+    /*  Writing "reset" clears the statistics:  */
+
+    if (strcmp ((unsigned char *) cmd, (unsigned char *) "reset"))
+	return EINVAL;
+
+    lockstat_reset ();
+    return 0;
+  }
+#endif
+
+
+
+#ifdef SYSCALLSTAT
+size_t procfs_syscallstat (struct proc *p, char *buf, size_t buflen)
+  {
+    /*
+     *	Syscall counts and latency histograms, per emulation and
+     *	syscall number.  (See kern/syscallstat.c.)
+     */
+
+    return syscallstat_print (buf, buflen);
+  }
+
+
+
+int procfs_syscallstat_control (struct proc *p, char *cmd)
+  {
+    /*  Writing "reset" clears the statistics:  */
+
+    if (strcmp ((unsigned char *) cmd, (unsigned char *) "reset"))
+	return EINVAL;
+
+    syscallstat_reset ();
+    return 0;
+  }
+#endif
+
+
+
+#ifdef SYSCALLSTAT_PERPROC
+size_t procfs_syscalls (struct proc *p, char *buf, size_t buflen)
+  {
+    /*  The process' syscall totals and calls per syscall number:  */
+
+    return syscallstat_procprint (p, buf, buflen);
+  }
+#endif
+
+
+
+size_t procfs_dmesg (struct proc *p, char *buf, size_t buflen)
+  {
+    /*  Recent kernel messages.  (See kern/msgbuf.c.)  */
+
+    return msgbuf_print (buf, buflen);
+  }
+
+
+
+#ifdef KPROF
+size_t procfs_kprof (struct proc *p, char *buf, size_t buflen)
+  {
+    /*  Kernel profile histogram.  (See kern/kprof.c.)  */
+
+    return kprof_print (buf, buflen);
+  }
+
+
+
+int procfs_kprof_control (struct proc *p, char *cmd)
+  {
+    /*  "start", "stop", "reset" or "pid N":  */
+
+    return kprof_control (cmd);
+  }
+#endif
+
+
+
+#ifdef EVTRACE
+size_t procfs_evtrace (struct proc *p, char *buf, size_t buflen)
+  {
+    /*  Binary event records, consumed as they are read.  (See
+	kern/evtrace.c.)  */
+
+    return evtrace_read (buf, buflen);
+  }
+
+
+
+int procfs_evtrace_control (struct proc *p, char *cmd)
+  {
+    /*  "start", "stop" or "reset":  */
+
+    return evtrace_control (cmd);
+  }
+#endif
+
+
+
+size_t procfs_maps (struct proc *p, char *buf, size_t buflen)
+  {
+    /*
+     *	One line per vm_region:  start and end address, protection
+     *	(r, w, x, c = copy-on-write), and the depth of the region's
+     *	chain of vm_objects.
+     */
+
+    struct vm_region *region;
+    struct vm_object *obj;
+    size_t len = 0;
+    int depth;
+    char prot [5];
+
+    region = p->vmregions;
+    while (region && len < buflen-1)
+      {
+	depth = 0;
+	for (obj=region->source; obj; obj=obj->next)
+	    depth ++;
+
+	prot[0] = (region->type & VMREGION_READABLE)? 'r' : '-';
+	prot[1] = (region->type & VMREGION_WRITABLE)? 'w' : '-';
+	prot[2] = (region->type & VMREGION_EXECUTABLE)? 'x' : '-';
+	prot[3] = (region->type & VMREGION_COW)? 'c' : '-';
+	prot[4] = '\0';
+
+	len += snprintf (buf+len, buflen-len, "%x-%x %s %i\n",
+	    region->start_addr, region->end_addr, prot, depth);
+
+	region = region->next;
+      }
+
+    return len;
+  }
+
+
+
+struct procfs_file *procfs__file (inode_t inode, pid_t *pid)
+  {
+    /*
+     *	Return the procfs_file for an inode number, or NULL if inode
+     *	is not a file. For files in process directories, *pid is set to
+     *	the pid, otherwise to 0.
+     */
+
+    inode_t n;
+
+    *pid = 0;
+
+    if (inode >= PROCFS_ROOTFILE_INODE(0) &&
+	inode < ((inode_t)1 << PROCFS_PIDFILE_SHIFT))
+      {
+	for (n=0; procfs_rootfiles[n].name; n++)
+	  if (inode == PROCFS_ROOTFILE_INODE(n))
+	    return &procfs_rootfiles[n];
+	return NULL;
+      }
+
+    if (inode >= ((inode_t)1 << PROCFS_PIDFILE_SHIFT))
+      {
+	*pid = (pid_t) (inode >> PROCFS_PIDFILE_SHIFT);
+	for (n=0; procfs_pidfiles[n].name; n++)
+	  if (inode == PROCFS_PIDFILE_INODE(*pid, n))
+	    return &procfs_pidfiles[n];
+      }
+
+    return NULL;
+  }
+
+
+
+int procfs__stat (struct mountinstance *mi, inode_t inode, struct stat *ss)
+  {
+    /*
+     *	Fill in ss for an inode number. Directories and files describing a
+     *	process are owned by the process' owner, everything else belongs
+     *	to root.wheel.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    struct proc *tmpp = NULL;
+    struct procfs_file *pf = NULL;
+    pid_t pid;
+    int oldints;
+
+    memset (ss, 0, sizeof(struct stat));
+
+    if (inode == ROOT_INODE)
+	inode = PROCFS_ROOT_INODE;
+
+    if (inode == PROCFS_ROOT_INODE)
+      {
+	ss->st_mode = 0555 | S_IFDIR;
+	ss->st_mtime = procfs_ctime.tv_sec;
+	ss->st_mtimensec = procfs_ctime.tv_nsec;
+      }
+    else
+      {
+	if (inode <= PID_MAX)
+	  {
+	    pid = (pid_t) inode;
+	    ss->st_mode = 0555 | S_IFDIR;
+	  }
+	else
+	  {
+	    pf = procfs__file (inode, &pid);
+	    if (!pf)
+		return ENOENT;
+	    ss->st_mode = (pf->control? 0644 : 0444) | S_IFREG;
+	    if (pf->flags & PROCFS_STREAM)
+		ss->st_size = PROCFS_STREAMSIZE;
+	    else
+		ss->st_size = PROCFS_FILESIZE(pf);
+	  }
+
+	if (pid)
+	  {
+	    oldints = interrupts (DISABLE);
+	    tmpp = find_proc_by_pid (pid);
+	    if (!tmpp)
+	      {
+		interrupts (oldints);
+		return ENOENT;
+	      }
+
+	    ss->st_uid = tmpp->cred.uid;
+	    ss->st_gid = tmpp->cred.gid;
+	    ss->st_mtime = tmpp->creattime.tv_sec;
+	    ss->st_mtimensec = tmpp->creattime.tv_nsec;
+	    interrupts (oldints);
+	  }
+	else
+	  {
+	    ss->st_mtime = procfs_ctime.tv_sec;
+	    ss->st_mtimensec = procfs_ctime.tv_nsec;
+	  }
+      }
+
+    ss->st_dev = (dev_t) mi;
+    ss->st_ino = inode;
+    ss->st_nlink = 1;
+    ss->st_rdev = NULL;
+    ss->st_ctime = ss->st_mtime;
+    ss->st_ctimensec = ss->st_mtimensec;
+    ss->st_blksize = mi->superblock->blocksize;
+    ss->st_gen = 1;
+    return 0;
+  }
+
+
+
 int procfs_read_superblock (struct mountinstance *mi, struct proc *p)
   {
     mi->superblock->blocksize = 1024;		/*  Doesn't matter  */
     mi->superblock->nr_of_blocks = 0;		/*  ---   ''   ---  */
-    mi->superblock->root_inode = PID_MAX+1;
+    mi->superblock->root_inode = PROCFS_ROOT_INODE;
     mi->superblock->fs_superblock = NULL;
 
     return 0;
@@ -79,75 +524,53 @@ int procfs_namestat (struct mountinstance *mi, inode_t dirinode, char *name,
      *	Scan the directory 'dirinode' for a file named 'name' and if found
      *	we fill the stat struct 'ss' with its data (creation time, uid,gid etc).
      *
-     *	TODO:  this function needs some fixing...
-     *
      *	Returns 0 on success, errno on failure.
      */
 
-    int a, b, pos;
-    struct proc *tmpp;
-    int oldints;
+    int a, b, pos, n;
 
-    if (dirinode != mi->superblock->root_inode)
-	return ENOENT;
+    if (dirinode == ROOT_INODE)
+	dirinode = PROCFS_ROOT_INODE;
 
-    memset (ss, 0, sizeof(struct stat));
+    if (!strcmp(name, ".."))
+	return procfs__stat (mi, PROCFS_ROOT_INODE, ss);
 
-    if (!strcmp(name, ".") || !strcmp(name, ".."))
+    if (!strcmp(name, "."))
+	return procfs__stat (mi, dirinode, ss);
+
+    /*  A file in a process directory?  */
+    if (dirinode >= 1 && dirinode <= PID_MAX)
       {
-	ss->st_ino = mi->superblock->root_inode;
-	ss->st_mode = S_IFDIR + 0555;
-	ss->st_nlink = 1;
-	ss->st_uid = 0;
-	ss->st_gid = 0;
-	ss->st_rdev = mi->device;
-	ss->st_blksize = mi->superblock->blocksize;
-	ss->st_flags = 0;
-	ss->st_gen = 1;
-	return 0;
+	for (n=0; procfs_pidfiles[n].name; n++)
+	  if (!strcmp(name, procfs_pidfiles[n].name))
+	    return procfs__stat (mi, PROCFS_PIDFILE_INODE(dirinode, n), ss);
+	return ENOENT;
       }
 
+    if (dirinode != PROCFS_ROOT_INODE)
+	return ENOENT;
+
+    /*  A file in the root directory?  */
+    for (n=0; procfs_rootfiles[n].name; n++)
+      if (!strcmp(name, procfs_rootfiles[n].name))
+	return procfs__stat (mi, PROCFS_ROOTFILE_INODE(n), ss);
+
     /*  Find process named 'name':  */
-    /*  TODO:  fix this, use atoi or something  */
     b = 0;
-    for (pos=0; pos<5; pos++)
+    for (pos=0; pos<6; pos++)
       {
 	a = name[pos];
-	if (a!=0)
-	  b = b*10 + (a - 48);
-	else
+	if (a == 0)
 	  break;
+	if (a < '0' || a > '9')
+	  return ENOENT;
+	b = b*10 + (a - '0');
       }
 
-    oldints = interrupts (DISABLE);
-    tmpp = find_proc_by_pid (b);
-    if (!tmpp)
-      {
-	interrupts (oldints);
+    if (b < 1 || b > PID_MAX || name[pos])
 	return ENOENT;
-      }
-
-    ss->st_dev = (dev_t) mi;
-    ss->st_ino = (inode_t) tmpp->pid;
-    ss->st_mode = 0511 | S_IFDIR;
-    ss->st_nlink = 1;
-    ss->st_uid = tmpp->cred.uid;
-    ss->st_gid = tmpp->cred.gid;
-    ss->st_rdev = NULL;
-    ss->st_atime = 0;
-    ss->st_atimensec = 0;
-    ss->st_mtime = tmpp->creattime.tv_sec;
-    ss->st_mtimensec = tmpp->creattime.tv_nsec;
-    ss->st_ctime = ss->st_mtime;
-    ss->st_ctimensec = ss->st_mtimensec;
-    ss->st_size = 0;
-    ss->st_blocks = 0;
-    ss->st_blksize = mi->superblock->blocksize;
-    ss->st_flags = 0;
-    ss->st_gen = 1;
 
-    interrupts (oldints);
-    return 0;
+    return procfs__stat (mi, (inode_t) b, ss);
   }
 
 
@@ -155,33 +578,34 @@ int procfs_namestat (struct mountinstance *mi, inode_t dirinode, char *name,
 int procfs_istat (struct mountinstance *mi, inode_t inode, struct stat *ss,
 	struct proc *p)
   {
-    if (inode != mi->superblock->root_inode)
-      {
-	printk ("devfs_istat(): can only istat the root directory");
-	return EINVAL;
-      }
+    return procfs__stat (mi, inode, ss);
+  }
 
-    /*  /proc is always owned by root.wheel, r-xr-xr-x  */
 
-    ss->st_dev = (dev_t) mi;	/*  Hm...  */
-    ss->st_ino = inode;
-    ss->st_mode = 0555 + S_IFDIR;
-    ss->st_nlink = 1;
-    ss->st_uid = 0;
-    ss->st_gid = 0;
-    ss->st_rdev = NULL;
-    ss->st_atime = 0;
-    ss->st_atimensec = 0;
-    ss->st_mtime = procfs_ctime.tv_sec;
-    ss->st_mtimensec = procfs_ctime.tv_nsec;
-    ss->st_ctime = ss->st_mtime;
-    ss->st_ctimensec = ss->st_mtimensec;
-    ss->st_size = 0;
-    ss->st_blocks = 0;
-    ss->st_blksize = mi->superblock->blocksize;
-    ss->st_flags = 0;
-    ss->st_gen = 1;
-    return 0;
+
+void procfs__direntry (byte *buf, inode_t inode, char *name)
+  {
+    /*
+     *	Fill in one 32-byte directory entry.
+     */
+
+    u_int32_t *p32;
+    u_int16_t *p16;
+    int len;
+
+    memset (buf, 0, 32);
+
+    p32 = (u_int32_t *)((byte *)(buf));
+    *p32 = (u_int32_t) inode;
+
+    p16 = (u_int16_t *)((byte *)(buf + 4));
+    *p16 = 32;
+
+    strlcpy (buf+8, name, 20);
+    len = strlen(buf+8);
+
+    p16 = (u_int16_t *)((byte *)(buf + 6));
+    *p16 = len;
   }
 
 
@@ -190,15 +614,16 @@ int procfs_get_direntries (struct proc *p, struct vnode *v,
 	off_t curofs, byte *buf, size_t buflen, off_t *offtres)
   {
     /*
-     *	TODO:  this is very ugly
+     *	Each directory entry is 32 bytes, so the offset into the
+     *	directory is 32 times the entry number. The root directory
+     *	contains the root files followed by one directory per process.
      */
 
     struct proc *tmpp;
     off_t fakeoffset = 0;
-    u_int32_t *p32;
-    u_int16_t *p16;
-    int len;
-    int i;
+    inode_t dirinode = v->ss.st_ino;
+    char pidname [20];
+    int i, n;
     int oldints;
 
     *offtres = 0;
@@ -206,6 +631,46 @@ int procfs_get_direntries (struct proc *p, struct vnode *v,
     if (buflen < 32)
 	return 0;
 
+    if (dirinode == ROOT_INODE)
+	dirinode = PROCFS_ROOT_INODE;
+
+    /*  A process directory:  */
+    if (dirinode != PROCFS_ROOT_INODE)
+      {
+	for (n=0; procfs_pidfiles[n].name; n++)
+	  {
+	    if (curofs == fakeoffset)
+	      {
+		if (buflen - *offtres < 32)
+		    return 0;
+		procfs__direntry (buf, PROCFS_PIDFILE_INODE(dirinode, n),
+		    procfs_pidfiles[n].name);
+		buf += 32;
+		curofs += 32;
+		*offtres += 32;
+	      }
+	    fakeoffset += 32;
+	  }
+
+	return 0;
+      }
+
+    /*  The root directory:  */
+    for (n=0; procfs_rootfiles[n].name; n++)
+      {
+	if (curofs == fakeoffset)
+	  {
+	    if (buflen - *offtres < 32)
+		return 0;
+	    procfs__direntry (buf, PROCFS_ROOTFILE_INODE(n),
+		procfs_rootfiles[n].name);
+	    buf += 32;
+	    curofs += 32;
+	    *offtres += 32;
+	  }
+	fakeoffset += 32;
+      }
+
     oldints = interrupts (DISABLE);
 
     for (i=0; i<PROC_MAXQUEUES; i++)
@@ -215,29 +680,18 @@ int procfs_get_direntries (struct proc *p, struct vnode *v,
 	  {
 	    if (curofs == fakeoffset)
 	      {
-		/*  fill in one entry:  */
-		memset (buf, 0, 32);
-
-		p32 = (u_int32_t *)((byte *)(buf));
-		*p32 = (long) tmpp->pid;
-
-		p16 = (u_int16_t *)((byte *)(buf + 4));
-		*p16 = 32;
-
-		snprintf (buf+8, 20, "%i", tmpp->pid);
+		if (buflen - *offtres < 32)
+		  {
+		    interrupts (oldints);
+		    return 0;
+		  }
 
-		len = strlen(buf+8);
-		if (len > 19)
-			len=19;
-		p16 = (u_int16_t *)((byte *)(buf + 6));
-		*p16 = len;
+		snprintf (pidname, sizeof(pidname), "%i", tmpp->pid);
+		procfs__direntry (buf, (inode_t) tmpp->pid, pidname);
 
 		buf += 32;
-
 		curofs += 32;
 		*offtres += 32;
-		if (buflen - *offtres < 32)
-			return 0;
 	      }
 
 	    /*  next:  */
@@ -248,13 +702,154 @@ int procfs_get_direntries (struct proc *p, struct vnode *v,
 	  }
       }
 
-    interrupts (oldints);    
+    interrupts (oldints);
+
+    return 0;
+  }
+
+
+
+int procfs_read (struct vnode *v, off_t offset, byte *buffer, off_t length,
+	off_t *transfered, struct proc *p)
+  {
+    /*
+     *	procfs_read ()
+     *	--------------
+     *
+     *	Generate the contents of the file, and copy the part starting
+     *	at offset to buffer. Stream files ignore the offset, and return
+     *	as much as is available (at most length bytes).
+     */
+
+    struct procfs_file *pf;
+    struct proc *tmpp = NULL;
+    pid_t pid;
+    char *tmp;
+    size_t len;
+    int oldints;
+
+    if (!v || !buffer || !transfered || length<0 || offset<0)
+	return EINVAL;
+
+    *transfered = 0;
+
+    pf = procfs__file (v->ss.st_ino, &pid);
+    if (!pf)
+	return EINVAL;
+
+    tmp = (char *) malloc (PROCFS_FILESIZE(pf));
+    if (!tmp)
+	return ENOMEM;
+
+    oldints = interrupts (DISABLE);
+
+    if (pid)
+      {
+	tmpp = find_proc_by_pid (pid);
+	if (!tmpp)
+	  {
+	    interrupts (oldints);
+	    free (tmp);
+	    return ENOENT;
+	  }
+      }
+
+    if (pf->flags & PROCFS_STREAM)
+      {
+	if (length > PROCFS_FILESIZE(pf))
+	    length = PROCFS_FILESIZE(pf);
+	len = pf->generate (tmpp, tmp, length);
+	interrupts (oldints);
+
+	memcpy (buffer, tmp, len);
+	*transfered = len;
+	free (tmp);
+	return 0;
+      }
+
+    len = pf->generate (tmpp, tmp, PROCFS_FILESIZE(pf));
+    interrupts (oldints);
+
+    if (offset < len)
+      {
+	if (length > len - offset)
+	    length = len - offset;
+	memcpy (buffer, tmp + offset, length);
+	*transfered = length;
+      }
 
+    free (tmp);
     return 0;
   }
 
 
 
+int procfs_write (struct vnode *v, off_t offset, byte *buffer, off_t length,
+	off_t *transfered)
+  {
+    /*
+     *	procfs_write ()
+     *	---------------
+     *
+     *	Pass the written text to the file's control function. The whole
+     *	command must be written at once; offset is ignored.
+     */
+
+    struct procfs_file *pf;
+    struct proc *tmpp = NULL;
+    char cmd [PROCFS_CMDLEN];
+    pid_t pid;
+    off_t len;
+    int oldints, res;
+
+    if (!v || !buffer || !transfered || length<0)
+	return EINVAL;
+
+    *transfered = 0;
+
+    /*  There are no permission checks in open(), so check here:  */
+    if (!superuser ())
+	return EPERM;
+
+    pf = procfs__file (v->ss.st_ino, &pid);
+    if (!pf)
+	return EINVAL;
+
+    if (!pf->control)
+	return EACCES;
+
+    if (length >= PROCFS_CMDLEN)
+	return EINVAL;
+
+    memcpy (cmd, buffer, length);
+    cmd [length] = '\0';
+    len = length;
+    while (len > 0 && (cmd[len-1] == '\n' || cmd[len-1] == ' '))
+	cmd [--len] = '\0';
+
+    oldints = interrupts (DISABLE);
+
+    if (pid)
+      {
+	tmpp = find_proc_by_pid (pid);
+	if (!tmpp)
+	  {
+	    interrupts (oldints);
+	    return ENOENT;
+	  }
+      }
+
+    res = pf->control (tmpp, cmd);
+    interrupts (oldints);
+
+    if (!res)
+	*transfered = length;
+
+    return res;
+  }
+
+
+
 void procfs_init (int arg)
   {
     /*
@@ -280,6 +875,8 @@ void procfs_init (int arg)
     interrupts (oldints);
 
     procfs_fs->read_superblock = procfs_read_superblock;
+    procfs_fs->read = procfs_read;
+    procfs_fs->write = procfs_write;
     procfs_fs->namestat = procfs_namestat;
     procfs_fs->istat = procfs_istat;
     procfs_fs->get_direntries = procfs_get_direntries;
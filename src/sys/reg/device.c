@@ -47,12 +47,17 @@
  *	device_unregister()
  *		Unregister a device
  *
+ *	device_lookup(), device_lookup_nr()
+ *		Find a device by name, or by device number
+ *
  *	device_dump()
  *		Debug dump of all registered devices
  *
  *  History:
  *	14 Jan 2000	first version
  *	12 Dec 2000	device_alloc needs to be called before device_register
+ *	19 Oct 2026	hash tables by name and by device number, and the
+ *			lowest free device number is used
  */
 
 
@@ -70,11 +75,151 @@
 struct device *first_device = NULL;
 extern struct timespec system_time;
 
+/*  Hash tables, by name and by device number:  */
+struct device *device_namehash [DEVICE_HASHSIZE];
+struct device *device_nrhash [DEVICE_HASHSIZE];
+
+/*  Device numbers in use (one bit each), the lowest number which may be
+    free, and the highest number in use:  */
+byte device_nrmap [DEVICE_MAXNR / 8];
+dev_t device_lowfree = 1;
+dev_t device_highnr = 0;
+
+#define	DEVICE_NAMEHASH(h)	((h) & (DEVICE_HASHSIZE - 1))
+#define	DEVICE_NRHASH(nr)	((nr) & (DEVICE_HASHSIZE - 1))
+#define	DEVICE_NRUSED(nr)	(device_nrmap[(nr) >> 3] & (1 << ((nr) & 7)))
+
 
 
 void device_init ()
   {
-    /*  Nothing.  */
+    memset (device_namehash, 0, sizeof(device_namehash));
+    memset (device_nrhash, 0, sizeof(device_nrhash));
+    memset (device_nrmap, 0, sizeof(device_nrmap));
+
+    /*  Device number 0 is never used:  */
+    device_nrmap[0] = 1;
+    device_lowfree = 1;
+    device_highnr = 0;
+  }
+
+
+
+hash_t device_hash (char *name)
+  {
+    hash_t h = 0;
+
+    while (*name)
+	h = h * 31 + (byte) *name++;
+
+    return h ^ (h >> 16);
+  }
+
+
+
+dev_t device__allocnr ()
+  {
+    /*
+     *	Return the lowest free device number, and mark it as used.
+     *	Returns 0 if all numbers are in use. Interrupts should be
+     *	disabled.
+     */
+
+    dev_t nr = device_lowfree;
+
+    /*  Skip whole bytes of used numbers:  */
+    while (nr < DEVICE_MAXNR && device_nrmap[nr >> 3] == 0xff)
+	nr = (nr | 7) + 1;
+
+    while (nr < DEVICE_MAXNR && DEVICE_NRUSED(nr))
+	nr ++;
+
+    if (nr >= DEVICE_MAXNR)
+	return 0;
+
+    device_nrmap[nr >> 3] |= (1 << (nr & 7));
+    device_lowfree = nr + 1;
+    if (nr > device_highnr)
+	device_highnr = nr;
+
+    return nr;
+  }
+
+
+
+void device__freenr (dev_t nr)
+  {
+    /*  Mark device number nr as free. Interrupts should be disabled.  */
+
+    device_nrmap[nr >> 3] &= ~(1 << (nr & 7));
+
+    if (nr < device_lowfree)
+	device_lowfree = nr;
+
+    while (device_highnr > 0 && !DEVICE_NRUSED(device_highnr))
+	device_highnr --;
+  }
+
+
+
+struct device *device__lookup (char *name)
+  {
+    struct device *d;
+
+    d = device_namehash [DEVICE_NAMEHASH(device_hash (name))];
+    while (d && strcmp (d->name, name))
+	d = d->name_next;
+
+    return d;
+  }
+
+
+
+struct device *device_lookup (char *name)
+  {
+    /*
+     *	device_lookup ()
+     *	----------------
+     *
+     *	Find the registered device called 'name'. Returns a pointer to
+     *	the device struct, or NULL if there is no such device.
+     */
+
+    struct device *d;
+    int oldints;
+
+    if (!name)
+	return NULL;
+
+    oldints = interrupts (DISABLE);
+    d = device__lookup (name);
+    interrupts (oldints);
+
+    return d;
+  }
+
+
+
+struct device *device_lookup_nr (dev_t nr)
+  {
+    /*
+     *	device_lookup_nr ()
+     *	-------------------
+     *
+     *	Find the registered device with device number 'nr'. Returns a
+     *	pointer to the device struct, or NULL if there is no such device.
+     */
+
+    struct device *d;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    d = device_nrhash [DEVICE_NRHASH(nr)];
+    while (d && d->vfs_dev != nr)
+	d = d->nr_next;
+    interrupts (oldints);
+
+    return d;
   }
 
 
@@ -85,51 +230,55 @@ int device_register (struct device *newd)
      *  device_register ()
      *	------------------
      *
-     *	Try to register a device by adding it to the first_device chain.
+     *	Try to register a device by adding it to the first_device chain
+     *	and the hash tables. The device gets the lowest free device
+     *	number.
      *
      *	Returns 0 on success, errno on error.
-     *
-     *	TODO: when lots of devices need to be registered, then this
-     *		routine will need to be rewritten... hash tables?
      */
 
     int oldints;
-    struct device *d;
-    dev_t nr = 0;
+    hash_t h;
+    dev_t nr;
 
     if (!newd)
       return EINVAL;
     if (!newd->name)
       return EINVAL;
 
+    h = DEVICE_NAMEHASH(device_hash (newd->name));
+
     oldints = interrupts (DISABLE);
 
     /*  Is there already a device registered with this name?  */
-    d = first_device;
-    if (d)
-      nr = d->vfs_dev;
-
-    while (d)
+    if (device__lookup (newd->name))
       {
-	if (!strcmp(d->name, newd->name))
-	  {
-	    interrupts (oldints);
-	    return EEXIST;
-	  }
-
-	if (d->vfs_dev > nr)
-	  nr = d->vfs_dev;
+	interrupts (oldints);
+	return EEXIST;
+      }
 
-	d = d->next;
+    nr = device__allocnr ();
+    if (!nr)
+      {
+	interrupts (oldints);
+	return ENFILE;
       }
 
-    /*  TODO:  use the lowest available device number  */
-    newd->vfs_dev = nr + 1;
+    newd->vfs_dev = nr;
 
-    /*  Add newd to the device list:  */
+    /*  Add newd to the device list and the hash chains:  */
+    newd->prev = NULL;
     newd->next = first_device;
+    if (first_device)
+	first_device->prev = newd;
     first_device = newd;
 
+    newd->name_next = device_namehash [h];
+    device_namehash [h] = newd;
+
+    newd->nr_next = device_nrhash [DEVICE_NRHASH(nr)];
+    device_nrhash [DEVICE_NRHASH(nr)] = newd;
+
     /*  Also, interrupts should be disabled to read system_time atomically:  */
     newd->vfs_atime = system_time;
     newd->vfs_ctime = newd->vfs_atime;
@@ -218,12 +367,12 @@ int device_unregister (char *name)
      *	--------------------
      *
      *	Try to unregister device 'name' by removing it from the
-     *	device list.  Fails if refcount > 0.
+     *	device list and the hash tables.  Fails if refcount > 0.
      *
      *	Returns 0 on success, errno on failure.
      */
 
-    struct device *d, *tmp, *prev;
+    struct device *d, **dp;
     int oldints;
 
     if (!name)
@@ -231,48 +380,48 @@ int device_unregister (char *name)
 
     oldints = interrupts (DISABLE);
 
-    /*  Find 'name' in the device list:  */
-    d = first_device;
-    tmp = NULL;
-    prev = NULL;
+    /*  Find 'name' in the name hash chain:  */
+    dp = &device_namehash [DEVICE_NAMEHASH(device_hash (name))];
+    while ((d = *dp) && strcmp (d->name, name))
+	dp = &d->name_next;
 
-    while (d)
+    if (!d)
       {
-	if (!strcmp(d->name, name))
-	  { tmp = d;  d = NULL; }
-
-	if (d)
-	  {
-	    prev = d;
-	    d = d->next;
-	  }
+	interrupts (oldints);
+	return ENXIO;	/*  Device not found. (TODO: find better errno)  */
       }
 
-    if (tmp)
+    /*  Try to remove d from the device list:  */
+    if (d->refcount > 0)
       {
-	/*  Try to remove tmp from the device list:  */
-	if (tmp->refcount > 0)
-	  {
-	    interrupts (oldints);
-	    return EBUSY;
-	  }
-
-	if (tmp->refcount < 0)
-	  panic ("device_unregister: device '%s'->refcount=%i !!!",
-		tmp->name, tmp->refcount);
-
-	if (!prev)
-	  first_device = tmp->next;
-	else
-	  prev->next = tmp->next;
-
-	free (tmp->name);
-	free (tmp);
+	interrupts (oldints);
+	return EBUSY;
       }
+
+    if (d->refcount < 0)
+      panic ("device_unregister: device '%s'->refcount=%i !!!",
+		d->name, d->refcount);
+
+    *dp = d->name_next;
+
+    dp = &device_nrhash [DEVICE_NRHASH(d->vfs_dev)];
+    while (*dp != d)
+	dp = &(*dp)->nr_next;
+    *dp = d->nr_next;
+
+    if (d->prev)
+	d->prev->next = d->next;
     else
-      return ENXIO;	/*  Device not found. (TODO: find better errno)  */
+	first_device = d->next;
+    if (d->next)
+	d->next->prev = d->prev;
+
+    device__freenr (d->vfs_dev);
 
     interrupts (oldints);
+
+    free (d->name);
+    free (d);
     return 0;
   }
 
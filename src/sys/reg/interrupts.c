@@ -54,6 +54,7 @@
  *	5 Jan 2000	first version, irq_dispatcher()
  *	28 May 2000	removing some obsolete code which was only
  *			used during kernel initialisation
+ *	19 Oct 2026	event trace points in irq_dispatcher()
  */
 
 
@@ -62,6 +63,7 @@
 #include <sys/std.h>
 #include <sys/interrupts.h>
 #include <sys/proc.h>
+#include <sys/evtrace.h>
 
 
 
@@ -124,7 +126,9 @@ void irq_dispatcher (int irqnr)
 	return;
       }
 
+    EVTRACE_EVENT (EVT_IRQ, irqnr, 0, 0);
     handler ();
+    EVTRACE_EVENT (EVT_IRQ_DONE, irqnr, 0, 0);
 
     if (need_to_pswitch)
 	pswitch ();
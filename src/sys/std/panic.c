@@ -31,6 +31,7 @@
  *
  *  History:
  *	18 Oct 1999	first version
+ *	19 Oct 2026	flushes the message buffer first
  */
 
 
@@ -39,6 +40,7 @@
 #include <stdio.h>
 #include <sys/console.h>
 #include <sys/std.h>
+#include <sys/msgbuf.h>
 
 #ifdef KDB
 #include <sys/md/machdep.h>
@@ -60,6 +62,9 @@ void panic (char *fmt, ...)
 
     snprintf (buf2, PANIC_BUFSIZE, "panic: %s", buf);
 
+    /*  Show any messages which haven't been shown yet:  */
+    msgbuf_flush ();
+
     /*  No reason to preserve color:  */
     console_puts (buf2, CONSOLE_PANIC_COLOR);
 
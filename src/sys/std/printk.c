@@ -26,27 +26,29 @@
 /*
  *  printk.c  --  kernel printf()
  *
+ *	The formatted message is appended to the kernel message buffer,
+ *	and shown on the console later by the msgbuf thread. (See
+ *	kern/msgbuf.c.)
+ *
  *  TODO:
  *	Inline, ie not call snprintf() ?
- *	Place output in a dmesg buffer!!!
  *
  *  History:
  *	18 Oct 1999	first version
  *	13 Jan 2000	disables printk if DEBUGLEVEL<0
  *	4 Feb 2000	disabling interrupts
+ *	19 Oct 2026	output goes to the message buffer
  */
 
 
 #include <stdarg.h>
 #include <stdio.h>
 #include <sys/std.h>
-#include <sys/console.h>
 #include <sys/interrupts.h>
+#include <sys/msgbuf.h>
 #include "../config.h"
 
 
-extern int	console_cursor_color;
-
 int	printk_enabled = 1;
 
 #define	PRINTK_BUFSIZE	2000
@@ -62,8 +64,7 @@ int printk (char *fmt, ...)
     res = vsnprintf (buf, PRINTK_BUFSIZE, fmt, argp);
     va_end (argp);
 
-    if (printk_enabled)
-	console_puts (buf, CONSOLE_KERNEL_COLOR);
+    msgbuf_putline (buf);
 
 #if DEBUGLEVEL<0
     /*  Disable printk if DEBUGLEVEL<0:  */
@@ -26,21 +26,34 @@
 /*
  *  string.c  --  string functions
  *
- *  TODO:
- *	Move to arch/ instead (?), or at least optimize...
+ *	If the machine dependant code has its own (faster) memset(),
+ *	memcpy(), strlen(), and strcmp(), then MD_STRING_FUNCTIONS is
+ *	defined in md/config.h. The portable versions below are then
+ *	renamed std_*(), so that they can still be used as a reference
+ *	(for example when benchmarking the MD versions).
  *
  *  History:
  *	18 Oct 1999	first version: memset(), memcpy()
  *	21 Oct 1999	adding strlen()
  *	20 Dec 1999	adding strncpy(), strlcpy(), strcmp(), strncmp()
+ *	19 Oct 2026	MD_STRING_FUNCTIONS
  */
 
 
+#include "../config.h"
 #include <string.h>
 #include <sys/std.h>
 #include <sys/defs.h>
 
 
+#ifdef	MD_STRING_FUNCTIONS
+#define	memset		std_memset
+#define	memcpy		std_memcpy
+#define	strlen		std_strlen
+#define	strcmp		std_strcmp
+#endif
+
+
 void *memset (void *b, int c, size_t len)
   {
     unsigned char *p;
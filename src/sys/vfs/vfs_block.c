@@ -45,6 +45,7 @@
  *	15 Mar 2000	uses device' readtip() if it exists to read
  *			the rest of a track from a disk into the cache
  *	26 Dec 2000	vfs_bcacheflush() called by timer every 15th sec.
+ *	19 Oct 2026	event trace points for cache hits/misses and device I/O
  */
 
 
@@ -55,6 +56,7 @@
 #include <sys/timer.h>
 #include <sys/vfs.h>
 #include <sys/std.h>
+#include <sys/evtrace.h>
 
 
 
@@ -147,7 +149,10 @@ int buffercache_write (struct mountinstance *mi, daddr_t blocknr, void *buf,
 	return EINVAL;
       }
 
+    EVTRACE_EVENT (EVT_DEV_WRITE, evtrace_name4 (mi->device->name),
+	blocknr, 1);
     res = mi->device->write (mi->device, (daddr_t)blocknr, (daddr_t)1, buf, p);
+    EVTRACE_EVENT (EVT_DEV_DONE, evtrace_name4 (mi->device->name), res, 0);
 
 printk ("buffercache_write: mi->device->write res = %i", res);
 
@@ -209,11 +214,14 @@ int buffercache_read (struct mountinstance *mi, daddr_t blocknr, void *buf,
     /*  Found the block in the cache? Then memcpy() it to buf and return:  */
     if (found)
       {
+	EVTRACE_EVENT (EVT_BCACHE_HIT, mi, blocknr, 0);
 	memcpy (buf, found->bufferptr, mi->superblock->blocksize);
 	unlock (&mi->lock);
 	return 0;
       }
 
+    EVTRACE_EVENT (EVT_BCACHE_MISS, mi, blocknr, 0);
+
 
     /*
      *	We are here if the block was not found in the cache.
@@ -257,7 +265,10 @@ int buffercache_read (struct mountinstance *mi, daddr_t blocknr, void *buf,
     blocknr = startblock;
 
     /*  Read from the device (non-cached access):  */
+    EVTRACE_EVENT (EVT_DEV_READ, evtrace_name4 (mi->device->name),
+	blocknr, blocks_to_read);
     res = mi->device->read (mi->device, blocknr, blocks_to_read, large_buf, p);
+    EVTRACE_EVENT (EVT_DEV_DONE, evtrace_name4 (mi->device->name), res, 0);
     if (res)
       {
 	free (large_buf);
@@ -37,6 +37,7 @@
  *
  *  History:
  *	20 Jan 2000	first version
+ *	19 Oct 2026	the device is found with device_lookup()
  */
 
 
@@ -50,7 +51,6 @@
 
 extern struct filesystem *firstfilesystem;
 extern struct mountinstance *firstmountinstance;
-extern struct device *first_device;
 
 
 
@@ -73,7 +73,7 @@ int vfs_mount (struct proc *p, char *devname, char *mountpoint, char *fstype,
      */
 
     struct filesystem *fsptr, *found;
-    struct device *adev, *fdev;
+    struct device *adev;
     struct mountinstance *mi, *tmpmi;
     struct superblock *sb;
     struct vnode *v = NULL;
@@ -134,26 +134,14 @@ int vfs_mount (struct proc *p, char *devname, char *mountpoint, char *fstype,
       }
     else
       {
-	/*  Find the device name in the device chain:  */
-	adev = first_device;
-	fdev = NULL;
-	while (adev)
-	  {
-	    if (adev->name && !strcmp(adev->name, devname))
-		{  fdev=adev; adev=NULL;  }
-
-	    if (adev)
-		adev = adev->next;
-	  }
-
-	if (!fdev)
+	/*  Find the device name in the device registry:  */
+	adev = device_lookup (devname);
+	if (!adev)
 	  {
 	    printk ("vfs_mount: device '%s' not found", devname);
 	    return ENOENT;
 	  }
 
-	adev = fdev;
-
 	/*  Try to open the device:  */
 	res = adev->open (adev, p);
 	if (res)
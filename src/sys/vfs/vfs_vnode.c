@@ -80,6 +80,8 @@
  *	25 Feb 2000	adding vnode_pagein()
  *	7 Jun 2000	locking
  *	19 Nov 2000	correct multiple name per vnode stuff
+ *	19 Oct 2026	vnode_pagein() zero fills the part of the last page
+ *			which is beyond the end of the file
  */
 
 
@@ -564,6 +566,10 @@ void *vnode_pagein (int *errno, struct vm_region *vmregion, struct vm_object *vm
      *	(o)  Where should we read from?
      *		(linearaddr - vmregion->start_addr) + vmregion->srcoffset
      *
+     *	(o)  Zero fill the part of the page beyond the end of the file.
+     *	     (The page may be mapped MAP_SHARED, and shouldn't show
+     *	     whatever the filesystem had after the end of the file.)
+     *
      *	(o)  Return a pointer to the page.
      *
      *	NOTE: We do NOT lock the vnode. (TODO ?)  If we simply lock the vnode,
@@ -574,7 +580,7 @@ void *vnode_pagein (int *errno, struct vm_region *vmregion, struct vm_object *vm
     void *pagebuffer;
     int res;
     struct vnode *v;
-    off_t actually_read = 0;
+    off_t offset, actually_read = 0;
 
 
     v = vmobject->vnode;
@@ -586,17 +592,25 @@ void *vnode_pagein (int *errno, struct vm_region *vmregion, struct vm_object *vm
 	return NULL;
       }
 
-    res = v->read (v, (off_t) ((linearaddr - vmregion->start_addr) + vmregion->srcoffset),
-	pagebuffer, (off_t) PAGESIZE, &actually_read, p);
+    offset = (off_t) ((linearaddr - vmregion->start_addr) + vmregion->srcoffset);
+    res = v->read (v, offset, pagebuffer, (off_t) PAGESIZE, &actually_read, p);
 
-    if (actually_read < PAGESIZE)
+    if (res || actually_read <= 0 || (actually_read < PAGESIZE
+	&& offset + actually_read < v->ss.st_size))
       {
-	*errno = EIO;
+	*errno = res? res : EIO;
 	free (pagebuffer);
 	return NULL;
       }
+
+    *errno = 0;
+
+    if (offset >= v->ss.st_size)
+	memset (pagebuffer, 0, PAGESIZE);
     else
-	*errno = res;
+    if (offset + PAGESIZE > v->ss.st_size)
+	memset ((byte *)pagebuffer + (v->ss.st_size - offset), 0,
+	    PAGESIZE - (v->ss.st_size - offset));
 
     return pagebuffer;
  }
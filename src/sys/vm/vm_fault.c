@@ -31,10 +31,23 @@
  *		low level code.  Should try to make the faulting page
  *		available, or kill the process.
  *
+ *	vm_fault_prefetch ()
+ *		Read pages of a file mapping before they are needed.
+ *		(Read-ahead for MADV_SEQUENTIAL, and MADV_WILLNEED.)
+ *
  *  History:
  *	25 Feb 2000	first version
  *	16 Apr 2000	rewriting most of it...
  *	24 May 2000	finnishing rewrite begun on 16 Apr
+ *	19 Oct 2026	per-vm_object locking instead of one global lock,
+ *			busy-page markers, fault latency histogram
+ *	19 Oct 2026	shadow chain collapse and bypass
+ *	19 Oct 2026	shared zero page for anonymous read faults
+ *	19 Oct 2026	pages may be on swap, waiting for the pageout daemon
+ *			when out of memory
+ *	19 Oct 2026	shared file mappings (dirty page tracking), and
+ *			read-ahead in MADV_SEQUENTIAL regions
+ *	19 Oct 2026	event trace points at fault entry and exit
  */
 
 
@@ -48,6 +61,8 @@
 #include <sys/defs.h>
 #include <sys/interrupts.h>
 #include <sys/lock.h>
+#include <sys/errno.h>
+#include <sys/evtrace.h>
 
 
 
@@ -55,7 +70,134 @@ extern struct mcb *first_mcb;		/*  physical addr of first mcb  */
 extern size_t malloc_firstaddr;
 
 volatile static int invmfault = 0;
-struct lockstruct vm_fault_lock;
+
+/*  Fault statistics, minor and major (ie. requiring I/O) faults:  */
+u_int32_t vm_fault_count [2];
+u_int32_t vm_fault_hist [2][VM_FAULT_HISTBUCKETS];
+
+/*  Nr of pages read by vm_fault_prefetch():  */
+u_int32_t vm_readahead_pages = 0;
+
+
+
+int vm_fault_memwait (struct proc *p)
+  {
+    /*
+     *	Wait for the pageout daemon to free some memory. (The process is
+     *	not in a vm operation while waiting, so the daemon may take pages
+     *	from it too.) Returns 0 if the fault should be retried.
+     */
+
+    int res;
+
+    p->vm_busy --;
+    res = vm_pageout_wait ();
+    p->vm_busy ++;
+
+    return res;
+  }
+
+
+
+void vm_fault_account (int kind, u_int64_t starttime)
+  {
+    /*
+     *	Add a fault to the latency histogram. Bucket n counts faults
+     *	which took 2^n .. 2^(n+1)-1 cycles.
+     */
+
+    u_int64_t cycles;
+    int bucket;
+
+    vm_fault_count [kind] ++;
+
+    /*  No cycle counter?  */
+    if (!starttime)
+	return;
+
+    cycles = machdep_cyclecounter () - starttime;
+
+    bucket = 0;
+    while (cycles > 1 && bucket < VM_FAULT_HISTBUCKETS-1)
+      {
+	cycles >>= 1;
+	bucket ++;
+      }
+
+    vm_fault_hist [kind][bucket] ++;
+  }
+
+
+
+int vm_fault_prefetch (struct proc *p, struct vm_region *region,
+	size_t startaddr, size_t endaddr)
+  {
+    /*
+     *	vm_fault_prefetch ()
+     *	--------------------
+     *
+     *	Read the pages startaddr..endaddr of region into the file vm_object
+     *	at the end of the region's source chain, without mapping them. The
+     *	next fault on such a page is then a minor fault. Pages which are
+     *	resident (or busy) are skipped. Stops at the end of the region, at
+     *	the end of the file, on a read error, or when memory is low.
+     *
+     *	Returns the nr of pages read.
+     */
+
+    struct vm_object *obj;
+    byte *a_page;
+    size_t addr, pagenumber;
+    int res, n = 0;
+
+    obj = region->source;
+    while (obj && obj->next)
+	obj = obj->next;
+
+    if (!obj || obj->type != VM_OBJECT_FILE || !obj->vnode)
+	return 0;
+
+    if (endaddr > region->end_addr)
+	endaddr = region->end_addr;
+
+    for (addr = startaddr & ~(PAGESIZE-1); addr <= endaddr && addr >=
+	 region->start_addr; addr += PAGESIZE)
+      {
+	pagenumber = (addr - region->start_addr + region->srcoffset) / PAGESIZE;
+
+	if ((off_t) pagenumber * PAGESIZE >= obj->vnode->ss.st_size
+	    || malloc_totalfreememory < VM_PAGEOUT_LOWWATER)
+	    break;
+
+	lock (&obj->lock, "vm_fault_prefetch", LOCK_BLOCKING | LOCK_RW);
+
+	if (vm_object_findpage (obj, pagenumber)
+	    || vm_object_findbusy (obj, pagenumber)
+	    || vm_object_setbusy (obj, pagenumber))
+	  {
+	    unlock (&obj->lock);
+	    continue;
+	  }
+
+	unlock (&obj->lock);
+
+	a_page = (byte *) obj->pagein (&res, region, obj, addr, p);
+
+	lock (&obj->lock, "vm_fault_prefetch", LOCK_BLOCKING | LOCK_RW);
+	if (a_page)
+	    vm_object_addpage (obj, a_page, pagenumber);
+	vm_object_unbusy (obj, pagenumber);
+	unlock (&obj->lock);
+
+	if (!a_page)
+	    break;
+
+	n ++;
+      }
+
+    vm_readahead_pages += n;
+    return n;
+  }
 
 
 
@@ -90,32 +232,52 @@ void vm_fault (struct proc *p, size_t virtualaddr, int action)
      *	    2)	If the lowest-level object is anonymous, then page-in the
      *		page at the highest-level object, mark the page as
      *		read-only or read-write depending on the region's
-     *		access bits.
+     *		access bits. (Read faults map the shared zero page
+     *		instead, until the page is written to.)
      *
-     *	B:  The page exists. If the region is Copy-On-Write, and the
+     *	B:  The page exists. If the region is Copy-on-write, and the
      *	    action was to 'write' then this means that we will have to
      *	    duplicate the page, and insert the new page in the
      *	    page chain of the vm_region's first source. This first
      *	    source should be a shadow vm_object. If it isn't (doesn't
      *	    exist) then we'll have to create it.
+     *
+     *	Shared file regions (VMREGION_SHARED) map the file object's pages
+     *	directly. Such a page is mapped read-only until it is written to;
+     *	the write fault marks it VM_PAGE_DIRTY, so that it will be written
+     *	back to the file (see vm/vm_writeback.c).
+     *
+     *	Shadow chains are kept short by vm_object_collapse(), which is
+     *	called when the region's first source has become the only referer
+     *	of its backing object, or when it has copied up enough pages to
+     *	possibly cover the backing object.
+     *
+     *	Locking:  Each vm_object is locked only while its page chain is
+     *	being searched or modified, never more than one object at a time.
+     *	While a page is being paged in, the object which the page will be
+     *	inserted into is unlocked, and has a busy-page marker for the page
+     *	instead. Other faults on that page wait for the marker to go away,
+     *	and then start over.
      */
 
 
     struct vm_region *region, *found_region;
-    struct vm_object *vmobj, *found_vmobj, *new_vmobj;
+    struct vm_object *vmobj, *found_vmobj, *new_vmobj, *target;
+    struct vm_busypage *busy;
     size_t offset_within_region, pagenumber;
     byte *a_page = NULL, *b_page = NULL;
     int res;
-    int pmapflags;
-    size_t mcb_index, found_mcb_index;
-    struct mcb *a_mcb;
-    size_t i;
+    int pmapflags, shared;
+    int kind = VM_FAULT_MINOR;
+    size_t found_mcb_index;
+    u_int64_t starttime;
 
 
+    starttime = machdep_cyclecounter ();
     invmfault ++;
+    p->vm_busy ++;
 
-/*  MEGA-LOCK:  */
-lock (&vm_fault_lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+    EVTRACE_EVENT (EVT_FAULT, virtualaddr, action, 0);
 
 
     /*
@@ -143,7 +305,6 @@ lock (&vm_fault_lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
 
     if (!region)
       {
-	unlock (&vm_fault_lock);
 	printk ("vm_fault(): no matching region for %x...", virtualaddr);
 	sig_post (p, p, SIGSEGV);
 pswitch();
@@ -157,7 +318,6 @@ pswitch();
 
     if ((action & VM_PAGEFAULT_READ) && (region->type & VMREGION_READABLE)==0)
       {
-	unlock (&vm_fault_lock);
 	printk ("vm_fault(): trying to read from read protected region");
 	sig_post (p, p, SIGSEGV);
 pswitch();
@@ -167,7 +327,6 @@ pswitch();
     if ((action & VM_PAGEFAULT_WRITE) && (region->type & VMREGION_WRITABLE)==0
 		&& (region->type & VMREGION_COW)==0)
       {
-	unlock (&vm_fault_lock);
 	printk ("vm_fault(): trying to write to write protected region");
 	sig_post (p, p, SIGSEGV);
 pswitch();
@@ -183,53 +342,70 @@ pswitch();
     pagenumber = offset_within_region / PAGESIZE;
 
 
+    /*
+     *	If the region's shadow object has become the only referer of
+     *	its backing object, then merge the two before walking the chain.
+     *	(Other referers may have gone away since the last fault.)
+     */
+
+    vmobj = region->source;
+    if (vmobj->refcount == 1 && vmobj->next && vmobj->next->refcount == 1)
+	vm_object_collapse (vmobj);
+
+
+vm_fault_retry:
+
     /*
      *	3.  Use the page offset to find the mcb describing the page
      *	    by traversing the vm_region's source chain (vm_objects).
+     *	    If the page is busy in any of the objects, then wait for
+     *	    it to be paged in and try again.
      */
 
-    /*  Start with the first source for this vm_region ...  */
     vmobj = region->source;
     found_vmobj = NULL;
     found_mcb_index = 0;
 
-    /*  ... and scan through vm_objects until we find the page:  */
     while (vmobj)
       {
-	/*
-	 *  Scan through all the pages of this vm_object:
-	 *  (TODO:  this is extremely inefficient, should be
-	 *	    hashed or something...)
-	 */
-	mcb_index = vmobj->page_chain_start;
-	while (mcb_index != 0)
+	lock (&vmobj->lock, "vm_fault", LOCK_BLOCKING | LOCK_RO);
+
+	found_mcb_index = vm_object_findpage (vmobj, pagenumber);
+	if (found_mcb_index)
+	  {
+	    found_vmobj = vmobj;
+	    first_mcb[found_mcb_index].bitmap |= VM_PAGE_REFERENCED;
+	    unlock (&vmobj->lock);
+	    break;
+	  }
+
+	busy = vm_object_findbusy (vmobj, pagenumber);
+	if (busy)
 	  {
-	    a_mcb = &first_mcb[mcb_index];
-
-	    /*  Is this the page we're looking for?  */
-	    if (a_mcb->size == MCB_VMOBJECT_PAGE)
-	      {
-		if (a_mcb->page_nr == pagenumber)
-		  {
-		    found_vmobj = vmobj;
-		    found_mcb_index = mcb_index;
-		    a_mcb = NULL;	/*  (to break the scan)  */
-		    vmobj = NULL;
-		  }
-	      }
-	    else
-	      panic ("vm_fault(): non-vm_object mcbs in vm_object page chain!");
-
-	    /*  go to the next mcb... until the end of the chain (0):  */
-	    if (a_mcb)
-		mcb_index = a_mcb->next;
-	    else
-		mcb_index = 0;
+	    vm_object_waitbusy (vmobj, busy);
+	    goto vm_fault_retry;
+	  }
+
+	/*  On swap? Then read it back, and start over:  */
+	if (vmobj->nswapped && vm_swap_lookup (vmobj, pagenumber))
+	  {
+	    unlock (&vmobj->lock);
+	    kind = VM_FAULT_MAJOR;
+
+	    res = vm_swapin (vmobj, pagenumber);
+	    if (!res || (res == ENOMEM && !vm_fault_memwait (p)))
+		goto vm_fault_retry;
+
+	    printk ("vm_fault(): swap read error %i, pid %i", res, p->pid);
+	    sig_post (p, p, SIGSEGV);
+pswitch();
+	    goto vm_fault_return;
 	  }
 
+	unlock (&vmobj->lock);
+
 	/*  Try next vmobj, if there are any more...  */
-	if (vmobj)
-	  vmobj = vmobj->next;
+	vmobj = vmobj->next;
       }
 
     vmobj = found_vmobj;
@@ -257,12 +433,91 @@ pswitch();
 	while (vmobj->next)
 	  vmobj = vmobj->next;
 
-	/*  Call the vm_object's pagein function:  */
+	/*  Is this an ANONYMOUS object, ie not a FILE object?  */
+	if (vmobj->type == VM_OBJECT_ANONYMOUS)
+	  {
+	    /*  Then we shall insert the newly paged-in page as
+		"close" to the process as possible.  */
+	    target = region->source;
+	  }
+	else
+	  {
+	    target = vmobj;
+	    kind = VM_FAULT_MAJOR;
+	  }
+
+	/*
+	 *  A read fault on anonymous memory which has never been written
+	 *  to is satisfied by mapping the shared zero page read-only. The
+	 *  first write fault then allocates a real page. (Only if the
+	 *  target object is private to this region, otherwise a page added
+	 *  by another referer would not be seen through our mapping.)
+	 */
+	if (vmobj->type == VM_OBJECT_ANONYMOUS && target->refcount == 1
+	    && !(action & VM_PAGEFAULT_WRITE))
+	  {
+	    res = pmap_mappage (p, virtualaddr, vm_zeropage,
+		region->type & VMREGION_READABLE);
+	    if (res)
+		panic ("vm_fault(): pmap_mappage() failed for the zero page");
+
+	    vm_zeropage_maps ++;
+	    goto vm_fault_return;
+	  }
+
+	/*
+	 *  Mark the page as busy in the target object, unless someone
+	 *  else got there first while the object was unlocked:
+	 */
+	lock (&target->lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+
+	if (vm_object_findpage (target, pagenumber)
+	    || (target->nswapped && vm_swap_lookup (target, pagenumber)))
+	  {
+	    unlock (&target->lock);
+	    goto vm_fault_retry;
+	  }
+
+	busy = vm_object_findbusy (target, pagenumber);
+	if (busy)
+	  {
+	    vm_object_waitbusy (target, busy);
+	    goto vm_fault_retry;
+	  }
+
+	if (vm_object_setbusy (target, pagenumber))
+	  {
+	    unlock (&target->lock);
+
+	    if (!vm_fault_memwait (p))
+		goto vm_fault_retry;
+
+	    printk ("vm_fault(): out of memory, pid %i", p->pid);
+	    sig_post (p, p, SIGSEGV);
+pswitch();
+	    goto vm_fault_return;
+	  }
+
+	unlock (&target->lock);
+
+	/*  Call the vm_object's pagein function:  (without any locks held)  */
 	a_page = (byte *) vmobj->pagein (&res, region, vmobj,
-			virtualaddr & ~(PAGESIZE-1));
+			virtualaddr & ~(PAGESIZE-1), p);
 
 	if (!a_page)
-	  panic ("vm_fault(): !a_page  TODO");
+	  {
+	    lock (&target->lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+	    vm_object_unbusy (target, pagenumber);
+	    unlock (&target->lock);
+
+	    if (res == ENOMEM && !vm_fault_memwait (p))
+		goto vm_fault_retry;
+
+	    printk ("vm_fault(): pagein failed, error %i, pid %i", res, p->pid);
+	    sig_post (p, p, SIGSEGV);
+pswitch();
+	    goto vm_fault_return;
+	  }
 
 #if DEBUGLEVEL>=5
     printk ("res = %i, a_page:  %y%y%y%y %y%y%y%y %y%y%y%y %y%y%y%y", res,
@@ -272,39 +527,36 @@ pswitch();
 	a_page[12], a_page[13], a_page[14], a_page[15]);
 #endif
 
-	/*  Is this an ANONYMOUS object, ie not a FILE object?  */
-	if (vmobj->type == VM_OBJECT_ANONYMOUS)
-	  {
-	    /*  Then we shall insert the newly paged-in page as
-		"close" to the process as possible.  */
-	    vmobj = region->source;
-	  }
-
-	/*  Insert this into the vmobj's page chain:  */
-	/*  (first, let's find the address to "a_page"'s mcb)  */
-	i = ((size_t)a_page - malloc_firstaddr) / PAGESIZE;
-	a_mcb = &first_mcb[i];
-
-	if (a_mcb->size != PAGESIZE)
-	    panic ("vm_fault(): pagein didn't allocate %i bytes as expected", PAGESIZE);
+	shared = (region->type & VMREGION_SHARED) &&
+	    target->type == VM_OBJECT_FILE;
 
-	a_mcb->size = MCB_VMOBJECT_PAGE;
-	a_mcb->bitmap = 0;
-	a_mcb->page_nr = pagenumber;
-	a_mcb->next = vmobj->page_chain_start;
-
-	vmobj->page_chain_start = i;
+	/*  Insert this into the target's page chain:  */
+	lock (&target->lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+	vm_object_addpage (target, a_page, pagenumber);
+	first_mcb[((size_t)a_page - malloc_firstaddr) / PAGESIZE].bitmap |=
+	    VM_PAGE_REFERENCED |
+	    ((shared && (action & VM_PAGEFAULT_WRITE))? VM_PAGE_DIRTY : 0);
+	vm_object_unbusy (target, pagenumber);
+	unlock (&target->lock);
 
 	/*
 	 *  If the region is Copy-on-write, then we DON'T set the writable
-	 *  flag:
+	 *  flag:  (Nor for shared file pages which are only being read.)
 	 */
 	pmapflags = region->type & (VMREGION_READABLE | VMREGION_WRITABLE);
-	if (region->type & VMREGION_COW)
+	if ((region->type & VMREGION_COW)
+	    || (shared && !(action & VM_PAGEFAULT_WRITE)))
 	  pmapflags = region->type & VMREGION_READABLE;
 
 	res = pmap_mappage (p, virtualaddr, a_page, pmapflags);
 
+	/*  Sequential access? Then read ahead:  */
+	if (target->type == VM_OBJECT_FILE &&
+	    (region->type & VMREGION_SEQUENTIAL))
+	    vm_fault_prefetch (p, region, (virtualaddr & ~(PAGESIZE-1)) +
+		PAGESIZE, (virtualaddr & ~(PAGESIZE-1)) +
+		VM_READAHEAD_PAGES*PAGESIZE);
+
 	goto vm_fault_return;
       }
 
@@ -319,20 +571,39 @@ pswitch();
      *	    page chain of the vm_region's first source. This first
      *	    source should be a shadow vm_object. If it isn't (doesn't
      *	    exist) then we'll have to create it.
+     *
+     *	    (If the page already is in the region's own shadow object,
+     *	    and nobody else uses that object, then the page is already
+     *	    private and doesn't need to be copied.)
      */
 
     a_page = (byte *) (found_mcb_index*PAGESIZE + malloc_firstaddr);
 
     if ((action & VM_PAGEFAULT_WRITE) && (region->type & VMREGION_COW))
       {
+	if (vmobj == region->source && vmobj->type != VM_OBJECT_FILE
+	    && vmobj->refcount == 1)
+	  {
+	    res = pmap_mappage (p, virtualaddr, a_page, region->type &
+		(VMREGION_WRITABLE | VMREGION_READABLE));
+	    if (res)
+		panic ("vm_fault(): pmap_mappage() failed 0");
+
+	    goto vm_fault_return;
+	  }
+
 	b_page = (byte *) malloc (PAGESIZE);
-	memcpy (b_page, a_page, PAGESIZE);
+	if (!b_page)
+	  {
+	    if (!vm_fault_memwait (p))
+		goto vm_fault_retry;
 
-	i = ((size_t)b_page - malloc_firstaddr)/PAGESIZE;
-	first_mcb[i].size = MCB_VMOBJECT_PAGE;
-	first_mcb[i].bitmap = 0;
-	first_mcb[i].page_nr = pagenumber;
-	first_mcb[i].next = 0;
+	    printk ("vm_fault(): out of memory, pid %i", p->pid);
+	    sig_post (p, p, SIGSEGV);
+pswitch();
+	    goto vm_fault_return;
+	  }
+	memcpy (b_page, a_page, PAGESIZE);
 
 	/*  region->source must be a shadow object. Create one if we have to:  */
 	if (region->source->type != VM_OBJECT_SHADOW)
@@ -342,14 +613,28 @@ pswitch();
 		panic ("vm_fault(): ENOMEM... TODO: kill(SIGSEGV) or something?");
 
 	    new_vmobj->next = region->source;
-	    new_vmobj->page_chain_start = i;
 	    new_vmobj->refcount = 1;
+	    vm_object_addpage (new_vmobj, b_page, pagenumber);
 	    region->source = new_vmobj;
 	  }
 	else
 	  {
-	    first_mcb[i].next = region->source->page_chain_start;
-	    region->source->page_chain_start = i;
+	    lock (&region->source->lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+	    vm_object_addpage (region->source, b_page, pagenumber);
+	    unlock (&region->source->lock);
+	  }
+
+	/*
+	 *  Count pages copied up from the backing object. Once the shadow
+	 *  object may cover all of the backing object's pages, try to
+	 *  bypass the backing object:
+	 */
+	target = region->source;
+	if (vmobj == target->next)
+	  {
+	    target->ncopied ++;
+	    if (target->refcount == 1 && target->ncopied >= vmobj->npages)
+		vm_object_collapse (target);
 	  }
 
 	res = pmap_mappage (p, virtualaddr, b_page, region->type &
@@ -360,14 +645,35 @@ pswitch();
 	goto vm_fault_return;
       }
 
+    /*
+     *	A write to a page of a shared file region makes the page dirty.
+     *	It stays writable until it has been written back:
+     */
+    shared = (region->type & VMREGION_SHARED) && vmobj->type == VM_OBJECT_FILE;
+
+    if ((action & VM_PAGEFAULT_WRITE) && shared)
+      {
+	lock (&vmobj->lock, "vm_fault", LOCK_BLOCKING | LOCK_RW);
+	first_mcb[found_mcb_index].bitmap |= VM_PAGE_DIRTY;
+	unlock (&vmobj->lock);
+
+	res = pmap_mappage (p, virtualaddr, a_page, region->type &
+		(VMREGION_WRITABLE | VMREGION_READABLE));
+	if (res)
+	  panic ("vm_fault(): pmap_mappage() failed 3");
+
+	goto vm_fault_return;
+      }
+
     if (!pmap_mapped (p, virtualaddr))
       {
 	/*
 	 *  If the region is Copy-on-write, then we DON'T set the writable
-	 *  flag:
+	 *  flag:  (Nor for shared file pages which are not dirty.)
 	 */
 	pmapflags = region->type & (VMREGION_READABLE | VMREGION_WRITABLE);
-	if (region->type & VMREGION_COW)
+	if ((region->type & VMREGION_COW) || (shared &&
+	    !(first_mcb[found_mcb_index].bitmap & VM_PAGE_DIRTY)))
 	  pmapflags = region->type & VMREGION_READABLE;
 
 	res = pmap_mappage (p, virtualaddr, a_page, pmapflags);
@@ -380,7 +686,9 @@ pswitch();
 
 vm_fault_return:
 
-    unlock (&vm_fault_lock);
+    vm_fault_account (kind, starttime);
+    EVTRACE_EVENT (EVT_FAULT_DONE, virtualaddr, kind, 0);
+    p->vm_busy --;
     invmfault --;
   }
 
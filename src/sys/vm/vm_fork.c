@@ -28,6 +28,9 @@
  *
  *  History:
  *	19 Jul 2000	first version, code moved here from sys_fork()
+ *	19 Oct 2026	collapse shadow chains before adding new shadows
+ *	19 Oct 2026	p->vm_busy is set while the regions are modified
+ *	19 Oct 2026	shared regions stay shared
  */
 
 
@@ -51,7 +54,8 @@ int vm_fork (struct proc *p, struct proc *child_proc)
      *	from both the parent and the child process. Read-only regions can be
      *	shared by the two processes, but writable regions need to have a
      *	shadow object inserted before the actual vm_object. This is neccessay
-     *	to implement copy-on-write.
+     *	to implement copy-on-write. (Shared regions, VMREGION_SHARED, refer
+     *	to the same object in both processes.)
      */
 
     struct vm_region *region;
@@ -63,6 +67,8 @@ int vm_fork (struct proc *p, struct proc *child_proc)
      *	For each region in the parent "p", create a region in child_proc:
      */
 
+    p->vm_busy ++;
+
     region = p->vmregions;
     datareg = 0;
     while (region)
@@ -72,11 +78,12 @@ int vm_fork (struct proc *p, struct proc *child_proc)
 	datareg = (region == p->dataregion)? 1 : 0;
 
 	/*
-	 *  Is this a non-writable region? Then simply attach a read-only
+	 *  Is this a non-writable (or shared) region? Then simply attach a
 	 *  region in the child using the same vm_object and characteristics
 	 *  as the parent's region:
 	 */
-	if (!(region->type & VMREGION_WRITABLE))
+	if (!(region->type & VMREGION_WRITABLE)
+	    || (region->type & VMREGION_SHARED))
 	    vm_region_attach (child_proc, region->source, region->srcoffset,
 		region->start_addr, region->end_addr, region->type);
 	else
@@ -84,9 +91,13 @@ int vm_fork (struct proc *p, struct proc *child_proc)
 	    /*
 	     *	The region is writable in one way or another:
 	     *	Create shadow objects for both the parent and the child.
-	     *	and make them point to the old object:
+	     *	and make them point to the old object. (Shorten the old
+	     *	object's chain first, so that repeated forks don't build
+	     *	long chains.)
 	     */
 
+	    vm_object_collapse (region->source);
+
 	    tmpobj1 = vm_object_create (VM_OBJECT_SHADOW);
 	    if (!tmpobj1)
 		goto vm_fork_failed;
@@ -94,6 +105,7 @@ int vm_fork (struct proc *p, struct proc *child_proc)
 	    tmpobj2 = vm_object_create (VM_OBJECT_SHADOW);
 	    if (!tmpobj2)
 	      {
+		free (tmpobj1->page_hash);
 		free (tmpobj1);
 		goto vm_fork_failed;
 	      }
@@ -102,12 +114,6 @@ int vm_fork (struct proc *p, struct proc *child_proc)
 	    tmpobj1->next = region->source;
 	    tmpobj2->next = region->source;
 
-	    if (region->source->type == VM_OBJECT_SHADOW)
-	      {
-		region->source->shadow_ref1 = tmpobj1;
-		region->source->shadow_ref2 = tmpobj2;
-	      }
-
 	    /*  The parent should now use the new shadow object 'tmpobj1':  */
 	    region->source = tmpobj1;
 
@@ -156,6 +162,7 @@ if (p->dataregion != region)
 	region = region->next;
       }
 
+    p->vm_busy --;
     return 0;
 
 
@@ -165,13 +172,14 @@ vm_fork_failed:
      *	If vm_fork() fails, it is up to the caller to deallocate any
      *	regions attached to the child process.
      *
-     *	TODO:  of course, if the fork fails and there has already been
-     *	one or more copy-on-write split ups using shadow vm_objects, then
-     *	the parent's vmregions will point to _shadow objects_, when before
-     *	the fork they would have pointed to the actual objects. A "tree
-     *	collapser" needs to be implemented to fix this memory leakage...
+     *	If the fork fails and there has already been one or more
+     *	copy-on-write split ups using shadow vm_objects, then the parent's
+     *	vmregions will point to _shadow objects_, when before the fork they
+     *	would have pointed to the actual objects. These are merged again
+     *	by vm_object_collapse() once the child's regions have been freed.
      */
 
+    p->vm_busy --;
     return ENOMEM;		/*  TODO: is this the best error code?  */
   }
 
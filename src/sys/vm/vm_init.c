@@ -42,13 +42,14 @@
 
 
 size_t default_stack_size = DEFAULT_STACK_SIZE;
-extern struct lockstruct vm_fault_lock;
 
 
 void vm_init ()
   {
-    memset (&vm_fault_lock, 0, sizeof(struct lockstruct));
+    memset (vm_fault_count, 0, sizeof(vm_fault_count));
+    memset (vm_fault_hist, 0, sizeof(vm_fault_hist));
 
+    vm_zero_init ();
     machdep_vm_init ();
   }
 
@@ -33,17 +33,31 @@
  *	vm_object_create ()
  *		Creates an "empty" object.
  *
+ *	vm_object_findpage ()
+ *		Finds a resident page of a vm_object.
+ *
+ *	vm_object_addpage ()
+ *		Inserts a page into a vm_object's page hash table.
+ *
+ *	vm_object_setbusy (), vm_object_unbusy (), vm_object_waitbusy ()
+ *		Busy-page markers, for pages which are being paged in.
+ *
  *	vm_object_freepages ()
  *		Frees pages (from a vm_object) with page_nr within a
  *		specific range.
  *
  *	vm_object_free ()
- *		Removes a vm_object from memory. Calls vm_object_combine()
- *		if neccessary.
+ *		Removes a vm_object from memory.
  *
  *	vm_object_combine ()
  *		Combine two vm_objects.
  *
+ *	vm_object_bypass ()
+ *		Let a shadow object skip a backing object which it covers.
+ *
+ *	vm_object_collapse ()
+ *		Shorten the chain of backing objects of a vm_object.
+ *
  *  History:
  *	8 Jan 2000	first version, vm_object_free()
  *	18 Feb 2000	added vm_object_create()
@@ -51,6 +65,11 @@
  *	7 Mar 2000	adding page chains to vm_objects
  *	17 Jul 2000	vm_object_combine()
  *	26 Jul 2000	vm_object_freepages()
+ *	19 Oct 2026	vm_object_findpage(), vm_object_addpage(),
+ *			busy-page markers
+ *	19 Oct 2026	page hash tables instead of page chains
+ *	19 Oct 2026	shadow chain collapse and bypass
+ *	19 Oct 2026	pages may be on swap, mcb->object
  */
 
 
@@ -70,6 +89,10 @@
 extern struct mcb *first_mcb;		/*  physical addr of first mcb  */
 extern size_t malloc_firstaddr;
 
+/*  Shadow chain statistics:  */
+u_int32_t vm_object_collapses = 0;
+u_int32_t vm_object_bypasses = 0;
+
 
 
 void *vm_anonymous_pagein (int *errno, struct vm_region *vmregion,
@@ -77,10 +100,11 @@ void *vm_anonymous_pagein (int *errno, struct vm_region *vmregion,
   {
     /*
      *	Anonymous memory pagein function:
-     *  Allocate a page and zerofill it.
+     *  Return a zero-filled page, preferably one which the idle loop
+     *	has already cleared.
      */
 
-    void *p = (void *) malloc (PAGESIZE);
+    void *p = (void *) vm_zeropage_alloc ();
     *errno = 0;
 
     if (!p)
@@ -89,7 +113,6 @@ void *vm_anonymous_pagein (int *errno, struct vm_region *vmregion,
 	return NULL;
       }
 
-    memset (p, 0, PAGESIZE);
     return p;
   }
 
@@ -116,6 +139,17 @@ struct vm_object *vm_object_create (int type)
 
     v->type = type;
 
+    /*  Allocate the (initially small) page hash table:  */
+    v->page_hashsize = VM_OBJECT_MINHASHSIZE;
+    v->page_hash = (size_t *) malloc (sizeof(size_t) * v->page_hashsize);
+    if (!v->page_hash)
+      {
+	free (v);
+	return NULL;
+      }
+
+    memset (v->page_hash, 0, sizeof(size_t) * v->page_hashsize);
+
     if (type == VM_OBJECT_FILE)
 	v->pagein = (void *) vnode_pagein;
 
@@ -127,50 +161,361 @@ struct vm_object *vm_object_create (int type)
 
 
 
-int vm_object_freepages (struct vm_object *obj, size_t firstpage, size_t lastpage)
+size_t vm_object_findpage (struct vm_object *obj, size_t page_nr)
   {
     /*
-     *	vm_object_freepages ()
-     *	----------------------
+     *	vm_object_findpage ()
+     *	---------------------
      *
-     *	Free any pages with page_nr in the range firstpage..lastpage, by
-     *	removing the page from the object's page chain and free()'ing it.
+     *	Find the page with page_nr in obj's page hash table. The caller
+     *	should hold obj->lock.
      *
-     *	Returns 0 on success, errno on error.
+     *	Returns the mcb index of the page, or 0 if the page is not resident.
      */
 
-    size_t pageindex;
-    struct mcb *a_mcb, *prev_mcb;
-    byte *addr;
+    size_t mcb_index;
+    struct mcb *a_mcb;
 
-    if (!obj)
-	return EINVAL;
+    mcb_index = obj->page_hash [VM_OBJECT_PAGEHASH(obj, page_nr)];
+    while (mcb_index != 0)
+      {
+	a_mcb = &first_mcb[mcb_index];
+
+	if (a_mcb->size != MCB_VMOBJECT_PAGE)
+	  panic ("vm_object_findpage(): non-vm_object mcbs in vm_object page chain!");
+
+	if (a_mcb->page_nr == page_nr)
+	  return mcb_index;
+
+	mcb_index = a_mcb->next;
+      }
+
+    return 0;
+  }
+
+
+
+void vm_object__rehash (struct vm_object *obj)
+  {
+    /*
+     *	Double the size of obj's page hash table. If there is not enough
+     *	memory for a larger table, we simply keep the old one.
+     */
+
+    size_t *newhash, *oldhash;
+    size_t oldsize, i, mcb_index, next;
+    struct mcb *a_mcb;
+
+    oldhash = obj->page_hash;
+    oldsize = obj->page_hashsize;
 
-    prev_mcb = NULL;
-    pageindex = obj->page_chain_start;
+    newhash = (size_t *) malloc (sizeof(size_t) * oldsize * 2);
+    if (!newhash)
+	return;
+
+    memset (newhash, 0, sizeof(size_t) * oldsize * 2);
+    obj->page_hash = newhash;
+    obj->page_hashsize = oldsize * 2;
+
+    for (i=0; i<oldsize; i++)
+      {
+	mcb_index = oldhash[i];
+	while (mcb_index)
+	  {
+	    a_mcb = &first_mcb[mcb_index];
+	    next = a_mcb->next;
+
+	    a_mcb->next = newhash [VM_OBJECT_PAGEHASH(obj, a_mcb->page_nr)];
+	    newhash [VM_OBJECT_PAGEHASH(obj, a_mcb->page_nr)] = mcb_index;
+
+	    mcb_index = next;
+	  }
+      }
+
+    free (oldhash);
+  }
+
+
+
+void vm_object__insert (struct vm_object *obj, size_t mcb_index)
+  {
+    /*
+     *	Link an mcb (which must already be a MCB_VMOBJECT_PAGE with a
+     *	valid page_nr) into obj's page hash table.
+     */
+
+    struct mcb *a_mcb = &first_mcb[mcb_index];
+    size_t h;
+
+    h = VM_OBJECT_PAGEHASH(obj, a_mcb->page_nr);
+    a_mcb->next = obj->page_hash [h];
+    a_mcb->object = obj;
+    obj->page_hash [h] = mcb_index;
+
+    obj->npages ++;
+
+    if (obj->npages > 2 * obj->page_hashsize &&
+	obj->page_hashsize < VM_OBJECT_MAXHASHSIZE)
+	vm_object__rehash (obj);
+  }
+
+
+
+void vm_object__remove (struct vm_object *obj, size_t mcb_index)
+  {
+    /*
+     *	Unlink an mcb from obj's page hash table. The page itself is
+     *	not freed.
+     */
+
+    struct mcb *a_mcb = &first_mcb[mcb_index];
+    size_t *prev;
+
+    prev = &obj->page_hash [VM_OBJECT_PAGEHASH(obj, a_mcb->page_nr)];
+    while (*prev && *prev != mcb_index)
+	prev = &first_mcb[*prev].next;
+
+    if (!*prev)
+	panic ("vm_object__remove(): page %i not found", a_mcb->page_nr);
+
+    *prev = a_mcb->next;
+    a_mcb->object = NULL;
+    obj->npages --;
+  }
+
+
+
+void vm_object_addpage (struct vm_object *obj, byte *a_page, size_t page_nr)
+  {
+    /*
+     *	vm_object_addpage ()
+     *	--------------------
+     *
+     *	Insert a_page (which must have been allocated using
+     *	malloc(PAGESIZE)) into obj's page hash table, as page number
+     *	page_nr. The caller should hold obj->lock.
+     */
+
+    size_t i;
+    struct mcb *a_mcb;
+
+    i = ((size_t)a_page - malloc_firstaddr) / PAGESIZE;
+    a_mcb = &first_mcb[i];
+
+    if (a_mcb->size != PAGESIZE)
+	panic ("vm_object_addpage(): page wasn't allocated using malloc(%i)", PAGESIZE);
+
+    a_mcb->size = MCB_VMOBJECT_PAGE;
+    a_mcb->bitmap = 0;
+    a_mcb->page_nr = page_nr;
+
+    vm_object__insert (obj, i);
+  }
+
+
+
+struct vm_busypage *vm_object_findbusy (struct vm_object *obj, size_t page_nr)
+  {
+    /*
+     *	Return the busy-page marker for page_nr in obj, or NULL if the page
+     *	is not being paged in.
+     */
+
+    struct vm_busypage *b;
+
+    b = obj->busy_pages;
+    while (b)
+      {
+	if (b->page_nr == page_nr)
+	  return b;
+	b = b->next;
+      }
+
+    return NULL;
+  }
+
+
+
+int vm_object_setbusy (struct vm_object *obj, size_t page_nr)
+  {
+    /*
+     *	vm_object_setbusy ()
+     *	--------------------
+     *
+     *	Mark page_nr in obj as "busy", ie. it is being paged in by someone
+     *	who doesn't hold obj->lock during the I/O. Others who fault on the
+     *	same page should then call vm_object_waitbusy() instead of paging
+     *	in the page themselves. The caller should hold obj->lock.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    struct vm_busypage *b;
+
+    b = (struct vm_busypage *) malloc (sizeof(struct vm_busypage));
+    if (!b)
+	return ENOMEM;
+
+    b->page_nr = page_nr;
+    b->waiting = 0;
+    b->next = obj->busy_pages;
+    obj->busy_pages = b;
+
+    return 0;
+  }
+
+
+
+void vm_object_unbusy (struct vm_object *obj, size_t page_nr)
+  {
+    /*
+     *	vm_object_unbusy ()
+     *	-------------------
+     *
+     *	Remove the busy-page marker for page_nr, and wake up anyone waiting
+     *	for it. The caller should hold obj->lock.
+     */
+
+    struct vm_busypage *b, *prev;
+    int waiting;
+
+    prev = NULL;
+    b = obj->busy_pages;
+    while (b)
+      {
+	if (b->page_nr == page_nr)
+	  {
+	    if (prev)
+	      prev->next = b->next;
+	    else
+	      obj->busy_pages = b->next;
+
+	    waiting = b->waiting;
+	    free (b);
+
+	    /*  (b is only used as a sleep address by the waiters)  */
+	    if (waiting)
+	      wakeup (b);
+	    return;
+	  }
+
+	prev = b;
+	b = b->next;
+      }
+
+    panic ("vm_object_unbusy(): page %i was not busy", page_nr);
+  }
+
+
+
+void vm_object_waitbusy (struct vm_object *obj, struct vm_busypage *b)
+  {
+    /*
+     *	vm_object_waitbusy ()
+     *	---------------------
+     *
+     *	Unlock obj->lock and sleep until the busy page b has been paged in.
+     *	The caller must hold obj->lock (read or write), and should look up
+     *	the page again when we return.
+     */
+
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    b->waiting ++;
+    unlock (&obj->lock);
+
+    /*
+     *	Interrupts are still disabled, so vm_object_unbusy() can't run
+     *	(it needs obj->lock) before we have gone to sleep:
+     */
+
+    sleep (b, "vm_busypage");
+
+    interrupts (oldints);
+  }
+
+
+
+void vm_object__freebucket (struct vm_object *obj, size_t h,
+	size_t firstpage, size_t lastpage)
+  {
+    /*
+     *	Free pages with page_nr in the range firstpage..lastpage from
+     *	one of obj's hash chains.
+     */
+
+    size_t pageindex, *prev;
+    struct mcb *a_mcb;
+    byte *addr;
+
+    prev = &obj->page_hash [h];
+    pageindex = *prev;
     while (pageindex)
       {
 	a_mcb = &first_mcb[pageindex];
 	if (a_mcb->size != MCB_VMOBJECT_PAGE)
 	  panic ("vm_object_free: inconsist vmobj page size");
 
-	addr = (byte *) (malloc_firstaddr+PAGESIZE*pageindex);
-
-	/*  Remember mcb index to the next page in this chain:  */
-	pageindex = a_mcb->next;
-
 	if (a_mcb->page_nr >= firstpage && a_mcb->page_nr <= lastpage)
 	  {
-	    if (!prev_mcb)
-	      obj->page_chain_start = a_mcb->next;
-	    else
-	      prev_mcb->next = a_mcb->next;
+	    *prev = a_mcb->next;
+	    obj->npages --;
 
 	    /*  Free the page:  (this also clears the mcb data)  */
+	    addr = (byte *) (malloc_firstaddr+PAGESIZE*pageindex);
 	    free (addr);
 	  }
 	else
-	  prev_mcb = a_mcb;
+	  prev = &a_mcb->next;
+
+	pageindex = *prev;
+      }
+  }
+
+
+
+int vm_object_freepages (struct vm_object *obj, size_t firstpage, size_t lastpage)
+  {
+    /*
+     *	vm_object_freepages ()
+     *	----------------------
+     *
+     *	Free any pages with page_nr in the range firstpage..lastpage, by
+     *	removing the page from the object's page hash table and free()'ing
+     *	it.
+     *
+     *	If the range is smaller than the hash table, only the hash chains
+     *	of the pages in the range are scanned. Otherwise, all hash chains
+     *	are scanned once. Pages in the range which are on swap are freed
+     *	as well.
+     *
+     *	Returns 0 on success, errno on error.
+     */
+
+    size_t page_nr, h;
+
+    if (!obj || lastpage < firstpage)
+	return EINVAL;
+
+    if (obj->nswapped)
+	vm_swap_freepages (obj, firstpage, lastpage);
+
+    if (lastpage - firstpage < obj->page_hashsize)
+      {
+	for (page_nr=firstpage; obj->npages > 0; page_nr++)
+	  {
+	    vm_object__freebucket (obj, VM_OBJECT_PAGEHASH(obj, page_nr),
+		firstpage, lastpage);
+	    if (page_nr == lastpage)
+		break;
+	  }
+      }
+    else
+      {
+	for (h=0; h<obj->page_hashsize && obj->npages > 0; h++)
+	    vm_object__freebucket (obj, h, firstpage, lastpage);
       }
 
     return 0;
@@ -188,7 +533,6 @@ int vm_object_free (struct vm_object *obj)
      */
 
     int oldints;
-    struct vm_object *object3;
 
 
     if (!obj)
@@ -205,43 +549,30 @@ int vm_object_free (struct vm_object *obj)
 	return 1;
       }
 
-
     /*
-     *	A shadow object (object1 in the picture below) points to another
-     * 	object (object2). If there is no object3, then object2 should also
-     *	be freed. Otherwise we should combine object2 and object3 into one.
-     *
-     *		object1  ---\
-     *			     \
-     *			      >---  object2
-     *			     /
-     *		object3  ---/
-     *
-     *	The pages belonging to object1 will be freed (later in this
-     *	function), but if we don't combine object2 and object3 there
-     *	might be duplicate pages somewhere which would waste memory.
-     *	Therefore, they should be combined into one object.
+     *	If the pageout daemon is writing one of the object's pages to
+     *	swap, then it frees the object when it is done.
      */
 
-    if (obj->next)
+    if (obj->busy_pages)
       {
-printk ("()()() refcount=%i vnode=%x type=%i nexttype=%i nextvnode=%x",
-	obj->refcount, obj->vnode, obj->type, obj->next->type,
-	obj->next->vnode);
+	unlock (&obj->lock);
+	return 1;
+      }
 
-	if (obj->next->refcount == 2  &&
-		obj->next->type == VM_OBJECT_SHADOW)
-	  {
-	    object3 = obj->next->shadow_ref1;
-	    if (object3 == obj)
-	      object3 = obj->next->shadow_ref2;
 
-	    vm_object_combine (obj->next, object3);
-	  }
-	else
-	  /*  Recursively free the referenced object:  */
-	  vm_object_free (obj->next);
-      }
+    /*
+     *	A shadow object points to another object (its backing object),
+     *	whose refcount we decrease. If that leaves the backing object with
+     *	only one referer, then that referer will merge the backing object
+     *	into itself (using vm_object_collapse()) the next time it faults
+     *	or forks. This cannot be done from here, since the remaining
+     *	referer may belong to another process which is walking the chain
+     *	right now.
+     */
+
+    if (obj->next)
+	vm_object_free (obj->next);
 
     /*  If the object was a file object, then let's decrease the refcount
 	of the vnode the object used:  */
@@ -285,7 +616,10 @@ printk ("()()() refcount=%i vnode=%x type=%i nexttype=%i nextvnode=%x",
      */
 
     if (!obj->vnode)
-      free (obj);
+      {
+	free (obj->page_hash);
+	free (obj);
+      }
 
     return 1;
   }
@@ -299,7 +633,8 @@ int vm_object_combine (struct vm_object *subobj, struct vm_object *newobj)
      *	-----------------
      *
      *	Combine objects subobj and newobj, and then free subobj (including
-     *	pages). This algorithm is used:
+     *	pages). newobj must be the only referer of subobj. This algorithm
+     *	is used:
      *
      *	    For each page in subobj
      *		which is not found in newobj:
@@ -307,78 +642,81 @@ int vm_object_combine (struct vm_object *subobj, struct vm_object *newobj)
      *		which is found in newobj:
      *			free the page
      *
+     *	    Let newobj point to whatever subobj pointed to. If subobj
+     *	    was the last (anonymous) object in the chain, then newobj
+     *	    becomes an anonymous object.
+     *
      *	    Free subobj itself.
      *
      *
-     *	Returns 0 on success, errno on error.
+     *	Returns 0 on success, errno on error.  (EBUSY if subobj has other
+     *	referers, or pages which are being paged in.)
      */
 
     struct mcb *a_mcb;
-    struct mcb *new_mcb;
     byte *addr;
-    size_t pageindex, newpageindex, foundindex, tmp;
-    size_t page_nr;
+    size_t pageindex, h, next;
 
 
     if (!subobj || !newobj)
 	return EINVAL;
 
     if (newobj->next != subobj || newobj->type != VM_OBJECT_SHADOW
-	  || subobj->type != VM_OBJECT_SHADOW)
+	  || subobj->type == VM_OBJECT_FILE)
 	panic ("vm_object_combine: vm_object chain is corrupt");
 
     lock (&newobj->lock, "vm_object_combine", LOCK_BLOCKING | LOCK_RW);
     lock (&subobj->lock, "vm_object_combine", LOCK_BLOCKING | LOCK_RW);
 
-    /*  Go through all of subobj's pages:  */
-    pageindex = subobj->page_chain_start;
-    while (pageindex)
+    if (subobj->refcount != 1 || subobj->busy_pages)
       {
-	a_mcb = &first_mcb[pageindex];
-	page_nr = a_mcb->page_nr;
-	addr = (byte *) (malloc_firstaddr+PAGESIZE*pageindex);
+	unlock (&subobj->lock);
+	unlock (&newobj->lock);
+	return EBUSY;
+      }
 
-	/*  Try to find the page "page_nr" in the newobj pages:  */
-	newpageindex = newobj->page_chain_start;
-	foundindex = 0;
-	while (newpageindex)
-	  {
-	    new_mcb = &first_mcb[newpageindex];
-	    if (page_nr == new_mcb->page_nr)
-	      {
-		foundindex = newpageindex;
-		newpageindex = 0;
-	      }
-	    else
-		newpageindex = new_mcb->next;
-	  }
-	/*  Was it not found? Then move it from subobj to newobj:  */
-	tmp = a_mcb->next;
-	if (foundindex==0)
-	  {
-	    a_mcb->next = newobj->page_chain_start;
-	    newobj->page_chain_start = pageindex;
-	    pageindex = tmp;
-	  }
-	else
+    /*  Go through all of subobj's pages:  */
+    for (h=0; h<subobj->page_hashsize; h++)
+      {
+	pageindex = subobj->page_hash [h];
+	while (pageindex)
 	  {
-	    pageindex = tmp;
-	    /*  Free the page...  */
+	    a_mcb = &first_mcb[pageindex];
+	    next = a_mcb->next;
+
 	    if (a_mcb->size != MCB_VMOBJECT_PAGE)
 	      panic ("vm_object_combine: inconsistent vmobj page size");
-	    free (addr);
+
+	    /*  Move the page to newobj, or free it if newobj has it:  */
+	    if (!vm_object_findpage (newobj, a_mcb->page_nr) &&
+		!(newobj->nswapped && vm_swap_lookup (newobj, a_mcb->page_nr)))
+		vm_object__insert (newobj, pageindex);
+	    else
+	      {
+		addr = (byte *) (malloc_firstaddr+PAGESIZE*pageindex);
+		free (addr);
+	      }
+
+	    pageindex = next;
 	  }
       }
 
+    /*  ... and the same for pages on swap:  */
+    if (subobj->nswapped)
+	vm_swap_moveobj (subobj, newobj);
 
-    /*  Free subobj:  */
+    /*  Take over subobj's place in the chain:  */
     newobj->next = subobj->next;
+    newobj->ncopied = 0;
+    if (!newobj->next)
+      {
+	newobj->type = subobj->type;
+	newobj->pagein = subobj->pagein;
+      }
 
-    if (subobj->next->shadow_ref1 == subobj)
-	subobj->next->shadow_ref1 = newobj;
-    if (subobj->next->shadow_ref2 == subobj)
-	subobj->next->shadow_ref2 = newobj;
-
+    /*  Free subobj:  (its reference to ->next now belongs to newobj)  */
+    unlock (&subobj->lock);
+    free (subobj->page_hash);
     free (subobj);
 
     unlock (&newobj->lock);
@@ -387,3 +725,142 @@ int vm_object_combine (struct vm_object *subobj, struct vm_object *newobj)
   }
 
 
+
+int vm_object__covers (struct vm_object *obj, struct vm_object *backing)
+  {
+    /*
+     *	Returns 1 if every page of backing (resident or on swap) is also
+     *	in obj, 0 otherwise. The caller should hold both locks.
+     */
+
+    size_t pageindex, h, page_nr;
+
+    for (h=0; h<backing->page_hashsize; h++)
+      {
+	pageindex = backing->page_hash [h];
+	while (pageindex)
+	  {
+	    page_nr = first_mcb[pageindex].page_nr;
+	    if (!vm_object_findpage (obj, page_nr) &&
+		!(obj->nswapped && vm_swap_lookup (obj, page_nr)))
+		return 0;
+	    pageindex = first_mcb[pageindex].next;
+	  }
+      }
+
+    if (backing->nswapped)
+	return vm_swap_covered (obj, backing);
+
+    return 1;
+  }
+
+
+
+int vm_object_bypass (struct vm_object *obj)
+  {
+    /*
+     *	vm_object_bypass ()
+     *	-------------------
+     *
+     *	If every resident page of obj's backing object (obj->next) is
+     *	also resident in obj, then a fault in obj can never end up using
+     *	a page from the backing object. Instead of walking through the
+     *	backing object on every fault, obj is made to point directly to
+     *	whatever the backing object points to, and our reference to the
+     *	backing object is dropped. This works even if the backing object
+     *	has other referers.
+     *
+     *	Returns 0 on success, errno on error.  (EBUSY if the backing
+     *	object is not completely covered by obj.)
+     */
+
+    struct vm_object *backing, *newnext;
+
+    if (!obj || !obj->next)
+	return EINVAL;
+
+    backing = obj->next;
+    if (backing->type == VM_OBJECT_FILE || obj->type != VM_OBJECT_SHADOW)
+	return EINVAL;
+
+    lock (&obj->lock, "vm_object_bypass", LOCK_BLOCKING | LOCK_RW);
+    lock (&backing->lock, "vm_object_bypass", LOCK_BLOCKING | LOCK_RO);
+
+    if (backing->busy_pages || !vm_object__covers (obj, backing))
+      {
+	/*  Don't try again until more pages have been copied up:  */
+	obj->ncopied = 0;
+	unlock (&backing->lock);
+	unlock (&obj->lock);
+	return EBUSY;
+      }
+
+    newnext = backing->next;
+    if (newnext)
+      {
+	lock (&newnext->lock, "vm_object_bypass", LOCK_BLOCKING | LOCK_RW);
+	newnext->refcount ++;
+	unlock (&newnext->lock);
+      }
+    else
+      {
+	obj->type = backing->type;
+	obj->pagein = backing->pagein;
+      }
+
+    obj->next = newnext;
+    obj->ncopied = 0;
+
+    unlock (&backing->lock);
+    unlock (&obj->lock);
+
+    vm_object_free (backing);
+    return 0;
+  }
+
+
+
+void vm_object_collapse (struct vm_object *obj)
+  {
+    /*
+     *	vm_object_collapse ()
+     *	---------------------
+     *
+     *	Make the chain of backing objects below obj as short as possible:
+     *
+     *	    o)	If obj is the only referer of its backing object, then
+     *		the backing object is merged into obj.
+     *
+     *	    o)	If obj covers all of the backing object's resident pages,
+     *		then the backing object is bypassed.
+     *
+     *	This is repeated until neither is possible. The caller must be
+     *	the only user of obj (obj->refcount == 1), so that nobody else
+     *	can be walking obj's chain while it is being modified. FILE
+     *	objects are never merged or bypassed.
+     */
+
+    struct vm_object *backing;
+
+    if (!obj || obj->refcount != 1)
+	return;
+
+    while (obj->type == VM_OBJECT_SHADOW && (backing = obj->next)
+	   && backing->type != VM_OBJECT_FILE)
+      {
+	if (backing->refcount == 1)
+	  {
+	    if (vm_object_combine (backing, obj))
+		return;
+	    vm_object_collapses ++;
+	  }
+	else
+	  {
+	    /*  Only scan for coverage when it is at all possible:  */
+	    if (obj->ncopied < backing->npages || vm_object_bypass (obj))
+		return;
+	    vm_object_bypasses ++;
+	  }
+      }
+  }
+
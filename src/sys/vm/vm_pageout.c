@@ -0,0 +1,457 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  vm/vm_pageout.c  --  the pageout daemon
+ *
+ *	When malloc() sees free memory drop below malloc_lowwater, it wakes
+ *	up the pageout daemon, a kernel thread which frees pages until
+ *	there are VM_PAGEOUT_HIGHWATER bytes free:
+ *
+ *	    o)	Pages of file vm_objects which are not used by any region
+ *		(the vnode "buffer cache") are simply dropped, using a
+ *		CLOCK scan over the MCB array. Pages which have been used
+ *		since the last scan (VM_PAGE_REFERENCED) get a second chance.
+ *		Dirty pages (written through shared file mappings) are
+ *		written back to their files first.
+ *
+ *	    o)	Pages of anonymous and shadow objects are written to swap
+ *		(see vm/vm_swap.c). Only top-level objects which are used
+ *		by a single region are considered, since there is no way to
+ *		find all mappings of a page. Pages whose PTEs have the
+ *		accessed bit set get a second chance.
+ *
+ *	Before anything is written to swap, programs are released from the
+ *	exec cache (kern/exec_cache.c) one at a time, so that their pages
+ *	can be dropped by the CLOCK scan.
+ *
+ *	Processes which run out of memory in vm_fault() can call
+ *	vm_pageout_wait() to wait for a pageout pass.
+ *
+ *	vm_pageout_init ()
+ *		Initialize swap, and start the pageout daemon.
+ *
+ *	vm_pageout_wait ()
+ *		Wait for the pageout daemon to free some memory.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ *	19 Oct 2026	shrink the exec cache before swapping
+ *	19 Oct 2026	write back dirty pages of shared file mappings
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/errno.h>
+#include <sys/lock.h>
+#include <sys/proc.h>
+#include <sys/md/proc.h>
+#include <sys/vm.h>
+#include <sys/emul.h>
+
+
+extern volatile struct proc *procqueue [PROC_MAXQUEUES];
+extern volatile struct proc *curproc;
+
+extern struct mcb *first_mcb;
+extern size_t nr_of_mcbs;
+extern size_t malloc_firstaddr;
+
+struct proc *vm_pageout_proc = NULL;	/*  the daemon itself  */
+
+size_t vm_pageout_hand = 0;		/*  CLOCK hand (mcb index)  */
+pid_t vm_pageout_lastpid = 0;		/*  last process swapped from  */
+
+volatile int vm_pageout_waiters = 0;
+volatile size_t vm_pageout_freed = 0;	/*  nr of pages freed by last pass  */
+
+/*  Statistics:  */
+u_int32_t vm_pageout_passes = 0;
+u_int32_t vm_pageout_reclaimed = 0;
+
+
+
+size_t vm_pageout__clock ()
+  {
+    /*
+     *	vm_pageout__clock ()
+     *	--------------------
+     *
+     *	Drop unreferenced pages of file vm_objects which aren't used by
+     *	any region (refcount 0). Such pages aren't mapped anywhere, so
+     *	they can be freed as soon as the object lock is free. At most two
+     *	full turns of the hand are made. Returns the nr of pages freed.
+     */
+
+    struct mcb *a_mcb;
+    struct vm_object *obj;
+    size_t n, freed = 0;
+    int oldints;
+
+    for (n=0; n<2*nr_of_mcbs; n++)
+      {
+	if (malloc_totalfreememory >= VM_PAGEOUT_HIGHWATER)
+	    break;
+
+	if (++vm_pageout_hand >= nr_of_mcbs)
+	    vm_pageout_hand = 1;
+
+	oldints = interrupts (DISABLE);
+
+	a_mcb = &first_mcb[vm_pageout_hand];
+	obj = a_mcb->object;
+
+	if (a_mcb->size != MCB_VMOBJECT_PAGE || !obj
+	    || obj->type != VM_OBJECT_FILE || obj->refcount > 0
+	    || (a_mcb->bitmap & (VM_PAGE_DIRTY | VM_PAGE_WRITEBACK)))
+	  {
+	    interrupts (oldints);
+	    continue;
+	  }
+
+	if (a_mcb->bitmap & VM_PAGE_REFERENCED)
+	  {
+	    a_mcb->bitmap &= ~VM_PAGE_REFERENCED;
+	    interrupts (oldints);
+	    continue;
+	  }
+
+	if (lock (&obj->lock, "vm_pageout", LOCK_NONBLOCKING |
+	    LOCK_NOINTERRUPTS | LOCK_RW) < 0)
+	  {
+	    interrupts (oldints);
+	    continue;
+	  }
+
+	vm_object__remove (obj, vm_pageout_hand);
+	unlock (&obj->lock);
+	free ((void *) (malloc_firstaddr + PAGESIZE*vm_pageout_hand));
+
+	interrupts (oldints);
+
+	vm_pageout_reclaimed ++;
+	freed ++;
+      }
+
+    return freed;
+  }
+
+
+
+struct proc *vm_pageout__nextproc ()
+  {
+    /*
+     *	Returns the process with the lowest pid above vm_pageout_lastpid
+     *	which we may take pages from, or NULL if there is none.
+     *	Interrupts should be disabled.
+     */
+
+    struct proc *p, *best = NULL;
+    int i;
+
+    for (i=0; i<PROC_MAXQUEUES; i++)
+      {
+	p = (struct proc *) procqueue [i];
+	if (!p)
+	    continue;
+
+	do
+	  {
+	    if (p->pid > vm_pageout_lastpid && (!best || p->pid < best->pid)
+		&& !(p->flags & PFLAG_KTHREAD) && p->status != P_ZOMBIE
+		&& p != curproc && !p->vm_busy && p->vmregions)
+		best = p;
+
+	    p = p->next;
+	  } while (p != (struct proc *) procqueue[i]);
+      }
+
+    return best;
+  }
+
+
+
+int vm_pageout__swapout ()
+  {
+    /*
+     *	vm_pageout__swapout ()
+     *	----------------------
+     *
+     *	Write one anonymous page to swap, and free it. Processes are
+     *	visited in pid order. A page is chosen from a region whose object
+     *	is not shared with anyone else, so the region's PTE is its only
+     *	mapping.
+     *
+     *	The page is removed from its object before the object is unlocked,
+     *	with a busy-page marker in its place. A fault on the page will wait
+     *	for the write to finish, and then find the page on swap.
+     *
+     *	Returns 1 if a page was freed, 0 otherwise.
+     */
+
+    struct vm_swapent *e;
+    struct vm_region *region;
+    struct vm_object *obj = NULL;
+    struct mcb *a_mcb;
+    struct proc *p;
+    size_t slot, h, pageindex, page_nr = 0, v, victim = 0;
+    int oldints, wraps, res;
+
+    if (vm_swap_alloc (&slot))
+	return 0;
+
+    e = (struct vm_swapent *) malloc (sizeof(struct vm_swapent));
+    if (!e)
+      {
+	vm_swap_free (slot);
+	return 0;
+      }
+
+    oldints = interrupts (DISABLE);
+
+    for (wraps=0; wraps<2 && !victim; )
+      {
+	p = vm_pageout__nextproc ();
+	if (!p)
+	  {
+	    vm_pageout_lastpid = 0;
+	    wraps ++;
+	    continue;
+	  }
+
+	vm_pageout_lastpid = p->pid;
+
+	for (region=p->vmregions; region && !victim; region=region->next)
+	  {
+	    obj = region->source;
+	    if (!obj || obj->type == VM_OBJECT_FILE || obj->refcount != 1
+		|| !obj->npages)
+		continue;
+
+	    if (lock (&obj->lock, "vm_pageout", LOCK_NONBLOCKING |
+		LOCK_NOINTERRUPTS | LOCK_RW) < 0)
+		continue;
+
+	    for (h=0; h<obj->page_hashsize && !victim; h++)
+	      for (pageindex=obj->page_hash[h]; pageindex;
+		   pageindex=first_mcb[pageindex].next)
+		{
+		  page_nr = first_mcb[pageindex].page_nr;
+		  v = region->start_addr + page_nr*PAGESIZE - region->srcoffset;
+
+		  /*  Recently used? Then give it a second chance.  */
+		  if (page_nr*PAGESIZE >= region->srcoffset &&
+		      v >= region->start_addr && v <= region->end_addr &&
+		      pmap_referenced (p, v))
+			continue;
+
+		  victim = pageindex;
+		  break;
+		}
+
+	    if (!victim)
+	      {
+		unlock (&obj->lock);
+		continue;
+	      }
+
+	    if (vm_object_setbusy (obj, page_nr))
+	      {
+		victim = 0;
+		unlock (&obj->lock);
+		break;
+	      }
+
+	    vm_object__remove (obj, victim);
+
+	    v = region->start_addr + page_nr*PAGESIZE - region->srcoffset;
+	    if (page_nr*PAGESIZE >= region->srcoffset &&
+		v >= region->start_addr && v <= region->end_addr)
+		pmap_unmappages (p, v, v + PAGESIZE - 1);
+
+	    unlock (&obj->lock);
+	  }
+      }
+
+    interrupts (oldints);
+
+    if (!victim)
+      {
+	free (e);
+	vm_swap_free (slot);
+	return 0;
+      }
+
+
+    /*  Write the page, and put it in the swap hash table:  */
+    res = vm_swap_io (slot, (byte *) (malloc_firstaddr + PAGESIZE*victim), 1);
+
+    lock (&obj->lock, "vm_pageout", LOCK_BLOCKING | LOCK_RW);
+
+    if (!res)
+	vm_swap_enter (obj, e, page_nr, slot);
+    else
+      {
+	/*  Put the page back:  */
+	a_mcb = &first_mcb[victim];
+	a_mcb->page_nr = page_nr;
+	vm_object__insert (obj, victim);
+      }
+
+    vm_object_unbusy (obj, page_nr);
+
+    /*  The object's last referer may have gone away during the write:  */
+    if (obj->refcount <= 0 && !obj->busy_pages)
+      {
+	unlock (&obj->lock);
+	obj->refcount = 1;
+	vm_object_free (obj);
+      }
+    else
+	unlock (&obj->lock);
+
+    if (res)
+      {
+	printk ("vm_pageout: swap write error %i (slot %i)", res, slot);
+	free (e);
+	vm_swap_free (slot);
+	return 0;
+      }
+
+    free ((void *) (malloc_firstaddr + PAGESIZE*victim));
+    vm_swap_outs ++;
+    return 1;
+  }
+
+
+
+void vm_pageout_daemon ()
+  {
+    /*
+     *	vm_pageout_daemon ()
+     *	--------------------
+     *
+     *	The pageout daemon's main loop. It starts out asleep, and is
+     *	woken up by malloc() when free memory runs low.
+     */
+
+    size_t freed;
+    int oldints;
+
+    for (;;)
+      {
+	vm_pageout_passes ++;
+
+	freed = vm_pageout__clock ();
+
+	if (malloc_totalfreememory < VM_PAGEOUT_HIGHWATER &&
+	    vm_writeback_dirty (VM_WRITEBACK_BATCH))
+	    freed += vm_pageout__clock ();
+
+	while (malloc_totalfreememory < VM_PAGEOUT_HIGHWATER &&
+	       exec_cache_shrink ())
+	    freed += vm_pageout__clock ();
+
+	while (malloc_totalfreememory < VM_PAGEOUT_HIGHWATER &&
+	       vm_pageout__swapout ())
+	    freed ++;
+
+	oldints = interrupts (DISABLE);
+
+	vm_pageout_freed = freed;
+	if (vm_pageout_waiters)
+	    wakeup ((void *) &vm_pageout_waiters);
+	malloc_lowwater_woken = 0;
+
+	/*  Sleep, unless memory is still low and we are making progress:  */
+	if (!freed || malloc_totalfreememory >= malloc_lowwater)
+	    sleep (&malloc_lowwater, "pageout");
+
+	interrupts (oldints);
+      }
+  }
+
+
+
+int vm_pageout_wait ()
+  {
+    /*
+     *	vm_pageout_wait ()
+     *	------------------
+     *
+     *	Wake up the pageout daemon, and wait for it to finish a pass.
+     *	The caller should not hold any vm_object locks.
+     *
+     *	Returns 0 if the daemon freed some memory (and the caller should
+     *	try again), ENOMEM otherwise.
+     */
+
+    int oldints, res;
+
+    if (!vm_pageout_proc || curproc == vm_pageout_proc)
+	return ENOMEM;
+
+    oldints = interrupts (DISABLE);
+
+    vm_pageout_waiters ++;
+    malloc_lowwater_woken = 1;
+    wakeup (&malloc_lowwater);
+    sleep ((void *) &vm_pageout_waiters, "memwait");
+    vm_pageout_waiters --;
+
+    res = vm_pageout_freed? 0 : ENOMEM;
+
+    interrupts (oldints);
+    return res;
+  }
+
+
+
+void vm_pageout_init ()
+  {
+    /*
+     *	vm_pageout_init ()
+     *	------------------
+     *
+     *	Find the swap device, and create the pageout daemon. It sleeps
+     *	until free memory drops below VM_PAGEOUT_LOWWATER.
+     */
+
+    vm_swap_init ();
+
+    vm_pageout_proc = proc_kthread_create (vm_pageout_daemon,
+	&malloc_lowwater, "pageout");
+    if (!vm_pageout_proc)
+      {
+	printk ("vm_pageout_init(): could not create the pageout daemon");
+	return;
+      }
+
+    malloc_lowwater = VM_PAGEOUT_LOWWATER;
+  }
@@ -43,7 +43,8 @@
  *	vm_region_detach ()
  *		Detach a vm_object from a process' vm_region chain.
  *		Decreases the vm_object's refcount (by calling
- *		vm_object_free()).
+ *		vm_object_free()). Dirty pages of shared file regions
+ *		are written back first.
  *
  *	vm_region_findfree ()
  *		Find a free memory area with as high address as possible.
@@ -56,6 +57,9 @@
  *	20 Jan 2000	removing vm_region_init(), since it didn't do
  *			anything
  *	19 Jul 2000	adding vm_region_findfree()
+ *	19 Oct 2026	p->vm_busy keeps the pageout daemon away while
+ *			the region chain is being modified
+ *	19 Oct 2026	write back shared file regions on detach
  */
 
 
@@ -104,6 +108,8 @@ if (type==9)
     region->source = obj;
     region->srcoffset = objoffset;
 
+    p->vm_busy ++;
+
     /*  Let's tell the object that we are using it:  */
     obj->refcount ++;
 
@@ -113,6 +119,7 @@ if (type==9)
 	region->next->prev = region;
     p->vmregions = region;
 
+    p->vm_busy --;
     return 1;
   }
 
@@ -154,6 +161,11 @@ int vm_region_detach (struct proc *p, size_t start_addr)
     if (!tmp)
 	return 0;
 
+    p->vm_busy ++;
+
+    /*  Changes made through a shared file mapping go to the file:  */
+    vm_writeback_region (tmp, tmp->start_addr, tmp->end_addr);
+
     /*  We are not using the source vm_object anymore:  */
     vm_object_free (tmp->source);
 
@@ -166,6 +178,7 @@ int vm_region_detach (struct proc *p, size_t start_addr)
     if (tmp == p->vmregions)
       p->vmregions = tmp->next;
 
+    p->vm_busy --;
     free (tmp);
 
     return 1;
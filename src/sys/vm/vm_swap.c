@@ -0,0 +1,498 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  vm/vm_swap.c  --  swap pager
+ *
+ *	Pages of anonymous and shadow vm_objects can be paged out to a
+ *	swap device by the pageout daemon (see vm/vm_pageout.c). The swap
+ *	device (VM_SWAPDEVICE in config.h) is divided into page sized
+ *	slots, and a bitmap keeps track of which slots are in use.
+ *
+ *	Which pages are on swap is remembered in one global hash table of
+ *	vm_swapent structs, hashed on page_nr, so vm_objects only need a
+ *	counter (obj->nswapped). The hash table and the slot bitmap are
+ *	protected by disabling interrupts; the pages' vm_objects should
+ *	be locked by the caller.
+ *
+ *	vm_swap_init ()
+ *		Find the swap device, and allocate the slot bitmap.
+ *
+ *	vm_swap_alloc (), vm_swap_free ()
+ *		Allocate and free swap slots.
+ *
+ *	vm_swap_io ()
+ *		Read or write one page.
+ *
+ *	vm_swap_lookup (), vm_swap_enter ()
+ *		Find or add the swap slot of a vm_object's page.
+ *
+ *	vm_swap_freepages ()
+ *		Forget about (and free the slots of) a range of pages.
+ *
+ *	vm_swap_moveobj (), vm_swap_covered ()
+ *		Used by vm_object_combine() and vm_object_bypass().
+ *
+ *	vm_swapin ()
+ *		Bring a page back from swap. Called by vm_fault().
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ *	19 Oct 2026	event trace points around swap device I/O
+ *	19 Oct 2026	the swap device is found with device_lookup()
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/errno.h>
+#include <sys/device.h>
+#include <sys/proc.h>
+#include <sys/vm.h>
+#include <sys/evtrace.h>
+
+struct device *vm_swapdev = NULL;
+size_t vm_swap_nslots = 0;		/*  0 = no swap  */
+size_t vm_swap_used = 0;
+
+byte *vm_swapmap = NULL;		/*  one bit per slot  */
+size_t vm_swap_hint = 0;		/*  where to start looking  */
+
+struct vm_swapent *vm_swap_hash [VM_SWAP_HASHSIZE];
+
+#define	VM_SWAP_HASH(page_nr)	((page_nr) & (VM_SWAP_HASHSIZE - 1))
+
+/*  Statistics:  */
+u_int32_t vm_swap_ins = 0;
+u_int32_t vm_swap_outs = 0;
+
+
+
+void vm_swap_init ()
+  {
+    /*
+     *	vm_swap_init ()
+     *	---------------
+     *
+     *	Find the swap device. This must be called after the device drivers
+     *	have registered their devices. If there is no usable swap device,
+     *	then anonymous pages are simply never paged out.
+     */
+
+    struct device *d;
+    size_t len;
+
+    memset (vm_swap_hash, 0, sizeof(vm_swap_hash));
+
+    d = device_lookup (VM_SWAPDEVICE);
+
+    if (!d)
+      {
+	printk ("vm: no swap device (%s not found)", VM_SWAPDEVICE);
+	return;
+      }
+
+    if (d->type != DEVICETYPE_BLOCK || !d->read || !d->write ||
+	!d->bsize || (PAGESIZE % d->bsize))
+      {
+	printk ("vm: %s can not be used for swap", d->name);
+	return;
+      }
+
+    len = (VM_SWAPPAGES + 7) / 8;
+    vm_swapmap = (byte *) malloc (len);
+    if (!vm_swapmap)
+      {
+	printk ("vm_swap_init(): out of memory");
+	return;
+      }
+
+    memset (vm_swapmap, 0, len);
+    vm_swapdev = d;
+    vm_swap_nslots = VM_SWAPPAGES;
+
+    printk ("vm: swapping to %s, %i KB", d->name,
+	(int) (vm_swap_nslots * (PAGESIZE / 1024)));
+  }
+
+
+
+int vm_swap_alloc (size_t *slot)
+  {
+    /*
+     *	Allocate a swap slot. Slot numbers start at 1.
+     *	Returns 0 on success, errno on failure.
+     */
+
+    size_t i, n;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    if (vm_swap_used >= vm_swap_nslots)
+      {
+	interrupts (oldints);
+	return ENOSPC;
+      }
+
+    i = vm_swap_hint;
+    for (n=0; n<vm_swap_nslots; n++)
+      {
+	if (i >= vm_swap_nslots)
+	    i = 0;
+
+	if (!(vm_swapmap[i/8] & (1 << (i&7))))
+	  {
+	    vm_swapmap[i/8] |= (1 << (i&7));
+	    vm_swap_used ++;
+	    vm_swap_hint = i+1;
+	    interrupts (oldints);
+
+	    *slot = i+1;
+	    return 0;
+	  }
+
+	i++;
+      }
+
+    interrupts (oldints);
+    return ENOSPC;
+  }
+
+
+
+void vm_swap_free (size_t slot)
+  {
+    /*
+     *	Free a swap slot.
+     */
+
+    int oldints;
+
+    if (slot < 1 || slot > vm_swap_nslots)
+	panic ("vm_swap_free(): bad slot %i", slot);
+
+    slot --;
+
+    oldints = interrupts (DISABLE);
+
+    if (!(vm_swapmap[slot/8] & (1 << (slot&7))))
+	panic ("vm_swap_free(): slot %i is not in use", slot+1);
+
+    vm_swapmap[slot/8] &= ~(1 << (slot&7));
+    vm_swap_used --;
+
+    interrupts (oldints);
+  }
+
+
+
+int vm_swap_io (size_t slot, byte *page, int writeflag)
+  {
+    /*
+     *	Read (writeflag = 0) or write (writeflag = 1) one page from/to
+     *	a swap slot. Returns 0 on success, errno on failure.
+     */
+
+    daddr_t blocknr, nrofblocks;
+    int res;
+
+    if (!vm_swapdev)
+	return ENODEV;
+
+    nrofblocks = PAGESIZE / vm_swapdev->bsize;
+    blocknr = (daddr_t) (slot - 1) * nrofblocks;
+
+    EVTRACE_EVENT (writeflag? EVT_DEV_WRITE : EVT_DEV_READ,
+	evtrace_name4 (vm_swapdev->name), blocknr, nrofblocks);
+
+    if (writeflag)
+	res = vm_swapdev->write (vm_swapdev, blocknr, nrofblocks, page, NULL);
+    else
+	res = vm_swapdev->read (vm_swapdev, blocknr, nrofblocks, page, NULL);
+
+    EVTRACE_EVENT (EVT_DEV_DONE, evtrace_name4 (vm_swapdev->name), res, 0);
+    return res;
+  }
+
+
+
+size_t vm_swap_lookup (struct vm_object *obj, size_t page_nr)
+  {
+    /*
+     *	Return the swap slot of page page_nr of obj, or 0 if the page is
+     *	not on swap.
+     */
+
+    struct vm_swapent *e;
+    int oldints;
+    size_t slot = 0;
+
+    oldints = interrupts (DISABLE);
+
+    e = vm_swap_hash [VM_SWAP_HASH(page_nr)];
+    while (e)
+      {
+	if (e->obj == obj && e->page_nr == page_nr)
+	  {
+	    slot = e->slot;
+	    break;
+	  }
+	e = e->next;
+      }
+
+    interrupts (oldints);
+    return slot;
+  }
+
+
+
+void vm_swap_enter (struct vm_object *obj, struct vm_swapent *e,
+	size_t page_nr, size_t slot)
+  {
+    /*
+     *	Remember that page page_nr of obj is in swap slot 'slot'. e has
+     *	been malloc()ed by the caller, so that this cannot fail.
+     */
+
+    int oldints;
+
+    e->obj = obj;
+    e->page_nr = page_nr;
+    e->slot = slot;
+
+    oldints = interrupts (DISABLE);
+
+    e->next = vm_swap_hash [VM_SWAP_HASH(page_nr)];
+    vm_swap_hash [VM_SWAP_HASH(page_nr)] = e;
+    obj->nswapped ++;
+
+    interrupts (oldints);
+  }
+
+
+
+void vm_swap__freechain (struct vm_object *obj, size_t h,
+	size_t firstpage, size_t lastpage)
+  {
+    /*
+     *	Free swap entries (and slots) of obj with page_nr in the range
+     *	firstpage..lastpage from one hash chain. Interrupts should be
+     *	disabled.
+     */
+
+    struct vm_swapent *e, **prev;
+
+    prev = &vm_swap_hash [h];
+    while ((e = *prev))
+      {
+	if (e->obj == obj && e->page_nr >= firstpage && e->page_nr <= lastpage)
+	  {
+	    *prev = e->next;
+	    obj->nswapped --;
+	    vm_swap_free (e->slot);
+	    free (e);
+	  }
+	else
+	  prev = &e->next;
+      }
+  }
+
+
+
+void vm_swap_freepages (struct vm_object *obj, size_t firstpage, size_t lastpage)
+  {
+    /*
+     *	vm_swap_freepages ()
+     *	--------------------
+     *
+     *	Forget about any pages of obj on swap with page_nr in the range
+     *	firstpage..lastpage, and free their slots. (Like in
+     *	vm_object_freepages(), small ranges only scan the chains of the
+     *	pages in the range.)
+     */
+
+    size_t page_nr, h;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    if (lastpage - firstpage < VM_SWAP_HASHSIZE)
+      {
+	for (page_nr=firstpage; obj->nswapped > 0; page_nr++)
+	  {
+	    vm_swap__freechain (obj, VM_SWAP_HASH(page_nr),
+		firstpage, lastpage);
+	    if (page_nr == lastpage)
+		break;
+	  }
+      }
+    else
+      {
+	for (h=0; h<VM_SWAP_HASHSIZE && obj->nswapped > 0; h++)
+	    vm_swap__freechain (obj, h, firstpage, lastpage);
+      }
+
+    interrupts (oldints);
+  }
+
+
+
+void vm_swap_moveobj (struct vm_object *from, struct vm_object *to)
+  {
+    /*
+     *	Move all swapped pages of 'from' to 'to', except for pages which
+     *	'to' already has (resident or on swap), which are freed. Used
+     *	when 'from' is merged into 'to'. Both objects should be locked.
+     */
+
+    struct vm_swapent *e, **prev;
+    size_t h;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    for (h=0; h<VM_SWAP_HASHSIZE && from->nswapped > 0; h++)
+      {
+	prev = &vm_swap_hash [h];
+	while ((e = *prev))
+	  {
+	    if (e->obj != from)
+	      {
+		prev = &e->next;
+		continue;
+	      }
+
+	    from->nswapped --;
+
+	    if (vm_object_findpage (to, e->page_nr) ||
+		vm_swap_lookup (to, e->page_nr))
+	      {
+		*prev = e->next;
+		vm_swap_free (e->slot);
+		free (e);
+	      }
+	    else
+	      {
+		e->obj = to;
+		to->nswapped ++;
+		prev = &e->next;
+	      }
+	  }
+      }
+
+    interrupts (oldints);
+  }
+
+
+
+int vm_swap_covered (struct vm_object *obj, struct vm_object *backing)
+  {
+    /*
+     *	Returns 1 if every page of backing which is on swap is also in
+     *	obj (resident or on swap), 0 otherwise. Both objects should be
+     *	locked.
+     */
+
+    struct vm_swapent *e;
+    size_t h;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+
+    for (h=0; h<VM_SWAP_HASHSIZE; h++)
+      for (e=vm_swap_hash[h]; e; e=e->next)
+	if (e->obj == backing && !vm_object_findpage (obj, e->page_nr) &&
+	    !vm_swap_lookup (obj, e->page_nr))
+	  {
+	    interrupts (oldints);
+	    return 0;
+	  }
+
+    interrupts (oldints);
+    return 1;
+  }
+
+
+
+int vm_swapin (struct vm_object *obj, size_t page_nr)
+  {
+    /*
+     *	vm_swapin ()
+     *	------------
+     *
+     *	Read page page_nr of obj back from swap, and insert it into obj.
+     *	The object is unlocked during the I/O, with a busy-page marker
+     *	for the page. If someone else is already paging in the page, then
+     *	we return at once. The caller should not hold obj->lock, and
+     *	should look up the page again when we return.
+     *
+     *	Returns 0 on success, errno on failure.
+     */
+
+    size_t slot;
+    byte *page;
+    int res;
+
+    lock (&obj->lock, "vm_swapin", LOCK_BLOCKING | LOCK_RW);
+
+    slot = vm_swap_lookup (obj, page_nr);
+    if (!slot || vm_object_findbusy (obj, page_nr))
+      {
+	unlock (&obj->lock);
+	return 0;
+      }
+
+    if (vm_object_setbusy (obj, page_nr))
+      {
+	unlock (&obj->lock);
+	return ENOMEM;
+      }
+
+    unlock (&obj->lock);
+
+    page = (byte *) malloc (PAGESIZE);
+    res = page? vm_swap_io (slot, page, 0) : ENOMEM;
+
+    lock (&obj->lock, "vm_swapin", LOCK_BLOCKING | LOCK_RW);
+
+    if (!res)
+      {
+	vm_object_addpage (obj, page, page_nr);
+	vm_swap_freepages (obj, page_nr, page_nr);
+	vm_swap_ins ++;
+      }
+
+    vm_object_unbusy (obj, page_nr);
+    unlock (&obj->lock);
+
+    if (res && page)
+	free (page);
+
+    return res;
+  }
@@ -0,0 +1,324 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  vm/vm_writeback.c  --  write-back of shared file mappings
+ *
+ *	Pages of a file vm_object which are written to through a MAP_SHARED
+ *	region are marked VM_PAGE_DIRTY by vm_fault(). They are written
+ *	back to the file by msync(), by munmap() and when the region is
+ *	detached, and by the pageout daemon when memory is low.
+ *
+ *	A shared file page is mapped writable only after a write fault has
+ *	marked it dirty. When the page is written back, the dirty bit is
+ *	cleared and all shared mappings of the page are write protected
+ *	before the page is copied to the file, so that a write during (or
+ *	after) the write-back makes the page dirty again.
+ *
+ *	vm_writeback ()
+ *		Write back dirty pages of a file vm_object.
+ *
+ *	vm_writeback_region ()
+ *		Write back the dirty pages of (a part of) a shared region.
+ *
+ *	vm_writeback_dirty ()
+ *		Write back dirty pages of any file vm_object. (Used by the
+ *		pageout daemon.)
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/errno.h>
+#include <sys/lock.h>
+#include <sys/proc.h>
+#include <sys/md/proc.h>
+#include <sys/vnode.h>
+#include <sys/vm.h>
+
+
+extern volatile struct proc *procqueue [PROC_MAXQUEUES];
+
+extern struct mcb *first_mcb;
+extern size_t nr_of_mcbs;
+extern size_t malloc_firstaddr;
+
+/*  Statistics:  */
+u_int32_t vm_writeback_pages = 0;
+
+
+
+void vm_writeback__protect (struct vm_object *obj, size_t *batch, int n)
+  {
+    /*
+     *	Write protect every shared mapping of the n pages in batch[]
+     *	(mcb indices) of obj, in all processes. Interrupts should be
+     *	disabled.
+     */
+
+    struct proc *p;
+    struct vm_region *region;
+    size_t page_nr, v;
+    int q, i;
+
+    for (q=0; q<PROC_MAXQUEUES; q++)
+      {
+	p = (struct proc *) procqueue [q];
+	if (!p)
+	    continue;
+
+	do
+	  {
+	    if (p->status != P_ZOMBIE)
+	      for (region=p->vmregions; region; region=region->next)
+		{
+		  if (region->source != obj ||
+		      !(region->type & VMREGION_SHARED))
+			continue;
+
+		  for (i=0; i<n; i++)
+		    {
+			page_nr = first_mcb[batch[i]].page_nr;
+			if (page_nr*PAGESIZE < region->srcoffset)
+			    continue;
+
+			v = region->start_addr + page_nr*PAGESIZE -
+			    region->srcoffset;
+			if (v >= region->start_addr && v <= region->end_addr)
+			    pmap_writeprotect (p, v, v + PAGESIZE - 1);
+		    }
+		}
+
+	    p = p->next;
+	  } while (p != (struct proc *) procqueue[q]);
+      }
+  }
+
+
+
+int vm_writeback__write (struct vnode *v, size_t page_nr, byte *page)
+  {
+    /*
+     *	Write one page to the file. The part of the page which is beyond
+     *	the end of the file is not written. Returns errno.
+     */
+
+    off_t offset, len, transfered = 0;
+    int res;
+
+    offset = (off_t) page_nr * PAGESIZE;
+    if (offset >= v->ss.st_size)
+	return 0;
+
+    len = v->ss.st_size - offset;
+    if (len > PAGESIZE)
+	len = PAGESIZE;
+
+    res = v->write (v, offset, page, len, &transfered);
+    if (!res && transfered < len)
+	res = EIO;
+
+    return res;
+  }
+
+
+
+int vm_writeback (struct vm_object *obj, size_t firstpage, size_t lastpage)
+  {
+    /*
+     *	vm_writeback ()
+     *	---------------
+     *
+     *	Write the dirty pages firstpage..lastpage (inclusive) of the file
+     *	vm_object obj back to the file. The pages are collected, at most
+     *	VM_WRITEBACK_BATCH at a time, while obj is locked. They are marked
+     *	VM_PAGE_WRITEBACK (which keeps the pageout daemon away from them)
+     *	and are written without any locks held.
+     *
+     *	Pages which are dirtied again while the write-back is in progress
+     *	are not waited for. (At most two rounds are made over the pages
+     *	which were resident when we started.)
+     *
+     *	Returns 0 on success, otherwise the errno of the first failed
+     *	write. Pages which could not be written stay dirty.
+     */
+
+    size_t batch [VM_WRITEBACK_BATCH];
+    size_t h, pageindex, page_nr, maxbatches;
+    struct vnode *v;
+    int n, i, res, err = 0, oldints;
+
+    if (!obj || obj->type != VM_OBJECT_FILE || !obj->vnode)
+	return EINVAL;
+
+    v = obj->vnode;
+    if (!v->write)
+	return EROFS;
+
+    maxbatches = 2 * (obj->npages / VM_WRITEBACK_BATCH + 1);
+
+    while (maxbatches-- > 0 && !err)
+      {
+	lock (&obj->lock, "vm_writeback", LOCK_BLOCKING | LOCK_RW);
+
+	n = 0;
+	for (h=0; h<obj->page_hashsize && n<VM_WRITEBACK_BATCH; h++)
+	  for (pageindex=obj->page_hash[h]; pageindex && n<VM_WRITEBACK_BATCH;
+	       pageindex=first_mcb[pageindex].next)
+	    {
+		page_nr = first_mcb[pageindex].page_nr;
+		if (page_nr < firstpage || page_nr > lastpage ||
+		    (first_mcb[pageindex].bitmap & VM_PAGE_WRITEBACK) ||
+		    !(first_mcb[pageindex].bitmap & VM_PAGE_DIRTY))
+			continue;
+
+		first_mcb[pageindex].bitmap &= ~VM_PAGE_DIRTY;
+		first_mcb[pageindex].bitmap |= VM_PAGE_WRITEBACK;
+		batch [n++] = pageindex;
+	    }
+
+	if (n == 0)
+	  {
+	    unlock (&obj->lock);
+	    break;
+	  }
+
+	/*  Catch any further writes to the pages:  */
+	oldints = interrupts (DISABLE);
+	vm_writeback__protect (obj, batch, n);
+	interrupts (oldints);
+
+	unlock (&obj->lock);
+
+	/*  Write the pages:  (no locks held)  */
+	for (i=0; i<n; i++)
+	  {
+	    res = vm_writeback__write (v, first_mcb[batch[i]].page_nr,
+		(byte *) (malloc_firstaddr + PAGESIZE*batch[i]));
+
+	    if (res)
+	      {
+		printk ("vm_writeback: write error %i, page %i", res,
+		    first_mcb[batch[i]].page_nr);
+		first_mcb[batch[i]].bitmap |= VM_PAGE_DIRTY;
+		if (!err)
+		    err = res;
+	      }
+	    else
+		vm_writeback_pages ++;
+	  }
+
+	lock (&obj->lock, "vm_writeback", LOCK_BLOCKING | LOCK_RW);
+	for (i=0; i<n; i++)
+	    first_mcb[batch[i]].bitmap &= ~VM_PAGE_WRITEBACK;
+	unlock (&obj->lock);
+      }
+
+    return err;
+  }
+
+
+
+int vm_writeback_region (struct vm_region *region, size_t startaddr,
+	size_t endaddr)
+  {
+    /*
+     *	Write back the dirty pages of region which are within the address
+     *	range startaddr..endaddr. Regions which are not shared file
+     *	mappings have nothing to write back. Returns errno.
+     */
+
+    struct vm_object *obj;
+
+    if (!region || !(region->type & VMREGION_SHARED))
+	return 0;
+
+    obj = region->source;
+    if (!obj || obj->type != VM_OBJECT_FILE)
+	return 0;
+
+    if (startaddr < region->start_addr)
+	startaddr = region->start_addr;
+    if (endaddr > region->end_addr)
+	endaddr = region->end_addr;
+    if (startaddr > endaddr)
+	return 0;
+
+    return vm_writeback (obj,
+	(startaddr - region->start_addr + region->srcoffset) / PAGESIZE,
+	(endaddr - region->start_addr + region->srcoffset) / PAGESIZE);
+  }
+
+
+
+size_t vm_writeback_dirty (size_t maxpages)
+  {
+    /*
+     *	vm_writeback_dirty ()
+     *	---------------------
+     *
+     *	Look for dirty pages in the MCB array, and write back the file
+     *	vm_objects they belong to, until at least maxpages pages have been
+     *	written. (File objects are never freed, so obj stays valid after
+     *	interrupts have been enabled again.)
+     *
+     *	Returns the nr of pages written.
+     */
+
+    struct mcb *a_mcb;
+    struct vm_object *obj;
+    u_int32_t before = vm_writeback_pages;
+    size_t i;
+    int oldints;
+
+    for (i=1; i<nr_of_mcbs && vm_writeback_pages - before < maxpages; i++)
+      {
+	oldints = interrupts (DISABLE);
+
+	a_mcb = &first_mcb[i];
+	obj = a_mcb->object;
+
+	if (a_mcb->size != MCB_VMOBJECT_PAGE || !obj
+	    || obj->type != VM_OBJECT_FILE
+	    || (a_mcb->bitmap & (VM_PAGE_DIRTY | VM_PAGE_WRITEBACK))
+		!= VM_PAGE_DIRTY)
+	  {
+	    interrupts (oldints);
+	    continue;
+	  }
+
+	interrupts (oldints);
+
+	vm_writeback (obj, 0, (size_t) -1);
+      }
+
+    return vm_writeback_pages - before;
+  }
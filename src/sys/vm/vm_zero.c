@@ -0,0 +1,150 @@
+/*
+ *  Copyright (C) 2000 by Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+/*
+ *  vm/vm_zero.c  --  zero-filled pages for anonymous memory
+ *
+ *	Read faults on anonymous memory which has never been written to
+ *	are satisfied by mapping one shared, read-only page of zeroes.
+ *	The first write fault then allocates a real page.
+ *
+ *	Pages for write faults are taken from a small pool of pages which
+ *	have been zeroed in advance by the idle loop, so that the fault
+ *	doesn't have to clear the page itself.
+ *
+ *	vm_zero_init ()
+ *		Allocate the shared zero page.
+ *
+ *	vm_zeropage_alloc ()
+ *		Return a zero-filled page, from the pool if possible.
+ *
+ *	vm_zeropool_fill ()
+ *		Called from the idle loop. Zeroes one page for the pool.
+ *
+ *  History:
+ *	19 Oct 2026	first version
+ */
+
+
+#include "../config.h"
+#include <string.h>
+#include <sys/std.h>
+#include <sys/malloc.h>
+#include <sys/interrupts.h>
+#include <sys/proc.h>
+#include <sys/vm.h>
+
+
+extern size_t malloc_totalfreememory;
+
+byte *vm_zeropage = NULL;
+
+byte *vm_zeropool [VM_ZEROPOOL_PAGES];
+volatile int vm_zeropool_count = 0;
+
+/*  Statistics:  */
+u_int32_t vm_zeropage_maps = 0;		/*  read faults using vm_zeropage  */
+u_int32_t vm_zeropool_hits = 0;		/*  pages taken from the pool  */
+u_int32_t vm_zeropool_misses = 0;	/*  pages zeroed at fault time  */
+
+
+
+void vm_zero_init ()
+  {
+    vm_zeropage = (byte *) malloc (PAGESIZE);
+    if (!vm_zeropage)
+	panic ("vm_zero_init(): could not allocate the zero page");
+
+    memset (vm_zeropage, 0, PAGESIZE);
+    vm_zeropool_count = 0;
+  }
+
+
+
+byte *vm_zeropage_alloc ()
+  {
+    /*
+     *	Return a zero-filled page (allocated using malloc(PAGESIZE)), or
+     *	NULL if we're out of memory.
+     */
+
+    byte *p = NULL;
+    int oldints;
+
+    oldints = interrupts (DISABLE);
+    if (vm_zeropool_count > 0)
+      {
+	p = vm_zeropool [--vm_zeropool_count];
+	vm_zeropool_hits ++;
+      }
+    interrupts (oldints);
+
+    if (p)
+	return p;
+
+    p = (byte *) malloc (PAGESIZE);
+    if (!p)
+	return NULL;
+
+    memset (p, 0, PAGESIZE);
+    vm_zeropool_misses ++;
+    return p;
+  }
+
+
+
+void vm_zeropool_fill ()
+  {
+    /*
+     *	Zero one page and add it to the pool, unless the pool is full or
+     *	free memory is low. The page is cleared with interrupts enabled,
+     *	so this can be called repeatedly from the idle loop.
+     */
+
+    byte *p;
+    int oldints;
+
+    if (vm_zeropool_count >= VM_ZEROPOOL_PAGES ||
+	malloc_totalfreememory < VM_ZEROPOOL_MINFREE)
+	return;
+
+    p = (byte *) malloc (PAGESIZE);
+    if (!p)
+	return;
+
+    memset (p, 0, PAGESIZE);
+
+    oldints = interrupts (DISABLE);
+    if (vm_zeropool_count < VM_ZEROPOOL_PAGES)
+      {
+	vm_zeropool [vm_zeropool_count++] = p;
+	p = NULL;
+      }
+    interrupts (oldints);
+
+    if (p)
+	free (p);
+  }
+